@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <Kernel/API/POSIX/fcntl.h>
+#include <Kernel/API/POSIX/sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// An I/O ring is a pair of queues in memory shared between a process and the kernel.
+// The process puts requests into the submission queue and tells the kernel about them
+// with io_ring_enter(), which can hand over any number of them at once. Their results
+// show up in the completion queue, possibly much later and in any order. Like read()
+// and write(), reads and writes may transfer less than asked for; file system I/O moves
+// at most 1 MiB per request.
+
+#define IO_RING_CLOEXEC O_CLOEXEC
+
+// Wait in io_ring_enter() until at least min_complete completions are available.
+#define IO_RING_ENTER_GETEVENTS (1u << 0)
+
+#define IO_RING_MAX_ENTRIES 4096
+
+enum {
+    IO_RING_OP_NOP,
+    // read() or, with an offset other than IO_RING_CURRENT_OFFSET, pread().
+    IO_RING_OP_READ,
+    // write() or, with an offset other than IO_RING_CURRENT_OFFSET, pwrite().
+    IO_RING_OP_WRITE,
+    // recv(), with op_flags as the MSG_* flags.
+    IO_RING_OP_RECV,
+    // send(), with op_flags as the MSG_* flags.
+    IO_RING_OP_SEND,
+    // accept4(), with op_flags as the SOCK_* flags. The result is the new file descriptor.
+    IO_RING_OP_ACCEPT,
+    IO_RING_OP_FSYNC,
+};
+
+#define IO_RING_CURRENT_OFFSET ((uint64_t)-1)
+
+struct io_ring_sqe {
+    uint8_t opcode;
+    uint8_t reserved0;
+    uint16_t reserved1;
+    int32_t fd;
+    uint64_t offset;
+    uint64_t addr;
+    uint32_t length;
+    uint32_t op_flags;
+    // Passed back untouched in the completion.
+    uint64_t user_data;
+};
+
+struct io_ring_cqe {
+    uint64_t user_data;
+    // What the equivalent syscall would have returned, or a negated errno value.
+    int32_t result;
+    uint32_t reserved;
+};
+
+// The start of the shared memory. The process only ever writes sq_tail and cq_head,
+// and the kernel only ever writes sq_head and cq_tail. All of them count up forever,
+// and the queue slot of an entry is its index modulo the size of its queue.
+struct io_ring_header {
+    uint32_t sq_head;
+    uint32_t sq_tail;
+    uint32_t cq_head;
+    uint32_t cq_tail;
+};
+
+// Filled in by io_ring_setup(), describing the memory to mmap() from the ring file descriptor.
+struct io_ring_params {
+    uint32_t sq_entries;
+    uint32_t cq_entries;
+    uint32_t sqes_offset;
+    uint32_t cqes_offset;
+    uint32_t mmap_size;
+};
+
+#ifdef __cplusplus
+}
+#endif
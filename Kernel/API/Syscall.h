@@ -17,6 +17,8 @@
 constexpr int syscall_vector = 0x82;
 
 extern "C" {
+struct epoll_event;
+struct io_ring_params;
 struct pollfd;
 struct timeval;
 struct timespec;
@@ -58,7 +60,7 @@ enum class NeedsBigProcessLock {
     S(clock_gettime, NeedsBigProcessLock::No)               \
     S(clock_nanosleep, NeedsBigProcessLock::No)             \
     S(clock_settime, NeedsBigProcessLock::Yes)              \
-    S(close, NeedsBigProcessLock::Yes)                      \
+    S(close, NeedsBigProcessLock::No)                       \
     S(connect, NeedsBigProcessLock::Yes)                    \
     S(create_inode_watcher, NeedsBigProcessLock::Yes)       \
     S(create_thread, NeedsBigProcessLock::Yes)              \
@@ -68,6 +70,9 @@ enum class NeedsBigProcessLock {
     S(dump_backtrace, NeedsBigProcessLock::No)              \
     S(dup2, NeedsBigProcessLock::Yes)                       \
     S(emuctl, NeedsBigProcessLock::Yes)                     \
+    S(epoll_create, NeedsBigProcessLock::Yes)               \
+    S(epoll_ctl, NeedsBigProcessLock::No)                   \
+    S(epoll_wait, NeedsBigProcessLock::No)                  \
     S(execve, NeedsBigProcessLock::Yes)                     \
     S(exit, NeedsBigProcessLock::Yes)                       \
     S(exit_thread, NeedsBigProcessLock::Yes)                \
@@ -76,11 +81,11 @@ enum class NeedsBigProcessLock {
     S(fchown, NeedsBigProcessLock::Yes)                     \
     S(fcntl, NeedsBigProcessLock::Yes)                      \
     S(fork, NeedsBigProcessLock::Yes)                       \
-    S(fstat, NeedsBigProcessLock::Yes)                      \
+    S(fstat, NeedsBigProcessLock::No)                       \
     S(fstatvfs, NeedsBigProcessLock::Yes)                   \
     S(fsync, NeedsBigProcessLock::Yes)                      \
     S(ftruncate, NeedsBigProcessLock::Yes)                  \
-    S(futex, NeedsBigProcessLock::Yes)                      \
+    S(futex, NeedsBigProcessLock::No)                       \
     S(get_dir_entries, NeedsBigProcessLock::Yes)            \
     S(get_process_name, NeedsBigProcessLock::Yes)           \
     S(get_stack_bounds, NeedsBigProcessLock::No)            \
@@ -107,6 +112,8 @@ enum class NeedsBigProcessLock {
     S(getuid, NeedsBigProcessLock::Yes)                     \
     S(inode_watcher_add_watch, NeedsBigProcessLock::Yes)    \
     S(inode_watcher_remove_watch, NeedsBigProcessLock::Yes) \
+    S(io_ring_enter, NeedsBigProcessLock::No)               \
+    S(io_ring_setup, NeedsBigProcessLock::Yes)              \
     S(ioctl, NeedsBigProcessLock::Yes)                      \
     S(join_thread, NeedsBigProcessLock::Yes)                \
     S(kill, NeedsBigProcessLock::Yes)                       \
@@ -115,23 +122,23 @@ enum class NeedsBigProcessLock {
     S(link, NeedsBigProcessLock::Yes)                       \
     S(listen, NeedsBigProcessLock::Yes)                     \
     S(lseek, NeedsBigProcessLock::Yes)                      \
-    S(madvise, NeedsBigProcessLock::Yes)                    \
+    S(madvise, NeedsBigProcessLock::No)                     \
     S(map_time_page, NeedsBigProcessLock::Yes)              \
     S(mkdir, NeedsBigProcessLock::Yes)                      \
     S(mknod, NeedsBigProcessLock::Yes)                      \
-    S(mmap, NeedsBigProcessLock::Yes)                       \
+    S(mmap, NeedsBigProcessLock::No)                        \
     S(mount, NeedsBigProcessLock::Yes)                      \
-    S(mprotect, NeedsBigProcessLock::Yes)                   \
+    S(mprotect, NeedsBigProcessLock::No)                    \
     S(mremap, NeedsBigProcessLock::Yes)                     \
     S(msync, NeedsBigProcessLock::Yes)                      \
     S(msyscall, NeedsBigProcessLock::Yes)                   \
-    S(munmap, NeedsBigProcessLock::Yes)                     \
-    S(open, NeedsBigProcessLock::Yes)                       \
+    S(munmap, NeedsBigProcessLock::No)                      \
+    S(open, NeedsBigProcessLock::No)                        \
     S(perf_event, NeedsBigProcessLock::Yes)                 \
     S(perf_register_string, NeedsBigProcessLock::Yes)       \
     S(pipe, NeedsBigProcessLock::Yes)                       \
     S(pledge, NeedsBigProcessLock::Yes)                     \
-    S(poll, NeedsBigProcessLock::Yes)                       \
+    S(poll, NeedsBigProcessLock::No)                        \
     S(prctl, NeedsBigProcessLock::Yes)                      \
     S(profiling_disable, NeedsBigProcessLock::Yes)          \
     S(profiling_enable, NeedsBigProcessLock::Yes)           \
@@ -139,10 +146,10 @@ enum class NeedsBigProcessLock {
     S(ptrace, NeedsBigProcessLock::Yes)                     \
     S(ptsname, NeedsBigProcessLock::Yes)                    \
     S(purge, NeedsBigProcessLock::Yes)                      \
-    S(read, NeedsBigProcessLock::Yes)                       \
-    S(pread, NeedsBigProcessLock::Yes)                      \
+    S(read, NeedsBigProcessLock::No)                        \
+    S(pread, NeedsBigProcessLock::No)                       \
     S(readlink, NeedsBigProcessLock::Yes)                   \
-    S(readv, NeedsBigProcessLock::Yes)                      \
+    S(readv, NeedsBigProcessLock::No)                       \
     S(realpath, NeedsBigProcessLock::Yes)                   \
     S(recvfd, NeedsBigProcessLock::Yes)                     \
     S(recvmsg, NeedsBigProcessLock::Yes)                    \
@@ -151,9 +158,10 @@ enum class NeedsBigProcessLock {
     S(sched_getparam, NeedsBigProcessLock::Yes)             \
     S(sched_setparam, NeedsBigProcessLock::Yes)             \
     S(sendfd, NeedsBigProcessLock::Yes)                     \
+    S(sendfile, NeedsBigProcessLock::No)                    \
     S(sendmsg, NeedsBigProcessLock::Yes)                    \
     S(set_coredump_metadata, NeedsBigProcessLock::Yes)      \
-    S(set_mmap_name, NeedsBigProcessLock::Yes)              \
+    S(set_mmap_name, NeedsBigProcessLock::No)               \
     S(set_process_name, NeedsBigProcessLock::Yes)           \
     S(set_thread_name, NeedsBigProcessLock::Yes)            \
     S(setegid, NeedsBigProcessLock::Yes)                    \
@@ -178,7 +186,7 @@ enum class NeedsBigProcessLock {
     S(sigtimedwait, NeedsBigProcessLock::Yes)               \
     S(socket, NeedsBigProcessLock::Yes)                     \
     S(socketpair, NeedsBigProcessLock::Yes)                 \
-    S(stat, NeedsBigProcessLock::Yes)                       \
+    S(stat, NeedsBigProcessLock::No)                        \
     S(statvfs, NeedsBigProcessLock::Yes)                    \
     S(symlink, NeedsBigProcessLock::Yes)                    \
     S(sync, NeedsBigProcessLock::No)                        \
@@ -192,8 +200,8 @@ enum class NeedsBigProcessLock {
     S(unveil, NeedsBigProcessLock::Yes)                     \
     S(utime, NeedsBigProcessLock::Yes)                      \
     S(waitid, NeedsBigProcessLock::Yes)                     \
-    S(write, NeedsBigProcessLock::Yes)                      \
-    S(writev, NeedsBigProcessLock::Yes)                     \
+    S(write, NeedsBigProcessLock::No)                       \
+    S(writev, NeedsBigProcessLock::No)                      \
     S(yield, NeedsBigProcessLock::No)
 
 namespace Syscall {
@@ -270,6 +278,14 @@ struct SC_poll_params {
     const u32* sigmask;
 };
 
+struct SC_epoll_wait_params {
+    int epoll_fd;
+    struct epoll_event* events;
+    int max_events;
+    const struct timespec* timeout;
+    const u32* sigmask;
+};
+
 struct SC_clock_nanosleep_params {
     int clock_id;
     int flags;
@@ -21,9 +21,27 @@ inline bool time_page_supports(clockid_t clock_id)
     return clock_id == CLOCK_REALTIME_COARSE || clock_id == CLOCK_MONOTONIC_COARSE;
 }
 
+// The precise clocks can be computed from the coarse ones and the TSC, if the kernel tells us how.
+inline bool time_page_supports_with_tsc(clockid_t clock_id)
+{
+    return clock_id == CLOCK_REALTIME || clock_id == CLOCK_MONOTONIC || clock_id == CLOCK_MONOTONIC_RAW;
+}
+
+inline clockid_t time_page_coarse_clock_for(clockid_t clock_id)
+{
+    return clock_id == CLOCK_REALTIME ? CLOCK_REALTIME_COARSE : CLOCK_MONOTONIC_COARSE;
+}
+
 struct TimePage {
     volatile u32 update1;
     struct timespec clocks[CLOCK_ID_COUNT];
+    // The TSC when the coarse clocks were last updated, and how to turn the cycles
+    // since then into nanoseconds: ns = (cycles * tsc_to_ns_multiplier) >> 32.
+    // The multiplier is 0 if the TSC isn't reliable enough to keep time with.
+    u64 tsc_at_update;
+    u64 tsc_to_ns_multiplier;
+    // Cycles past this many are clamped, so that we never get ahead of the next update.
+    u64 max_tsc_delta;
     volatile u32 update2;
 };
 
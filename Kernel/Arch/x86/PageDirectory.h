@@ -25,6 +25,13 @@ public:
         m_raw |= PhysicalAddress::physical_page_base(value);
     }
 
+    // With the Huge bit set, the entry maps a 2 MiB page directly instead of pointing to a page table.
+    void set_huge_page_base(PhysicalPtr value)
+    {
+        m_raw &= 0x8000000000000fffULL;
+        m_raw |= PhysicalAddress::physical_page_base(value);
+    }
+
     bool is_null() const { return m_raw == 0; }
     void clear() { m_raw = 0; }
 
@@ -149,6 +149,11 @@ public:
         s_idle_cpu_mask.fetch_and(~(1u << m_cpu), AK::MemoryOrder::memory_order_relaxed);
     }
 
+    static u32 idle_processor_mask()
+    {
+        return s_idle_cpu_mask.load(AK::MemoryOrder::memory_order_relaxed);
+    }
+
     static Processor& by_id(u32);
 
     static u32 count()
@@ -383,6 +388,7 @@ public:
     static void smp_unicast(u32 cpu, Function<void()>, bool async);
     static void smp_broadcast_flush_tlb(Memory::PageDirectory const*, VirtualAddress, size_t);
     static u32 smp_wake_n_idle_processors(u32 wake_count);
+    static bool smp_wake_idle_processor(u32 cpu);
 
     static void deferred_call_queue(Function<void()> callback);
 
@@ -29,6 +29,7 @@
 #include <Kernel/Arch/x86/TrapFrame.h>
 
 #include <Kernel/Memory/PageDirectory.h>
+#include <Kernel/Memory/Region.h>
 #include <Kernel/Memory/ScopedAddressSpaceSwitcher.h>
 
 namespace Kernel {
@@ -587,37 +588,45 @@ ErrorOr<Vector<FlatPtr, 32>> Processor::capture_stack_trace(Thread& thread, size
     // is a chance a context switch may happen while we're trying
     // to get it. It also won't be entirely accurate and merely
     // reflect the status at the last context switch.
-    SpinlockLocker lock(g_scheduler_lock);
+    // NOTE: Holding the thread's lock keeps the Scheduler from switching it in.
+    SpinlockLocker lock(thread.get_lock());
     if (&thread == Processor::current_thread()) {
         VERIFY(thread.state() == Thread::State::Running);
-        // Leave the scheduler lock. If we trigger page faults we may
+        // Leave the thread lock. If we trigger page faults we may
         // need to be preempted. Since this is our own thread it won't
         // cause any problems as the stack won't change below this frame.
         lock.unlock();
         TRY(capture_current_thread());
     } else if (thread.is_active()) {
-        VERIFY(thread.cpu() != Processor::current_id());
+        auto cpu = thread.cpu();
+        VERIFY(cpu != Processor::current_id());
         // If this is the case, the thread is currently running
         // on another processor. We can't trust the kernel stack as
         // it may be changing at any time. We need to probably send
         // an IPI to that processor, have it walk the stack and wait
-        // until it returns the data back to us
+        // until it returns the data back to us.
+        // The other processor needs the thread lock to switch the thread
+        // out, which it can't do with interrupts disabled while we wait
+        // for it, so let go of it first.
+        lock.unlock();
         auto& proc = Processor::current();
         ErrorOr<void> result;
         smp_unicast(
-            thread.cpu(),
+            cpu,
             [&]() {
                 dbgln("CPU[{}] getting stack for cpu #{}", Processor::current_id(), proc.id());
-                ScopedAddressSpaceSwitcher switcher(thread.process());
                 VERIFY(&Processor::current() != &proc);
-                VERIFY(&thread == Processor::current_thread());
-                // NOTE: Because the other processor is still holding the
-                // scheduler lock while waiting for this callback to finish,
-                // the current thread on the target processor cannot change
+                // NOTE: The thread may have been switched out before we got here, but
+                // the current thread can't change while we're handling this message.
+                if (&thread != Processor::current_thread()) {
+                    result = Error::from_errno(EAGAIN);
+                    return;
+                }
+                ScopedAddressSpaceSwitcher switcher(thread.process());
 
                 // TODO: What to do about page faults here? We might deadlock
-                //       because the other processor is still holding the
-                //       scheduler lock...
+                //       because the other processor is waiting for us
+                //       with interrupts disabled...
                 result = capture_current_thread();
             },
             false);
@@ -649,7 +658,7 @@ ErrorOr<Vector<FlatPtr, 32>> Processor::capture_stack_trace(Thread& thread, size
 
             ip = regs.ip();
 
-            // TODO: We need to leave the scheduler lock here, but we also
+            // TODO: We need to leave the thread lock here, but we also
             //       need to prevent the target thread from being run while
             //       we walk the stack
             lock.unlock();
@@ -872,6 +881,22 @@ u32 Processor::smp_wake_n_idle_processors(u32 wake_count)
     return did_wake_count;
 }
 
+bool Processor::smp_wake_idle_processor(u32 cpu)
+{
+    VERIFY_INTERRUPTS_DISABLED();
+    if (!s_smp_enabled || cpu == Processor::current_id())
+        return false;
+
+    // Flip it to busy first, so that we don't send an IPI if
+    // someone else already woke it up.
+    u32 cpu_mask = 1u << cpu;
+    if (!(s_idle_cpu_mask.fetch_and(~cpu_mask, AK::MemoryOrder::memory_order_acq_rel) & cpu_mask))
+        return false;
+
+    APIC::the().send_ipi(cpu);
+    return true;
+}
+
 UNMAP_AFTER_INIT void Processor::smp_enable()
 {
     size_t msg_pool_size = Processor::count() * 100u;
@@ -1377,6 +1402,10 @@ extern "C" void enter_thread_context(Thread* from_thread, Thread* to_thread)
     if (from_regs.cr3 != to_regs.cr3)
         write_cr3(to_regs.cr3);
 
+    // The thread's page mapping may still be cached from an earlier mapping if the thread ran here before.
+    if (to_thread->has_page_mapped() && to_thread->cpu() != processor.id())
+        Processor::flush_tlb_local(to_thread->page_mapping_region()->vaddr());
+
     to_thread->set_cpu(processor.id());
 
     auto in_critical = to_thread->saved_critical();
@@ -63,10 +63,10 @@ StringView Processor::platform_string()
 FlatPtr Processor::init_context(Thread& thread, bool leave_crit)
 {
     VERIFY(is_kernel_mode());
-    VERIFY(g_scheduler_lock.is_locked());
+    VERIFY(Scheduler::context_switch_lock().is_locked_by_current_processor());
     if (leave_crit) {
         // Leave the critical section we set up in in Process::exec,
-        // but because we still have the scheduler lock we should end up with 1
+        // but because we still have the context switch lock we should end up with 1
         VERIFY(in_critical() == 2);
         m_in_critical = 1; // leave it without triggering anything or restoring flags
     }
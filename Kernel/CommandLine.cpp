@@ -119,6 +119,12 @@ UNMAP_AFTER_INIT bool CommandLine::is_smp_enabled() const
     return lookup("smp"sv).value_or("off"sv) == "on"sv;
 }
 
+UNMAP_AFTER_INIT bool CommandLine::is_smp_scheduling_enabled() const
+{
+    // FIXME: Make this the default once scheduling threads on the APs has seen enough testing.
+    return lookup("smp_scheduling"sv).value_or("off"sv) == "on"sv;
+}
+
 UNMAP_AFTER_INIT bool CommandLine::is_smp_enabled_without_ioapic_enabled() const
 {
     auto smp_enabled = lookup("smp"sv).value_or("off"sv) == "on"sv;
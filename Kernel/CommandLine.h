@@ -67,6 +67,7 @@ public:
     [[nodiscard]] bool is_ioapic_enabled() const;
     [[nodiscard]] bool is_smp_enabled_without_ioapic_enabled() const;
     [[nodiscard]] bool is_smp_enabled() const;
+    [[nodiscard]] bool is_smp_scheduling_enabled() const;
     [[nodiscard]] bool is_physical_networking_disabled() const;
     [[nodiscard]] bool is_vmmouse_enabled() const;
     [[nodiscard]] PCIAccessLevel pci_access_level() const;
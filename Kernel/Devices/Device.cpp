@@ -154,12 +154,25 @@ ErrorOr<NonnullOwnPtr<KString>> Device::pseudo_path(const OpenFileDescription&)
 void Device::process_next_queued_request(Badge<AsyncDeviceRequest>, const AsyncDeviceRequest& completed_request)
 {
     SpinlockLocker lock(m_requests_lock);
-    VERIFY(!m_requests.is_empty());
-    VERIFY(m_requests.first().ptr() == &completed_request);
-    m_requests.remove(m_requests.begin());
-    if (!m_requests.is_empty()) {
-        auto* next_request = m_requests.first().ptr();
-        next_request->do_start(move(lock));
+    VERIFY(m_outstanding_requests > 0);
+
+    // Requests may complete out of order when several are in flight, but they are always started in order.
+    size_t index = 0;
+    auto it = m_requests.begin();
+    for (; it != m_requests.end() && index < m_outstanding_requests; ++it, ++index) {
+        if (it->ptr() == &completed_request)
+            break;
+    }
+    VERIFY(it != m_requests.end() && index < m_outstanding_requests);
+    m_requests.remove(it);
+    --m_outstanding_requests;
+
+    auto next = m_requests.begin();
+    for (size_t i = 0; i < m_outstanding_requests && next != m_requests.end(); ++i)
+        ++next;
+    if (next != m_requests.end()) {
+        ++m_outstanding_requests;
+        (*next)->do_start(move(lock));
     }
 
     evaluate_block_conditions();
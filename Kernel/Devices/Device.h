@@ -50,15 +50,20 @@ public:
     virtual void after_inserting();
     void process_next_queued_request(Badge<AsyncDeviceRequest>, const AsyncDeviceRequest&);
 
+    // How many requests the device can have in flight at once. Requests beyond this
+    // limit are queued and started in order as earlier ones complete.
+    virtual size_t max_outstanding_requests() const { return 1; }
+
     template<typename AsyncRequestType, typename... Args>
     ErrorOr<NonnullRefPtr<AsyncRequestType>> try_make_request(Args&&... args)
     {
         auto request = TRY(adopt_nonnull_ref_or_enomem(new (nothrow) AsyncRequestType(*this, forward<Args>(args)...)));
         SpinlockLocker lock(m_requests_lock);
-        bool was_empty = m_requests.is_empty();
         m_requests.append(request);
-        if (was_empty)
+        if (m_outstanding_requests < max_outstanding_requests()) {
+            ++m_outstanding_requests;
             request->do_start(move(lock));
+        }
         return request;
     }
 
@@ -76,7 +81,9 @@ private:
     State m_state { State::Normal };
 
     Spinlock m_requests_lock;
+    // NOTE: The first m_outstanding_requests entries have been started, the rest are waiting.
     DoublyLinkedList<RefPtr<AsyncDeviceRequest>> m_requests;
+    size_t m_outstanding_requests { 0 };
     RefPtr<SysFSDeviceComponent> m_sysfs_component;
 };
 
@@ -4,53 +4,109 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/FixedArray.h>
 #include <AK/IntrusiveList.h>
+#include <AK/QuickSort.h>
 #include <Kernel/Debug.h>
 #include <Kernel/FileSystem/BlockBasedFileSystem.h>
+#include <Kernel/KBuffer.h>
+#include <Kernel/Memory/MemoryManager.h>
 #include <Kernel/Process.h>
+#include <Kernel/WorkQueue.h>
 
 namespace Kernel {
 
 struct CacheEntry {
+    enum class Queue : u8 {
+        Free,
+        Recent,
+        Frequent,
+    };
+
     IntrusiveListNode<CacheEntry> list_node;
+    IntrusiveListNode<CacheEntry> dirty_list_node;
     BlockBasedFileSystem::BlockIndex block_index { 0 };
     u8* data { nullptr };
     bool has_data { false };
+    Queue queue { Queue::Free };
+};
+
+// Cached block data is allocated in chunks, so that the cache can grow and shrink
+// in whole pages instead of fragmenting the kernel heap.
+struct CacheChunk {
+    NonnullOwnPtr<KBuffer> data;
+    FixedArray<CacheEntry> entries;
 };
 
+// The replacement policy is 2Q (Johnson & Shasha): blocks seen for the first time go
+// on the "recent" FIFO, and only blocks that are referenced again after falling off
+// it are promoted to the "frequent" LRU list. This keeps one-off scans (like reading
+// a large file once) from flushing out the blocks that are actually hot.
 class DiskCache {
 public:
-    static constexpr size_t EntryCount = 10000;
-    explicit DiskCache(BlockBasedFileSystem& fs, NonnullOwnPtr<KBuffer> cached_block_data, NonnullOwnPtr<KBuffer> entries_buffer)
+    static constexpr size_t ChunkSize = 64 * KiB;
+
+    // The cache never grows beyond 1/MaxMemoryFraction of physical memory.
+    static constexpr size_t MaxMemoryFraction = 8;
+
+    // When less than 1/LowMemoryFraction of physical memory is left, the cache stops
+    // growing and gives back clean chunks on the next sync.
+    static constexpr size_t LowMemoryFraction = 16;
+
+    explicit DiskCache(BlockBasedFileSystem& fs)
         : m_fs(fs)
-        , m_cached_block_data(move(cached_block_data))
-        , m_entries(move(entries_buffer))
     {
-        for (size_t i = 0; i < EntryCount; ++i) {
-            entries()[i].data = m_cached_block_data->data() + i * m_fs.block_size();
-            m_clean_list.append(entries()[i]);
-        }
     }
 
-    ~DiskCache() = default;
+    ~DiskCache()
+    {
+        m_dirty_list.clear();
+        m_recent_list.clear();
+        m_frequent_list.clear();
+        m_free_list.clear();
+    }
+
+    ErrorOr<void> grow()
+    {
+        auto entry_count = entries_per_chunk();
+        auto data = TRY(KBuffer::try_create_with_size(entry_count * m_fs.block_size(), Memory::Region::Access::ReadWrite, "DiskCache"sv));
+        auto entries = TRY(FixedArray<CacheEntry>::try_create(entry_count));
+        auto chunk = TRY(adopt_nonnull_own_or_enomem(new (nothrow) CacheChunk { move(data), move(entries) }));
+        TRY(m_chunks.try_append(move(chunk)));
+
+        auto& new_chunk = *m_chunks.last();
+        for (size_t i = 0; i < entry_count; ++i) {
+            auto& entry = new_chunk.entries[i];
+            entry.data = new_chunk.data->data() + i * m_fs.block_size();
+            m_free_list.append(entry);
+        }
+        m_entry_count += entry_count;
+        return {};
+    }
 
     bool is_dirty() const { return !m_dirty_list.is_empty(); }
-    bool entry_is_dirty(CacheEntry const& entry) const { return m_dirty_list.contains(entry); }
+    size_t dirty_count() const { return m_dirty_count; }
+    size_t entry_count() const { return m_entry_count; }
+    bool entry_is_dirty(CacheEntry const& entry) const { return entry.dirty_list_node.is_in_list(); }
 
-    void mark_all_clean()
+    bool has_data(BlockBasedFileSystem::BlockIndex block_index) const
     {
-        while (auto* entry = m_dirty_list.first())
-            m_clean_list.prepend(*entry);
+        auto* entry = get(block_index);
+        return entry && entry->has_data;
     }
 
-    void mark_dirty(CacheEntry& entry)
+    void mark_all_clean()
     {
-        m_dirty_list.prepend(entry);
+        m_dirty_list.clear();
+        m_dirty_count = 0;
     }
 
-    void mark_clean(CacheEntry& entry)
+    void mark_dirty(CacheEntry& entry)
     {
-        m_clean_list.prepend(entry);
+        if (entry_is_dirty(entry))
+            return;
+        m_dirty_list.append(entry);
+        ++m_dirty_count;
     }
 
     CacheEntry* get(BlockBasedFileSystem::BlockIndex block_index) const
@@ -63,35 +119,56 @@ public:
         return &entry;
     }
 
-    ErrorOr<CacheEntry*> ensure(BlockBasedFileSystem::BlockIndex block_index) const
+    ErrorOr<CacheEntry*> ensure(BlockBasedFileSystem::BlockIndex block_index)
     {
-        if (auto* entry = get(block_index))
+        if (auto* entry = get(block_index)) {
+            ++m_hits;
+            // NOTE: Hits in the recent queue are deliberately ignored, as they are likely
+            //       to be correlated references (e.g. several small reads of one block).
+            if (entry->queue == CacheEntry::Queue::Frequent)
+                m_frequent_list.prepend(*entry);
             return entry;
-
-        if (m_clean_list.is_empty()) {
-            // Not a single clean entry! Flush writes and try again.
-            // NOTE: We want to make sure we only call FileBackedFileSystem flush here,
-            //       not some FileBackedFileSystem subclass flush!
-            m_fs.flush_writes_impl();
-            return ensure(block_index);
         }
 
-        VERIFY(m_clean_list.last());
-        auto& new_entry = *m_clean_list.last();
-        m_clean_list.prepend(new_entry);
-
-        m_hash.remove(new_entry.block_index);
-        TRY(m_hash.try_set(block_index, &new_entry));
+        ++m_misses;
+        auto* new_entry = take_free_entry();
+        if (!new_entry && can_grow()) {
+            if (!grow().is_error())
+                new_entry = take_free_entry();
+        }
+        if (!new_entry) {
+            auto* victim = find_victim();
+            if (!victim) {
+                // Not a single clean entry! Flush writes and try again.
+                // NOTE: We want to make sure we only call FileBackedFileSystem flush here,
+                //       not some FileBackedFileSystem subclass flush!
+                m_fs.flush_writes_impl();
+                return ensure(block_index);
+            }
+            evict(*victim);
+            new_entry = take_free_entry();
+        }
+        VERIFY(new_entry);
 
-        new_entry.block_index = block_index;
-        new_entry.has_data = false;
+        if (auto result = m_hash.try_set(block_index, new_entry); result.is_error()) {
+            m_free_list.prepend(*new_entry);
+            return result.release_error();
+        }
 
-        return &new_entry;
+        new_entry->block_index = block_index;
+        new_entry->has_data = false;
+        if (m_ghosts.remove(block_index)) {
+            new_entry->queue = CacheEntry::Queue::Frequent;
+            m_frequent_list.prepend(*new_entry);
+            ++m_frequent_count;
+        } else {
+            new_entry->queue = CacheEntry::Queue::Recent;
+            m_recent_list.prepend(*new_entry);
+            ++m_recent_count;
+        }
+        return new_entry;
     }
 
-    const CacheEntry* entries() const { return (const CacheEntry*)m_entries->data(); }
-    CacheEntry* entries() { return (CacheEntry*)m_entries->data(); }
-
     template<typename Callback>
     void for_each_dirty_entry(Callback callback)
     {
@@ -99,13 +176,164 @@ public:
             callback(entry);
     }
 
+    static bool is_under_memory_pressure()
+    {
+        auto memory_info = MM.get_system_memory_info();
+        return memory_info.user_physical_pages_uncommitted < memory_info.user_physical_pages / LowMemoryFraction;
+    }
+
+    // Gives clean chunks back to the MemoryManager until the pressure is relieved,
+    // preferring the chunks holding the fewest frequently used blocks.
+    void release_memory_under_pressure()
+    {
+        while (m_chunks.size() > 1 && is_under_memory_pressure()) {
+            Optional<size_t> best_chunk;
+            size_t best_frequent_count = NumericLimits<size_t>::max();
+            for (size_t i = 0; i < m_chunks.size(); ++i) {
+                auto frequent_count = frequent_entry_count_if_clean(*m_chunks[i]);
+                if (frequent_count.has_value() && frequent_count.value() < best_frequent_count) {
+                    best_chunk = i;
+                    best_frequent_count = frequent_count.value();
+                }
+            }
+            if (!best_chunk.has_value())
+                return;
+            release_chunk(best_chunk.value());
+        }
+    }
+
+    BlockBasedFileSystem::CacheStatistics statistics() const
+    {
+        BlockBasedFileSystem::CacheStatistics statistics;
+        statistics.cached_blocks = m_recent_count + m_frequent_count;
+        statistics.recent_blocks = m_recent_count;
+        statistics.frequent_blocks = m_frequent_count;
+        statistics.dirty_blocks = m_dirty_count;
+        statistics.capacity_blocks = m_entry_count;
+        statistics.max_blocks = max_entries();
+        statistics.hits = m_hits;
+        statistics.misses = m_misses;
+        statistics.evictions = m_evictions;
+        return statistics;
+    }
+
 private:
+    size_t entries_per_chunk() const { return max<size_t>(ChunkSize / m_fs.block_size(), 1); }
+
+    size_t max_entries() const
+    {
+        auto memory_limit = MM.get_system_memory_info().user_physical_pages * PAGE_SIZE / MaxMemoryFraction;
+        size_t limit = memory_limit / m_fs.block_size();
+        // There is no point in caching more blocks than the filesystem has.
+        if (size_t total_block_count = m_fs.total_block_count())
+            limit = min(limit, ceil_div(total_block_count, entries_per_chunk()) * entries_per_chunk());
+        return max(limit, entries_per_chunk());
+    }
+
+    bool can_grow() const
+    {
+        return m_entry_count + entries_per_chunk() <= max_entries() && !is_under_memory_pressure();
+    }
+
+    CacheEntry* take_free_entry()
+    {
+        auto* entry = m_free_list.first();
+        if (entry)
+            m_free_list.remove(*entry);
+        return entry;
+    }
+
+    // Picks the oldest clean entry of the recent queue if it is over its target size,
+    // or the least recently used clean entry of the frequent queue otherwise.
+    CacheEntry* find_victim()
+    {
+        auto find_clean_entry = [this](auto& list) -> CacheEntry* {
+            for (auto it = list.rbegin(); it != list.rend(); ++it) {
+                if (!entry_is_dirty(*it))
+                    return &*it;
+            }
+            return nullptr;
+        };
+        auto recent_target = m_entry_count / 4;
+        if (m_recent_count > recent_target || m_frequent_count == 0) {
+            if (auto* entry = find_clean_entry(m_recent_list))
+                return entry;
+            return find_clean_entry(m_frequent_list);
+        }
+        if (auto* entry = find_clean_entry(m_frequent_list))
+            return entry;
+        return find_clean_entry(m_recent_list);
+    }
+
+    void evict(CacheEntry& entry)
+    {
+        VERIFY(!entry_is_dirty(entry));
+        VERIFY(entry.queue != CacheEntry::Queue::Free);
+        m_hash.remove(entry.block_index);
+        if (entry.queue == CacheEntry::Queue::Recent) {
+            --m_recent_count;
+            remember_ghost(entry.block_index);
+        } else {
+            --m_frequent_count;
+        }
+        entry.queue = CacheEntry::Queue::Free;
+        entry.has_data = false;
+        m_free_list.append(entry);
+        ++m_evictions;
+    }
+
+    // Blocks that fell off the recent queue are remembered (without their data) for a while,
+    // so that a second reference can be recognized and the block promoted to the frequent queue.
+    void remember_ghost(BlockBasedFileSystem::BlockIndex block_index)
+    {
+        auto max_ghosts = max<size_t>(m_entry_count / 2, 1);
+        while (m_ghosts.size() >= max_ghosts) {
+            auto oldest_ghost = *m_ghosts.begin();
+            m_ghosts.remove(oldest_ghost);
+        }
+        // NOTE: Failing to remember a ghost only makes the replacement policy a bit less clever.
+        (void)m_ghosts.try_set(block_index);
+    }
+
+    Optional<size_t> frequent_entry_count_if_clean(CacheChunk const& chunk) const
+    {
+        size_t frequent_count = 0;
+        for (auto const& entry : chunk.entries) {
+            if (entry_is_dirty(entry))
+                return {};
+            if (entry.queue == CacheEntry::Queue::Frequent)
+                ++frequent_count;
+        }
+        return frequent_count;
+    }
+
+    void release_chunk(size_t index)
+    {
+        auto& chunk = *m_chunks[index];
+        for (auto& entry : chunk.entries) {
+            if (entry.queue != CacheEntry::Queue::Free)
+                evict(entry);
+            m_free_list.remove(entry);
+        }
+        m_entry_count -= chunk.entries.size();
+        m_chunks.remove(index);
+    }
+
     BlockBasedFileSystem& m_fs;
-    mutable HashMap<BlockBasedFileSystem::BlockIndex, CacheEntry*> m_hash;
-    mutable IntrusiveList<&CacheEntry::list_node> m_clean_list;
-    mutable IntrusiveList<&CacheEntry::list_node> m_dirty_list;
-    NonnullOwnPtr<KBuffer> m_cached_block_data;
-    NonnullOwnPtr<KBuffer> m_entries;
+    HashMap<BlockBasedFileSystem::BlockIndex, CacheEntry*> m_hash;
+    OrderedHashTable<BlockBasedFileSystem::BlockIndex> m_ghosts;
+    IntrusiveList<&CacheEntry::list_node> m_free_list;
+    IntrusiveList<&CacheEntry::list_node> m_recent_list;
+    IntrusiveList<&CacheEntry::list_node> m_frequent_list;
+    IntrusiveList<&CacheEntry::dirty_list_node> m_dirty_list;
+    Vector<NonnullOwnPtr<CacheChunk>> m_chunks;
+    size_t m_entry_count { 0 };
+    size_t m_recent_count { 0 };
+    size_t m_frequent_count { 0 };
+    size_t m_dirty_count { 0 };
+    u64 m_hits { 0 };
+    u64 m_misses { 0 };
+    u64 m_evictions { 0 };
 };
 
 BlockBasedFileSystem::BlockBasedFileSystem(OpenFileDescription& file_description)
@@ -121,9 +349,9 @@ BlockBasedFileSystem::~BlockBasedFileSystem()
 ErrorOr<void> BlockBasedFileSystem::initialize()
 {
     VERIFY(block_size() != 0);
-    auto cached_block_data = TRY(KBuffer::try_create_with_size(DiskCache::EntryCount * block_size()));
-    auto entries_data = TRY(KBuffer::try_create_with_size(DiskCache::EntryCount * sizeof(CacheEntry)));
-    auto disk_cache = TRY(adopt_nonnull_own_or_enomem(new (nothrow) DiskCache(*this, move(cached_block_data), move(entries_data))));
+    // NOTE: The cache starts out with a single chunk and grows on demand.
+    auto disk_cache = TRY(adopt_nonnull_own_or_enomem(new (nothrow) DiskCache(*this)));
+    TRY(disk_cache->grow());
 
     m_cache.with_exclusive([&](auto& cache) {
         cache = move(disk_cache);
@@ -131,6 +359,15 @@ ErrorOr<void> BlockBasedFileSystem::initialize()
     return {};
 }
 
+BlockBasedFileSystem::CacheStatistics BlockBasedFileSystem::cache_statistics() const
+{
+    return m_cache.with_shared([&](auto& cache) -> CacheStatistics {
+        if (!cache)
+            return {};
+        return cache->statistics();
+    });
+}
+
 ErrorOr<void> BlockBasedFileSystem::write_block(BlockIndex index, const UserOrKernelBuffer& data, size_t count, u64 offset, bool allow_cache)
 {
     VERIFY(m_logical_block_size);
@@ -162,10 +399,25 @@ ErrorOr<void> BlockBasedFileSystem::write_block(BlockIndex index, const UserOrKe
 
         cache->mark_dirty(*entry);
         entry->has_data = true;
+
+        // Start writing back early once a good part of the cache is dirty, so that the next
+        // sync (or a miss looking for a clean victim) doesn't have to write it all at once.
+        if (cache->dirty_count() >= cache->entry_count() / WriteBehindDirtyFraction)
+            schedule_write_behind();
         return {};
     });
 }
 
+void BlockBasedFileSystem::schedule_write_behind()
+{
+    if (m_write_behind_pending.exchange(true))
+        return;
+    g_fs_work->queue([fs = NonnullRefPtr<BlockBasedFileSystem>(*this)]() mutable {
+        fs->m_write_behind_pending.store(false);
+        fs->flush_writes_impl();
+    });
+}
+
 ErrorOr<void> BlockBasedFileSystem::raw_read(BlockIndex index, UserOrKernelBuffer& buffer)
 {
     auto base_offset = index.value() * m_logical_block_size;
@@ -206,8 +458,41 @@ ErrorOr<void> BlockBasedFileSystem::write_blocks(BlockIndex index, unsigned coun
 {
     VERIFY(m_logical_block_size);
     dbgln_if(BBFS_DEBUG, "BlockBasedFileSystem::write_blocks {}, count={}", index, count);
-    for (unsigned i = 0; i < count; ++i) {
-        TRY(write_block(BlockIndex { index.value() + i }, data.offset(i * block_size()), block_size(), 0, allow_cache));
+    if (count == 1)
+        return write_block(index, data, block_size(), 0, allow_cache);
+
+    auto max_run_blocks = max<size_t>(MaxRunSize / block_size(), 1);
+    for (size_t i = 0; i < count;) {
+        auto run_length = min(static_cast<size_t>(count) - i, max_run_blocks);
+        BlockIndex first_block = index.value() + i;
+        auto run_data = data.offset(i * block_size());
+
+        if (!allow_cache) {
+            TRY(m_cache.with_exclusive([&](auto&) -> ErrorOr<void> {
+                for (size_t j = 0; j < run_length; ++j)
+                    flush_specific_block_if_needed(first_block.value() + j);
+                return write_run(first_block, run_data, run_length * block_size());
+            }));
+            i += run_length;
+            continue;
+        }
+
+        // NOTE: Just like write_block(), we copy the data into a local buffer before taking the cache lock.
+        auto buffered_data = TRY(ByteBuffer::create_uninitialized(run_length * block_size()));
+        TRY(run_data.read(buffered_data.bytes()));
+
+        TRY(m_cache.with_exclusive([&](auto& cache) -> ErrorOr<void> {
+            for (size_t j = 0; j < run_length; ++j) {
+                auto* entry = TRY(cache->ensure(first_block.value() + j));
+                memcpy(entry->data, buffered_data.data() + j * block_size(), block_size());
+                cache->mark_dirty(*entry);
+                entry->has_data = true;
+            }
+            if (cache->dirty_count() >= cache->entry_count() / WriteBehindDirtyFraction)
+                schedule_write_behind();
+            return {};
+        }));
+        i += run_length;
     }
     return {};
 }
@@ -248,13 +533,48 @@ ErrorOr<void> BlockBasedFileSystem::read_blocks(BlockIndex index, unsigned count
         return EINVAL;
     if (count == 1)
         return read_block(index, &buffer, block_size(), 0, allow_cache);
-    auto out = buffer;
-    for (unsigned i = 0; i < count; ++i) {
-        TRY(read_block(BlockIndex { index.value() + i }, &out, block_size(), 0, allow_cache));
-        out = out.offset(block_size());
-    }
 
-    return {};
+    auto max_run_blocks = max<size_t>(MaxRunSize / block_size(), 1);
+    return m_cache.with_exclusive([&](auto& cache) -> ErrorOr<void> {
+        if (!allow_cache) {
+            for (unsigned i = 0; i < count; ++i)
+                const_cast<BlockBasedFileSystem*>(this)->flush_specific_block_if_needed(index.value() + i);
+            return read_run(index, buffer, count * block_size());
+        }
+
+        // Blocks that are already cached are copied out one at a time, but runs of blocks
+        // that aren't are read from the device with a single request.
+        OwnPtr<KBuffer> run_buffer;
+        for (size_t i = 0; i < count;) {
+            BlockIndex first_block = index.value() + i;
+            size_t missing_blocks = 0;
+            while (i + missing_blocks < count && missing_blocks < max_run_blocks && !cache->has_data(first_block.value() + missing_blocks))
+                ++missing_blocks;
+
+            if (missing_blocks < 2) {
+                auto out = buffer.offset(i * block_size());
+                TRY(read_block(first_block, &out, block_size(), 0, true));
+                ++i;
+                continue;
+            }
+
+            if (!run_buffer)
+                run_buffer = TRY(KBuffer::try_create_with_size(min(static_cast<size_t>(count), max_run_blocks) * block_size(), Memory::Region::Access::ReadWrite, "DiskCache read"sv));
+            auto run_data_buffer = UserOrKernelBuffer::for_kernel_buffer(run_buffer->data());
+            TRY(read_run(first_block, run_data_buffer, missing_blocks * block_size()));
+
+            for (size_t j = 0; j < missing_blocks; ++j) {
+                auto* entry = TRY(cache->ensure(first_block.value() + j));
+                if (!entry->has_data) {
+                    memcpy(entry->data, run_buffer->data() + j * block_size(), block_size());
+                    entry->has_data = true;
+                }
+                TRY(buffer.write(entry->data, (i + j) * block_size(), block_size()));
+            }
+            i += missing_blocks;
+        }
+        return {};
+    });
 }
 
 void BlockBasedFileSystem::flush_specific_block_if_needed(BlockIndex index)
@@ -273,26 +593,105 @@ void BlockBasedFileSystem::flush_specific_block_if_needed(BlockIndex index)
     });
 }
 
+ErrorOr<void> BlockBasedFileSystem::write_run(BlockIndex first_block, UserOrKernelBuffer const& buffer, size_t length)
+{
+    // NOTE: A StorageDevice takes the whole run at once and splits it up into as few requests as it can,
+    //       but other block devices may write less than we asked for, so keep going until the whole run is written.
+    //       The same goes for read_run() below.
+    u64 base_offset = first_block.value() * block_size();
+    size_t nwritten = 0;
+    while (nwritten < length) {
+        auto result = TRY(file_description().write(base_offset + nwritten, buffer.offset(nwritten), length - nwritten));
+        if (result == 0)
+            return EIO;
+        nwritten += result;
+    }
+    return {};
+}
+
+ErrorOr<void> BlockBasedFileSystem::read_run(BlockIndex first_block, UserOrKernelBuffer& buffer, size_t length) const
+{
+    u64 base_offset = first_block.value() * block_size();
+    size_t nread = 0;
+    while (nread < length) {
+        auto buffer_offset = buffer.offset(nread);
+        auto result = TRY(file_description().read(buffer_offset, base_offset + nread, length - nread));
+        if (result == 0)
+            return EIO;
+        nread += result;
+    }
+    return {};
+}
+
 void BlockBasedFileSystem::flush_writes_impl()
 {
     size_t count = 0;
+    size_t run_count = 0;
     m_cache.with_exclusive([&](auto& cache) {
         if (!cache->is_dirty())
             return;
-        cache->for_each_dirty_entry([&](CacheEntry& entry) {
-            auto base_offset = entry.block_index.value() * block_size();
-            auto entry_data_buffer = UserOrKernelBuffer::for_kernel_buffer(entry.data);
-            [[maybe_unused]] auto rc = file_description().write(base_offset, entry_data_buffer, block_size());
-            ++count;
-        });
+
+        // Write the dirty blocks in disk order, merging adjacent blocks into a single write,
+        // so the device sees a few large sequential requests instead of many scattered ones.
+        // If we can't get the memory for that, we fall back to writing one block at a time.
+        Vector<CacheEntry*> dirty_entries;
+        bool can_merge = !dirty_entries.try_ensure_capacity(cache->dirty_count()).is_error();
+        OwnPtr<KBuffer> run_buffer;
+        if (can_merge) {
+            cache->for_each_dirty_entry([&](CacheEntry& entry) {
+                dirty_entries.unchecked_append(&entry);
+            });
+            quick_sort(dirty_entries, [](auto* a, auto* b) { return a->block_index < b->block_index; });
+            auto max_run_blocks = max<size_t>(MaxRunSize / block_size(), 1);
+            if (auto buffer_or_error = KBuffer::try_create_with_size(max_run_blocks * block_size(), Memory::Region::Access::ReadWrite, "DiskCache write-behind"sv); !buffer_or_error.is_error())
+                run_buffer = buffer_or_error.release_value();
+        }
+
+        if (!run_buffer) {
+            cache->for_each_dirty_entry([&](CacheEntry& entry) {
+                auto entry_data_buffer = UserOrKernelBuffer::for_kernel_buffer(entry.data);
+                [[maybe_unused]] auto rc = write_run(entry.block_index, entry_data_buffer, block_size());
+                ++count;
+                ++run_count;
+            });
+        } else {
+            auto max_run_blocks = run_buffer->size() / block_size();
+            for (size_t i = 0; i < dirty_entries.size();) {
+                auto first_block = dirty_entries[i]->block_index;
+                size_t run_length = 1;
+                while (i + run_length < dirty_entries.size() && run_length < max_run_blocks
+                    && dirty_entries[i + run_length]->block_index.value() == first_block.value() + run_length)
+                    ++run_length;
+
+                if (run_length == 1) {
+                    auto entry_data_buffer = UserOrKernelBuffer::for_kernel_buffer(dirty_entries[i]->data);
+                    [[maybe_unused]] auto rc = write_run(first_block, entry_data_buffer, block_size());
+                } else {
+                    for (size_t j = 0; j < run_length; ++j)
+                        memcpy(run_buffer->data() + j * block_size(), dirty_entries[i + j]->data, block_size());
+                    auto run_data_buffer = UserOrKernelBuffer::for_kernel_buffer(run_buffer->data());
+                    [[maybe_unused]] auto rc = write_run(first_block, run_data_buffer, run_length * block_size());
+                }
+                i += run_length;
+                count += run_length;
+                ++run_count;
+            }
+        }
         cache->mark_all_clean();
-        dbgln("{}: Flushed {} blocks to disk", class_name(), count);
+        dbgln("{}: Flushed {} blocks to disk in {} writes", class_name(), count, run_count);
     });
 }
 
 void BlockBasedFileSystem::flush_writes()
 {
     flush_writes_impl();
+
+    // NOTE: All entries are clean at this point, so this is a good time to shrink the cache if memory is tight.
+    if (DiskCache::is_under_memory_pressure()) {
+        m_cache.with_exclusive([&](auto& cache) {
+            cache->release_memory_under_pressure();
+        });
+    }
 }
 
 }
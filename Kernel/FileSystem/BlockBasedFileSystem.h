@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include <AK/Atomic.h>
 #include <Kernel/FileSystem/FileBackedFileSystem.h>
 #include <Kernel/Locking/MutexProtected.h>
 
@@ -15,14 +16,30 @@ class BlockBasedFileSystem : public FileBackedFileSystem {
 public:
     TYPEDEF_DISTINCT_ORDERED_ID(u64, BlockIndex);
 
+    struct CacheStatistics {
+        size_t cached_blocks { 0 };
+        size_t recent_blocks { 0 };
+        size_t frequent_blocks { 0 };
+        size_t dirty_blocks { 0 };
+        size_t capacity_blocks { 0 };
+        size_t max_blocks { 0 };
+        u64 hits { 0 };
+        u64 misses { 0 };
+        u64 evictions { 0 };
+    };
+
     virtual ~BlockBasedFileSystem() override;
     virtual ErrorOr<void> initialize() override;
 
+    virtual bool is_block_based() const override { return true; }
+
     u64 logical_block_size() const { return m_logical_block_size; };
 
     virtual void flush_writes() override;
     void flush_writes_impl();
 
+    CacheStatistics cache_statistics() const;
+
 protected:
     explicit BlockBasedFileSystem(OpenFileDescription&);
 
@@ -41,10 +58,18 @@ protected:
     u64 m_logical_block_size { 512 };
 
 private:
-    DiskCache& cache() const;
+    // Background write-behind starts once 1/WriteBehindDirtyFraction of the cache is dirty.
+    static constexpr size_t WriteBehindDirtyFraction = 2;
+    // The largest request we build out of a run of contiguous blocks.
+    static constexpr size_t MaxRunSize = 128 * KiB;
+
     void flush_specific_block_if_needed(BlockIndex index);
+    void schedule_write_behind();
+    ErrorOr<void> read_run(BlockIndex first_block, UserOrKernelBuffer&, size_t length) const;
+    ErrorOr<void> write_run(BlockIndex first_block, UserOrKernelBuffer const&, size_t length);
 
     mutable MutexProtected<OwnPtr<DiskCache>> m_cache;
+    Atomic<bool> m_write_behind_pending { false };
 };
 
 }
@@ -0,0 +1,243 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <Kernel/FileSystem/EPoll.h>
+#include <Kernel/FileSystem/OpenFileDescription.h>
+#include <Kernel/Process.h>
+
+namespace Kernel {
+
+using BlockFlags = Thread::FileBlocker::BlockFlags;
+
+// These only change how and when events are reported, they don't ask for any.
+static constexpr u32 mode_flags = EPOLLET | EPOLLONESHOT;
+
+ErrorOr<NonnullRefPtr<EPoll>> EPoll::try_create()
+{
+    return adopt_nonnull_ref_or_enomem(new (nothrow) EPoll);
+}
+
+EPoll::~EPoll()
+{
+    (void)close();
+}
+
+bool EPoll::can_read(const OpenFileDescription&, u64) const
+{
+    SpinlockLocker lock(m_ready_lock);
+    return !m_ready_items.is_empty();
+}
+
+ErrorOr<void> EPoll::close()
+{
+    MutexLocker locker(m_items_lock);
+    for (auto& it : m_items)
+        detach(*it.value);
+    m_items.clear();
+    return {};
+}
+
+ErrorOr<NonnullOwnPtr<KString>> EPoll::pseudo_path(const OpenFileDescription&) const
+{
+    MutexLocker locker(m_items_lock);
+    return KString::formatted("EPoll:({})", m_items.size());
+}
+
+EPoll::Item::Item(EPoll& epoll, int fd, OpenFileDescription& description, epoll_event const& event)
+    : m_epoll(epoll)
+    , m_fd(fd)
+    , m_description(description)
+    , m_file(description.file())
+    , m_events(event.events)
+    , m_data(event.data.u64)
+{
+}
+
+Optional<u32> EPoll::Item::ready_events() const
+{
+    auto description = m_description.strong_ref();
+    if (!description)
+        return {};
+
+    u32 events;
+    {
+        SpinlockLocker lock(m_epoll.m_ready_lock);
+        events = m_events;
+    }
+
+    BlockFlags block_flags = BlockFlags::None;
+    if (events & EPOLLIN)
+        block_flags |= BlockFlags::Read;
+    if (events & EPOLLOUT)
+        block_flags |= BlockFlags::Write;
+    if (block_flags == BlockFlags::None)
+        return 0u;
+
+    auto unblock_flags = description->should_unblock(block_flags);
+    u32 ready_events = 0;
+    if (has_flag(unblock_flags, BlockFlags::Read))
+        ready_events |= EPOLLIN;
+    if (has_flag(unblock_flags, BlockFlags::Write))
+        ready_events |= EPOLLOUT;
+    return ready_events;
+}
+
+void EPoll::item_state_changed(Item& item)
+{
+    // NOTE: This is called with the watched file's blocker set locked, so we only queue the
+    //       item here. Whether it is actually ready is checked in collect_ready_events().
+    {
+        SpinlockLocker lock(m_ready_lock);
+        ++item.m_generation;
+        if (!(item.m_events & ~mode_flags) || item.m_ready_list_node.is_in_list())
+            return;
+        m_ready_items.append(item);
+    }
+    evaluate_block_conditions();
+}
+
+void EPoll::attach(Item& item)
+{
+    item.m_file->blocker_set().add_observer(item);
+    // Queue the item right away, in case the file is ready already.
+    item_state_changed(item);
+}
+
+void EPoll::detach(Item& item)
+{
+    // NOTE: Once the item is no longer an observer, nothing can put it back on the ready list.
+    item.m_file->blocker_set().remove_observer(item);
+    SpinlockLocker lock(m_ready_lock);
+    if (item.m_ready_list_node.is_in_list())
+        m_ready_items.remove(item);
+}
+
+ErrorOr<void> EPoll::add(int fd, OpenFileDescription& description, epoll_event const& event)
+{
+    MutexLocker locker(m_items_lock);
+    if (auto it = m_items.find(fd); it != m_items.end()) {
+        if (it->value->m_description.unsafe_ptr() == &description)
+            return EEXIST;
+        // NOTE: The fd was closed and reused before the old entry was dropped, so it is stale. Replace it.
+        detach(*it->value);
+        m_items.remove(it);
+    }
+
+    auto item = TRY(adopt_nonnull_ref_or_enomem(new (nothrow) Item(*this, fd, description, event)));
+    TRY(m_items.try_set(fd, item));
+    attach(*item);
+    return {};
+}
+
+ErrorOr<void> EPoll::modify(int fd, OpenFileDescription& description, epoll_event const& event)
+{
+    MutexLocker locker(m_items_lock);
+    auto it = m_items.find(fd);
+    if (it == m_items.end())
+        return ENOENT;
+
+    auto& item = *it->value;
+    if (item.m_description.unsafe_ptr() != &description) {
+        // NOTE: Same as in add(), the fd now refers to a different file description.
+        auto new_item = TRY(adopt_nonnull_ref_or_enomem(new (nothrow) Item(*this, fd, description, event)));
+        detach(item);
+        it->value = new_item;
+        attach(*new_item);
+        return {};
+    }
+
+    {
+        SpinlockLocker lock(m_ready_lock);
+        item.m_events = event.events;
+        item.m_data = event.data.u64;
+    }
+    item_state_changed(item);
+    return {};
+}
+
+ErrorOr<void> EPoll::remove(int fd)
+{
+    MutexLocker locker(m_items_lock);
+    auto it = m_items.find(fd);
+    if (it == m_items.end())
+        return ENOENT;
+    detach(*it->value);
+    m_items.remove(it);
+    return {};
+}
+
+void EPoll::remove_closed_items(Span<NonnullRefPtr<Item>> items)
+{
+    MutexLocker locker(m_items_lock);
+    for (auto& item : items) {
+        // NOTE: The item may have been removed or replaced in the meantime, in which case it is detached already.
+        auto it = m_items.find(item->m_fd);
+        if (it == m_items.end() || it->value.ptr() != item.ptr())
+            continue;
+        detach(item);
+        m_items.remove(it);
+    }
+}
+
+ErrorOr<size_t> EPoll::collect_ready_events(Span<epoll_event> events)
+{
+    // Level-triggered items that were reported stay on the ready list, so they are looked at
+    // again on the next call. We put them back at the end, so we don't see them twice now.
+    Vector<NonnullRefPtr<Item>> items_to_requeue;
+    TRY(items_to_requeue.try_ensure_capacity(events.size()));
+    Vector<NonnullRefPtr<Item>> closed_items;
+
+    size_t event_count = 0;
+    while (event_count < events.size()) {
+        RefPtr<Item> item;
+        u32 generation;
+        {
+            SpinlockLocker lock(m_ready_lock);
+            if (m_ready_items.is_empty())
+                break;
+            item = m_ready_items.take_first();
+            generation = item->m_generation;
+        }
+
+        // NOTE: We can't hold m_ready_lock here, as checking a file may take its locks.
+        auto maybe_ready_events = item->ready_events();
+        if (!maybe_ready_events.has_value()) {
+            TRY(closed_items.try_append(item.release_nonnull()));
+            continue;
+        }
+        auto ready_events = maybe_ready_events.value();
+
+        SpinlockLocker lock(m_ready_lock);
+        if (!ready_events || !(item->m_events & ~mode_flags)) {
+            // If the state of the file changed while we were looking at it, we have to look again.
+            if (item->m_generation != generation && !item->m_ready_list_node.is_in_list())
+                m_ready_items.append(*item);
+            continue;
+        }
+
+        events[event_count++] = { ready_events, { .u64 = item->m_data } };
+        if (item->m_events & EPOLLONESHOT)
+            item->m_events &= mode_flags;
+        else if (!(item->m_events & EPOLLET))
+            items_to_requeue.unchecked_append(*item);
+        else if (item->m_generation != generation && !item->m_ready_list_node.is_in_list())
+            m_ready_items.append(*item);
+    }
+
+    if (!closed_items.is_empty())
+        remove_closed_items(closed_items);
+
+    if (!items_to_requeue.is_empty()) {
+        SpinlockLocker lock(m_ready_lock);
+        for (auto& item : items_to_requeue) {
+            if (!item->m_ready_list_node.is_in_list())
+                m_ready_items.append(item);
+        }
+    }
+    return event_count;
+}
+
+}
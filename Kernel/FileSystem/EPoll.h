@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/HashMap.h>
+#include <AK/IntrusiveList.h>
+#include <AK/Optional.h>
+#include <AK/RefCounted.h>
+#include <AK/WeakPtr.h>
+#include <Kernel/API/POSIX/sys/epoll.h>
+#include <Kernel/FileSystem/File.h>
+#include <Kernel/Forward.h>
+#include <Kernel/Locking/Mutex.h>
+#include <Kernel/Locking/Spinlock.h>
+
+namespace Kernel {
+
+// An EPoll keeps a persistent set of file descriptions a process is interested in.
+// Instead of checking every one of them on each wait (like poll() and select() do),
+// each watched file tells the EPoll when its state changes, and only the files that
+// changed are looked at again. This makes waiting O(ready) instead of O(watched).
+class EPoll final : public File {
+public:
+    static ErrorOr<NonnullRefPtr<EPoll>> try_create();
+    virtual ~EPoll() override;
+
+    virtual bool can_read(const OpenFileDescription&, u64) const override;
+    virtual ErrorOr<size_t> read(OpenFileDescription&, u64, UserOrKernelBuffer&, size_t) override { return EINVAL; }
+    virtual bool can_write(const OpenFileDescription&, u64) const override { return false; }
+    virtual ErrorOr<size_t> write(OpenFileDescription&, u64, const UserOrKernelBuffer&, size_t) override { return EINVAL; }
+    virtual ErrorOr<void> close() override;
+
+    virtual ErrorOr<NonnullOwnPtr<KString>> pseudo_path(const OpenFileDescription&) const override;
+    virtual StringView class_name() const override { return "EPoll"sv; }
+    virtual bool is_epoll() const override { return true; }
+
+    ErrorOr<void> add(int fd, OpenFileDescription&, epoll_event const&);
+    ErrorOr<void> modify(int fd, OpenFileDescription&, epoll_event const&);
+    ErrorOr<void> remove(int fd);
+
+    // Fills in up to events.size() events for watched files that are ready, and returns how many there were.
+    ErrorOr<size_t> collect_ready_events(Span<epoll_event> events);
+
+private:
+    class Item final
+        : public RefCounted<Item>
+        , public FileBlockerSet::Observer {
+    public:
+        Item(EPoll&, int fd, OpenFileDescription&, epoll_event const&);
+
+        virtual void file_state_changed() override { m_epoll.item_state_changed(*this); }
+
+        // Returns an empty Optional if the watched description has been closed.
+        Optional<u32> ready_events() const;
+
+        EPoll& m_epoll;
+        int m_fd { -1 };
+        // NOTE: Like on other systems, watching a file doesn't keep it open. Once the description
+        //       is gone, the item is dropped the next time it is looked at. We keep the file
+        //       alive until then, as we are still registered with its blocker set.
+        WeakPtr<OpenFileDescription> m_description;
+        NonnullRefPtr<File> m_file;
+
+        // NOTE: These are protected by the EPoll's m_ready_lock.
+        u32 m_events { 0 };
+        u64 m_data { 0 };
+        u32 m_generation { 0 };
+        IntrusiveListNode<Item, RefPtr<Item>> m_ready_list_node;
+    };
+
+    EPoll() = default;
+
+    void item_state_changed(Item&);
+    void attach(Item&);
+    void detach(Item&);
+    void remove_closed_items(Span<NonnullRefPtr<Item>>);
+
+    mutable Mutex m_items_lock { "EPoll" };
+    HashMap<int, NonnullRefPtr<Item>> m_items;
+
+    mutable Spinlock m_ready_lock;
+    IntrusiveList<&Item::m_ready_list_node> m_ready_items;
+};
+
+}
@@ -363,6 +363,114 @@ ErrorOr<void> Ext2FSInode::shrink_triply_indirect_block(BlockBasedFileSystem::Bl
     return {};
 }
 
+ErrorOr<Ext2FSBlockMap> Ext2FSBlockMap::try_create(Span<BlockBasedFileSystem::BlockIndex const> blocks)
+{
+    Ext2FSBlockMap map;
+    TRY(map.try_extend(blocks));
+    return map;
+}
+
+size_t Ext2FSBlockMap::extent_index_of(size_t logical_block) const
+{
+    VERIFY(logical_block < m_block_count);
+    size_t low = 0;
+    size_t high = m_extents.size();
+    while (high - low > 1) {
+        auto middle = low + (high - low) / 2;
+        if (m_extents[middle].first_logical_block <= logical_block)
+            low = middle;
+        else
+            high = middle;
+    }
+    return low;
+}
+
+BlockBasedFileSystem::BlockIndex Ext2FSBlockMap::operator[](size_t logical_block) const
+{
+    return extent_at(logical_block).first_block;
+}
+
+Ext2FSBlockMap::Extent Ext2FSBlockMap::extent_at(size_t logical_block) const
+{
+    auto const& extent = m_extents[extent_index_of(logical_block)];
+    auto offset = logical_block - extent.first_logical_block;
+    return {
+        .first_logical_block = logical_block,
+        .first_block = extent.is_hole() ? 0 : extent.first_block.value() + offset,
+        .length = extent.length - offset,
+    };
+}
+
+BlockBasedFileSystem::BlockIndex Ext2FSBlockMap::next_contiguous_block() const
+{
+    for (size_t i = m_extents.size(); i > 0; --i) {
+        auto const& extent = m_extents[i - 1];
+        if (!extent.is_hole())
+            return extent.first_block.value() + extent.length;
+    }
+    return 0;
+}
+
+ErrorOr<void> Ext2FSBlockMap::try_append(BlockBasedFileSystem::BlockIndex block)
+{
+    if (!m_extents.is_empty()) {
+        auto& last = m_extents.last();
+        bool continues_last_extent = last.is_hole() ? block.value() == 0 : block.value() == last.first_block.value() + last.length;
+        if (continues_last_extent) {
+            ++last.length;
+            ++m_block_count;
+            return {};
+        }
+    }
+    TRY(m_extents.try_append({ .first_logical_block = m_block_count, .first_block = block, .length = 1 }));
+    ++m_block_count;
+    return {};
+}
+
+ErrorOr<void> Ext2FSBlockMap::try_extend(Span<BlockBasedFileSystem::BlockIndex const> blocks)
+{
+    for (auto block : blocks)
+        TRY(try_append(block));
+    return {};
+}
+
+Ext2FSBlockMap::Extent Ext2FSBlockMap::take_last_blocks(size_t max_length)
+{
+    VERIFY(!m_extents.is_empty());
+    auto& last = m_extents.last();
+    auto length = min(max_length, last.length);
+    Extent taken {
+        .first_logical_block = last.first_logical_block + last.length - length,
+        .first_block = last.is_hole() ? 0 : last.first_block.value() + last.length - length,
+        .length = length,
+    };
+    last.length -= length;
+    if (last.length == 0)
+        m_extents.take_last();
+    m_block_count -= length;
+    return taken;
+}
+
+ErrorOr<Vector<BlockBasedFileSystem::BlockIndex>> Ext2FSBlockMap::to_vector() const
+{
+    Vector<BlockBasedFileSystem::BlockIndex> blocks;
+    TRY(blocks.try_ensure_capacity(m_block_count));
+    for (auto const& extent : m_extents) {
+        for (size_t i = 0; i < extent.length; ++i)
+            blocks.unchecked_append(BlockBasedFileSystem::BlockIndex { extent.is_hole() ? 0 : extent.first_block.value() + i });
+    }
+    return blocks;
+}
+
+ErrorOr<void> Ext2FSInode::populate_block_list() const
+{
+    if (!m_block_list.is_empty())
+        return {};
+    auto blocks = TRY(compute_block_list());
+    m_block_list = TRY(Ext2FSBlockMap::try_create(blocks));
+    return {};
+}
+
 ErrorOr<void> Ext2FSInode::flush_block_list()
 {
     MutexLocker locker(m_inode_lock);
@@ -374,30 +482,33 @@ ErrorOr<void> Ext2FSInode::flush_block_list()
         return {};
     }
 
+    // NOTE: The indirect block code below wants the whole list, one block number at a time.
+    auto block_list = TRY(m_block_list.to_vector());
+
     // NOTE: There is a mismatch between i_blocks and blocks.size() since i_blocks includes meta blocks and blocks.size() does not.
     const auto old_block_count = ceil_div(size(), static_cast<u64>(fs().block_size()));
 
     auto old_shape = fs().compute_block_list_shape(old_block_count);
-    const auto new_shape = fs().compute_block_list_shape(m_block_list.size());
+    const auto new_shape = fs().compute_block_list_shape(block_list.size());
 
     Vector<Ext2FS::BlockIndex> new_meta_blocks;
     if (new_shape.meta_blocks > old_shape.meta_blocks) {
         new_meta_blocks = TRY(fs().allocate_blocks(fs().group_index_from_inode(index()), new_shape.meta_blocks - old_shape.meta_blocks));
     }
 
-    m_raw_inode.i_blocks = (m_block_list.size() + new_shape.meta_blocks) * (fs().block_size() / 512);
+    m_raw_inode.i_blocks = (block_list.size() + new_shape.meta_blocks) * (fs().block_size() / 512);
     dbgln_if(EXT2_BLOCKLIST_DEBUG, "Ext2FSInode[{}]::flush_block_list(): Old shape=({};{};{};{}:{}), new shape=({};{};{};{}:{})", identifier(), old_shape.direct_blocks, old_shape.indirect_blocks, old_shape.doubly_indirect_blocks, old_shape.triply_indirect_blocks, old_shape.meta_blocks, new_shape.direct_blocks, new_shape.indirect_blocks, new_shape.doubly_indirect_blocks, new_shape.triply_indirect_blocks, new_shape.meta_blocks);
 
     unsigned output_block_index = 0;
-    unsigned remaining_blocks = m_block_list.size();
+    unsigned remaining_blocks = block_list.size();
 
     // Deal with direct blocks.
     bool inode_dirty = false;
     VERIFY(new_shape.direct_blocks <= EXT2_NDIR_BLOCKS);
     for (unsigned i = 0; i < new_shape.direct_blocks; ++i) {
-        if (BlockBasedFileSystem::BlockIndex(m_raw_inode.i_block[i]) != m_block_list[output_block_index])
+        if (BlockBasedFileSystem::BlockIndex(m_raw_inode.i_block[i]) != block_list[output_block_index])
             inode_dirty = true;
-        m_raw_inode.i_block[i] = m_block_list[output_block_index].value();
+        m_raw_inode.i_block[i] = block_list[output_block_index].value();
         ++output_block_index;
         --remaining_blocks;
     }
@@ -412,9 +523,9 @@ ErrorOr<void> Ext2FSInode::flush_block_list()
     }
     if (inode_dirty) {
         if constexpr (EXT2_DEBUG) {
-            dbgln("Ext2FSInode[{}]::flush_block_list(): Writing {} direct block(s) to i_block array of inode {}", identifier(), min((size_t)EXT2_NDIR_BLOCKS, m_block_list.size()), index());
-            for (size_t i = 0; i < min((size_t)EXT2_NDIR_BLOCKS, m_block_list.size()); ++i)
-                dbgln("   + {}", m_block_list[i]);
+            dbgln("Ext2FSInode[{}]::flush_block_list(): Writing {} direct block(s) to i_block array of inode {}", identifier(), min((size_t)EXT2_NDIR_BLOCKS, block_list.size()), index());
+            for (size_t i = 0; i < min((size_t)EXT2_NDIR_BLOCKS, block_list.size()); ++i)
+                dbgln("   + {}", block_list[i]);
         }
         set_metadata_dirty(true);
     }
@@ -431,7 +542,7 @@ ErrorOr<void> Ext2FSInode::flush_block_list()
                 old_shape.meta_blocks++;
             }
 
-            TRY(write_indirect_block(m_raw_inode.i_block[EXT2_IND_BLOCK], m_block_list.span().slice(output_block_index, new_shape.indirect_blocks)));
+            TRY(write_indirect_block(m_raw_inode.i_block[EXT2_IND_BLOCK], block_list.span().slice(output_block_index, new_shape.indirect_blocks)));
         } else if ((new_shape.indirect_blocks == 0) && (old_shape.indirect_blocks != 0)) {
             dbgln_if(EXT2_BLOCKLIST_DEBUG, "Ext2FSInode[{}]::flush_block_list(): Freeing indirect block: {}", identifier(), m_raw_inode.i_block[EXT2_IND_BLOCK]);
             TRY(fs().set_block_allocation_state(m_raw_inode.i_block[EXT2_IND_BLOCK], false));
@@ -453,7 +564,7 @@ ErrorOr<void> Ext2FSInode::flush_block_list()
                 set_metadata_dirty(true);
                 old_shape.meta_blocks++;
             }
-            TRY(grow_doubly_indirect_block(m_raw_inode.i_block[EXT2_DIND_BLOCK], old_shape.doubly_indirect_blocks, m_block_list.span().slice(output_block_index, new_shape.doubly_indirect_blocks), new_meta_blocks, old_shape.meta_blocks));
+            TRY(grow_doubly_indirect_block(m_raw_inode.i_block[EXT2_DIND_BLOCK], old_shape.doubly_indirect_blocks, block_list.span().slice(output_block_index, new_shape.doubly_indirect_blocks), new_meta_blocks, old_shape.meta_blocks));
         } else {
             TRY(shrink_doubly_indirect_block(m_raw_inode.i_block[EXT2_DIND_BLOCK], old_shape.doubly_indirect_blocks, new_shape.doubly_indirect_blocks, old_shape.meta_blocks));
             if (new_shape.doubly_indirect_blocks == 0)
@@ -474,7 +585,7 @@ ErrorOr<void> Ext2FSInode::flush_block_list()
                 set_metadata_dirty(true);
                 old_shape.meta_blocks++;
             }
-            TRY(grow_triply_indirect_block(m_raw_inode.i_block[EXT2_TIND_BLOCK], old_shape.triply_indirect_blocks, m_block_list.span().slice(output_block_index, new_shape.triply_indirect_blocks), new_meta_blocks, old_shape.meta_blocks));
+            TRY(grow_triply_indirect_block(m_raw_inode.i_block[EXT2_TIND_BLOCK], old_shape.triply_indirect_blocks, block_list.span().slice(output_block_index, new_shape.triply_indirect_blocks), new_meta_blocks, old_shape.meta_blocks));
         } else {
             TRY(shrink_triply_indirect_block(m_raw_inode.i_block[EXT2_TIND_BLOCK], old_shape.triply_indirect_blocks, new_shape.triply_indirect_blocks, old_shape.meta_blocks));
             if (new_shape.triply_indirect_blocks == 0)
@@ -801,6 +912,17 @@ ErrorOr<NonnullRefPtr<Inode>> Ext2FS::get_inode(InodeIdentifier inode) const
 }
 
 ErrorOr<size_t> Ext2FSInode::read_bytes(off_t offset, size_t count, UserOrKernelBuffer& buffer, OpenFileDescription* description) const
+{
+    return read_bytes_impl(offset, count, buffer, !description || !description->is_direct());
+}
+
+ErrorOr<size_t> Ext2FSInode::read_bytes_for_page_cache(off_t offset, size_t count, UserOrKernelBuffer& buffer) const
+{
+    // The page cache holds on to the data itself, so keeping the blocks in the DiskCache as well would only waste memory.
+    return read_bytes_impl(offset, count, buffer, false);
+}
+
+ErrorOr<size_t> Ext2FSInode::read_bytes_impl(off_t offset, size_t count, UserOrKernelBuffer& buffer, bool allow_cache) const
 {
     MutexLocker inode_locker(m_inode_lock);
     VERIFY(offset >= 0);
@@ -819,16 +941,13 @@ ErrorOr<size_t> Ext2FSInode::read_bytes(off_t offset, size_t count, UserOrKernel
         return nread;
     }
 
-    if (m_block_list.is_empty())
-        m_block_list = TRY(compute_block_list());
+    TRY(populate_block_list());
 
     if (m_block_list.is_empty()) {
         dmesgln("Ext2FSInode[{}]::read_bytes(): Empty block list", identifier());
         return EIO;
     }
 
-    bool allow_cache = !description || !description->is_direct();
-
     const int block_size = fs().block_size();
 
     BlockBasedFileSystem::BlockIndex first_block_logical_index = offset / block_size;
@@ -844,10 +963,27 @@ ErrorOr<size_t> Ext2FSInode::read_bytes(off_t offset, size_t count, UserOrKernel
     dbgln_if(EXT2_VERY_DEBUG, "Ext2FSInode[{}]::read_bytes(): Reading up to {} bytes, {} bytes into inode to {}", identifier(), count, offset, buffer.user_or_kernel_ptr());
 
     for (auto bi = first_block_logical_index; remaining_count && bi <= last_block_logical_index; bi = bi.value() + 1) {
-        auto block_index = m_block_list[bi.value()];
+        auto extent = m_block_list.extent_at(bi.value());
+        auto block_index = extent.first_block;
         size_t offset_into_block = (bi == first_block_logical_index) ? offset_into_first_block : 0;
         size_t num_bytes_to_copy = min((size_t)block_size - offset_into_block, (size_t)remaining_count);
         auto buffer_offset = buffer.offset(nread);
+
+        // Whole blocks are read a contiguous run at a time.
+        size_t whole_blocks = offset_into_block == 0 ? min(extent.length, static_cast<size_t>(remaining_count) / block_size) : 0;
+        if (whole_blocks > 1) {
+            if (extent.is_hole()) {
+                TRY(buffer_offset.memset(0, whole_blocks * block_size));
+            } else if (auto result = fs().read_blocks(block_index, whole_blocks, buffer_offset, allow_cache); result.is_error()) {
+                dmesgln("Ext2FSInode[{}]::read_bytes(): Failed to read {} blocks at {} (index {})", identifier(), whole_blocks, block_index.value(), bi);
+                return result.release_error();
+            }
+            remaining_count -= whole_blocks * block_size;
+            nread += whole_blocks * block_size;
+            bi = bi.value() + whole_blocks - 1;
+            continue;
+        }
+
         if (block_index.value() == 0) {
             // This is a hole, act as if it's filled with zeroes.
             TRY(buffer_offset.memset(0, num_bytes_to_copy));
@@ -888,24 +1024,24 @@ ErrorOr<void> Ext2FSInode::resize(u64 new_size)
             return ENOSPC;
     }
 
-    if (m_block_list.is_empty())
-        m_block_list = TRY(compute_block_list());
+    TRY(populate_block_list());
 
     if (blocks_needed_after > blocks_needed_before) {
-        auto blocks = TRY(fs().allocate_blocks(fs().group_index_from_inode(index()), blocks_needed_after - blocks_needed_before));
-        TRY(m_block_list.try_extend(move(blocks)));
+        // Try to continue right where the file currently ends, so it stays contiguous on disk.
+        auto blocks = TRY(fs().allocate_blocks(fs().group_index_from_inode(index()), blocks_needed_after - blocks_needed_before, m_block_list.next_contiguous_block()));
+        TRY(m_block_list.try_extend(blocks));
     } else if (blocks_needed_after < blocks_needed_before) {
         if constexpr (EXT2_VERY_DEBUG) {
-            dbgln("Ext2FSInode[{}]::resize(): Shrinking inode, old block list is {} entries:", identifier(), m_block_list.size());
-            for (auto block_index : m_block_list) {
-                dbgln("    # {}", block_index);
+            dbgln("Ext2FSInode[{}]::resize(): Shrinking inode, old block list is {} extents:", identifier(), m_block_list.extents().size());
+            for (auto const& extent : m_block_list.extents()) {
+                dbgln("    # {} (+{})", extent.first_block, extent.length);
             }
         }
         while (m_block_list.size() != blocks_needed_after) {
-            auto block_index = m_block_list.take_last();
-            if (block_index.value()) {
-                if (auto result = fs().set_block_allocation_state(block_index, false); result.is_error()) {
-                    dbgln("Ext2FSInode[{}]::resize(): Failed to free block {}: {}", identifier(), block_index, result.error());
+            auto extent = m_block_list.take_last_blocks(m_block_list.size() - blocks_needed_after);
+            if (!extent.is_hole()) {
+                if (auto result = fs().set_block_range_allocation_state(extent.first_block, extent.length, false); result.is_error()) {
+                    dbgln("Ext2FSInode[{}]::resize(): Failed to free blocks {} (+{}): {}", identifier(), extent.first_block, extent.length, result.error());
                     return result;
                 }
             }
@@ -920,6 +1056,9 @@ ErrorOr<void> Ext2FSInode::resize(u64 new_size)
 
     set_metadata_dirty(true);
 
+    if (new_size < old_size)
+        truncate_page_cache(new_size);
+
     if (new_size > old_size) {
         // If we're growing the inode, make sure we zero out all the new space.
         // FIXME: There are definitely more efficient ways to achieve this.
@@ -967,8 +1106,7 @@ ErrorOr<size_t> Ext2FSInode::write_bytes(off_t offset, size_t count, const UserO
 
     TRY(resize(new_size));
 
-    if (m_block_list.is_empty())
-        m_block_list = TRY(compute_block_list());
+    TRY(populate_block_list());
 
     if (m_block_list.is_empty()) {
         dbgln("Ext2FSInode[{}]::write_bytes(): Empty block list", identifier());
@@ -990,15 +1128,32 @@ ErrorOr<size_t> Ext2FSInode::write_bytes(off_t offset, size_t count, const UserO
     for (auto bi = first_block_logical_index; remaining_count && bi <= last_block_logical_index; bi = bi.value() + 1) {
         size_t offset_into_block = (bi == first_block_logical_index) ? offset_into_first_block : 0;
         size_t num_bytes_to_copy = min((size_t)block_size - offset_into_block, (size_t)remaining_count);
-        dbgln_if(EXT2_DEBUG, "Ext2FSInode[{}]::write_bytes(): Writing block {} (offset_into_block: {})", identifier(), m_block_list[bi.value()], offset_into_block);
-        if (auto result = fs().write_block(m_block_list[bi.value()], data.offset(nwritten), num_bytes_to_copy, offset_into_block, allow_cache); result.is_error()) {
-            dbgln("Ext2FSInode[{}]::write_bytes(): Failed to write block {} (index {})", identifier(), m_block_list[bi.value()], bi);
+
+        // Whole blocks are written a contiguous run at a time.
+        auto extent = m_block_list.extent_at(bi.value());
+        size_t whole_blocks = offset_into_block == 0 && !extent.is_hole() ? min(extent.length, static_cast<size_t>(remaining_count) / block_size) : 0;
+        if (whole_blocks > 1) {
+            dbgln_if(EXT2_DEBUG, "Ext2FSInode[{}]::write_bytes(): Writing {} blocks at {}", identifier(), whole_blocks, extent.first_block);
+            if (auto result = fs().write_blocks(extent.first_block, whole_blocks, data.offset(nwritten), allow_cache); result.is_error()) {
+                dbgln("Ext2FSInode[{}]::write_bytes(): Failed to write {} blocks at {} (index {})", identifier(), whole_blocks, extent.first_block, bi);
+                return result.release_error();
+            }
+            remaining_count -= whole_blocks * block_size;
+            nwritten += whole_blocks * block_size;
+            bi = bi.value() + whole_blocks - 1;
+            continue;
+        }
+
+        dbgln_if(EXT2_DEBUG, "Ext2FSInode[{}]::write_bytes(): Writing block {} (offset_into_block: {})", identifier(), extent.first_block, offset_into_block);
+        if (auto result = fs().write_block(extent.first_block, data.offset(nwritten), num_bytes_to_copy, offset_into_block, allow_cache); result.is_error()) {
+            dbgln("Ext2FSInode[{}]::write_bytes(): Failed to write block {} (index {})", identifier(), extent.first_block, bi);
             return result.release_error();
         }
         remaining_count -= num_bytes_to_copy;
         nwritten += num_bytes_to_copy;
     }
 
+    TRY(update_page_cache(offset, nwritten, data));
     did_modify_contents();
 
     dbgln_if(EXT2_VERY_DEBUG, "Ext2FSInode[{}]::write_bytes(): After write, i_size={}, i_blocks={} ({} blocks in list)", identifier(), size(), m_raw_inode.i_blocks, m_block_list.size());
@@ -1225,9 +1380,34 @@ ErrorOr<void> Ext2FS::write_ext2_inode(InodeIndex inode, ext2_inode const& e2ino
     return write_block(block_index, buffer, inode_size(), offset);
 }
 
-auto Ext2FS::allocate_blocks(GroupIndex preferred_group_index, size_t count) -> ErrorOr<Vector<BlockIndex>>
+// Counts the unset bits starting exactly at the given index, up to max_length.
+// NOTE: BitmapView::find_next_range_of_unset_bits() won't do here, since it may move the start of the range back.
+static size_t count_unset_bits_at(BitmapView const& bitmap, size_t index, size_t max_length)
+{
+    auto start = index;
+    auto end = min(bitmap.size(), index + max_length);
+
+    // Go bit by bit up to the next byte boundary, then let BitmapView skip over the free bytes.
+    for (; index < end && index % 8 != 0; ++index) {
+        if (bitmap.get(index))
+            return index - start;
+    }
+    if (auto whole_bytes = (end - index) / 8; whole_bytes > 0) {
+        BitmapView whole_bytes_bitmap { const_cast<u8*>(bitmap.data()) + index / 8, whole_bytes * 8 };
+        if (auto first_set_bit = whole_bytes_bitmap.find_first_set(); first_set_bit.has_value())
+            return index + first_set_bit.value() - start;
+        index += whole_bytes * 8;
+    }
+    for (; index < end; ++index) {
+        if (bitmap.get(index))
+            break;
+    }
+    return index - start;
+}
+
+auto Ext2FS::allocate_blocks(GroupIndex preferred_group_index, size_t count, BlockIndex goal) -> ErrorOr<Vector<BlockIndex>>
 {
-    dbgln_if(EXT2_DEBUG, "Ext2FS: allocate_blocks(preferred group: {}, count {})", preferred_group_index, count);
+    dbgln_if(EXT2_DEBUG, "Ext2FS: allocate_blocks(preferred group: {}, count {}, goal {})", preferred_group_index, count, goal);
     if (count == 0)
         return Vector<BlockIndex> {};
 
@@ -1235,6 +1415,32 @@ auto Ext2FS::allocate_blocks(GroupIndex preferred_group_index, size_t count) ->
     TRY(blocks.try_ensure_capacity(count));
 
     MutexLocker locker(m_lock);
+
+    auto allocate_range = [&](GroupIndex group_index, size_t first_bit_index, size_t length) -> ErrorOr<void> {
+        auto const& bgd = group_descriptor(group_index);
+        BlockIndex first_block_in_group = (group_index.value() - 1) * blocks_per_group() + first_block_index().value();
+        dbgln_if(EXT2_DEBUG, "Ext2FS: allocating free region of size: {} [{}]", length, group_index);
+        TRY(update_bitmap_block_range(bgd.bg_block_bitmap, first_bit_index, length, true, m_super_block.s_free_blocks_count, const_cast<ext2_group_desc&>(bgd).bg_free_blocks_count));
+        for (size_t i = 0; i < length; ++i)
+            blocks.unchecked_append(BlockIndex { first_block_in_group.value() + first_bit_index + i });
+        return {};
+    };
+
+    // If the caller knows where the blocks would ideally go (usually right after the end of
+    // the file), take as many free blocks from there as we can, so the file stays contiguous.
+    if (goal.value() >= first_block_index().value() && goal.value() < super_block().s_blocks_count) {
+        auto goal_group_index = group_index_from_block_index(goal);
+        if (group_descriptor(goal_group_index).bg_free_blocks_count) {
+            auto* cached_bitmap = TRY(get_bitmap_block(group_descriptor(goal_group_index).bg_block_bitmap));
+            int blocks_in_group = min(blocks_per_group(), super_block().s_blocks_count);
+            auto block_bitmap = cached_bitmap->bitmap(blocks_in_group);
+            size_t goal_bit_index = goal.value() - first_block_index().value() - (goal_group_index.value() - 1) * blocks_per_group();
+            size_t free_region_size = goal_bit_index < block_bitmap.size() ? count_unset_bits_at(block_bitmap, goal_bit_index, count) : 0;
+            if (free_region_size)
+                TRY(allocate_range(goal_group_index, goal_bit_index, free_region_size));
+        }
+    }
+
     auto group_index = preferred_group_index;
 
     if (!group_descriptor(preferred_group_index).bg_free_blocks_count) {
@@ -1264,17 +1470,15 @@ auto Ext2FS::allocate_blocks(GroupIndex preferred_group_index, size_t count) ->
         int blocks_in_group = min(blocks_per_group(), super_block().s_blocks_count);
         auto block_bitmap = cached_bitmap->bitmap(blocks_in_group);
 
-        BlockIndex first_block_in_group = (group_index.value() - 1) * blocks_per_group() + first_block_index().value();
-        size_t free_region_size = 0;
-        auto first_unset_bit_index = block_bitmap.find_longest_range_of_unset_bits(count - blocks.size(), free_region_size);
+        // Prefer the first free run that fits the whole remaining request, and only
+        // settle for the longest run in the group when there is no such run.
+        size_t remaining_count = count - blocks.size();
+        size_t free_region_size = remaining_count;
+        auto first_unset_bit_index = block_bitmap.find_first_fit(remaining_count);
+        if (!first_unset_bit_index.has_value())
+            first_unset_bit_index = block_bitmap.find_longest_range_of_unset_bits(remaining_count, free_region_size);
         VERIFY(first_unset_bit_index.has_value());
-        dbgln_if(EXT2_DEBUG, "Ext2FS: allocating free region of size: {} [{}]", free_region_size, group_index);
-        for (size_t i = 0; i < free_region_size; ++i) {
-            BlockIndex block_index = (first_unset_bit_index.value() + i) + first_block_in_group.value();
-            TRY(set_block_allocation_state(block_index, true));
-            blocks.unchecked_append(block_index);
-            dbgln_if(EXT2_DEBUG, "  allocated > {}", block_index);
-        }
+        TRY(allocate_range(group_index, first_unset_bit_index.value(), free_region_size));
     }
 
     VERIFY(blocks.size() == count);
@@ -1370,22 +1574,27 @@ ErrorOr<bool> Ext2FS::get_inode_allocation_state(InodeIndex index) const
 }
 
 ErrorOr<void> Ext2FS::update_bitmap_block(BlockIndex bitmap_block, size_t bit_index, bool new_state, u32& super_block_counter, u16& group_descriptor_counter)
+{
+    return update_bitmap_block_range(bitmap_block, bit_index, 1, new_state, super_block_counter, group_descriptor_counter);
+}
+
+ErrorOr<void> Ext2FS::update_bitmap_block_range(BlockIndex bitmap_block, size_t first_bit_index, size_t count, bool new_state, u32& super_block_counter, u16& group_descriptor_counter)
 {
     auto* cached_bitmap = TRY(get_bitmap_block(bitmap_block));
-    bool current_state = cached_bitmap->bitmap(blocks_per_group()).get(bit_index);
-    if (current_state == new_state) {
-        dbgln("Ext2FS: Bit {} in bitmap block {} had unexpected state {}", bit_index, bitmap_block, current_state);
+    auto bitmap = cached_bitmap->bitmap(blocks_per_group());
+    if (auto unexpected_count = bitmap.count_in_range(first_bit_index, count, new_state); unexpected_count != 0) {
+        dbgln("Ext2FS: {} of bits {}-{} in bitmap block {} had unexpected state {}", unexpected_count, first_bit_index, first_bit_index + count - 1, bitmap_block, new_state);
         return EIO;
     }
-    cached_bitmap->bitmap(blocks_per_group()).set(bit_index, new_state);
+    bitmap.set_range(first_bit_index, count, new_state);
     cached_bitmap->dirty = true;
 
     if (new_state) {
-        --super_block_counter;
-        --group_descriptor_counter;
+        super_block_counter -= count;
+        group_descriptor_counter -= count;
     } else {
-        ++super_block_counter;
-        ++group_descriptor_counter;
+        super_block_counter += count;
+        group_descriptor_counter += count;
     }
 
     m_super_block_dirty = true;
@@ -1439,6 +1648,26 @@ ErrorOr<void> Ext2FS::set_block_allocation_state(BlockIndex block_index, bool ne
     return update_bitmap_block(bgd.bg_block_bitmap, bit_index, new_state, m_super_block.s_free_blocks_count, bgd.bg_free_blocks_count);
 }
 
+ErrorOr<void> Ext2FS::set_block_range_allocation_state(BlockIndex first_block, size_t count, bool new_state)
+{
+    VERIFY(first_block != 0);
+    MutexLocker locker(m_lock);
+
+    // NOTE: A run of blocks may cross into the next group, in which case we have to update several bitmaps.
+    while (count) {
+        auto group_index = group_index_from_block_index(first_block);
+        size_t bit_index = (first_block.value() - first_block_index().value()) - ((group_index.value() - 1) * blocks_per_group());
+        auto count_in_group = min(count, static_cast<size_t>(blocks_per_group() - bit_index));
+        auto& bgd = const_cast<ext2_group_desc&>(group_descriptor(group_index));
+
+        dbgln_if(EXT2_DEBUG, "Ext2FS: Blocks {}-{} state -> {} (in bitmap block {})", first_block, first_block.value() + count_in_group - 1, new_state, bgd.bg_block_bitmap);
+        TRY(update_bitmap_block_range(bgd.bg_block_bitmap, bit_index, count_in_group, new_state, m_super_block.s_free_blocks_count, bgd.bg_free_blocks_count));
+        first_block = first_block.value() + count_in_group;
+        count -= count_in_group;
+    }
+    return {};
+}
+
 ErrorOr<NonnullRefPtr<Inode>> Ext2FS::create_directory(Ext2FSInode& parent_inode, StringView name, mode_t mode, UserID uid, GroupID gid)
 {
     MutexLocker locker(m_lock);
@@ -1644,8 +1873,7 @@ ErrorOr<int> Ext2FSInode::get_block_address(int index)
 {
     MutexLocker locker(m_inode_lock);
 
-    if (m_block_list.is_empty())
-        m_block_list = TRY(compute_block_list());
+    TRY(populate_block_list());
 
     if (index < 0 || (size_t)index >= m_block_list.size())
         return 0;
@@ -23,6 +23,49 @@ namespace Kernel {
 class Ext2FS;
 struct Ext2FSDirectoryEntry;
 
+// Maps the logical blocks of an inode to the filesystem blocks that back them.
+// Runs of physically contiguous blocks (and runs of holes) are kept as a single extent,
+// so an unfragmented file needs only a handful of entries, and whole runs can be read
+// or written with a single request.
+class Ext2FSBlockMap {
+public:
+    struct Extent {
+        u64 first_logical_block { 0 };
+        BlockBasedFileSystem::BlockIndex first_block { 0 };
+        size_t length { 0 };
+
+        bool is_hole() const { return first_block.value() == 0; }
+    };
+
+    static ErrorOr<Ext2FSBlockMap> try_create(Span<BlockBasedFileSystem::BlockIndex const>);
+
+    bool is_empty() const { return m_block_count == 0; }
+    size_t size() const { return m_block_count; }
+    Vector<Extent> const& extents() const { return m_extents; }
+
+    BlockBasedFileSystem::BlockIndex operator[](size_t logical_block) const;
+
+    // Returns the remainder of the extent containing the given logical block, starting at that block.
+    Extent extent_at(size_t logical_block) const;
+
+    // Returns the block following the last allocated block, which is where the file would ideally grow.
+    BlockBasedFileSystem::BlockIndex next_contiguous_block() const;
+
+    ErrorOr<void> try_append(BlockBasedFileSystem::BlockIndex);
+    ErrorOr<void> try_extend(Span<BlockBasedFileSystem::BlockIndex const>);
+
+    // Removes up to max_length blocks from the end of the map, all of them from the last extent.
+    Extent take_last_blocks(size_t max_length);
+
+    ErrorOr<Vector<BlockBasedFileSystem::BlockIndex>> to_vector() const;
+
+private:
+    size_t extent_index_of(size_t logical_block) const;
+
+    Vector<Extent> m_extents;
+    size_t m_block_count { 0 };
+};
+
 class Ext2FSInode final : public Inode {
     friend class Ext2FS;
 
@@ -53,7 +96,9 @@ private:
     virtual ErrorOr<void> chown(UserID, GroupID) override;
     virtual ErrorOr<void> truncate(u64) override;
     virtual ErrorOr<int> get_block_address(int) override;
+    virtual ErrorOr<size_t> read_bytes_for_page_cache(off_t, size_t, UserOrKernelBuffer&) const override;
 
+    ErrorOr<size_t> read_bytes_impl(off_t, size_t, UserOrKernelBuffer&, bool allow_cache) const;
     ErrorOr<void> write_directory(Vector<Ext2FSDirectoryEntry>&);
     ErrorOr<void> populate_lookup_cache() const;
     ErrorOr<void> resize(u64);
@@ -63,6 +108,7 @@ private:
     ErrorOr<void> grow_triply_indirect_block(BlockBasedFileSystem::BlockIndex, size_t, Span<BlockBasedFileSystem::BlockIndex>, Vector<BlockBasedFileSystem::BlockIndex>&, unsigned&);
     ErrorOr<void> shrink_triply_indirect_block(BlockBasedFileSystem::BlockIndex, size_t, size_t, unsigned&);
     ErrorOr<void> flush_block_list();
+    ErrorOr<void> populate_block_list() const;
     ErrorOr<Vector<BlockBasedFileSystem::BlockIndex>> compute_block_list() const;
     ErrorOr<Vector<BlockBasedFileSystem::BlockIndex>> compute_block_list_with_meta_blocks() const;
     ErrorOr<Vector<BlockBasedFileSystem::BlockIndex>> compute_block_list_impl(bool include_block_list_blocks) const;
@@ -72,7 +118,7 @@ private:
     const Ext2FS& fs() const;
     Ext2FSInode(Ext2FS&, InodeIndex);
 
-    mutable Vector<BlockBasedFileSystem::BlockIndex> m_block_list;
+    mutable Ext2FSBlockMap m_block_list;
     mutable HashMap<NonnullOwnPtr<KString>, InodeIndex> m_lookup_cache;
     ext2_inode m_raw_inode {};
 };
@@ -133,13 +179,14 @@ private:
 
     BlockIndex first_block_index() const;
     ErrorOr<InodeIndex> allocate_inode(GroupIndex preferred_group = 0);
-    ErrorOr<Vector<BlockIndex>> allocate_blocks(GroupIndex preferred_group_index, size_t count);
+    ErrorOr<Vector<BlockIndex>> allocate_blocks(GroupIndex preferred_group_index, size_t count, BlockIndex goal = 0);
     GroupIndex group_index_from_inode(InodeIndex) const;
     GroupIndex group_index_from_block_index(BlockIndex) const;
 
     ErrorOr<bool> get_inode_allocation_state(InodeIndex) const;
     ErrorOr<void> set_inode_allocation_state(InodeIndex, bool);
     ErrorOr<void> set_block_allocation_state(BlockIndex, bool);
+    ErrorOr<void> set_block_range_allocation_state(BlockIndex first_block, size_t count, bool);
 
     void uncache_inode(InodeIndex);
     ErrorOr<void> free_inode(Ext2FSInode&);
@@ -178,6 +225,7 @@ private:
 
     ErrorOr<CachedBitmap*> get_bitmap_block(BlockIndex);
     ErrorOr<void> update_bitmap_block(BlockIndex bitmap_block, size_t bit_index, bool new_state, u32& super_block_counter, u16& group_descriptor_counter);
+    ErrorOr<void> update_bitmap_block_range(BlockIndex bitmap_block, size_t first_bit_index, size_t count, bool new_state, u32& super_block_counter, u16& group_descriptor_counter);
 
     Vector<OwnPtr<CachedBitmap>> m_cached_bitmaps;
     RefPtr<Ext2FSInode> m_root_inode;
@@ -0,0 +1,580 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/NumericLimits.h>
+#include <AK/StdLibExtras.h>
+#include <Kernel/FileSystem/IORing.h>
+#include <Kernel/FileSystem/OpenFileDescription.h>
+#include <Kernel/Memory/MemoryManager.h>
+#include <Kernel/Net/Socket.h>
+#include <Kernel/Process.h>
+#include <Kernel/UnixTypes.h>
+#include <Kernel/WorkQueue.h>
+
+namespace Kernel {
+
+// Keep the submission queue on its own cache line, away from the indices.
+static constexpr u32 submission_queue_offset = 64;
+static_assert(sizeof(io_ring_header) <= submission_queue_offset);
+
+// File system reads and writes go through a kernel buffer, so we don't move more than this at once.
+// Like read() and write(), they report how much they actually transferred.
+static constexpr size_t max_file_request_size = 1 * MiB;
+
+ErrorOr<NonnullRefPtr<IORing>> IORing::try_create(Process& process, u32 entry_count)
+{
+    if (entry_count == 0 || entry_count > IO_RING_MAX_ENTRIES || !is_power_of_two(entry_count))
+        return EINVAL;
+
+    io_ring_params params {};
+    params.sq_entries = entry_count;
+    // NOTE: Parked requests hold on to their slot in the completion queue, so we give it some more room.
+    params.cq_entries = entry_count * 2;
+    params.sqes_offset = submission_queue_offset;
+    params.cqes_offset = params.sqes_offset + params.sq_entries * sizeof(io_ring_sqe);
+    params.mmap_size = TRY(Memory::page_round_up(params.cqes_offset + params.cq_entries * sizeof(io_ring_cqe)));
+
+    auto vmobject = TRY(Memory::AnonymousVMObject::try_create_with_size(params.mmap_size, AllocationStrategy::AllocateNow));
+    auto kernel_region = TRY(MM.allocate_kernel_region_with_vmobject(*vmobject, params.mmap_size, "IORing"sv, Memory::Region::Access::ReadWrite));
+    return adopt_nonnull_ref_or_enomem(new (nothrow) IORing(process, move(vmobject), move(kernel_region), params));
+}
+
+IORing::IORing(Process& process, NonnullRefPtr<Memory::AnonymousVMObject> vmobject, NonnullOwnPtr<Memory::Region> kernel_region, io_ring_params const& params)
+    : m_owner_pid(process.pid())
+    , m_vmobject(move(vmobject))
+    , m_kernel_region(move(kernel_region))
+    , m_params(params)
+    , m_header(reinterpret_cast<io_ring_header*>(m_kernel_region->vaddr().as_ptr()))
+    , m_submission_queue(reinterpret_cast<io_ring_sqe*>(m_kernel_region->vaddr().offset(params.sqes_offset).as_ptr()))
+    , m_completion_queue(reinterpret_cast<io_ring_cqe*>(m_kernel_region->vaddr().offset(params.cqes_offset).as_ptr()))
+{
+}
+
+IORing::~IORing()
+{
+    (void)close();
+}
+
+bool IORing::can_read(const OpenFileDescription&, u64) const
+{
+    return completions_available() > 0 || has_requests_to_process();
+}
+
+bool IORing::has_requests_to_process() const
+{
+    SpinlockLocker lock(m_pending_lock);
+    return !m_woken_requests.is_empty() || !m_finished_file_requests.is_empty();
+}
+
+bool IORing::is_owned_by(Process const& process) const
+{
+    return process.pid() == m_owner_pid;
+}
+
+ErrorOr<Memory::Region*> IORing::mmap(Process& process, OpenFileDescription&, Memory::VirtualRange const& range, u64 offset, int prot, bool shared)
+{
+    if (!is_owned_by(process))
+        return EPERM;
+    if (offset != 0 || range.size() != m_vmobject->size() || !shared)
+        return EINVAL;
+    return process.address_space().allocate_region_with_vmobject(range, m_vmobject, 0, "IORing"sv, prot, true);
+}
+
+ErrorOr<void> IORing::close()
+{
+    MutexLocker locker(m_lock);
+    // NOTE: Nobody is going to look at the results anymore, so we just drop whatever is still parked or finished.
+    //       File system requests that are still running drop themselves when they are done.
+    for (;;) {
+        RefPtr<FileRequest> request;
+        {
+            SpinlockLocker lock(m_pending_lock);
+            m_is_closed = true;
+            if (m_finished_file_requests.is_empty())
+                break;
+            request = m_finished_file_requests.take_first();
+        }
+    }
+    for (;;) {
+        RefPtr<PendingRequest> request;
+        {
+            SpinlockLocker lock(m_pending_lock);
+            if (!m_waiting_requests.is_empty())
+                request = m_waiting_requests.take_first();
+            else if (!m_woken_requests.is_empty())
+                request = m_woken_requests.take_first();
+            else
+                break;
+        }
+        detach(*request);
+    }
+    return {};
+}
+
+ErrorOr<NonnullOwnPtr<KString>> IORing::pseudo_path(const OpenFileDescription&) const
+{
+    return KString::formatted("IORing:({})", m_params.sq_entries);
+}
+
+IORing::PendingRequest::PendingRequest(IORing& ring, io_ring_sqe const& sqe, NonnullRefPtr<OpenFileDescription> description)
+    : m_ring(ring)
+    , m_sqe(sqe)
+    , m_description(move(description))
+{
+}
+
+IORing::FileRequest::FileRequest(IORing& ring, io_ring_sqe const& sqe, NonnullRefPtr<OpenFileDescription> description)
+    : m_ring(ring)
+    , m_sqe(sqe)
+    , m_description(move(description))
+{
+}
+
+size_t IORing::completions_available() const
+{
+    // NOTE: The process owns the head, so it may be garbage. We never report more completions than fit in the queue.
+    auto head = AK::atomic_load(&m_header->cq_head, AK::memory_order_acquire);
+    return min(m_cq_tail.load(AK::memory_order_acquire) - head, m_params.cq_entries);
+}
+
+bool IORing::has_room_for_completion() const
+{
+    VERIFY(m_lock.is_locked());
+    auto head = AK::atomic_load(&m_header->cq_head, AK::memory_order_acquire);
+    auto used = m_cq_tail.load(AK::memory_order_relaxed) - head;
+    SpinlockLocker lock(m_pending_lock);
+    return used <= m_params.cq_entries && used + m_pending_request_count < m_params.cq_entries;
+}
+
+void IORing::post_completion(u64 user_data, ErrorOr<size_t> const& result)
+{
+    VERIFY(m_lock.is_locked());
+    auto tail = m_cq_tail.load(AK::memory_order_relaxed);
+    auto& cqe = m_completion_queue[tail & (m_params.cq_entries - 1)];
+    cqe.user_data = user_data;
+    cqe.result = result.is_error() ? -result.error().code() : static_cast<i32>(result.value());
+    cqe.reserved = 0;
+    m_cq_tail.store(tail + 1, AK::memory_order_release);
+    AK::atomic_store(&m_header->cq_tail, tail + 1, AK::memory_order_release);
+}
+
+void IORing::notify_completions()
+{
+    m_completion_wait_queue.wake_all();
+    evaluate_block_conditions();
+}
+
+ErrorOr<size_t> IORing::submit(size_t count)
+{
+    MutexLocker locker(m_lock);
+
+    // NOTE: The process owns the tail, so it may be garbage. We never take more entries than fit in the queue.
+    auto tail = AK::atomic_load(&m_header->sq_tail, AK::memory_order_acquire);
+    count = min(count, static_cast<size_t>(min(tail - m_sq_head, m_params.sq_entries)));
+
+    size_t submitted = 0;
+    auto completions_before = m_cq_tail.load(AK::memory_order_relaxed);
+    while (submitted < count && has_room_for_completion()) {
+        // NOTE: The process can change the entry under our feet, so we only look at our own copy of it.
+        io_ring_sqe sqe;
+        __builtin_memcpy(&sqe, &m_submission_queue[m_sq_head & (m_params.sq_entries - 1)], sizeof(sqe));
+        ++m_sq_head;
+        AK::atomic_store(&m_header->sq_head, m_sq_head, AK::memory_order_release);
+        ++submitted;
+        submit_one(sqe);
+    }
+    if (m_cq_tail.load(AK::memory_order_relaxed) != completions_before)
+        notify_completions();
+    return submitted;
+}
+
+void IORing::submit_one(io_ring_sqe const& sqe)
+{
+    if (sqe.opcode == IO_RING_OP_NOP) {
+        post_completion(sqe.user_data, 0);
+        return;
+    }
+
+    auto description_or_error = Process::current().open_file_description(sqe.fd);
+    if (description_or_error.is_error()) {
+        post_completion(sqe.user_data, description_or_error.release_error());
+        return;
+    }
+    auto description = description_or_error.release_value();
+    // NOTE: Parking a request on another ring would keep both of them alive forever.
+    if (description->file().is_io_ring()) {
+        post_completion(sqe.user_data, EINVAL);
+        return;
+    }
+
+    if (should_execute_in_background(sqe, *description)) {
+        start_file_request(sqe, move(description));
+        return;
+    }
+
+    auto result = execute(sqe, *description);
+    if (!result.is_error() || result.error().code() != EAGAIN) {
+        post_completion(sqe.user_data, result);
+        return;
+    }
+
+    auto request_or_error = adopt_nonnull_ref_or_enomem(new (nothrow) PendingRequest(*this, sqe, description));
+    if (request_or_error.is_error()) {
+        post_completion(sqe.user_data, request_or_error.release_error());
+        return;
+    }
+    auto request = request_or_error.release_value();
+    {
+        SpinlockLocker lock(m_pending_lock);
+        ++m_pending_request_count;
+    }
+    description->file().blocker_set().add_observer(*request);
+
+    // NOTE: The file may have changed state before we started observing it, so we have to look again.
+    u32 generation;
+    {
+        SpinlockLocker lock(m_pending_lock);
+        generation = request->m_generation;
+    }
+    result = execute(sqe, *description);
+    if (!result.is_error() || result.error().code() != EAGAIN) {
+        detach(*request);
+        post_completion(sqe.user_data, result);
+        return;
+    }
+    park(*request, generation);
+}
+
+bool IORing::should_execute_in_background(io_ring_sqe const& sqe, OpenFileDescription const& description)
+{
+    if (!description.file().is_inode())
+        return false;
+    return sqe.opcode == IO_RING_OP_READ || sqe.opcode == IO_RING_OP_WRITE || sqe.opcode == IO_RING_OP_FSYNC;
+}
+
+void IORing::start_file_request(io_ring_sqe const& sqe, NonnullRefPtr<OpenFileDescription> description)
+{
+    auto request_or_error = adopt_nonnull_ref_or_enomem(new (nothrow) FileRequest(*this, sqe, move(description)));
+    if (request_or_error.is_error()) {
+        post_completion(sqe.user_data, request_or_error.release_error());
+        return;
+    }
+    auto request = request_or_error.release_value();
+    if (auto result = prepare_file_request(*request); result.is_error()) {
+        post_completion(sqe.user_data, result.release_error());
+        return;
+    }
+
+    {
+        SpinlockLocker lock(m_pending_lock);
+        ++m_pending_request_count;
+    }
+    g_fs_work->queue([request = move(request)] {
+        execute_file_request(*request);
+        request->m_ring->file_request_finished(*request);
+    });
+}
+
+ErrorOr<void> IORing::prepare_file_request(FileRequest& request)
+{
+    auto const& sqe = request.m_sqe;
+    auto& description = *request.m_description;
+    if (sqe.length > static_cast<u32>(NumericLimits<i32>::max()))
+        return EINVAL;
+    if (sqe.offset != IO_RING_CURRENT_OFFSET && sqe.offset > static_cast<u64>(NumericLimits<off_t>::max()))
+        return EINVAL;
+
+    request.m_length = min(static_cast<size_t>(sqe.length), max_file_request_size);
+    auto* user_buffer = reinterpret_cast<u8*>(static_cast<FlatPtr>(sqe.addr));
+    switch (sqe.opcode) {
+    case IO_RING_OP_READ:
+        if (!description.is_readable())
+            return EBADF;
+        if (description.is_directory())
+            return EISDIR;
+        // NOTE: We check the buffer now, so that a bad one doesn't cost the process a disk read.
+        TRY(UserOrKernelBuffer::for_user_buffer(user_buffer, request.m_length));
+        if (request.m_length > 0)
+            request.m_buffer = TRY(KBuffer::try_create_with_size(request.m_length, Memory::Region::Access::ReadWrite, "IORing read"sv));
+        return {};
+    case IO_RING_OP_WRITE:
+        if (!description.is_writable())
+            return EBADF;
+        if (request.m_length > 0) {
+            request.m_buffer = TRY(KBuffer::try_create_with_size(request.m_length, Memory::Region::Access::ReadWrite, "IORing write"sv));
+            TRY(copy_from_user(request.m_buffer->data(), user_buffer, request.m_length));
+        }
+        return {};
+    case IO_RING_OP_FSYNC:
+        return {};
+    default:
+        VERIFY_NOT_REACHED();
+    }
+}
+
+void IORing::execute_file_request(FileRequest& request)
+{
+    auto const& sqe = request.m_sqe;
+    auto& description = *request.m_description;
+    bool has_offset = sqe.offset != IO_RING_CURRENT_OFFSET;
+    auto buffer = UserOrKernelBuffer::for_kernel_buffer(request.m_buffer ? request.m_buffer->data() : nullptr);
+
+    request.m_result = [&]() -> ErrorOr<size_t> {
+        switch (sqe.opcode) {
+        case IO_RING_OP_READ:
+            if (has_offset)
+                return description.read(buffer, sqe.offset, request.m_length);
+            return description.read(buffer, request.m_length);
+        case IO_RING_OP_WRITE:
+            if (has_offset)
+                return description.write(sqe.offset, buffer, request.m_length);
+            if (description.should_append())
+                TRY(description.seek(0, SEEK_END));
+            return description.write(buffer, request.m_length);
+        case IO_RING_OP_FSYNC:
+            TRY(description.sync());
+            return 0;
+        default:
+            VERIFY_NOT_REACHED();
+        }
+    }();
+}
+
+void IORing::file_request_finished(FileRequest& request)
+{
+    {
+        SpinlockLocker lock(m_pending_lock);
+        if (m_is_closed)
+            return;
+        m_finished_file_requests.append(request);
+    }
+    notify_completions();
+}
+
+void IORing::complete_finished_file_requests()
+{
+    MutexLocker locker(m_lock);
+
+    auto completions_before = m_cq_tail.load(AK::memory_order_relaxed);
+    for (;;) {
+        RefPtr<FileRequest> request;
+        {
+            SpinlockLocker lock(m_pending_lock);
+            if (m_finished_file_requests.is_empty())
+                break;
+            request = m_finished_file_requests.take_first();
+            --m_pending_request_count;
+        }
+
+        auto result = move(request->m_result);
+        if (!result.is_error() && request->m_sqe.opcode == IO_RING_OP_READ && result.value() > 0) {
+            auto* user_buffer = reinterpret_cast<u8*>(static_cast<FlatPtr>(request->m_sqe.addr));
+            if (auto copy_result = copy_to_user(user_buffer, request->m_buffer->data(), result.value()); copy_result.is_error())
+                result = copy_result.release_error();
+        }
+        post_completion(request->m_sqe.user_data, result);
+    }
+    if (m_cq_tail.load(AK::memory_order_relaxed) != completions_before)
+        notify_completions();
+}
+
+void IORing::retry_woken_requests()
+{
+    MutexLocker locker(m_lock);
+
+    // NOTE: Requests that are still stuck after this may be woken again right away, so we only look at each one once.
+    size_t count;
+    {
+        SpinlockLocker lock(m_pending_lock);
+        count = m_woken_requests.size_slow();
+    }
+
+    auto completions_before = m_cq_tail.load(AK::memory_order_relaxed);
+    for (size_t i = 0; i < count; ++i) {
+        RefPtr<PendingRequest> request;
+        u32 generation;
+        {
+            SpinlockLocker lock(m_pending_lock);
+            if (m_woken_requests.is_empty())
+                break;
+            request = m_woken_requests.take_first();
+            request->m_is_woken = false;
+            generation = request->m_generation;
+        }
+
+        auto result = execute(request->m_sqe, *request->m_description);
+        if (result.is_error() && result.error().code() == EAGAIN) {
+            park(*request, generation);
+            continue;
+        }
+        detach(*request);
+        post_completion(request->m_sqe.user_data, result);
+    }
+    if (m_cq_tail.load(AK::memory_order_relaxed) != completions_before)
+        notify_completions();
+}
+
+ErrorOr<void> IORing::wait_for_completions(size_t count)
+{
+    count = min(count, static_cast<size_t>(m_params.cq_entries));
+    for (;;) {
+        if (completions_available() >= count)
+            return {};
+        if (has_requests_to_process())
+            return {};
+        // NOTE: A wakeup that happens after we looked is remembered by the wait queue, so we can't miss it.
+        if (m_completion_wait_queue.wait_on({}, "IORing"sv).was_interrupted())
+            return EINTR;
+    }
+}
+
+ErrorOr<size_t> IORing::execute(io_ring_sqe const& sqe, OpenFileDescription& description)
+{
+    if (sqe.length > static_cast<u32>(NumericLimits<i32>::max()))
+        return EINVAL;
+    bool has_offset = sqe.offset != IO_RING_CURRENT_OFFSET;
+    if (has_offset && sqe.offset > static_cast<u64>(NumericLimits<off_t>::max()))
+        return EINVAL;
+
+    switch (sqe.opcode) {
+    case IO_RING_OP_READ: {
+        if (!description.is_readable())
+            return EBADF;
+        if (description.is_directory())
+            return EISDIR;
+        if (has_offset && !description.file().is_seekable())
+            return EINVAL;
+        if (!description.can_read())
+            return EAGAIN;
+        auto buffer = TRY(UserOrKernelBuffer::for_user_buffer(reinterpret_cast<u8*>(static_cast<FlatPtr>(sqe.addr)), sqe.length));
+        if (has_offset)
+            return description.read(buffer, sqe.offset, sqe.length);
+        return description.read(buffer, sqe.length);
+    }
+    case IO_RING_OP_WRITE: {
+        if (!description.is_writable())
+            return EBADF;
+        if (has_offset && !description.file().is_seekable())
+            return EINVAL;
+        if (!description.can_write())
+            return EAGAIN;
+        auto buffer = TRY(UserOrKernelBuffer::for_user_buffer(reinterpret_cast<u8*>(static_cast<FlatPtr>(sqe.addr)), sqe.length));
+        if (has_offset)
+            return description.write(sqe.offset, buffer, sqe.length);
+        if (description.should_append() && description.file().is_seekable())
+            TRY(description.seek(0, SEEK_END));
+        return description.write(buffer, sqe.length);
+    }
+    case IO_RING_OP_RECV: {
+        if (!description.is_socket())
+            return ENOTSOCK;
+        auto& socket = *description.socket();
+        if (socket.is_shut_down_for_reading())
+            return 0;
+        if (!description.can_read())
+            return EAGAIN;
+        auto buffer = TRY(UserOrKernelBuffer::for_user_buffer(reinterpret_cast<u8*>(static_cast<FlatPtr>(sqe.addr)), sqe.length));
+        Time timestamp {};
+        return socket.recvfrom(description, buffer, sqe.length, static_cast<int>(sqe.op_flags), {}, {}, timestamp);
+    }
+    case IO_RING_OP_SEND: {
+        if (!description.is_socket())
+            return ENOTSOCK;
+        auto& socket = *description.socket();
+        if (socket.is_shut_down_for_writing())
+            return EPIPE;
+        if (!description.can_write())
+            return EAGAIN;
+        auto buffer = TRY(UserOrKernelBuffer::for_user_buffer(reinterpret_cast<u8*>(static_cast<FlatPtr>(sqe.addr)), sqe.length));
+        auto bytes_sent = TRY(socket.sendto(description, buffer, sqe.length, static_cast<int>(sqe.op_flags), {}, 0));
+        if (bytes_sent == 0 && sqe.length > 0)
+            return EAGAIN;
+        return bytes_sent;
+    }
+    case IO_RING_OP_ACCEPT: {
+        auto& process = Process::current();
+        TRY(process.require_promise(Pledge::accept));
+        if (!description.is_socket())
+            return ENOTSOCK;
+        auto& socket = *description.socket();
+        if (!socket.can_accept())
+            return EAGAIN;
+        auto fd_allocation = TRY(process.allocate_fd());
+        auto accepted_socket = socket.accept();
+        if (!accepted_socket)
+            return EAGAIN;
+
+        auto accepted_socket_description = TRY(OpenFileDescription::try_create(*accepted_socket));
+        accepted_socket_description->set_readable(true);
+        accepted_socket_description->set_writable(true);
+        if (sqe.op_flags & SOCK_NONBLOCK)
+            accepted_socket_description->set_blocking(false);
+        int fd_flags = 0;
+        if (sqe.op_flags & SOCK_CLOEXEC)
+            fd_flags |= FD_CLOEXEC;
+        TRY(process.fds().with_exclusive([&](auto& fds) -> ErrorOr<void> {
+            fds[fd_allocation.fd].set(move(accepted_socket_description), fd_flags);
+            return {};
+        }));
+
+        // NOTE: Moving this state to Completed is what causes connect() to unblock on the client side.
+        accepted_socket->set_setup_state(Socket::SetupState::Completed);
+        return fd_allocation.fd;
+    }
+    case IO_RING_OP_FSYNC:
+        TRY(description.sync());
+        return 0;
+    default:
+        return EINVAL;
+    }
+}
+
+void IORing::park(PendingRequest& request, u32 generation)
+{
+    {
+        SpinlockLocker lock(m_pending_lock);
+        // If the file changed state while we were trying, it may be ready now. Try again on the next round.
+        if (request.m_generation == generation) {
+            m_waiting_requests.append(request);
+            return;
+        }
+        request.m_is_woken = true;
+        m_woken_requests.append(request);
+    }
+    notify_completions();
+}
+
+void IORing::request_state_changed(PendingRequest& request)
+{
+    // NOTE: This is called with the watched file's blocker set locked, so we only move the request
+    //       over to the woken list here. It is retried the next time the process enters the ring.
+    {
+        SpinlockLocker lock(m_pending_lock);
+        ++request.m_generation;
+        if (!request.m_list_node.is_in_list() || request.m_is_woken)
+            return;
+        m_waiting_requests.remove(request);
+        request.m_is_woken = true;
+        m_woken_requests.append(request);
+    }
+    notify_completions();
+}
+
+void IORing::detach(PendingRequest& request)
+{
+    // NOTE: Once the request is no longer an observer, nothing can move it between the lists anymore.
+    request.m_description->file().blocker_set().remove_observer(request);
+    SpinlockLocker lock(m_pending_lock);
+    if (request.m_list_node.is_in_list()) {
+        if (request.m_is_woken)
+            m_woken_requests.remove(request);
+        else
+            m_waiting_requests.remove(request);
+    }
+    --m_pending_request_count;
+}
+
+}
@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Atomic.h>
+#include <AK/IntrusiveList.h>
+#include <AK/OwnPtr.h>
+#include <AK/RefCounted.h>
+#include <Kernel/API/POSIX/sys/io_ring.h>
+#include <Kernel/FileSystem/File.h>
+#include <Kernel/Forward.h>
+#include <Kernel/KBuffer.h>
+#include <Kernel/Locking/Mutex.h>
+#include <Kernel/Locking/Spinlock.h>
+#include <Kernel/Memory/AnonymousVMObject.h>
+#include <Kernel/Memory/Region.h>
+#include <Kernel/WaitQueue.h>
+
+namespace Kernel {
+
+// An IORing holds the submission and completion queues that a process shares with the kernel,
+// so that it can hand over many I/O requests with a single syscall and pick up their results
+// without making any. File system I/O may have to wait for the disk, so it is handed off to
+// g_fs_work through a kernel bounce buffer, and its results are copied back and posted on the
+// next io_ring_enter(). Other requests that can complete right away are executed when they are
+// submitted. Requests that would block, like reading from a socket without any data, are parked
+// instead, and retried on the next io_ring_enter() once their file tells us that its state has
+// changed. The ring file descriptor is readable while there are completions to collect, finished
+// file system requests to post, or parked requests to retry, so it fits right into an event loop.
+class IORing final : public File {
+public:
+    static ErrorOr<NonnullRefPtr<IORing>> try_create(Process&, u32 entry_count);
+    virtual ~IORing() override;
+
+    virtual bool can_read(const OpenFileDescription&, u64) const override;
+    virtual ErrorOr<size_t> read(OpenFileDescription&, u64, UserOrKernelBuffer&, size_t) override { return EINVAL; }
+    virtual bool can_write(const OpenFileDescription&, u64) const override { return false; }
+    virtual ErrorOr<size_t> write(OpenFileDescription&, u64, const UserOrKernelBuffer&, size_t) override { return EINVAL; }
+    virtual ErrorOr<Memory::Region*> mmap(Process&, OpenFileDescription&, Memory::VirtualRange const&, u64 offset, int prot, bool shared) override;
+    virtual ErrorOr<void> close() override;
+
+    virtual ErrorOr<NonnullOwnPtr<KString>> pseudo_path(const OpenFileDescription&) const override;
+    virtual StringView class_name() const override { return "IORing"sv; }
+    virtual bool is_io_ring() const override { return true; }
+
+    io_ring_params const& params() const { return m_params; }
+    // NOTE: Requests point into the address space of the process that set up the ring, so only it may use the ring.
+    bool is_owned_by(Process const&) const;
+
+    // Executes or parks up to `count` requests from the submission queue, and returns how many were taken.
+    // We stop early when the completion queue doesn't have room for the results of any more requests.
+    ErrorOr<size_t> submit(size_t count);
+    // Posts the results of the file system requests that have finished in the background.
+    void complete_finished_file_requests();
+    // Retries the parked requests whose files have changed state since we last looked at them.
+    void retry_woken_requests();
+    size_t completions_available() const;
+    // Waits until at least `count` completions are waiting to be collected, or a request needs our attention.
+    ErrorOr<void> wait_for_completions(size_t count);
+
+private:
+    class PendingRequest final
+        : public RefCounted<PendingRequest>
+        , public FileBlockerSet::Observer {
+    public:
+        PendingRequest(IORing&, io_ring_sqe const&, NonnullRefPtr<OpenFileDescription>);
+
+        virtual void file_state_changed() override { m_ring.request_state_changed(*this); }
+
+        IORing& m_ring;
+        io_ring_sqe const m_sqe;
+        // NOTE: Like a blocked syscall, a parked request keeps its file open until it completes.
+        NonnullRefPtr<OpenFileDescription> m_description;
+
+        // NOTE: These are protected by the IORing's m_pending_lock.
+        u32 m_generation { 0 };
+        bool m_is_woken { false };
+        IntrusiveListNode<PendingRequest, RefPtr<PendingRequest>> m_list_node;
+    };
+
+    class FileRequest final : public RefCounted<FileRequest> {
+    public:
+        FileRequest(IORing&, io_ring_sqe const&, NonnullRefPtr<OpenFileDescription>);
+
+        // NOTE: The ring stays alive until the request is done with it, but drops finished requests once it is closed.
+        NonnullRefPtr<IORing> m_ring;
+        io_ring_sqe const m_sqe;
+        NonnullRefPtr<OpenFileDescription> m_description;
+        // NOTE: The work queue can't get at the process's memory, so data goes through here.
+        OwnPtr<KBuffer> m_buffer;
+        size_t m_length { 0 };
+        ErrorOr<size_t> m_result { 0 };
+
+        IntrusiveListNode<FileRequest, RefPtr<FileRequest>> m_list_node;
+    };
+
+    IORing(Process&, NonnullRefPtr<Memory::AnonymousVMObject>, NonnullOwnPtr<Memory::Region>, io_ring_params const&);
+
+    bool has_room_for_completion() const;
+    void post_completion(u64 user_data, ErrorOr<size_t> const&);
+    void notify_completions();
+
+    void submit_one(io_ring_sqe const&);
+    // Returns EAGAIN if the request can't make progress without blocking.
+    ErrorOr<size_t> execute(io_ring_sqe const&, OpenFileDescription&);
+
+    static bool should_execute_in_background(io_ring_sqe const&, OpenFileDescription const&);
+    void start_file_request(io_ring_sqe const&, NonnullRefPtr<OpenFileDescription>);
+    ErrorOr<void> prepare_file_request(FileRequest&);
+    static void execute_file_request(FileRequest&);
+    void file_request_finished(FileRequest&);
+    bool has_requests_to_process() const;
+
+    void park(PendingRequest&, u32 generation);
+    void request_state_changed(PendingRequest&);
+    void detach(PendingRequest&);
+
+    ProcessID const m_owner_pid;
+    NonnullRefPtr<Memory::AnonymousVMObject> m_vmobject;
+    NonnullOwnPtr<Memory::Region> m_kernel_region;
+    io_ring_params const m_params;
+
+    // These point into the memory shared with the process.
+    io_ring_header* const m_header;
+    io_ring_sqe* const m_submission_queue;
+    io_ring_cqe* const m_completion_queue;
+
+    // Serializes everything that touches the queues on the kernel side.
+    Mutex m_lock { "IORing" };
+    // NOTE: We keep our own copies of the indices we own, so that the process can't confuse us by writing to them.
+    u32 m_sq_head { 0 };
+    Atomic<u32> m_cq_tail { 0 };
+
+    // Requests waiting for their file to change state, the ones whose file did, and file system requests
+    // that are being executed or have finished in the background. They all count against the space in the
+    // completion queue, so that their results are guaranteed to fit.
+    using PendingRequestList = IntrusiveList<&PendingRequest::m_list_node>;
+    using FileRequestList = IntrusiveList<&FileRequest::m_list_node>;
+    mutable Spinlock m_pending_lock;
+    PendingRequestList m_waiting_requests;
+    PendingRequestList m_woken_requests;
+    FileRequestList m_finished_file_requests;
+    size_t m_pending_request_count { 0 };
+    bool m_is_closed { false };
+
+    WaitQueue m_completion_wait_queue;
+};
+
+}
@@ -9,20 +9,38 @@
 #include <AK/Singleton.h>
 #include <AK/StringView.h>
 #include <Kernel/API/InodeWatcherEvent.h>
+#include <Kernel/Debug.h>
 #include <Kernel/FileSystem/Custody.h>
 #include <Kernel/FileSystem/Inode.h>
 #include <Kernel/FileSystem/InodeWatcher.h>
 #include <Kernel/FileSystem/OpenFileDescription.h>
 #include <Kernel/FileSystem/VirtualFileSystem.h>
 #include <Kernel/KBufferBuilder.h>
+#include <Kernel/Memory/AnonymousVMObject.h>
+#include <Kernel/Memory/MemoryManager.h>
 #include <Kernel/Memory/SharedInodeVMObject.h>
 #include <Kernel/Net/LocalSocket.h>
 #include <Kernel/Process.h>
+#include <Kernel/WorkQueue.h>
 
 namespace Kernel {
 
 static Singleton<SpinlockProtected<Inode::AllInstancesList>> s_all_instances;
 
+// Guards the cached pages of every inode, as well as the LRU list that links all of them together.
+static RecursiveSpinlock s_page_cache_lock;
+static Singleton<Inode::CachedPageLRUList> s_page_cache_lru_list;
+static size_t s_page_cache_page_count;
+
+// Past this, adding a page to the page cache evicts the least recently used one.
+static size_t max_page_cache_page_count()
+{
+    return static_cast<size_t>(MM.get_system_memory_info().user_physical_pages / 2);
+}
+
+// A single readahead may fill at most this fraction of the page cache.
+static constexpr size_t max_readahead_page_cache_fraction = 16;
+
 SpinlockProtected<Inode::AllInstancesList>& Inode::all_instances()
 {
     return s_all_instances;
@@ -93,6 +111,15 @@ Inode::Inode(FileSystem& fs, InodeIndex index)
 
 Inode::~Inode()
 {
+    {
+        SpinlockLocker locker(s_page_cache_lock);
+        for (auto& it : m_cached_pages) {
+            s_page_cache_lru_list->remove(*it.value);
+            --s_page_cache_page_count;
+        }
+        m_cached_pages.clear();
+    }
+
     m_watchers.for_each([&](auto& watcher) {
         watcher->unregister_by_inode({}, identifier());
     });
@@ -264,6 +291,255 @@ RefPtr<Memory::SharedInodeVMObject> Inode::shared_vmobject() const
     return m_shared_vmobject.strong_ref();
 }
 
+bool Inode::has_page_cache() const
+{
+    return fs().is_block_based() && metadata().is_regular_file();
+}
+
+size_t Inode::page_cache_size() const
+{
+    SpinlockLocker locker(s_page_cache_lock);
+    return m_cached_pages.size() * PAGE_SIZE;
+}
+
+// Must be called with s_page_cache_lock held.
+size_t Inode::evict_least_recently_used_cached_pages(size_t page_count)
+{
+    VERIFY(s_page_cache_lock.is_locked_by_current_processor());
+    auto& lru_list = *s_page_cache_lru_list;
+    size_t evicted_page_count = 0;
+    for (size_t scanned_page_count = 0, total_page_count = s_page_cache_page_count; scanned_page_count < total_page_count && evicted_page_count < page_count; ++scanned_page_count) {
+        auto& cached_page = *lru_list.last();
+        // Pages that are mapped or otherwise in use wouldn't be freed anyway, so they go back to the front of the list.
+        if (cached_page.physical_page->ref_count() > 1) {
+            lru_list.prepend(cached_page);
+            continue;
+        }
+        lru_list.remove(cached_page);
+        --s_page_cache_page_count;
+        cached_page.inode.m_cached_pages.remove(cached_page.index);
+        ++evicted_page_count;
+    }
+    return evicted_page_count;
+}
+
+size_t Inode::reclaim_page_cache(size_t page_count)
+{
+    // We may have been called because allocating memory for the page cache itself ran out of pages.
+    if (s_page_cache_lock.is_locked_by_current_processor())
+        return 0;
+    SpinlockLocker locker(s_page_cache_lock);
+    auto evicted_page_count = evict_least_recently_used_cached_pages(page_count);
+    dbgln_if(PAGE_CACHE_DEBUG, "Inode::reclaim_page_cache(): Evicted {} of {} requested pages", evicted_page_count, page_count);
+    return evicted_page_count;
+}
+
+ErrorOr<void> Inode::add_cached_page(size_t page_index, NonnullRefPtr<Memory::PhysicalPage> physical_page)
+{
+    auto cached_page = TRY(adopt_nonnull_own_or_enomem(new (nothrow) CachedPage(*this, page_index, move(physical_page))));
+    auto max_page_count = max_page_cache_page_count();
+
+    SpinlockLocker locker(s_page_cache_lock);
+    VERIFY(!m_cached_pages.contains(page_index));
+    auto& cached_page_ref = *cached_page;
+    TRY(m_cached_pages.try_set(page_index, move(cached_page)));
+    s_page_cache_lru_list->prepend(cached_page_ref);
+    ++s_page_cache_page_count;
+    if (s_page_cache_page_count > max_page_count)
+        evict_least_recently_used_cached_pages(s_page_cache_page_count - max_page_count);
+    return {};
+}
+
+RefPtr<Memory::PhysicalPage> Inode::find_cached_page(size_t page_index)
+{
+    SpinlockLocker locker(s_page_cache_lock);
+    auto it = m_cached_pages.find(page_index);
+    if (it == m_cached_pages.end())
+        return nullptr;
+    s_page_cache_lru_list->prepend(*it->value);
+    return it->value->physical_page;
+}
+
+ErrorOr<NonnullRefPtr<Memory::PhysicalPage>> Inode::get_or_load_cached_page(size_t page_index)
+{
+    VERIFY(has_page_cache());
+    if (auto page = find_cached_page(page_index))
+        return page.release_nonnull();
+
+    // NOTE: Holding the inode lock while loading makes sure the page can't miss a concurrent write.
+    MutexLocker locker(m_inode_lock);
+    if (auto page = find_cached_page(page_index))
+        return page.release_nonnull();
+
+    u8 page_buffer[PAGE_SIZE];
+    auto buffer = UserOrKernelBuffer::for_kernel_buffer(page_buffer);
+    auto nread = TRY(read_bytes_for_page_cache(page_index * PAGE_SIZE, PAGE_SIZE, buffer));
+    if (nread < PAGE_SIZE) {
+        // If we read less than a page, zero out the rest to avoid leaking uninitialized data.
+        memset(page_buffer + nread, 0, PAGE_SIZE - nread);
+    }
+
+    auto page = TRY(MM.allocate_user_physical_page(Memory::MemoryManager::ShouldZeroFill::No));
+    MM.copy_to_physical_page(*page, 0, { page_buffer, PAGE_SIZE });
+    TRY(add_cached_page(page_index, page));
+    return page;
+}
+
+ErrorOr<size_t> Inode::read_bytes_through_page_cache(off_t offset, size_t count, UserOrKernelBuffer& buffer)
+{
+    VERIFY(offset >= 0);
+    auto file_size = size();
+    if (static_cast<u64>(offset) >= file_size)
+        return 0;
+    count = min<u64>(count, file_size - offset);
+
+    size_t nread = 0;
+    while (nread < count) {
+        auto position = offset + nread;
+        auto offset_in_page = position % PAGE_SIZE;
+        auto chunk_size = min(PAGE_SIZE - offset_in_page, count - nread);
+        auto page = TRY(get_or_load_cached_page(position / PAGE_SIZE));
+        // NOTE: Copying to the buffer may fault, so the page has to stay mapped even if we end up blocking.
+        auto* mapped_page = TRY(MM.map_page_for_current_thread(*page));
+        auto result = buffer.write(mapped_page + offset_in_page, nread, chunk_size);
+        MM.unmap_page_for_current_thread();
+        TRY(result);
+        nread += chunk_size;
+    }
+    return nread;
+}
+
+ErrorOr<NonnullOwnPtr<Memory::Region>> Inode::map_cached_pages(size_t first_page, size_t page_count)
+{
+    VERIFY(has_page_cache());
+    Vector<NonnullRefPtr<Memory::PhysicalPage>> pages;
+    TRY(pages.try_ensure_capacity(page_count));
+    for (size_t i = 0; i < page_count; ++i)
+        pages.unchecked_append(TRY(get_or_load_cached_page(first_page + i)));
+
+    auto vmobject = TRY(Memory::AnonymousVMObject::try_create_with_physical_pages(pages.span()));
+    return MM.allocate_kernel_region_with_vmobject(*vmobject, page_count * PAGE_SIZE, "Page cache"sv, Memory::Region::Access::Read);
+}
+
+void Inode::start_readahead(u64 first_page, size_t page_count)
+{
+    VERIFY(has_page_cache());
+    g_fs_work->queue([inode = NonnullRefPtr<Inode>(*this), first_page, page_count]() mutable {
+        if (auto result = inode->read_ahead(first_page, page_count); result.is_error())
+            dbgln_if(READAHEAD_DEBUG, "Inode[{}]::read_ahead(): Failed: {}", inode->identifier(), result.error());
+    });
+}
+
+ErrorOr<void> Inode::read_ahead(u64 first_page, size_t page_count)
+{
+    auto is_cached = [&](u64 page_index) {
+        SpinlockLocker locker(s_page_cache_lock);
+        return m_cached_pages.contains(page_index);
+    };
+
+    // Readahead must not push the pages that are actually being used out of the page cache.
+    page_count = min(page_count, max_page_cache_page_count() / max_readahead_page_cache_fraction);
+
+    u64 page_cache_generation = 0;
+    {
+        MutexLocker locker(m_inode_lock);
+        // Don't read past the end of the file, nor any pages at the edges of the range that are already cached.
+        auto end_page = min(first_page + page_count, ceil_div(static_cast<u64>(size()), static_cast<u64>(PAGE_SIZE)));
+        while (first_page < end_page && is_cached(first_page))
+            ++first_page;
+        while (end_page > first_page && is_cached(end_page - 1))
+            --end_page;
+        if (first_page >= end_page)
+            return {};
+        page_count = end_page - first_page;
+        page_cache_generation = m_page_cache_generation;
+    }
+
+    dbgln_if(READAHEAD_DEBUG, "Inode[{}]::read_ahead(): Reading {} pages at page {}", identifier(), page_count, first_page);
+
+    auto readahead_buffer = TRY(KBuffer::try_create_with_size(page_count * PAGE_SIZE, Memory::Region::Access::ReadWrite, "Readahead"sv));
+    auto buffer = UserOrKernelBuffer::for_kernel_buffer(readahead_buffer->data());
+    auto nread = TRY(read_bytes_for_page_cache(first_page * PAGE_SIZE, page_count * PAGE_SIZE, buffer));
+    // If we read less than requested, zero out the rest to avoid leaking uninitialized data.
+    memset(readahead_buffer->data() + nread, 0, page_count * PAGE_SIZE - nread);
+
+    MutexLocker locker(m_inode_lock);
+    // If the file was written to or truncated while we were reading, what we have may be stale.
+    if (page_cache_generation != m_page_cache_generation) {
+        dbgln_if(READAHEAD_DEBUG, "Inode[{}]::read_ahead(): Inode changed while reading, dropping {} pages", identifier(), page_count);
+        return {};
+    }
+    for (size_t i = 0; i < page_count; ++i) {
+        if (is_cached(first_page + i))
+            continue;
+        auto page = TRY(MM.allocate_user_physical_page(Memory::MemoryManager::ShouldZeroFill::No));
+        MM.copy_to_physical_page(*page, 0, { readahead_buffer->data() + i * PAGE_SIZE, PAGE_SIZE });
+        TRY(add_cached_page(first_page + i, move(page)));
+    }
+    return {};
+}
+
+ErrorOr<void> Inode::update_page_cache(off_t offset, size_t count, UserOrKernelBuffer const& data)
+{
+    VERIFY(offset >= 0);
+    VERIFY(m_inode_lock.is_locked());
+    ++m_page_cache_generation;
+
+    size_t nupdated = 0;
+    while (nupdated < count) {
+        auto position = offset + nupdated;
+        auto offset_in_page = position % PAGE_SIZE;
+        auto chunk_size = min(PAGE_SIZE - offset_in_page, count - nupdated);
+        if (auto page = find_cached_page(position / PAGE_SIZE)) {
+            auto* mapped_page = TRY(MM.map_page_for_current_thread(*page));
+            auto result = data.read(mapped_page + offset_in_page, nupdated, chunk_size);
+            MM.unmap_page_for_current_thread();
+            TRY(result);
+        }
+        nupdated += chunk_size;
+    }
+    return {};
+}
+
+void Inode::truncate_page_cache(u64 new_size)
+{
+    VERIFY(m_inode_lock.is_locked());
+    ++m_page_cache_generation;
+
+    auto new_page_count = ceil_div(new_size, static_cast<u64>(PAGE_SIZE));
+    RefPtr<Memory::PhysicalPage> last_page;
+    {
+        SpinlockLocker locker(s_page_cache_lock);
+        m_cached_pages.remove_all_matching([&](size_t page_index, auto& cached_page) {
+            if (page_index < new_page_count)
+                return false;
+            s_page_cache_lru_list->remove(*cached_page);
+            --s_page_cache_page_count;
+            return true;
+        });
+        if (new_size % PAGE_SIZE) {
+            if (auto it = m_cached_pages.find(new_page_count - 1); it != m_cached_pages.end())
+                last_page = it->value->physical_page;
+        }
+    }
+
+    // Mappings of the file must let go of the pages past the new end of file as well, or they'd keep seeing the old data.
+    MM.for_each_vmobject([&](Memory::VMObject& vmobject) {
+        if (!vmobject.is_inode())
+            return;
+        auto& inode_vmobject = static_cast<Memory::InodeVMObject&>(vmobject);
+        if (&inode_vmobject.inode() == this)
+            inode_vmobject.release_pages_from(new_page_count);
+    });
+
+    // The part of the last page past the new end of file must read back as zeroes if the file grows again.
+    if (last_page) {
+        auto offset_in_page = new_size % PAGE_SIZE;
+        u8 zero_buffer[PAGE_SIZE] {};
+        MM.copy_to_physical_page(*last_page, offset_in_page, { zero_buffer, PAGE_SIZE - offset_in_page });
+    }
+}
+
 template<typename T>
 static inline bool range_overlap(T start1, T len1, T start2, T len2)
 {
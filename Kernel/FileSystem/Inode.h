@@ -9,8 +9,10 @@
 
 #include <AK/Error.h>
 #include <AK/Function.h>
+#include <AK/HashMap.h>
 #include <AK/HashTable.h>
 #include <AK/IntrusiveList.h>
+#include <AK/NonnullOwnPtr.h>
 #include <AK/String.h>
 #include <AK/WeakPtr.h>
 #include <Kernel/FileSystem/FIFO.h>
@@ -85,6 +87,26 @@ public:
     void set_shared_vmobject(Memory::SharedInodeVMObject&);
     RefPtr<Memory::SharedInodeVMObject> shared_vmobject() const;
 
+    // Regular files on block based file systems keep their contents in a page cache.
+    // read(), write() and every mapping of the inode share the same physical pages.
+    bool has_page_cache() const;
+    ErrorOr<NonnullRefPtr<Memory::PhysicalPage>> get_or_load_cached_page(size_t page_index);
+    // Unlike get_or_load_cached_page(), this never does any I/O and returns null if the page isn't cached.
+    RefPtr<Memory::PhysicalPage> find_cached_page(size_t page_index);
+    ErrorOr<size_t> read_bytes_through_page_cache(off_t, size_t, UserOrKernelBuffer&);
+    // Maps the given cached pages (loading them first if needed) read-only into kernel memory, so their contents
+    // can be handed to another file without copying them out of the page cache first.
+    ErrorOr<NonnullOwnPtr<Memory::Region>> map_cached_pages(size_t first_page, size_t page_count);
+    size_t page_cache_size() const;
+
+    // The page cache of all inodes together is kept below a fixed share of physical memory. When it's full, or when
+    // the MemoryManager runs out of physical pages, the least recently used pages that aren't mapped anywhere go first.
+    // Returns how many pages were freed.
+    static size_t reclaim_page_cache(size_t page_count);
+
+    // Loads the given pages into the page cache in the background, with as few large reads as possible.
+    void start_readahead(u64 first_page, size_t page_count);
+
     static void sync_all();
     void sync();
 
@@ -110,12 +132,43 @@ protected:
     void did_modify_contents();
     void did_delete_self();
 
+    ErrorOr<void> read_ahead(u64 first_page, size_t page_count);
+
+    // Used to fill the page cache. File systems with a block cache of their own should read around it here,
+    // so that the data doesn't end up cached twice.
+    virtual ErrorOr<size_t> read_bytes_for_page_cache(off_t offset, size_t count, UserOrKernelBuffer& buffer) const { return read_bytes(offset, count, buffer, nullptr); }
+
+    // File systems must call these with m_inode_lock held after changing the contents or the size of the inode.
+    ErrorOr<void> update_page_cache(off_t, size_t, UserOrKernelBuffer const&);
+    void truncate_page_cache(u64 new_size);
+
     mutable Mutex m_inode_lock { "Inode" };
 
 private:
+    struct CachedPage {
+        CachedPage(Inode& inode, size_t index, NonnullRefPtr<Memory::PhysicalPage> physical_page)
+            : inode(inode)
+            , index(index)
+            , physical_page(move(physical_page))
+        {
+        }
+
+        Inode& inode;
+        size_t index { 0 };
+        NonnullRefPtr<Memory::PhysicalPage> physical_page;
+        IntrusiveListNode<CachedPage> lru_list_node;
+    };
+
+    ErrorOr<void> add_cached_page(size_t page_index, NonnullRefPtr<Memory::PhysicalPage>);
+    static size_t evict_least_recently_used_cached_pages(size_t page_count);
+
     FileSystem& m_file_system;
     InodeIndex m_index { 0 };
     WeakPtr<Memory::SharedInodeVMObject> m_shared_vmobject;
+    // Guarded by the global page cache lock, which also protects the LRU list linking the cached pages of all inodes.
+    HashMap<size_t, NonnullOwnPtr<CachedPage>> m_cached_pages;
+    // Bumped under m_inode_lock whenever the contents of the inode change, so readahead can tell if what it read is stale.
+    u64 m_page_cache_generation { 0 };
     RefPtr<LocalSocket> m_bound_socket;
     SpinlockProtected<HashTable<InodeWatcher*>> m_watchers;
     bool m_metadata_dirty { false };
@@ -135,6 +188,8 @@ private:
 public:
     using AllInstancesList = IntrusiveList<&Inode::m_inode_list_node>;
     static SpinlockProtected<Inode::AllInstancesList>& all_instances();
+
+    using CachedPageLRUList = IntrusiveList<&CachedPage::lru_list_node>;
 };
 
 }
@@ -31,7 +31,14 @@ ErrorOr<size_t> InodeFile::read(OpenFileDescription& description, u64 offset, Us
     if (Checked<off_t>::addition_would_overflow(offset, count))
         return EOVERFLOW;
 
-    auto nread = TRY(m_inode->read_bytes(offset, count, buffer, &description));
+    size_t nread;
+    if (!description.is_direct() && m_inode->has_page_cache()) {
+        nread = TRY(m_inode->read_bytes_through_page_cache(offset, count, buffer));
+        if (auto readahead = description.update_readahead(offset, nread); readahead.has_value())
+            m_inode->start_readahead(readahead->first_page, readahead->page_count);
+    } else {
+        nread = TRY(m_inode->read_bytes(offset, count, buffer, &description));
+    }
     if (nread > 0) {
         Thread::current()->did_file_read(nread);
         evaluate_block_conditions();
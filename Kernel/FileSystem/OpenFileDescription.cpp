@@ -9,7 +9,9 @@
 #include <Kernel/API/POSIX/errno.h>
 #include <Kernel/Devices/BlockDevice.h>
 #include <Kernel/FileSystem/Custody.h>
+#include <Kernel/FileSystem/EPoll.h>
 #include <Kernel/FileSystem/FIFO.h>
+#include <Kernel/FileSystem/IORing.h>
 #include <Kernel/FileSystem/InodeFile.h>
 #include <Kernel/FileSystem/InodeWatcher.h>
 #include <Kernel/FileSystem/OpenFileDescription.h>
@@ -161,6 +163,38 @@ ErrorOr<size_t> OpenFileDescription::write(u64 offset, UserOrKernelBuffer const&
     return m_file->write(*this, offset, data, data_size);
 }
 
+// The readahead window starts small and doubles with every sequential read, up to a maximum.
+static constexpr size_t min_readahead_pages = 4;
+static constexpr size_t max_readahead_pages = 64;
+
+Optional<OpenFileDescription::ReadaheadRange> OpenFileDescription::update_readahead(u64 offset, size_t nread)
+{
+    return m_state.with([&](auto& state) -> Optional<ReadaheadRange> {
+        bool is_sequential = offset == state.readahead_next_offset;
+        state.readahead_next_offset = offset + nread;
+        if (!is_sequential || nread == 0) {
+            state.readahead_window = 0;
+            state.readahead_end_page = 0;
+            return {};
+        }
+
+        state.readahead_window = clamp(state.readahead_window * 2, min_readahead_pages, max_readahead_pages);
+        auto current_page = ceil_div(offset + nread, static_cast<u64>(PAGE_SIZE));
+
+        // Only start the next window once the reader is halfway through the previous one,
+        // so that it is (hopefully) in the page cache by the time the reader gets there.
+        if (state.readahead_end_page > current_page + state.readahead_window / 2)
+            return {};
+
+        auto first_page = max(current_page, state.readahead_end_page);
+        auto end_page = current_page + state.readahead_window;
+        if (first_page >= end_page)
+            return {};
+        state.readahead_end_page = end_page;
+        return ReadaheadRange { first_page, static_cast<size_t>(end_page - first_page) };
+    });
+}
+
 ErrorOr<size_t> OpenFileDescription::read(UserOrKernelBuffer& buffer, size_t count)
 {
     auto offset = TRY(m_state.with([&](auto& state) -> ErrorOr<off_t> {
@@ -327,6 +361,30 @@ InodeWatcher* OpenFileDescription::inode_watcher()
     return static_cast<InodeWatcher*>(m_file.ptr());
 }
 
+bool OpenFileDescription::is_epoll() const
+{
+    return m_file->is_epoll();
+}
+
+EPoll* OpenFileDescription::epoll()
+{
+    if (!is_epoll())
+        return nullptr;
+    return static_cast<EPoll*>(m_file.ptr());
+}
+
+bool OpenFileDescription::is_io_ring() const
+{
+    return m_file->is_io_ring();
+}
+
+IORing* OpenFileDescription::io_ring()
+{
+    if (!is_io_ring())
+        return nullptr;
+    return static_cast<IORing*>(m_file.ptr());
+}
+
 bool OpenFileDescription::is_master_pty() const
 {
     return m_file->is_master_pty();
@@ -8,6 +8,7 @@
 
 #include <AK/Badge.h>
 #include <AK/RefCounted.h>
+#include <AK/Weakable.h>
 #include <Kernel/FileSystem/FIFO.h>
 #include <Kernel/FileSystem/Inode.h>
 #include <Kernel/FileSystem/InodeMetadata.h>
@@ -22,7 +23,9 @@ public:
     virtual ~OpenFileDescriptionData() = default;
 };
 
-class OpenFileDescription : public RefCounted<OpenFileDescription> {
+class OpenFileDescription
+    : public RefCounted<OpenFileDescription>
+    , public Weakable<OpenFileDescription> {
 public:
     static ErrorOr<NonnullRefPtr<OpenFileDescription>> try_create(Custody&);
     static ErrorOr<NonnullRefPtr<OpenFileDescription>> try_create(File&);
@@ -80,6 +83,12 @@ public:
     const InodeWatcher* inode_watcher() const;
     InodeWatcher* inode_watcher();
 
+    bool is_epoll() const;
+    EPoll* epoll();
+
+    bool is_io_ring() const;
+    IORing* io_ring();
+
     bool is_master_pty() const;
     const MasterPTY* master_pty() const;
     MasterPTY* master_pty();
@@ -118,6 +127,13 @@ public:
     ErrorOr<void> truncate(u64);
     ErrorOr<void> sync();
 
+    struct ReadaheadRange {
+        u64 first_page { 0 };
+        size_t page_count { 0 };
+    };
+    // Records a read through this description and, if the reads are sequential, returns the pages to read ahead.
+    Optional<ReadaheadRange> update_readahead(u64 offset, size_t nread);
+
     off_t offset() const;
 
     ErrorOr<void> chown(UserID, GroupID);
@@ -153,6 +169,9 @@ private:
         bool should_append : 1 { false };
         bool direct : 1 { false };
         FIFO::Direction fifo_direction : 2 { FIFO::Direction::Neither };
+        u64 readahead_next_offset { 0 };
+        u64 readahead_end_page { 0 };
+        size_t readahead_window { 0 };
     };
 
     SpinlockProtected<State> m_state;
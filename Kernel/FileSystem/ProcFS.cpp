@@ -320,6 +320,8 @@ ErrorOr<NonnullRefPtr<Inode>> ProcFSProcessDirectoryInode::lookup(StringView nam
         return TRY(ProcFSProcessPropertyInode::try_create_for_pid_property(procfs(), SegmentedProcFSIndex::MainProcessProperty::VirtualMemoryStats, associated_pid()));
     if (name == "tty"sv)
         return TRY(ProcFSProcessPropertyInode::try_create_for_pid_property(procfs(), SegmentedProcFSIndex::MainProcessProperty::TTYLink, associated_pid()));
+    if (name == "syscalls"sv)
+        return TRY(ProcFSProcessPropertyInode::try_create_for_pid_property(procfs(), SegmentedProcFSIndex::MainProcessProperty::SyscallStatistics, associated_pid()));
     return ENOENT;
 }
 
@@ -563,6 +565,8 @@ ErrorOr<void> ProcFSProcessPropertyInode::try_to_acquire_data(Process& process,
         return process.procfs_get_virtual_memory_stats(builder);
     case SegmentedProcFSIndex::MainProcessProperty::TTYLink:
         return process.procfs_get_tty_link(builder);
+    case SegmentedProcFSIndex::MainProcessProperty::SyscallStatistics:
+        return process.procfs_get_syscall_statistics(builder);
     default:
         VERIFY_NOT_REACHED();
     }
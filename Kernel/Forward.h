@@ -23,7 +23,9 @@ class DevTmpFSRootDirectoryInode;
 class Device;
 class DiskCache;
 class DoubleBuffer;
+class EPoll;
 class File;
+class IORing;
 class OpenFileDescription;
 class FileSystem;
 class FutexQueue;
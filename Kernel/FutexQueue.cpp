@@ -10,7 +10,9 @@
 
 namespace Kernel {
 
-FutexQueue::FutexQueue()
+FutexQueue::FutexQueue(FutexKey const& key, RefPtr<Memory::VMObject> vmobject)
+    : m_key(key)
+    , m_vmobject(move(vmobject))
 {
 }
 
@@ -30,33 +32,55 @@ bool FutexQueue::should_add_blocker(Thread::Blocker& b, void*)
         dbgln_if(FUTEXQUEUE_DEBUG, "FutexQueue @ {}: should not block thread {}: was removed", this, b.thread());
         return false;
     }
+    if (m_imminent_wakes > 0) {
+        m_imminent_wakes--;
+        dbgln_if(FUTEXQUEUE_DEBUG, "FutexQueue @ {}: should not block thread {}: was woken before blocking", this, b.thread());
+        return false;
+    }
     dbgln_if(FUTEXQUEUE_DEBUG, "FutexQueue @ {}: should block thread {}", this, b.thread());
 
     return true;
 }
 
-u32 FutexQueue::wake_n_requeue(u32 wake_count, const Function<FutexQueue*()>& get_target_queue, u32 requeue_count, bool& is_empty, bool& is_empty_target)
+u32 FutexQueue::wake_imminent_waiters_locked(u32 wake_count)
+{
+    // Threads that are about to block can't be unblocked yet, so we make sure they won't block at all.
+    // As we don't know the bitsets they are going to wait with, some of them may wake up spuriously.
+    VERIFY(m_lock.is_locked());
+    VERIFY(m_imminent_wakes <= m_imminent_waits);
+    auto did_wake = static_cast<u32>(min<size_t>(wake_count, m_imminent_waits - m_imminent_wakes));
+    m_imminent_wakes += did_wake;
+    return did_wake;
+}
+
+u32 FutexQueue::wake_n_requeue(u32 wake_count, const Function<FutexQueue*()>& get_target_queue, u32 requeue_count)
 {
-    is_empty_target = false;
     SpinlockLocker lock(m_lock);
 
     dbgln_if(FUTEXQUEUE_DEBUG, "FutexQueue @ {}: wake_n_requeue({}, {})", this, wake_count, requeue_count);
 
     u32 did_wake = 0, did_requeue = 0;
-    unblock_all_blockers_whose_conditions_are_met_locked([&](Thread::Blocker& b, void*, bool& stop_iterating) {
-        VERIFY(b.blocker_type() == Thread::Blocker::Type::Futex);
-        auto& blocker = static_cast<Thread::FutexBlocker&>(b);
+    if (wake_count > 0) {
+        unblock_all_blockers_whose_conditions_are_met_locked([&](Thread::Blocker& b, void*, bool& stop_iterating) {
+            VERIFY(b.blocker_type() == Thread::Blocker::Type::Futex);
+            auto& blocker = static_cast<Thread::FutexBlocker&>(b);
+
+            dbgln_if(FUTEXQUEUE_DEBUG, "FutexQueue @ {}: wake_n_requeue unblocking {}", this, blocker.thread());
+            VERIFY(did_wake < wake_count);
+            if (blocker.unblock()) {
+                if (++did_wake >= wake_count)
+                    stop_iterating = true;
+                return true;
+            }
+            return false;
+        });
+    }
+    did_wake += wake_imminent_waiters_locked(wake_count - did_wake);
+    // Threads that haven't blocked yet can't be moved over to the target queue, so they are woken up instead.
+    auto did_wake_instead_of_requeue = wake_imminent_waiters_locked(requeue_count);
+    did_wake += did_wake_instead_of_requeue;
+    requeue_count -= did_wake_instead_of_requeue;
 
-        dbgln_if(FUTEXQUEUE_DEBUG, "FutexQueue @ {}: wake_n_requeue unblocking {}", this, blocker.thread());
-        VERIFY(did_wake < wake_count);
-        if (blocker.unblock()) {
-            if (++did_wake >= wake_count)
-                stop_iterating = true;
-            return true;
-        }
-        return false;
-    });
-    is_empty = is_empty_and_no_imminent_waits_locked();
     if (requeue_count > 0) {
         auto blockers_to_requeue = do_take_blockers(requeue_count);
         if (!blockers_to_requeue.is_empty()) {
@@ -82,7 +106,6 @@ u32 FutexQueue::wake_n_requeue(u32 wake_count, const Function<FutexQueue*()>& ge
                     blocker.finish_requeue(*target_futex_queue);
                 }
                 target_futex_queue->do_append_blockers(move(blockers_to_requeue));
-                is_empty_target = target_futex_queue->is_empty_and_no_imminent_waits_locked();
             } else {
                 dbgln_if(FUTEXQUEUE_DEBUG, "FutexQueue @ {}: wake_n_requeue could not get target queue to requeue {} blockers", this, blockers_to_requeue.size());
                 do_append_blockers(move(blockers_to_requeue));
@@ -92,12 +115,10 @@ u32 FutexQueue::wake_n_requeue(u32 wake_count, const Function<FutexQueue*()>& ge
     return did_wake + did_requeue;
 }
 
-u32 FutexQueue::wake_n(u32 wake_count, const Optional<u32>& bitset, bool& is_empty)
+u32 FutexQueue::wake_n(u32 wake_count, const Optional<u32>& bitset)
 {
-    if (wake_count == 0) {
-        is_empty = false;
+    if (wake_count == 0)
         return 0; // should we assert instead?
-    }
     SpinlockLocker lock(m_lock);
     dbgln_if(FUTEXQUEUE_DEBUG, "FutexQueue @ {}: wake_n({})", this, wake_count);
     u32 did_wake = 0;
@@ -114,11 +135,11 @@ u32 FutexQueue::wake_n(u32 wake_count, const Optional<u32>& bitset, bool& is_emp
         }
         return false;
     });
-    is_empty = is_empty_and_no_imminent_waits_locked();
+    did_wake += wake_imminent_waiters_locked(wake_count - did_wake);
     return did_wake;
 }
 
-u32 FutexQueue::wake_all(bool& is_empty)
+u32 FutexQueue::wake_all()
 {
     SpinlockLocker lock(m_lock);
     dbgln_if(FUTEXQUEUE_DEBUG, "FutexQueue @ {}: wake_all", this);
@@ -133,7 +154,7 @@ u32 FutexQueue::wake_all(bool& is_empty)
         }
         return false;
     });
-    is_empty = is_empty_and_no_imminent_waits_locked();
+    did_wake += wake_imminent_waiters_locked(NumericLimits<u32>::max());
     return did_wake;
 }
 
@@ -151,6 +172,17 @@ bool FutexQueue::queue_imminent_wait()
     return true;
 }
 
+void FutexQueue::cancel_imminent_wait()
+{
+    SpinlockLocker lock(m_lock);
+    VERIFY(m_imminent_waits > 0);
+    m_imminent_waits--;
+    // If we were woken up, that's fine: The thread that did it changed the futex value first,
+    // which is why we're not going to block. Any other imminent wakes stay with their threads.
+    if (m_imminent_wakes > m_imminent_waits)
+        m_imminent_wakes = m_imminent_waits;
+}
+
 bool FutexQueue::try_remove()
 {
     SpinlockLocker lock(m_lock);
@@ -162,4 +194,10 @@ bool FutexQueue::try_remove()
     return true;
 }
 
+void FutexQueue::remove()
+{
+    SpinlockLocker lock(m_lock);
+    m_was_removed = true;
+}
+
 }
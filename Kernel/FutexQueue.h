@@ -7,6 +7,8 @@
 #pragma once
 
 #include <AK/Atomic.h>
+#include <AK/HashFunctions.h>
+#include <AK/IntrusiveList.h>
 #include <AK/RefCounted.h>
 #include <Kernel/Locking/Spinlock.h>
 #include <Kernel/Memory/VMObject.h>
@@ -14,16 +16,29 @@
 
 namespace Kernel {
 
+// Identifies a futex across the whole system. Private futexes are identified by their process
+// and address. Shared ones may be mapped at a different address in every process using them,
+// so those are identified by the VMObject backing them and their offset into it instead.
+struct FutexKey {
+    void const* object { nullptr };
+    FlatPtr offset { 0 };
+
+    bool operator==(FutexKey const&) const = default;
+    unsigned hash() const { return pair_int_hash(ptr_hash(object), ptr_hash(offset)); }
+};
+
 class FutexQueue final
     : public RefCounted<FutexQueue>
     , public Thread::BlockerSet {
 public:
-    FutexQueue();
+    FutexQueue(FutexKey const&, RefPtr<Memory::VMObject>);
     virtual ~FutexQueue();
 
-    u32 wake_n_requeue(u32, const Function<FutexQueue*()>&, u32, bool&, bool&);
-    u32 wake_n(u32, const Optional<u32>&, bool&);
-    u32 wake_all(bool&);
+    FutexKey const& key() const { return m_key; }
+
+    u32 wake_n_requeue(u32, const Function<FutexQueue*()>&, u32);
+    u32 wake_n(u32, const Optional<u32>&);
+    u32 wake_all();
 
     template<class... Args>
     Thread::BlockResult wait_on(const Thread::BlockTimeout& timeout, Args&&... args)
@@ -32,7 +47,10 @@ public:
     }
 
     bool queue_imminent_wait();
+    // For threads that registered an imminent wait, but then decided not to block after all.
+    void cancel_imminent_wait();
     bool try_remove();
+    void remove();
 
     bool is_empty_and_no_imminent_waits()
     {
@@ -45,8 +63,21 @@ protected:
     virtual bool should_add_blocker(Thread::Blocker& b, void*) override;
 
 private:
-    size_t m_imminent_waits { 1 }; // We only create this object if we're going to be waiting, so start out with 1
+    u32 wake_imminent_waiters_locked(u32);
+
+    FutexKey const m_key;
+    // Keeps the memory of a shared futex alive, so that its key can't be reused while anyone waits on it.
+    RefPtr<Memory::VMObject> const m_vmobject;
+
+    size_t m_imminent_waits { 0 };
+    // How many of the imminent waits have been woken up before they got to block.
+    size_t m_imminent_wakes { 0 };
     bool m_was_removed { false };
+
+    IntrusiveListNode<FutexQueue, RefPtr<FutexQueue>> m_bucket_list_node;
+
+public:
+    using BucketList = IntrusiveList<&FutexQueue::m_bucket_list_node>;
 };
 
 }
@@ -12,6 +12,7 @@
 #include <Kernel/CommandLine.h>
 #include <Kernel/Devices/DeviceManagement.h>
 #include <Kernel/Devices/HID/HIDManagement.h>
+#include <Kernel/FileSystem/BlockBasedFileSystem.h>
 #include <Kernel/FileSystem/Custody.h>
 #include <Kernel/FileSystem/FileBackedFileSystem.h>
 #include <Kernel/FileSystem/OpenFileDescription.h>
@@ -107,6 +108,9 @@ private:
             obj.add("bytes_in", socket.bytes_in());
             obj.add("packets_out", socket.packets_out());
             obj.add("bytes_out", socket.bytes_out());
+            obj.add("congestion_window", socket.congestion_window());
+            obj.add("send_window", socket.send_window_size());
+            obj.add("smoothed_rtt_us", socket.smoothed_round_trip_time().to_microseconds());
             if (Process::current().is_superuser() || Process::current().uid() == socket.origin_uid()) {
                 obj.add("origin_pid", socket.origin_pid().value());
                 obj.add("origin_uid", socket.origin_uid().value());
@@ -290,6 +294,16 @@ private:
     mutable Mutex m_lock;
 };
 
+class ProcFSSyscallStatistics : public ProcFSSystemBoolean {
+public:
+    static NonnullRefPtr<ProcFSSyscallStatistics> must_create(const ProcFSSystemDirectory&);
+    virtual bool value() const override { return g_syscall_statistics_enabled.load(); }
+    virtual void set_value(bool new_value) override { g_syscall_statistics_enabled.store(new_value); }
+
+private:
+    ProcFSSyscallStatistics();
+};
+
 UNMAP_AFTER_INIT NonnullRefPtr<ProcFSDumpKmallocStacks> ProcFSDumpKmallocStacks::must_create(const ProcFSSystemDirectory&)
 {
     return adopt_ref_if_nonnull(new (nothrow) ProcFSDumpKmallocStacks).release_nonnull();
@@ -302,6 +316,10 @@ UNMAP_AFTER_INIT NonnullRefPtr<ProcFSCapsLockRemap> ProcFSCapsLockRemap::must_cr
 {
     return adopt_ref_if_nonnull(new (nothrow) ProcFSCapsLockRemap).release_nonnull();
 }
+UNMAP_AFTER_INIT NonnullRefPtr<ProcFSSyscallStatistics> ProcFSSyscallStatistics::must_create(const ProcFSSystemDirectory&)
+{
+    return adopt_ref_if_nonnull(new (nothrow) ProcFSSyscallStatistics).release_nonnull();
+}
 
 UNMAP_AFTER_INIT ProcFSDumpKmallocStacks::ProcFSDumpKmallocStacks()
     : ProcFSSystemBoolean("kmalloc_stacks"sv)
@@ -318,6 +336,11 @@ UNMAP_AFTER_INIT ProcFSCapsLockRemap::ProcFSCapsLockRemap()
 {
 }
 
+UNMAP_AFTER_INIT ProcFSSyscallStatistics::ProcFSSyscallStatistics()
+    : ProcFSSystemBoolean("syscall_statistics"sv)
+{
+}
+
 class ProcFSSelfProcessDirectory final : public ProcFSExposedLink {
 public:
     static NonnullRefPtr<ProcFSSelfProcessDirectory> must_create();
@@ -378,6 +401,46 @@ private:
     }
 };
 
+class ProcFSDiskCache final : public ProcFSGlobalInformation {
+public:
+    static NonnullRefPtr<ProcFSDiskCache> must_create();
+
+private:
+    ProcFSDiskCache();
+    virtual ErrorOr<void> try_generate(KBufferBuilder& builder) override
+    {
+        JsonArraySerializer array { builder };
+        ErrorOr<void> result;
+        VirtualFileSystem::the().for_each_mount([&array, &result](auto& mount) {
+            auto& fs = mount.guest_fs();
+            if (!fs.is_block_based())
+                return IterationDecision::Continue;
+            auto statistics = static_cast<BlockBasedFileSystem const&>(fs).cache_statistics();
+            auto fs_object = array.add_object();
+            auto mount_point_or_error = mount.absolute_path();
+            if (mount_point_or_error.is_error()) {
+                result = mount_point_or_error.release_error();
+                return IterationDecision::Break;
+            }
+            fs_object.add("mount_point", mount_point_or_error.value()->view());
+            fs_object.add("block_size", static_cast<u64>(fs.block_size()));
+            fs_object.add("cached_blocks", statistics.cached_blocks);
+            fs_object.add("recent_blocks", statistics.recent_blocks);
+            fs_object.add("frequent_blocks", statistics.frequent_blocks);
+            fs_object.add("dirty_blocks", statistics.dirty_blocks);
+            fs_object.add("capacity_blocks", statistics.capacity_blocks);
+            fs_object.add("max_blocks", statistics.max_blocks);
+            fs_object.add("hits", statistics.hits);
+            fs_object.add("misses", statistics.misses);
+            fs_object.add("evictions", statistics.evictions);
+            return IterationDecision::Continue;
+        });
+        if (!result.is_error())
+            array.finish();
+        return result;
+    }
+};
+
 class ProcFSMemoryStatus final : public ProcFSGlobalInformation {
 public:
     static NonnullRefPtr<ProcFSMemoryStatus> must_create();
@@ -400,6 +463,7 @@ private:
         json.add("user_physical_available", system_memory.user_physical_pages - system_memory.user_physical_pages_used);
         json.add("user_physical_committed", system_memory.user_physical_pages_committed);
         json.add("user_physical_uncommitted", system_memory.user_physical_pages_uncommitted);
+        json.add("user_physical_zeroed", system_memory.user_physical_pages_zeroed);
         json.add("super_physical_allocated", system_memory.super_physical_pages_used);
         json.add("super_physical_available", system_memory.super_physical_pages - system_memory.super_physical_pages_used);
         json.add("kmalloc_call_count", stats.kmalloc_call_count);
@@ -409,6 +473,44 @@ private:
     }
 };
 
+class ProcFSKmallocStatistics final : public ProcFSGlobalInformation {
+public:
+    static NonnullRefPtr<ProcFSKmallocStatistics> must_create();
+
+private:
+    ProcFSKmallocStatistics();
+    virtual ErrorOr<void> try_generate(KBufferBuilder& builder) override
+    {
+        InterruptDisabler disabler;
+
+        kmalloc_stats stats;
+        get_kmalloc_stats(stats);
+
+        JsonObjectSerializer<KBufferBuilder> json { builder };
+        json.add("allocated", stats.bytes_allocated);
+        json.add("available", stats.bytes_free);
+        json.add("kmalloc_call_count", stats.kmalloc_call_count);
+        json.add("kfree_call_count", stats.kfree_call_count);
+
+        auto processors_array = json.add_array("processors");
+        Processor::for_each([&](Processor& processor) {
+            kmalloc_processor_cache_stats cache_stats {};
+            if (!get_kmalloc_processor_cache_stats(processor.id(), cache_stats))
+                return;
+            auto obj = processors_array.add_object();
+            obj.add("processor", processor.id());
+            obj.add("cached_bytes", cache_stats.cached_bytes);
+            obj.add("kmalloc_hits", cache_stats.kmalloc_hit_count);
+            obj.add("kmalloc_misses", cache_stats.kmalloc_miss_count);
+            obj.add("kfree_hits", cache_stats.kfree_hit_count);
+            obj.add("kfree_misses", cache_stats.kfree_miss_count);
+        });
+        processors_array.finish();
+        json.finish();
+        return {};
+    }
+};
+
 class ProcFSSystemStatistics final : public ProcFSGlobalInformation {
 public:
     static NonnullRefPtr<ProcFSSystemStatistics> must_create();
@@ -765,10 +867,18 @@ UNMAP_AFTER_INIT NonnullRefPtr<ProcFSDiskUsage> ProcFSDiskUsage::must_create()
 {
     return adopt_ref_if_nonnull(new (nothrow) ProcFSDiskUsage).release_nonnull();
 }
+UNMAP_AFTER_INIT NonnullRefPtr<ProcFSDiskCache> ProcFSDiskCache::must_create()
+{
+    return adopt_ref_if_nonnull(new (nothrow) ProcFSDiskCache).release_nonnull();
+}
 UNMAP_AFTER_INIT NonnullRefPtr<ProcFSMemoryStatus> ProcFSMemoryStatus::must_create()
 {
     return adopt_ref_if_nonnull(new (nothrow) ProcFSMemoryStatus).release_nonnull();
 }
+UNMAP_AFTER_INIT NonnullRefPtr<ProcFSKmallocStatistics> ProcFSKmallocStatistics::must_create()
+{
+    return adopt_ref_if_nonnull(new (nothrow) ProcFSKmallocStatistics).release_nonnull();
+}
 UNMAP_AFTER_INIT NonnullRefPtr<ProcFSSystemStatistics> ProcFSSystemStatistics::must_create()
 {
     return adopt_ref_if_nonnull(new (nothrow) ProcFSSystemStatistics).release_nonnull();
@@ -831,10 +941,18 @@ UNMAP_AFTER_INIT ProcFSDiskUsage::ProcFSDiskUsage()
     : ProcFSGlobalInformation("df"sv)
 {
 }
+UNMAP_AFTER_INIT ProcFSDiskCache::ProcFSDiskCache()
+    : ProcFSGlobalInformation("diskcache"sv)
+{
+}
 UNMAP_AFTER_INIT ProcFSMemoryStatus::ProcFSMemoryStatus()
     : ProcFSGlobalInformation("memstat"sv)
 {
 }
+UNMAP_AFTER_INIT ProcFSKmallocStatistics::ProcFSKmallocStatistics()
+    : ProcFSGlobalInformation("kmalloc"sv)
+{
+}
 UNMAP_AFTER_INIT ProcFSSystemStatistics::ProcFSSystemStatistics()
     : ProcFSGlobalInformation("stat"sv)
 {
@@ -895,6 +1013,7 @@ UNMAP_AFTER_INIT NonnullRefPtr<ProcFSSystemDirectory> ProcFSSystemDirectory::mus
     directory->m_components.append(ProcFSDumpKmallocStacks::must_create(directory));
     directory->m_components.append(ProcFSUBSanDeadly::must_create(directory));
     directory->m_components.append(ProcFSCapsLockRemap::must_create(directory));
+    directory->m_components.append(ProcFSSyscallStatistics::must_create(directory));
     return directory;
 }
 
@@ -908,7 +1027,9 @@ UNMAP_AFTER_INIT NonnullRefPtr<ProcFSRootDirectory> ProcFSRootDirectory::must_cr
     auto directory = adopt_ref(*new (nothrow) ProcFSRootDirectory);
     directory->m_components.append(ProcFSSelfProcessDirectory::must_create());
     directory->m_components.append(ProcFSDiskUsage::must_create());
+    directory->m_components.append(ProcFSDiskCache::must_create());
     directory->m_components.append(ProcFSMemoryStatus::must_create());
+    directory->m_components.append(ProcFSKmallocStatistics::must_create());
     directory->m_components.append(ProcFSSystemStatistics::must_create());
     directory->m_components.append(ProcFSOverallProcesses::must_create());
     directory->m_components.append(ProcFSCPUInformation::must_create());
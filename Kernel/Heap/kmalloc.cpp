@@ -6,6 +6,7 @@
 
 #include <AK/Assertions.h>
 #include <AK/Types.h>
+#include <Kernel/Arch/x86/InterruptDisabler.h>
 #include <Kernel/Debug.h>
 #include <Kernel/Heap/Heap.h>
 #include <Kernel/Heap/kmalloc.h>
@@ -120,22 +121,7 @@ public:
 
     void* allocate()
     {
-        if (m_usable_blocks.is_empty()) {
-            // FIXME: This allocation wastes `block_size` bytes due to the implementation of kmalloc_aligned().
-            //        Handle this with a custom VM+page allocator instead of using kmalloc_aligned().
-            auto* slot = kmalloc_aligned(KmallocSlabBlock::block_size, KmallocSlabBlock::block_size);
-            if (!slot) {
-                // FIXME: Dare to return nullptr!
-                PANIC("OOM while growing slabheap ({})", m_slab_size);
-            }
-            auto* block = new (slot) KmallocSlabBlock(m_slab_size);
-            m_usable_blocks.append(*block);
-        }
-        auto* block = m_usable_blocks.first();
-        auto* ptr = block->allocate();
-        if (block->is_full())
-            m_full_blocks.append(*block);
-
+        auto* ptr = allocate_slab();
         memset(ptr, KMALLOC_SCRUB_BYTE, m_slab_size);
         return ptr;
     }
@@ -143,12 +129,21 @@ public:
     void deallocate(void* ptr)
     {
         memset(ptr, KFREE_SCRUB_BYTE, m_slab_size);
+        deallocate_slab(ptr);
+    }
 
-        auto* block = (KmallocSlabBlock*)((FlatPtr)ptr & KmallocSlabBlock::block_mask);
-        bool block_was_full = block->is_full();
-        block->deallocate(ptr);
-        if (block_was_full)
-            m_usable_blocks.append(*block);
+    // These move slabs to and from a processor cache in one go. The caller is responsible
+    // for scrubbing them, which happens as they are handed out or given back.
+    void allocate_batch(Span<void*> slabs)
+    {
+        for (auto& slab : slabs)
+            slab = allocate_slab();
+    }
+
+    void deallocate_batch(Span<void*> slabs)
+    {
+        for (auto* slab : slabs)
+            deallocate_slab(slab);
     }
 
     size_t allocated_bytes() const
@@ -168,6 +163,35 @@ public:
     }
 
 private:
+    void* allocate_slab()
+    {
+        if (m_usable_blocks.is_empty()) {
+            // FIXME: This allocation wastes `block_size` bytes due to the implementation of kmalloc_aligned().
+            //        Handle this with a custom VM+page allocator instead of using kmalloc_aligned().
+            auto* slot = kmalloc_aligned(KmallocSlabBlock::block_size, KmallocSlabBlock::block_size);
+            if (!slot) {
+                // FIXME: Dare to return nullptr!
+                PANIC("OOM while growing slabheap ({})", m_slab_size);
+            }
+            auto* block = new (slot) KmallocSlabBlock(m_slab_size);
+            m_usable_blocks.append(*block);
+        }
+        auto* block = m_usable_blocks.first();
+        auto* ptr = block->allocate();
+        if (block->is_full())
+            m_full_blocks.append(*block);
+        return ptr;
+    }
+
+    void deallocate_slab(void* ptr)
+    {
+        auto* block = (KmallocSlabBlock*)((FlatPtr)ptr & KmallocSlabBlock::block_mask);
+        bool block_was_full = block->is_full();
+        block->deallocate(ptr);
+        if (block_was_full)
+            m_usable_blocks.append(*block);
+    }
+
     size_t m_slab_size { 0 };
 
     KmallocSlabBlock::List m_usable_blocks;
@@ -346,7 +370,8 @@ struct KmallocGlobalData {
 
     KmallocSubheap::List subheaps;
 
-    KmallocSlabheap slabheaps[6] = { 16, 32, 64, 128, 256, 512 };
+    static constexpr size_t slabheap_count = 6;
+    KmallocSlabheap slabheaps[slabheap_count] = { 16, 32, 64, 128, 256, 512 };
 
     bool expansion_in_progress { false };
 };
@@ -359,6 +384,120 @@ static size_t g_kfree_call_count;
 static size_t g_nested_kfree_calls;
 bool g_dump_kmalloc_stacks;
 
+// Every processor keeps a cache of free slabs for each slabheap, so that most small allocations
+// don't need to take the global kmalloc lock. When a cache runs empty it is refilled from the
+// shared slabheap in one batch, and when it's full, half of it is given back in one batch.
+struct KmallocSlabCache {
+    static constexpr size_t capacity = 32;
+    static constexpr size_t batch_size = capacity / 2;
+
+    size_t count { 0 };
+    void* slabs[capacity];
+};
+
+struct KmallocProcessorCache {
+    KmallocSlabCache slab_caches[KmallocGlobalData::slabheap_count];
+
+    size_t kmalloc_call_count { 0 };
+    size_t kfree_call_count { 0 };
+    size_t kmalloc_hit_count { 0 };
+    size_t kmalloc_miss_count { 0 };
+    size_t kfree_hit_count { 0 };
+    size_t kfree_miss_count { 0 };
+
+    size_t cached_bytes() const
+    {
+        size_t total = 0;
+        for (size_t i = 0; i < KmallocGlobalData::slabheap_count; ++i)
+            total += slab_caches[i].count * g_kmalloc_global->slabheaps[i].slab_size();
+        return total;
+    }
+};
+
+// NOTE: These are created on first use, and only ever touched by their own processor with interrupts disabled.
+static KmallocProcessorCache* s_processor_caches[sizeof(ProcessorContainer) / sizeof(Processor*)];
+
+static KmallocProcessorCache& current_processor_cache()
+{
+    VERIFY_INTERRUPTS_DISABLED();
+    auto cpu = Processor::current_id();
+    VERIFY(cpu < array_size(s_processor_caches));
+    if (auto* cache = s_processor_caches[cpu])
+        return *cache;
+
+    SpinlockLocker lock(s_lock);
+    auto* cache = new (g_kmalloc_global->allocate(sizeof(KmallocProcessorCache))) KmallocProcessorCache;
+    s_processor_caches[cpu] = cache;
+    return *cache;
+}
+
+static Optional<size_t> slabheap_index_for(size_t size)
+{
+    for (size_t i = 0; i < KmallocGlobalData::slabheap_count; ++i) {
+        if (size <= g_kmalloc_global->slabheaps[i].slab_size())
+            return i;
+    }
+    return {};
+}
+
+static void* kmalloc_from_processor_cache(size_t size)
+{
+    auto slabheap_index = slabheap_index_for(size);
+    if (!slabheap_index.has_value())
+        return nullptr;
+    auto& slabheap = g_kmalloc_global->slabheaps[slabheap_index.value()];
+
+    InterruptDisabler disabler;
+    auto& cache = current_processor_cache();
+    auto& slab_cache = cache.slab_caches[slabheap_index.value()];
+    ++cache.kmalloc_call_count;
+
+    if (slab_cache.count == 0) {
+        ++cache.kmalloc_miss_count;
+        SpinlockLocker lock(s_lock);
+        slabheap.allocate_batch({ slab_cache.slabs, KmallocSlabCache::batch_size });
+        slab_cache.count = KmallocSlabCache::batch_size;
+    } else {
+        ++cache.kmalloc_hit_count;
+    }
+
+    auto* ptr = slab_cache.slabs[--slab_cache.count];
+    memset(ptr, KMALLOC_SCRUB_BYTE, slabheap.slab_size());
+    return ptr;
+}
+
+static bool kfree_to_processor_cache(void* ptr, size_t size)
+{
+    auto slabheap_index = slabheap_index_for(size);
+    if (!slabheap_index.has_value())
+        return false;
+    VERIFY(g_kmalloc_global->is_valid_kmalloc_address(VirtualAddress { ptr }));
+    auto& slabheap = g_kmalloc_global->slabheaps[slabheap_index.value()];
+    memset(ptr, KFREE_SCRUB_BYTE, slabheap.slab_size());
+
+    InterruptDisabler disabler;
+    auto& cache = current_processor_cache();
+    auto& slab_cache = cache.slab_caches[slabheap_index.value()];
+    ++cache.kfree_call_count;
+
+    if (slab_cache.count == KmallocSlabCache::capacity) {
+        ++cache.kfree_miss_count;
+        // Give back the slabs that have been sitting in the cache the longest, and keep the ones most likely to still be in the CPU cache.
+        {
+            SpinlockLocker lock(s_lock);
+            slabheap.deallocate_batch({ slab_cache.slabs, KmallocSlabCache::batch_size });
+        }
+        slab_cache.count -= KmallocSlabCache::batch_size;
+        for (size_t i = 0; i < slab_cache.count; ++i)
+            slab_cache.slabs[i] = slab_cache.slabs[i + KmallocSlabCache::batch_size];
+    } else {
+        ++cache.kfree_hit_count;
+    }
+
+    slab_cache.slabs[slab_cache.count++] = ptr;
+    return true;
+}
+
 void kmalloc_enable_expand()
 {
     g_kmalloc_global->enable_expansion();
@@ -384,15 +523,22 @@ UNMAP_AFTER_INIT void kmalloc_init()
 void* kmalloc(size_t size)
 {
     kmalloc_verify_nospinlock_held();
-    SpinlockLocker lock(s_lock);
-    ++g_kmalloc_call_count;
 
-    if (g_dump_kmalloc_stacks && Kernel::g_kernel_symbols_available) {
-        dbgln("kmalloc({})", size);
-        Kernel::dump_backtrace();
-    }
+    void* ptr = nullptr;
+    if (!g_dump_kmalloc_stacks)
+        ptr = kmalloc_from_processor_cache(size);
 
-    void* ptr = g_kmalloc_global->allocate(size);
+    if (!ptr) {
+        SpinlockLocker lock(s_lock);
+        ++g_kmalloc_call_count;
+
+        if (g_dump_kmalloc_stacks && Kernel::g_kernel_symbols_available) {
+            dbgln("kmalloc({})", size);
+            Kernel::dump_backtrace();
+        }
+
+        ptr = g_kmalloc_global->allocate(size);
+    }
 
     Thread* current_thread = Thread::current();
     if (!current_thread)
@@ -415,6 +561,18 @@ void kfree_sized(void* ptr, size_t size)
     VERIFY(size > 0);
 
     kmalloc_verify_nospinlock_held();
+
+    if (kfree_to_processor_cache(ptr, size)) {
+        Thread* current_thread = Thread::current();
+        if (!current_thread)
+            current_thread = Processor::idle_thread();
+        if (current_thread) {
+            VERIFY(current_thread->is_allocation_enabled());
+            PerformanceManager::add_kfree_perf_event(*current_thread, 0, (FlatPtr)ptr);
+        }
+        return;
+    }
+
     SpinlockLocker lock(s_lock);
     ++g_kfree_call_count;
     ++g_nested_kfree_calls;
@@ -523,4 +681,30 @@ void get_kmalloc_stats(kmalloc_stats& stats)
     stats.bytes_free = g_kmalloc_global->free_bytes();
     stats.kmalloc_call_count = g_kmalloc_call_count;
     stats.kfree_call_count = g_kfree_call_count;
+
+    // Slabs sitting in a processor cache are free as far as the users of kmalloc are concerned.
+    for (auto const* cache : s_processor_caches) {
+        if (!cache)
+            continue;
+        auto cached_bytes = cache->cached_bytes();
+        stats.bytes_allocated -= cached_bytes;
+        stats.bytes_free += cached_bytes;
+        stats.kmalloc_call_count += cache->kmalloc_call_count;
+        stats.kfree_call_count += cache->kfree_call_count;
+    }
+}
+
+bool get_kmalloc_processor_cache_stats(u32 cpu, kmalloc_processor_cache_stats& stats)
+{
+    if (cpu >= array_size(s_processor_caches))
+        return false;
+    auto const* cache = s_processor_caches[cpu];
+    if (!cache)
+        return false;
+    stats.cached_bytes = cache->cached_bytes();
+    stats.kmalloc_hit_count = cache->kmalloc_hit_count;
+    stats.kmalloc_miss_count = cache->kmalloc_miss_count;
+    stats.kfree_hit_count = cache->kfree_hit_count;
+    stats.kfree_miss_count = cache->kfree_miss_count;
+    return true;
 }
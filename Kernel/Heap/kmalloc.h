@@ -50,6 +50,15 @@ struct kmalloc_stats {
 };
 void get_kmalloc_stats(kmalloc_stats&);
 
+struct kmalloc_processor_cache_stats {
+    size_t cached_bytes;
+    size_t kmalloc_hit_count;
+    size_t kmalloc_miss_count;
+    size_t kfree_hit_count;
+    size_t kfree_miss_count;
+};
+bool get_kmalloc_processor_cache_stats(u32 cpu, kmalloc_processor_cache_stats&);
+
 extern bool g_dump_kmalloc_stacks;
 
 inline void* operator new(size_t, void* p) { return p; }
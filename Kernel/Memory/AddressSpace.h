@@ -10,6 +10,7 @@
 #include <AK/RedBlackTree.h>
 #include <AK/Vector.h>
 #include <AK/WeakPtr.h>
+#include <Kernel/Locking/Mutex.h>
 #include <Kernel/Memory/AllocationStrategy.h>
 #include <Kernel/Memory/PageDirectory.h>
 #include <Kernel/UnixTypes.h>
@@ -57,6 +58,10 @@ public:
 
     RecursiveSpinlock& get_lock() const { return m_lock; }
 
+    // Serializes operations that create, destroy or reshape regions on behalf of
+    // userspace (mmap, munmap, mprotect, ...), so they don't need the process big lock.
+    Mutex& mapping_lock() { return m_mapping_lock; }
+
     ErrorOr<size_t> amount_clean_inode() const;
     size_t amount_dirty_private() const;
     size_t amount_virtual() const;
@@ -69,6 +74,7 @@ private:
     explicit AddressSpace(NonnullRefPtr<PageDirectory>);
 
     mutable RecursiveSpinlock m_lock;
+    Mutex m_mapping_lock { "AddressSpace" };
 
     RefPtr<PageDirectory> m_page_directory;
 
@@ -258,6 +258,41 @@ NonnullRefPtr<PhysicalPage> AnonymousVMObject::allocate_committed_page(Badge<Reg
     return m_unused_committed_pages->take_one();
 }
 
+bool AnonymousVMObject::try_allocate_huge_page(Badge<Region>, size_t first_page_index)
+{
+    VERIFY(m_lock.is_locked());
+    if (first_page_index + pages_per_huge_page > page_count())
+        return false;
+    if (is_volatile())
+        return false;
+
+    // We only back a huge page range in one go if none of it has been touched yet, and all of it
+    // is either committed or not. Anything else gets filled in one page at a time.
+    auto pages = physical_pages().slice(first_page_index, pages_per_huge_page);
+    bool is_committed = pages[0]->is_lazy_committed_page();
+    for (auto& page : pages) {
+        if (is_committed && !page->is_lazy_committed_page())
+            return false;
+        if (!is_committed && !page->is_shared_zero_page())
+            return false;
+    }
+
+    if (is_committed) {
+        if (!m_unused_committed_pages->try_take_huge_page(pages))
+            return false;
+    } else {
+        if (!MM.allocate_huge_user_physical_page(pages))
+            return false;
+    }
+
+    // These pages are brand new, so there's nothing to copy when they get written to.
+    if (!m_cow_map.is_null()) {
+        for (size_t i = 0; i < pages_per_huge_page; ++i)
+            m_cow_map.set(first_page_index + i, false);
+    }
+    return true;
+}
+
 ErrorOr<void> AnonymousVMObject::ensure_cow_map()
 {
     if (m_cow_map.is_null())
@@ -69,6 +69,26 @@ int InodeVMObject::release_all_clean_pages()
     return count;
 }
 
+int InodeVMObject::release_pages_from(size_t first_page_index)
+{
+    SpinlockLocker locker(m_lock);
+
+    int count = 0;
+    for (size_t i = first_page_index; i < page_count(); ++i) {
+        if (m_physical_pages[i]) {
+            m_physical_pages[i] = nullptr;
+            m_dirty_pages.set(i, false);
+            ++count;
+        }
+    }
+    if (count) {
+        for_each_region([](auto& region) {
+            region.remap();
+        });
+    }
+    return count;
+}
+
 u32 InodeVMObject::writable_mappings() const
 {
     u32 count = 0;
@@ -23,6 +23,8 @@ public:
     size_t amount_clean() const;
 
     int release_all_clean_pages();
+    // Called when the inode shrinks, so that accessing the pages past its new end faults them in again.
+    int release_pages_from(size_t first_page_index);
 
     u32 writable_mappings() const;
     u32 executable_mappings() const;
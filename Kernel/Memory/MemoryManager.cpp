@@ -21,8 +21,11 @@
 #include <Kernel/Multiboot.h>
 #include <Kernel/Panic.h>
 #include <Kernel/Process.h>
+#include <Kernel/Scheduler.h>
 #include <Kernel/Sections.h>
 #include <Kernel/StdLib.h>
+#include <Kernel/Tasks/SyncTask.h>
+#include <Kernel/WaitQueue.h>
 
 extern u8 start_of_kernel_image[];
 extern u8 end_of_kernel_image[];
@@ -61,6 +64,45 @@ ErrorOr<FlatPtr> page_round_up(FlatPtr x)
 static MemoryManager* s_the;
 RecursiveSpinlock s_mm_lock { LockRank::MemoryManager };
 
+// Free pages that a processor's zeroing thread has cleared ahead of time, so that zero-fill allocations on
+// that processor can skip the memset. Pooled pages are still accounted as free, and allocations that find
+// no free pages left in the physical regions steal them from any processor's pool.
+struct ZeroedPagePool {
+    static constexpr size_t capacity = 64;
+    // The zeroing thread is woken up once the pool has drained this far, so that it refills it in batches.
+    static constexpr size_t refill_threshold = capacity / 2;
+
+    size_t count { 0 };
+    bool refill_requested { false };
+    RefPtr<PhysicalPage> pages[capacity];
+    WaitQueue wait_queue;
+};
+
+// The zeroing threads stop once this few free pages are left outside of the pools, so that allocations
+// that don't need zeroed pages (or need contiguous ones) don't have to dig into them.
+static constexpr size_t zeroed_page_pool_free_page_reserve = 256;
+
+// NOTE: These are created by start_zeroed_page_pool_threads(), and only ever touched with s_mm_lock held.
+static ZeroedPagePool* s_zeroed_page_pools[sizeof(ProcessorContainer) / sizeof(Processor*)];
+
+// Pages that are zeroed ahead of time won't be touched again until someone faults them in, so we clear
+// them with non-temporal stores to avoid pushing anything useful out of the caches.
+static void zero_page_bypassing_caches(u8* page)
+{
+    if (!Processor::current().has_feature(CPUFeature::SSE2)) {
+        memset(page, 0, PAGE_SIZE);
+        return;
+    }
+    auto* words = reinterpret_cast<FlatPtr*>(page);
+    for (size_t i = 0; i < PAGE_SIZE / sizeof(FlatPtr); ++i)
+        asm volatile("movnti %[zero], %[word]"
+                     : [word] "=m"(words[i])
+                     : [zero] "r"(static_cast<FlatPtr>(0)));
+    // Non-temporal stores are weakly ordered, so make sure they have landed before anyone else can use the page.
+    asm volatile("sfence" ::
+                     : "memory");
+}
+
 MemoryManager& MemoryManager::the()
 {
     return *s_the;
@@ -554,6 +596,7 @@ PageTableEntry* MemoryManager::pte(PageDirectory& page_directory, VirtualAddress
     PageDirectoryEntry const& pde = pd[page_directory_index];
     if (!pde.is_present())
         return nullptr;
+    VERIFY(!pde.is_huge());
 
     return &quickmap_pt(PhysicalAddress((FlatPtr)pde.page_table_base()))[page_table_index];
 }
@@ -569,9 +612,13 @@ PageTableEntry* MemoryManager::ensure_pte(PageDirectory& page_directory, Virtual
 
     auto* pd = quickmap_pd(page_directory, page_directory_table_index);
     auto& pde = pd[page_directory_index];
-    if (pde.is_present())
+    if (pde.is_present() && !pde.is_huge())
         return &quickmap_pt(PhysicalAddress(pde.page_table_base()))[page_table_index];
 
+    // If a huge page covers this address, we split it up into a page table with the same mappings,
+    // so that the caller can change just the one page it's interested in.
+    bool is_splitting_huge_page = pde.is_present();
+
     bool did_purge = false;
     auto page_table_or_error = allocate_user_physical_page(ShouldZeroFill::Yes, &did_purge);
     if (page_table_or_error.is_error()) {
@@ -586,13 +633,43 @@ PageTableEntry* MemoryManager::ensure_pte(PageDirectory& page_directory, Virtual
         pd = quickmap_pd(page_directory, page_directory_table_index);
         VERIFY(&pde == &pd[page_directory_index]); // Sanity check
 
-        VERIFY(!pde.is_present()); // Should have not changed
+        if (is_splitting_huge_page && !pde.is_huge()) {
+            // Purging remapped the huge page we were about to split, which split it for us.
+            return &quickmap_pt(PhysicalAddress(pde.page_table_base()))[page_table_index];
+        }
+        VERIFY(pde.is_present() == is_splitting_huge_page); // Should have not changed
+    }
+
+    PageDirectoryEntry new_pde;
+    new_pde.clear();
+    new_pde.set_page_table_base(page_table->paddr().get());
+    new_pde.set_user_allowed(true);
+    new_pde.set_present(true);
+    new_pde.set_writable(true);
+    new_pde.set_global(&page_directory == m_kernel_page_directory.ptr());
+
+    if (is_splitting_huge_page) {
+        auto huge_page_base = pde.page_table_base();
+        auto* ptes = quickmap_pt(page_table->paddr());
+        for (size_t i = 0; i < pages_per_huge_page; ++i) {
+            auto& pte = ptes[i];
+            pte.set_physical_page_base(huge_page_base + i * PAGE_SIZE);
+            pte.set_present(true);
+            pte.set_writable(pde.is_writable());
+            pte.set_user_allowed(pde.is_user_allowed());
+            pte.set_write_through(pde.is_write_through());
+            pte.set_cache_disabled(pde.is_cache_disabled());
+            pte.set_global(pde.is_global());
+            pte.set_execute_disabled(pde.is_execute_disabled());
+        }
+        dbgln_if(PAGE_FAULT_DEBUG, "MM: Split huge page @ {} for {}", PhysicalAddress(huge_page_base), vaddr);
     }
-    pde.set_page_table_base(page_table->paddr().get());
-    pde.set_user_allowed(true);
-    pde.set_present(true);
-    pde.set_writable(true);
-    pde.set_global(&page_directory == m_kernel_page_directory.ptr());
+
+    // Replace the entry in one go, since other processors may be walking through it.
+    pde = new_pde;
+
+    if (is_splitting_huge_page)
+        flush_tlb(&page_directory, VirtualAddress(vaddr.get() & ~(huge_page_size - 1)), pages_per_huge_page);
 
     // NOTE: This leaked ref is matched by the unref in MemoryManager::release_pte()
     (void)page_table.leak_ref();
@@ -612,6 +689,7 @@ void MemoryManager::release_pte(PageDirectory& page_directory, VirtualAddress va
     auto* pd = quickmap_pd(page_directory, page_directory_table_index);
     PageDirectoryEntry& pde = pd[page_directory_index];
     if (pde.is_present()) {
+        VERIFY(!pde.is_huge());
         auto* page_table = quickmap_pt(PhysicalAddress((FlatPtr)pde.page_table_base()));
         auto& pte = page_table[page_table_index];
         pte.clear();
@@ -634,6 +712,57 @@ void MemoryManager::release_pte(PageDirectory& page_directory, VirtualAddress va
     }
 }
 
+void MemoryManager::set_huge_pde(PageDirectory& page_directory, VirtualAddress vaddr, PageDirectoryEntry const& huge_pde)
+{
+    VERIFY_INTERRUPTS_DISABLED();
+    VERIFY(s_mm_lock.is_locked_by_current_processor());
+    VERIFY(page_directory.get_lock().is_locked_by_current_processor());
+    VERIFY(vaddr.get() % huge_page_size == 0);
+    VERIFY(huge_pde.is_huge());
+    u32 page_directory_table_index = (vaddr.get() >> 30) & 0x1ff;
+    u32 page_directory_index = (vaddr.get() >> 21) & 0x1ff;
+
+    auto* pd = quickmap_pd(page_directory, page_directory_table_index);
+    PageDirectoryEntry& pde = pd[page_directory_index];
+    bool had_page_table = pde.is_present() && !pde.is_huge();
+    auto old_page_table_base = PhysicalAddress { pde.page_table_base() };
+
+    pde = huge_pde;
+
+    // The page table only held mappings for the pages that the huge page now covers.
+    if (had_page_table)
+        get_physical_page_entry(old_page_table_base).allocated.physical_page.unref();
+}
+
+bool MemoryManager::release_huge_pde(PageDirectory& page_directory, VirtualAddress vaddr)
+{
+    VERIFY_INTERRUPTS_DISABLED();
+    VERIFY(s_mm_lock.is_locked_by_current_processor());
+    VERIFY(page_directory.get_lock().is_locked_by_current_processor());
+    u32 page_directory_table_index = (vaddr.get() >> 30) & 0x1ff;
+    u32 page_directory_index = (vaddr.get() >> 21) & 0x1ff;
+
+    auto* pd = quickmap_pd(page_directory, page_directory_table_index);
+    PageDirectoryEntry& pde = pd[page_directory_index];
+    if (!pde.is_present() || !pde.is_huge())
+        return false;
+    pde.clear();
+    return true;
+}
+
+bool MemoryManager::is_mapped_with_huge_page(PageDirectory& page_directory, VirtualAddress vaddr)
+{
+    VERIFY_INTERRUPTS_DISABLED();
+    VERIFY(s_mm_lock.is_locked_by_current_processor());
+    VERIFY(page_directory.get_lock().is_locked_by_current_processor());
+    u32 page_directory_table_index = (vaddr.get() >> 30) & 0x1ff;
+    u32 page_directory_index = (vaddr.get() >> 21) & 0x1ff;
+
+    auto* pd = quickmap_pd(page_directory, page_directory_table_index);
+    PageDirectoryEntry const& pde = pd[page_directory_index];
+    return pde.is_present() && pde.is_huge();
+}
+
 UNMAP_AFTER_INIT void MemoryManager::initialize(u32 cpu)
 {
     ProcessorSpecific<MemoryManagerData>::initialize();
@@ -826,10 +955,30 @@ ErrorOr<NonnullOwnPtr<Region>> MemoryManager::allocate_kernel_region_with_vmobje
     return allocate_kernel_region_with_vmobject(range, vmobject, name, access, cacheable);
 }
 
+size_t MemoryManager::reclaim_page_cache(SpinlockLocker<RecursiveSpinlock>& lock, size_t page_count)
+{
+    VERIFY(lock.have_lock());
+    // The page cache frees pages with its own lock held, and that one nests outside of s_mm_lock.
+    // So we can only get to it if the caller didn't already hold s_mm_lock before taking this locker.
+    lock.unlock();
+    if (s_mm_lock.is_locked_by_current_processor() || Processor::current_in_irq()) {
+        lock.lock();
+        return 0;
+    }
+    auto reclaimed_page_count = Inode::reclaim_page_cache(page_count);
+    // The block caches of the file systems are guarded by mutexes, so they can't be shrunk from here.
+    // Have the SyncTask flush them, which also gives clean cache chunks back while memory is tight.
+    SyncTask::wake();
+    lock.lock();
+    return reclaimed_page_count;
+}
+
 ErrorOr<CommittedPhysicalPageSet> MemoryManager::commit_user_physical_pages(size_t page_count)
 {
     VERIFY(page_count > 0);
     SpinlockLocker lock(s_mm_lock);
+    if (m_system_memory_info.user_physical_pages_uncommitted < page_count)
+        reclaim_page_cache(lock, page_count - m_system_memory_info.user_physical_pages_uncommitted);
     if (m_system_memory_info.user_physical_pages_uncommitted < page_count)
         return ENOMEM;
 
@@ -876,7 +1025,7 @@ void MemoryManager::deallocate_physical_page(PhysicalAddress paddr)
     --m_system_memory_info.super_physical_pages_used;
 }
 
-RefPtr<PhysicalPage> MemoryManager::find_free_user_physical_page(bool committed)
+RefPtr<PhysicalPage> MemoryManager::find_free_user_physical_page(bool committed, ShouldZeroFill should_zero_fill)
 {
     VERIFY(s_mm_lock.is_locked());
     RefPtr<PhysicalPage> page;
@@ -890,33 +1039,151 @@ RefPtr<PhysicalPage> MemoryManager::find_free_user_physical_page(bool committed)
             return {};
         m_system_memory_info.user_physical_pages_uncommitted--;
     }
-    for (auto& region : m_user_physical_regions) {
-        page = region.take_free_page();
-        if (!page.is_null()) {
-            ++m_system_memory_info.user_physical_pages_used;
-            break;
+
+    bool page_is_zeroed = false;
+    if (should_zero_fill == ShouldZeroFill::Yes) {
+        page = take_page_from_zeroed_page_pool(Processor::current_id());
+        page_is_zeroed = !page.is_null();
+    }
+    if (page.is_null()) {
+        for (auto& region : m_user_physical_regions) {
+            page = region.take_free_page();
+            if (!page.is_null())
+                break;
         }
     }
+    if (page.is_null()) {
+        // Whatever free pages we have left are sitting in the zeroed page pools.
+        for (u32 cpu = 0; cpu < array_size(s_zeroed_page_pools) && page.is_null(); ++cpu)
+            page = take_page_from_zeroed_page_pool(cpu);
+        page_is_zeroed = !page.is_null();
+    }
     VERIFY(!committed || !page.is_null());
+    if (page.is_null())
+        return {};
+
+    ++m_system_memory_info.user_physical_pages_used;
+    if (should_zero_fill == ShouldZeroFill::Yes && !page_is_zeroed) {
+        auto* ptr = quickmap_page(*page);
+        memset(ptr, 0, PAGE_SIZE);
+        unquickmap_page();
+    }
     return page;
 }
 
+RefPtr<PhysicalPage> MemoryManager::take_page_from_zeroed_page_pool(u32 cpu)
+{
+    VERIFY(s_mm_lock.is_locked());
+    auto* pool = s_zeroed_page_pools[cpu];
+    if (!pool || pool->count == 0)
+        return {};
+
+    auto page = move(pool->pages[--pool->count]);
+    --m_system_memory_info.user_physical_pages_zeroed;
+    if (pool->count <= ZeroedPagePool::refill_threshold && !pool->refill_requested) {
+        pool->refill_requested = true;
+        // NOTE: We're holding s_mm_lock, so this runs once we leave the critical section.
+        Processor::deferred_call_queue([pool] {
+            pool->wait_queue.wake_one();
+        });
+    }
+    return page;
+}
+
+void MemoryManager::refill_zeroed_page_pool(ZeroedPagePool& pool)
+{
+    if (ensure_page_mapping_region_for_current_thread().is_error())
+        return;
+    auto* ptr = Thread::current()->page_mapping_region()->vaddr().as_ptr();
+
+    // Pages are cleared through our own mapping, so that s_mm_lock is only held to put a zeroed page into the pool
+    // and to take the next free one, rather than while clearing it.
+    RefPtr<PhysicalPage> zeroed_page;
+    for (;;) {
+        RefPtr<PhysicalPage> page;
+        {
+            SpinlockLocker page_lock(kernel_page_directory().get_lock());
+            SpinlockLocker lock(s_mm_lock);
+            if (zeroed_page) {
+                // Only we add pages to the pool, so there's still room for this one.
+                VERIFY(pool.count < ZeroedPagePool::capacity);
+                pool.pages[pool.count++] = move(zeroed_page);
+                ++m_system_memory_info.user_physical_pages_zeroed;
+                ++m_system_memory_info.user_physical_pages_uncommitted;
+            }
+
+            auto free_pages_outside_pools = m_system_memory_info.user_physical_pages - m_system_memory_info.user_physical_pages_used - m_system_memory_info.user_physical_pages_zeroed;
+            if (pool.count < ZeroedPagePool::capacity && free_pages_outside_pools > zeroed_page_pool_free_page_reserve && m_system_memory_info.user_physical_pages_uncommitted > 0) {
+                for (auto& region : m_user_physical_regions) {
+                    page = region.take_free_page();
+                    if (!page.is_null())
+                        break;
+                }
+            }
+            if (page.is_null()) {
+                pool.refill_requested = false;
+                if (Thread::current()->has_page_mapped())
+                    set_page_mapping_for_current_thread(nullptr);
+                return;
+            }
+
+            // NOTE: Allocations can't find the page while we're clearing it, so take it out of the uncommitted pages
+            //       until it's in the pool. Once it is, it's accounted as free (and committable) again.
+            --m_system_memory_info.user_physical_pages_uncommitted;
+            set_page_mapping_for_current_thread(page.ptr());
+        }
+
+        zero_page_bypassing_caches(ptr);
+        zeroed_page = move(page);
+    }
+}
+
+void MemoryManager::zeroed_page_pool_thread(void* data)
+{
+    auto& pool = *static_cast<ZeroedPagePool*>(data);
+    for (;;) {
+        MM.refill_zeroed_page_pool(pool);
+        pool.wait_queue.wait_forever("ZeroedPagePool"sv);
+    }
+}
+
+UNMAP_AFTER_INIT void MemoryManager::start_zeroed_page_pool_threads()
+{
+    RefPtr<Process> process;
+    // NOTE: Processors that don't run any threads don't allocate pages either, so they don't need a pool.
+    for (u32 cpu = 0; cpu < Scheduler::schedulable_processor_count(); ++cpu) {
+        auto* pool = new ZeroedPagePool;
+        VERIFY(pool);
+        {
+            SpinlockLocker lock(s_mm_lock);
+            s_zeroed_page_pools[cpu] = pool;
+        }
+
+        // NOTE: These run at the lowest priority, so they only ever get to zero pages when the processor is otherwise idle.
+        RefPtr<Thread> thread;
+        auto name = KString::must_create("ZeroedPagePool"sv);
+        if (!process) {
+            process = Process::create_kernel_process(thread, move(name), zeroed_page_pool_thread, pool, 1u << cpu);
+            VERIFY(process);
+            thread->set_priority(THREAD_PRIORITY_MIN);
+        } else {
+            thread = process->create_kernel_thread(zeroed_page_pool_thread, pool, THREAD_PRIORITY_MIN, move(name), 1u << cpu, false);
+            VERIFY(thread);
+        }
+    }
+}
+
 NonnullRefPtr<PhysicalPage> MemoryManager::allocate_committed_user_physical_page(Badge<CommittedPhysicalPageSet>, ShouldZeroFill should_zero_fill)
 {
     SpinlockLocker lock(s_mm_lock);
-    auto page = find_free_user_physical_page(true);
-    if (should_zero_fill == ShouldZeroFill::Yes) {
-        auto* ptr = quickmap_page(*page);
-        memset(ptr, 0, PAGE_SIZE);
-        unquickmap_page();
-    }
+    auto page = find_free_user_physical_page(true, should_zero_fill);
     return page.release_nonnull();
 }
 
 ErrorOr<NonnullRefPtr<PhysicalPage>> MemoryManager::allocate_user_physical_page(ShouldZeroFill should_zero_fill, bool* did_purge)
 {
     SpinlockLocker lock(s_mm_lock);
-    auto page = find_free_user_physical_page(false);
+    auto page = find_free_user_physical_page(false, should_zero_fill);
     bool purged_pages = false;
 
     if (!page) {
@@ -930,28 +1197,101 @@ ErrorOr<NonnullRefPtr<PhysicalPage>> MemoryManager::allocate_user_physical_page(
                 return IterationDecision::Continue;
             if (auto purged_page_count = anonymous_vmobject.purge()) {
                 dbgln("MM: Purge saved the day! Purged {} pages from AnonymousVMObject", purged_page_count);
-                page = find_free_user_physical_page(false);
+                page = find_free_user_physical_page(false, should_zero_fill);
                 purged_pages = true;
                 VERIFY(page);
                 return IterationDecision::Break;
             }
             return IterationDecision::Continue;
         });
+        if (!page && reclaim_page_cache(lock, page_cache_reclaim_page_count) > 0) {
+            dbgln("MM: Reclaimed pages from the page cache");
+            page = find_free_user_physical_page(false, should_zero_fill);
+        }
         if (!page) {
             dmesgln("MM: no user physical pages available");
             return ENOMEM;
         }
     }
 
-    if (should_zero_fill == ShouldZeroFill::Yes) {
+    if (did_purge)
+        *did_purge = purged_pages;
+    return page.release_nonnull();
+}
+
+bool MemoryManager::allocate_committed_huge_user_physical_page(Badge<CommittedPhysicalPageSet>, Span<RefPtr<PhysicalPage>> pages)
+{
+    {
+        SpinlockLocker lock(s_mm_lock);
+        if (!allocate_huge_user_physical_page_impl(true, pages))
+            return false;
+    }
+    zero_huge_page(pages);
+    return true;
+}
+
+bool MemoryManager::allocate_huge_user_physical_page(Span<RefPtr<PhysicalPage>> pages)
+{
+    {
+        SpinlockLocker lock(s_mm_lock);
+        if (!allocate_huge_user_physical_page_impl(false, pages))
+            return false;
+    }
+    zero_huge_page(pages);
+    return true;
+}
+
+void MemoryManager::zero_huge_page(Span<RefPtr<PhysicalPage>> pages)
+{
+    // Clearing 2 MiB takes a while, so it happens through a mapping of our own rather than the quickmap,
+    // which would have us hold s_mm_lock (and stall every other MM operation) the whole time.
+    VERIFY(!s_mm_lock.is_locked_by_current_processor());
+    if (auto region_or_error = allocate_kernel_region(pages[0]->paddr(), huge_page_size, "Huge page zeroing"sv, Region::Access::ReadWrite); !region_or_error.is_error()) {
+        memset(region_or_error.value()->vaddr().as_ptr(), 0, huge_page_size);
+        return;
+    }
+
+    // We couldn't map the whole huge page, so clear it one page at a time, only holding s_mm_lock for one page at once.
+    for (auto& page : pages) {
+        SpinlockLocker lock(s_mm_lock);
         auto* ptr = quickmap_page(*page);
         memset(ptr, 0, PAGE_SIZE);
         unquickmap_page();
     }
+}
 
-    if (did_purge)
-        *did_purge = purged_pages;
-    return page.release_nonnull();
+bool MemoryManager::allocate_huge_user_physical_page_impl(bool committed, Span<RefPtr<PhysicalPage>> pages)
+{
+    VERIFY(s_mm_lock.is_locked());
+    VERIFY(pages.size() == pages_per_huge_page);
+
+    if (committed)
+        VERIFY(m_system_memory_info.user_physical_pages_committed >= pages_per_huge_page);
+    else if (m_system_memory_info.user_physical_pages_uncommitted < pages_per_huge_page)
+        return false;
+
+    // NOTE: Unlike with single pages, we don't purge volatile memory to make room here,
+    //       since the caller can always fall back to single pages instead.
+    Optional<PhysicalAddress> huge_page_base;
+    for (auto& region : m_user_physical_regions) {
+        huge_page_base = region.take_aligned_free_pages(pages_per_huge_page);
+        if (huge_page_base.has_value())
+            break;
+    }
+    if (!huge_page_base.has_value())
+        return false;
+
+    if (committed)
+        m_system_memory_info.user_physical_pages_committed -= pages_per_huge_page;
+    else
+        m_system_memory_info.user_physical_pages_uncommitted -= pages_per_huge_page;
+    m_system_memory_info.user_physical_pages_used += pages_per_huge_page;
+
+    // The pages are handed out individually, so that they can be freed one by one once the huge page gets split.
+    // NOTE: The caller clears them once s_mm_lock is dropped, see zero_huge_page().
+    for (size_t i = 0; i < pages_per_huge_page; ++i)
+        pages[i] = PhysicalPage::create(huge_page_base.value().offset(i * PAGE_SIZE));
+    return true;
 }
 
 ErrorOr<NonnullRefPtrVector<PhysicalPage>> MemoryManager::allocate_contiguous_user_physical_pages(size_t size)
@@ -1206,6 +1546,16 @@ NonnullRefPtr<PhysicalPage> CommittedPhysicalPageSet::take_one()
     return MM.allocate_committed_user_physical_page({}, MemoryManager::ShouldZeroFill::Yes);
 }
 
+bool CommittedPhysicalPageSet::try_take_huge_page(Span<RefPtr<PhysicalPage>> pages)
+{
+    if (m_page_count < pages_per_huge_page)
+        return false;
+    if (!MM.allocate_committed_huge_user_physical_page({}, pages))
+        return false;
+    m_page_count -= pages_per_huge_page;
+    return true;
+}
+
 void CommittedPhysicalPageSet::uncommit_one()
 {
     VERIFY(m_page_count > 0);
@@ -1221,4 +1571,63 @@ void MemoryManager::copy_physical_page(PhysicalPage& physical_page, u8 page_buff
     unquickmap_page();
 }
 
+void MemoryManager::copy_to_physical_page(PhysicalPage& physical_page, size_t offset_in_page, ReadonlyBytes bytes)
+{
+    VERIFY(offset_in_page + bytes.size() <= PAGE_SIZE);
+    SpinlockLocker locker(s_mm_lock);
+    auto* quickmapped_page = quickmap_page(physical_page);
+    memcpy(quickmapped_page + offset_in_page, bytes.data(), bytes.size());
+    unquickmap_page();
+}
+
+ErrorOr<void> MemoryManager::ensure_page_mapping_region_for_current_thread()
+{
+    auto& thread = *Thread::current();
+    if (!thread.page_mapping_region())
+        thread.set_page_mapping_region(TRY(allocate_kernel_region(PAGE_SIZE, "Page mapping"sv, Region::Access::ReadWrite, AllocationStrategy::None)));
+    return {};
+}
+
+void MemoryManager::set_page_mapping_for_current_thread(PhysicalPage* physical_page)
+{
+    VERIFY(kernel_page_directory().get_lock().is_locked_by_current_processor());
+    VERIFY(s_mm_lock.is_locked_by_current_processor());
+    auto& thread = *Thread::current();
+    auto vaddr = thread.page_mapping_region()->vaddr();
+    auto* pte = this->pte(kernel_page_directory(), vaddr);
+    VERIFY(pte);
+    if (physical_page) {
+        pte->set_physical_page_base(physical_page->paddr().get());
+        pte->set_present(true);
+        pte->set_writable(true);
+        pte->set_user_allowed(false);
+    } else {
+        pte->clear();
+    }
+    // Nobody but this thread uses the address, so only the processors it ran on can have a stale translation for it.
+    // This one is flushed here, and enter_thread_context() flushes it on any other processor the thread moves to.
+    flush_tlb_local(vaddr);
+    thread.set_has_page_mapped(physical_page != nullptr);
+}
+
+ErrorOr<u8*> MemoryManager::map_page_for_current_thread(PhysicalPage& physical_page)
+{
+    VERIFY(!Thread::current()->has_page_mapped());
+    TRY(ensure_page_mapping_region_for_current_thread());
+
+    SpinlockLocker page_lock(kernel_page_directory().get_lock());
+    SpinlockLocker lock(s_mm_lock);
+    set_page_mapping_for_current_thread(&physical_page);
+    return Thread::current()->page_mapping_region()->vaddr().as_ptr();
+}
+
+void MemoryManager::unmap_page_for_current_thread()
+{
+    VERIFY(Thread::current()->has_page_mapped());
+
+    SpinlockLocker page_lock(kernel_page_directory().get_lock());
+    SpinlockLocker lock(s_mm_lock);
+    set_page_mapping_for_current_thread(nullptr);
+}
+
 }
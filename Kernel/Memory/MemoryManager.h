@@ -35,6 +35,10 @@ constexpr FlatPtr page_round_down(FlatPtr x)
     return ((FlatPtr)(x)) & ~(PAGE_SIZE - 1);
 }
 
+// A single page directory entry can map 2 MiB of memory, both with PAE and in long mode.
+static constexpr size_t huge_page_size = 2 * MiB;
+static constexpr size_t pages_per_huge_page = huge_page_size / PAGE_SIZE;
+
 inline FlatPtr virtual_to_low_physical(FlatPtr virtual_)
 {
     return virtual_ - physical_to_virtual_offset;
@@ -94,6 +98,8 @@ struct MemoryManagerData {
     PhysicalAddress m_last_quickmap_pt;
 };
 
+struct ZeroedPagePool;
+
 // NOLINTNEXTLINE(readability-redundant-declaration) FIXME: Why do we declare this here *and* in Thread.h?
 extern RecursiveSpinlock s_mm_lock;
 
@@ -121,6 +127,8 @@ public:
     size_t page_count() const { return m_page_count; }
 
     [[nodiscard]] NonnullRefPtr<PhysicalPage> take_one();
+    // Fills `pages` with a huge page worth of physically contiguous pages, if such a run is free.
+    [[nodiscard]] bool try_take_huge_page(Span<RefPtr<PhysicalPage>> pages);
     void uncommit_one();
 
     void operator=(CommittedPhysicalPageSet&&) = delete;
@@ -142,6 +150,10 @@ public:
 
     static void initialize(u32 cpu);
 
+    // Starts a low priority thread on each processor that keeps a pool of zeroed pages around,
+    // so that zero-fill page faults don't have to clear a page while holding the MM lock.
+    void start_zeroed_page_pool_threads();
+
     static inline MemoryManagerData& get_data()
     {
         return ProcessorSpecific<MemoryManagerData>::get();
@@ -172,6 +184,10 @@ public:
 
     NonnullRefPtr<PhysicalPage> allocate_committed_user_physical_page(Badge<CommittedPhysicalPageSet>, ShouldZeroFill = ShouldZeroFill::Yes);
     ErrorOr<NonnullRefPtr<PhysicalPage>> allocate_user_physical_page(ShouldZeroFill = ShouldZeroFill::Yes, bool* did_purge = nullptr);
+    // These fill `pages` with zeroed user pages that are physically contiguous and aligned so that they can be mapped
+    // as a single huge page. They fail if no such run is free, and callers are expected to fall back to single pages.
+    [[nodiscard]] bool allocate_committed_huge_user_physical_page(Badge<CommittedPhysicalPageSet>, Span<RefPtr<PhysicalPage>> pages);
+    [[nodiscard]] bool allocate_huge_user_physical_page(Span<RefPtr<PhysicalPage>> pages);
     ErrorOr<NonnullRefPtr<PhysicalPage>> allocate_supervisor_physical_page();
     ErrorOr<NonnullRefPtrVector<PhysicalPage>> allocate_contiguous_supervisor_physical_pages(size_t size);
     ErrorOr<NonnullRefPtrVector<PhysicalPage>> allocate_contiguous_user_physical_pages(size_t size);
@@ -192,6 +208,8 @@ public:
         PhysicalSize user_physical_pages_used { 0 };
         PhysicalSize user_physical_pages_committed { 0 };
         PhysicalSize user_physical_pages_uncommitted { 0 };
+        // Free pages that have been zeroed ahead of time, see start_zeroed_page_pool_threads().
+        PhysicalSize user_physical_pages_zeroed { 0 };
         PhysicalSize super_physical_pages { 0 };
         PhysicalSize super_physical_pages_used { 0 };
     };
@@ -241,6 +259,13 @@ public:
     PhysicalAddress get_physical_address(PhysicalPage const&);
 
     void copy_physical_page(PhysicalPage&, u8 page_buffer[PAGE_SIZE]);
+    void copy_to_physical_page(PhysicalPage&, size_t offset_in_page, ReadonlyBytes);
+
+    // Like quickmap_page(), but the mapping belongs to the current thread rather than to the processor, and s_mm_lock
+    // isn't held while it's in use. That lets the caller block or take page faults (e.g. when copying to user memory)
+    // until it calls unmap_page_for_current_thread(). A thread can only have one page mapped at a time.
+    ErrorOr<u8*> map_page_for_current_thread(PhysicalPage&);
+    void unmap_page_for_current_thread();
 
     IterationDecision for_each_physical_memory_range(Function<IterationDecision(PhysicalMemoryRange const&)>);
 
@@ -263,7 +288,21 @@ private:
 
     static Region* find_region_from_vaddr(VirtualAddress);
 
-    RefPtr<PhysicalPage> find_free_user_physical_page(bool);
+    ErrorOr<void> ensure_page_mapping_region_for_current_thread();
+    // Points the current thread's page mapping at the given page, or unmaps it if there is none.
+    void set_page_mapping_for_current_thread(PhysicalPage*);
+
+    RefPtr<PhysicalPage> find_free_user_physical_page(bool committed, ShouldZeroFill);
+    // Takes pages the page cache doesn't need (see Inode::reclaim_page_cache()) when we run out of physical memory,
+    // and asks the SyncTask to shrink the file system block caches.
+    static constexpr size_t page_cache_reclaim_page_count = 64;
+    size_t reclaim_page_cache(SpinlockLocker<RecursiveSpinlock>&, size_t page_count);
+
+    RefPtr<PhysicalPage> take_page_from_zeroed_page_pool(u32 cpu);
+    void refill_zeroed_page_pool(ZeroedPagePool&);
+    [[noreturn]] static void zeroed_page_pool_thread(void*);
+    bool allocate_huge_user_physical_page_impl(bool committed, Span<RefPtr<PhysicalPage>> pages);
+    void zero_huge_page(Span<RefPtr<PhysicalPage>> pages);
 
     ALWAYS_INLINE u8* quickmap_page(PhysicalPage& page)
     {
@@ -283,6 +322,12 @@ private:
     };
     void release_pte(PageDirectory&, VirtualAddress, IsLastPTERelease);
 
+    // Replaces whatever maps the huge page at the given address (if anything) with the given huge page directory entry.
+    void set_huge_pde(PageDirectory&, VirtualAddress, PageDirectoryEntry const&);
+    // Clears the page directory entry for the given address if it maps a huge page, and returns whether it did.
+    bool release_huge_pde(PageDirectory&, VirtualAddress);
+    bool is_mapped_with_huge_page(PageDirectory&, VirtualAddress);
+
     RefPtr<PageDirectory> m_kernel_page_directory;
 
     RefPtr<PhysicalPage> m_shared_zero_page;
@@ -4,6 +4,7 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/BinarySearch.h>
 #include <AK/BuiltinWrappers.h>
 #include <AK/NonnullRefPtr.h>
 #include <AK/RefPtr.h>
@@ -43,6 +44,22 @@ void PhysicalRegion::initialize_zones()
     size_t remaining_pages = m_pages;
     auto base_address = m_lower;
 
+    // Huge pages can only come out of zones that start on a huge page boundary. If this region doesn't,
+    // cover the space up to the first boundary with small, naturally aligned zones.
+    size_t alignment_zone_count = 0;
+    while (remaining_pages > 0 && base_address.get() % huge_page_size != 0) {
+        size_t pages_per_zone = 1u << count_trailing_zeroes(base_address.get() / PAGE_SIZE);
+        while (pages_per_zone > remaining_pages)
+            pages_per_zone /= 2;
+        m_zones.append(adopt_nonnull_own_or_enomem(new (nothrow) PhysicalZone(base_address, pages_per_zone)).release_value_but_fixme_should_propagate_errors());
+        m_usable_zones.append(m_zones.last());
+        base_address = base_address.offset(pages_per_zone * PAGE_SIZE);
+        remaining_pages -= pages_per_zone;
+        ++alignment_zone_count;
+    }
+    if (alignment_zone_count)
+        dmesgln(" * {}x PhysicalZone (< 2 MiB) @ {:016x}-{:016x}", alignment_zone_count, m_lower.get(), base_address.get() - 1);
+
     auto make_zones = [&](size_t zone_size) -> size_t {
         size_t pages_per_zone = zone_size / PAGE_SIZE;
         size_t zone_count = 0;
@@ -60,7 +77,7 @@ void PhysicalRegion::initialize_zones()
     };
 
     // First make 16 MiB zones (with 4096 pages each)
-    m_large_zones = make_zones(large_zone_size);
+    make_zones(large_zone_size);
 
     // Then divide any remaining space into 1 MiB zones (with 256 pages each)
     make_zones(small_zone_size);
@@ -123,22 +140,41 @@ RefPtr<PhysicalPage> PhysicalRegion::take_free_page()
     return PhysicalPage::create(page.value());
 }
 
+Optional<PhysicalAddress> PhysicalRegion::take_aligned_free_pages(size_t count)
+{
+    VERIFY(is_power_of_two(count));
+    auto order = count_trailing_zeroes(count);
+
+    // Blocks are aligned to their size relative to the start of their zone, so we only
+    // have to look at zones that are themselves aligned.
+    for (auto& zone : m_usable_zones) {
+        if (zone.base().get() % (count * PAGE_SIZE) != 0)
+            continue;
+        auto page_base = zone.allocate_block(order);
+        if (!page_base.has_value())
+            continue;
+        if (zone.is_empty()) {
+            // We've exhausted this zone, move it to the full zones list.
+            m_full_zones.append(zone);
+        }
+        return page_base;
+    }
+    return {};
+}
+
 void PhysicalRegion::return_page(PhysicalAddress paddr)
 {
-    auto large_zone_base = lower().get();
-    auto small_zone_base = lower().get() + (m_large_zones * large_zone_size);
-
-    size_t zone_index;
-    if (paddr.get() < small_zone_base)
-        zone_index = (paddr.get() - large_zone_base) / large_zone_size;
-    else
-        zone_index = m_large_zones + (paddr.get() - small_zone_base) / small_zone_size;
-
-    auto& zone = m_zones[zone_index];
-    VERIFY(zone.contains(paddr));
-    zone.deallocate_block(paddr, 0);
-    if (m_full_zones.contains(zone))
-        m_usable_zones.append(zone);
+    auto* zone = binary_search(m_zones, paddr, nullptr, [](PhysicalAddress paddr, PhysicalZone const& zone) {
+        if (paddr < zone.base())
+            return -1;
+        if (!zone.contains(paddr))
+            return 1;
+        return 0;
+    });
+    VERIFY(zone);
+    zone->deallocate_block(paddr, 0);
+    if (m_full_zones.contains(*zone))
+        m_usable_zones.append(*zone);
 }
 
 }
@@ -35,6 +35,8 @@ public:
 
     RefPtr<PhysicalPage> take_free_page();
     NonnullRefPtrVector<PhysicalPage> take_contiguous_free_pages(size_t count);
+    // Takes a run of `count` free pages (a power of two) that is aligned to its own size.
+    Optional<PhysicalAddress> take_aligned_free_pages(size_t count);
     void return_page(PhysicalAddress);
 
 private:
@@ -45,8 +47,6 @@ private:
 
     NonnullOwnPtrVector<PhysicalZone> m_zones;
 
-    size_t m_large_zones { 0 };
-
     PhysicalZone::List m_usable_zones;
     PhysicalZone::List m_full_zones;
 
@@ -4,7 +4,9 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <Kernel/Debug.h>
 #include <Kernel/FileSystem/Inode.h>
+#include <Kernel/Memory/MemoryManager.h>
 #include <Kernel/Memory/PrivateInodeVMObject.h>
 
 namespace Kernel::Memory {
@@ -37,4 +39,31 @@ PrivateInodeVMObject::~PrivateInodeVMObject()
 {
 }
 
+PageFaultResponse PrivateInodeVMObject::handle_cow_fault(size_t page_index)
+{
+    VERIFY_INTERRUPTS_DISABLED();
+    SpinlockLocker lock(m_lock);
+
+    auto& page_slot = physical_pages()[page_index];
+    VERIFY(page_slot);
+    if (page_slot->ref_count() == 1) {
+        dbgln_if(PAGE_FAULT_DEBUG, "    >> It's a COW page but nobody is sharing it anymore. Remap r/w");
+        return PageFaultResponse::Continue;
+    }
+
+    auto page_or_error = MM.allocate_user_physical_page(MemoryManager::ShouldZeroFill::No);
+    if (page_or_error.is_error()) {
+        dmesgln("MM: handle_cow_fault was unable to allocate a physical page");
+        return PageFaultResponse::OutOfMemory;
+    }
+    auto page = page_or_error.release_value();
+
+    dbgln_if(PAGE_FAULT_DEBUG, "      >> COW {} <- {}", page->paddr(), page_slot->paddr());
+    u8 page_buffer[PAGE_SIZE];
+    MM.copy_physical_page(*page_slot, page_buffer);
+    MM.copy_to_physical_page(*page, 0, { page_buffer, PAGE_SIZE });
+    page_slot = move(page);
+    return PageFaultResponse::Continue;
+}
+
 }
@@ -7,6 +7,7 @@
 #pragma once
 
 #include <Kernel/Memory/InodeVMObject.h>
+#include <Kernel/Memory/PageFaultResponse.h>
 #include <Kernel/UnixTypes.h>
 
 namespace Kernel::Memory {
@@ -20,6 +21,8 @@ public:
     static ErrorOr<NonnullRefPtr<PrivateInodeVMObject>> try_create_with_inode(Inode&);
     virtual ErrorOr<NonnullRefPtr<VMObject>> try_clone() override;
 
+    PageFaultResponse handle_cow_fault(size_t page_index);
+
 private:
     virtual bool is_private_inode() const override { return true; }
 
@@ -4,6 +4,7 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/Array.h>
 #include <AK/Memory.h>
 #include <AK/StringView.h>
 #include <Kernel/Arch/x86/PageFault.h>
@@ -12,6 +13,7 @@
 #include <Kernel/Memory/AnonymousVMObject.h>
 #include <Kernel/Memory/MemoryManager.h>
 #include <Kernel/Memory/PageDirectory.h>
+#include <Kernel/Memory/PrivateInodeVMObject.h>
 #include <Kernel/Memory/Region.h>
 #include <Kernel/Memory/SharedInodeVMObject.h>
 #include <Kernel/Panic.h>
@@ -86,6 +88,7 @@ ErrorOr<NonnullOwnPtr<Region>> Region::try_clone()
         region->set_mmap(m_mmap);
         region->set_shared(m_shared);
         region->set_syscall_region(is_syscall_region());
+        region->set_wants_huge_pages(m_wants_huge_pages);
         return region;
     }
 
@@ -113,6 +116,7 @@ ErrorOr<NonnullOwnPtr<Region>> Region::try_clone()
     }
     clone_region->set_syscall_region(is_syscall_region());
     clone_region->set_mmap(m_mmap);
+    clone_region->set_wants_huge_pages(m_wants_huge_pages);
     return clone_region;
 }
 
@@ -150,6 +154,21 @@ size_t Region::amount_resident() const
     return bytes;
 }
 
+size_t Region::amount_mapped_with_huge_pages() const
+{
+    if (!m_page_directory)
+        return 0;
+    auto& page_directory = const_cast<PageDirectory&>(*m_page_directory);
+    SpinlockLocker page_lock(page_directory.get_lock());
+    SpinlockLocker lock(s_mm_lock);
+    size_t bytes = 0;
+    for (auto address = align_up_to(vaddr().get(), huge_page_size); address + huge_page_size <= range().end().get(); address += huge_page_size) {
+        if (MM.is_mapped_with_huge_page(page_directory, VirtualAddress(address)))
+            bytes += huge_page_size;
+    }
+    return bytes;
+}
+
 size_t Region::amount_shared() const
 {
     size_t bytes = 0;
@@ -173,6 +192,12 @@ ErrorOr<NonnullOwnPtr<Region>> Region::try_create_kernel_only(VirtualRange const
 
 bool Region::should_cow(size_t page_index) const
 {
+    if (vmobject().is_private_inode()) {
+        // Pages of a private inode mapping may be shared with the inode's page cache or with a forked
+        // process. They are copied on the first write, unless nobody else holds on to them anymore.
+        auto const* page = physical_page(page_index);
+        return page && page->ref_count() > 1;
+    }
     if (!vmobject().is_anonymous())
         return false;
     return static_cast<AnonymousVMObject const&>(vmobject()).should_cow(first_page_index() + page_index, m_shared);
@@ -221,6 +246,49 @@ bool Region::map_individual_page_impl(size_t page_index)
     return true;
 }
 
+bool Region::can_map_as_huge_page(size_t page_index) const
+{
+    if (vaddr_from_page_index(page_index).get() % huge_page_size != 0 || page_index + pages_per_huge_page > page_count())
+        return false;
+    if (!is_user() || !is_cacheable() || is_write_combine() || (!is_readable() && !is_writable()))
+        return false;
+    if (!vmobject().is_anonymous())
+        return false;
+
+    auto const* first_page = physical_page(page_index);
+    if (!first_page || first_page->paddr().get() % huge_page_size != 0)
+        return false;
+    bool first_page_should_cow = should_cow(page_index);
+    for (size_t i = 0; i < pages_per_huge_page; ++i) {
+        auto const* page = physical_page(page_index + i);
+        if (!page || page->is_shared_zero_page() || page->is_lazy_committed_page())
+            return false;
+        if (page->paddr() != first_page->paddr().offset(i * PAGE_SIZE))
+            return false;
+        // One entry maps all of the pages, so they all need the same permissions.
+        if (should_cow(page_index + i) != first_page_should_cow)
+            return false;
+    }
+    return true;
+}
+
+void Region::map_huge_page_impl(size_t page_index)
+{
+    VERIFY(m_page_directory->get_lock().is_locked_by_current_processor());
+    VERIFY(s_mm_lock.is_locked_by_current_processor());
+
+    PageDirectoryEntry pde;
+    pde.clear();
+    pde.set_huge_page_base(physical_page(page_index)->paddr().get());
+    pde.set_huge(true);
+    pde.set_present(true);
+    pde.set_writable(is_writable() && !should_cow(page_index));
+    if (Processor::current().has_feature(CPUFeature::NX))
+        pde.set_execute_disabled(!is_executable());
+    pde.set_user_allowed(true);
+    MM.set_huge_pde(*m_page_directory, vaddr_from_page_index(page_index), pde);
+}
+
 bool Region::do_remap_vmobject_page(size_t page_index, bool with_flush)
 {
     if (!m_page_directory)
@@ -248,6 +316,47 @@ bool Region::remap_vmobject_page(size_t page_index, bool with_flush)
     return success;
 }
 
+bool Region::do_remap_vmobject_huge_page(size_t first_page_index_in_vmobject)
+{
+    if (!m_page_directory)
+        return true; // not an error, region may have not yet mapped it
+    auto first_index = max(first_page_index_in_vmobject, first_page_index());
+    auto end_index = min(first_page_index_in_vmobject + pages_per_huge_page, first_page_index() + page_count());
+    if (first_index >= end_index)
+        return true; // not an error, region doesn't map these pages
+    auto first_page_index_in_region = first_index - first_page_index();
+    auto count = end_index - first_index;
+
+    SpinlockLocker page_lock(m_page_directory->get_lock());
+    SpinlockLocker lock(s_mm_lock);
+    bool success = true;
+    if (count == pages_per_huge_page && can_map_as_huge_page(first_page_index_in_region)) {
+        map_huge_page_impl(first_page_index_in_region);
+    } else {
+        // This region maps the pages somewhere a huge page can't go, so it gets them one by one.
+        for (size_t i = 0; i < count; ++i) {
+            if (!map_individual_page_impl(first_page_index_in_region + i)) {
+                success = false;
+                break;
+            }
+        }
+    }
+    MemoryManager::flush_tlb(m_page_directory, vaddr_from_page_index(first_page_index_in_region), count);
+    return success;
+}
+
+bool Region::remap_vmobject_huge_page(size_t first_page_index_in_vmobject)
+{
+    auto& vmobject = this->vmobject();
+    bool success = true;
+    SpinlockLocker lock(vmobject.m_lock);
+    vmobject.for_each_region([&](auto& region) {
+        if (!region.do_remap_vmobject_huge_page(first_page_index_in_vmobject))
+            success = false;
+    });
+    return success;
+}
+
 void Region::unmap(ShouldDeallocateVirtualRange should_deallocate_range, ShouldFlushTLB should_flush_tlb)
 {
     if (!m_page_directory)
@@ -262,9 +371,14 @@ void Region::unmap_with_locks_held(ShouldDeallocateVirtualRange deallocate_range
     if (!m_page_directory)
         return;
     size_t count = page_count();
-    for (size_t i = 0; i < count; ++i) {
+    for (size_t i = 0; i < count;) {
         auto vaddr = vaddr_from_page_index(i);
+        if (vaddr.get() % huge_page_size == 0 && i + pages_per_huge_page <= count && MM.release_huge_pde(*m_page_directory, vaddr)) {
+            i += pages_per_huge_page;
+            continue;
+        }
         MM.release_pte(*m_page_directory, vaddr, i == count - 1 ? MemoryManager::IsLastPTERelease::Yes : MemoryManager::IsLastPTERelease::No);
+        ++i;
     }
     if (should_flush_tlb == ShouldFlushTLB::Yes)
         MemoryManager::flush_tlb(m_page_directory, vaddr(), page_count());
@@ -294,6 +408,11 @@ ErrorOr<void> Region::map(PageDirectory& page_directory, ShouldFlushTLB should_f
     set_page_directory(page_directory);
     size_t page_index = 0;
     while (page_index < page_count()) {
+        if (can_map_as_huge_page(page_index)) {
+            map_huge_page_impl(page_index);
+            page_index += pages_per_huge_page;
+            continue;
+        }
         if (!map_individual_page_impl(page_index))
             break;
         ++page_index;
@@ -404,6 +523,14 @@ PageFaultResponse Region::handle_zero_fault(size_t page_index_in_region)
     if (current_thread != nullptr)
         current_thread->did_zero_fault();
 
+    if (auto first_page_index_in_vmobject = try_allocate_huge_page_for_fault(page_index_in_region); first_page_index_in_vmobject.has_value()) {
+        if (!remap_vmobject_huge_page(first_page_index_in_vmobject.value())) {
+            dmesgln("MM: handle_zero_fault was unable to allocate a page table to map a huge page");
+            return PageFaultResponse::OutOfMemory;
+        }
+        return PageFaultResponse::Continue;
+    }
+
     if (page_slot->is_lazy_committed_page()) {
         VERIFY(m_vmobject->is_anonymous());
         page_slot = static_cast<AnonymousVMObject&>(*m_vmobject).allocate_committed_page({});
@@ -425,6 +552,25 @@ PageFaultResponse Region::handle_zero_fault(size_t page_index_in_region)
     return PageFaultResponse::Continue;
 }
 
+Optional<size_t> Region::try_allocate_huge_page_for_fault(size_t page_index_in_region)
+{
+    if (!wants_huge_pages() || !is_cacheable() || is_write_combine())
+        return {};
+
+    // Only fill in the huge page around the fault if it fits into this region entirely.
+    auto huge_page_vaddr = VirtualAddress { vaddr_from_page_index(page_index_in_region).get() & ~(huge_page_size - 1) };
+    if (huge_page_vaddr < vaddr() || huge_page_vaddr.offset(huge_page_size) > range().end())
+        return {};
+
+    auto first_page_index_in_region = page_index_from_address(huge_page_vaddr);
+    auto first_page_index_in_vmobject = translate_to_vmobject_page(first_page_index_in_region);
+    if (!static_cast<AnonymousVMObject&>(vmobject()).try_allocate_huge_page({}, first_page_index_in_vmobject))
+        return {};
+
+    dbgln_if(PAGE_FAULT_DEBUG, "      >> ALLOCATED HUGE PAGE {}", physical_page(first_page_index_in_region)->paddr());
+    return first_page_index_in_vmobject;
+}
+
 PageFaultResponse Region::handle_cow_fault(size_t page_index_in_region)
 {
     VERIFY_INTERRUPTS_DISABLED();
@@ -432,10 +578,17 @@ PageFaultResponse Region::handle_cow_fault(size_t page_index_in_region)
     if (current_thread)
         current_thread->did_cow_fault();
 
+    auto page_index_in_vmobject = translate_to_vmobject_page(page_index_in_region);
+    if (vmobject().is_private_inode()) {
+        auto response = static_cast<PrivateInodeVMObject&>(vmobject()).handle_cow_fault(page_index_in_vmobject);
+        if (!remap_vmobject_page(page_index_in_vmobject))
+            return PageFaultResponse::OutOfMemory;
+        return response;
+    }
+
     if (!vmobject().is_anonymous())
         return PageFaultResponse::ShouldCrash;
 
-    auto page_index_in_vmobject = translate_to_vmobject_page(page_index_in_region);
     auto response = reinterpret_cast<AnonymousVMObject&>(vmobject()).handle_cow_fault(page_index_in_vmobject, vaddr().offset(page_index_in_region * PAGE_SIZE));
     if (!remap_vmobject_page(page_index_in_vmobject))
         return PageFaultResponse::OutOfMemory;
@@ -470,8 +623,30 @@ PageFaultResponse Region::handle_inode_fault(size_t page_index_in_region)
     if (current_thread)
         current_thread->did_inode_fault();
 
-    u8 page_buffer[PAGE_SIZE];
     auto& inode = inode_vmobject.inode();
+    if (inode.has_page_cache()) {
+        // Map the page straight from the inode's page cache, so that the mapping and read()/write() share it.
+        // Private mappings get it copy-on-write, see Region::should_cow().
+        auto page_or_error = inode.get_or_load_cached_page(page_index_in_vmobject);
+        if (page_or_error.is_error()) {
+            dmesgln("handle_inode_fault: Error ({}) while reading from inode", page_or_error.error());
+            return PageFaultResponse::ShouldCrash;
+        }
+
+        {
+            SpinlockLocker locker(inode_vmobject.m_lock);
+            if (vmobject_physical_page_entry.is_null())
+                vmobject_physical_page_entry = page_or_error.release_value();
+            else
+                dbgln_if(PAGE_FAULT_DEBUG, "handle_inode_fault: Page faulted in by someone else, remapping.");
+            if (!remap_vmobject_page(page_index_in_vmobject))
+                return PageFaultResponse::OutOfMemory;
+        }
+        fault_around_inode_page(page_index_in_region);
+        return PageFaultResponse::Continue;
+    }
+
+    u8 page_buffer[PAGE_SIZE];
 
     auto buffer = UserOrKernelBuffer::for_kernel_buffer(page_buffer);
     auto result = inode.read_bytes(page_index_in_vmobject * PAGE_SIZE, PAGE_SIZE, buffer, nullptr);
@@ -518,4 +693,62 @@ PageFaultResponse Region::handle_inode_fault(size_t page_index_in_region)
     return PageFaultResponse::Continue;
 }
 
+void Region::fault_around_inode_page(size_t page_index_in_region)
+{
+    VERIFY(vmobject().is_inode());
+    VERIFY(m_page_directory);
+
+    auto& inode_vmobject = static_cast<InodeVMObject&>(vmobject());
+    auto& inode = inode_vmobject.inode();
+
+    // Programs tend to touch the pages of a file mapping close to each other, so we map every page in the
+    // naturally aligned window around the fault that's already in the page cache, rather than taking a
+    // separate fault for each of them.
+    auto page_index_in_vmobject = translate_to_vmobject_page(page_index_in_region);
+    auto window_start = page_index_in_vmobject & ~(fault_around_page_count - 1);
+    auto first_index = max(window_start, first_page_index());
+    auto end_index = min(window_start + fault_around_page_count, first_page_index() + page_count());
+    end_index = min(end_index, ceil_div(inode.size(), static_cast<size_t>(PAGE_SIZE)));
+    if (first_index >= end_index)
+        return;
+
+    Array<RefPtr<PhysicalPage>, fault_around_page_count> cached_pages;
+    bool has_uncached_pages = false;
+    for (auto index = first_index; index < end_index; ++index) {
+        if (index == page_index_in_vmobject)
+            continue;
+        auto& cached_page = cached_pages[index - window_start];
+        cached_page = inode.find_cached_page(index);
+        if (!cached_page)
+            has_uncached_pages = true;
+    }
+
+    {
+        SpinlockLocker locker(inode_vmobject.m_lock);
+        SpinlockLocker page_lock(m_page_directory->get_lock());
+        SpinlockLocker mm_locker(s_mm_lock);
+        size_t mapped_page_count = 0;
+        for (auto index = first_index; index < end_index; ++index) {
+            if (index == page_index_in_vmobject)
+                continue;
+            auto& page_slot = inode_vmobject.physical_pages()[index];
+            if (page_slot.is_null()) {
+                if (!cached_pages[index - window_start])
+                    continue;
+                page_slot = move(cached_pages[index - window_start]);
+            }
+            if (!map_individual_page_impl(index - first_page_index()))
+                break;
+            ++mapped_page_count;
+        }
+        if (mapped_page_count > 0)
+            MemoryManager::flush_tlb(m_page_directory, vaddr_from_page_index(first_index - first_page_index()), end_index - first_index);
+        dbgln_if(PAGE_FAULT_DEBUG, "handle_inode_fault: Faulted around {} pages in {}", mapped_page_count, name());
+    }
+
+    // Whatever isn't cached yet is likely to be needed soon, so we start loading it in the background.
+    if (has_uncached_pages)
+        inode.start_readahead(first_index, end_index - first_index);
+}
+
 }
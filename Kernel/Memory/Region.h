@@ -88,6 +88,10 @@ public:
     [[nodiscard]] bool is_mmap() const { return m_mmap; }
     void set_mmap(bool mmap) { m_mmap = mmap; }
 
+    // Page faults in regions that want huge pages try to fill in a whole 2 MiB at once.
+    [[nodiscard]] bool wants_huge_pages() const { return m_wants_huge_pages; }
+    void set_wants_huge_pages(bool wants_huge_pages) { m_wants_huge_pages = wants_huge_pages; }
+
     [[nodiscard]] bool is_write_combine() const { return m_write_combine; }
     ErrorOr<void> set_write_combine(bool);
 
@@ -165,6 +169,8 @@ public:
     [[nodiscard]] size_t amount_resident() const;
     [[nodiscard]] size_t amount_shared() const;
     [[nodiscard]] size_t amount_dirty() const;
+    // How much of the region is currently mapped with huge pages rather than page tables.
+    [[nodiscard]] size_t amount_mapped_with_huge_pages() const;
 
     [[nodiscard]] bool should_cow(size_t page_index) const;
     ErrorOr<void> set_should_cow(size_t page_index, bool);
@@ -196,10 +202,15 @@ public:
     void set_syscall_region(bool b) { m_syscall_region = b; }
 
 private:
+    // How many pages around an inode fault get mapped at once, if they're already cached.
+    static constexpr size_t fault_around_page_count = 16;
+
     Region(VirtualRange const&, NonnullRefPtr<VMObject>, size_t offset_in_vmobject, OwnPtr<KString>, Region::Access access, Cacheable, bool shared);
 
     [[nodiscard]] bool remap_vmobject_page(size_t page_index, bool with_flush = true);
     [[nodiscard]] bool do_remap_vmobject_page(size_t page_index, bool with_flush = true);
+    [[nodiscard]] bool remap_vmobject_huge_page(size_t first_page_index_in_vmobject);
+    [[nodiscard]] bool do_remap_vmobject_huge_page(size_t first_page_index_in_vmobject);
 
     void set_access_bit(Access access, bool b)
     {
@@ -211,9 +222,13 @@ private:
 
     [[nodiscard]] PageFaultResponse handle_cow_fault(size_t page_index);
     [[nodiscard]] PageFaultResponse handle_inode_fault(size_t page_index);
+    void fault_around_inode_page(size_t page_index);
     [[nodiscard]] PageFaultResponse handle_zero_fault(size_t page_index);
+    [[nodiscard]] Optional<size_t> try_allocate_huge_page_for_fault(size_t page_index);
 
     [[nodiscard]] bool map_individual_page_impl(size_t page_index);
+    [[nodiscard]] bool can_map_as_huge_page(size_t page_index) const;
+    void map_huge_page_impl(size_t page_index);
 
     RefPtr<PageDirectory> m_page_directory;
     VirtualRange m_range;
@@ -227,6 +242,7 @@ private:
     bool m_mmap : 1 { false };
     bool m_syscall_region : 1 { false };
     bool m_write_combine : 1 { false };
+    bool m_wants_huge_pages : 1 { false };
 
     IntrusiveRedBlackTreeNode<FlatPtr, Region, RawPtr<Region>> m_tree_node;
     IntrusiveListNode<Region> m_vmobject_list_node;
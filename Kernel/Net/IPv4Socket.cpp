@@ -282,6 +282,10 @@ ErrorOr<size_t> IPv4Socket::receive_byte_buffered(OpenFileDescription& descripti
         Thread::current()->did_ipv4_socket_read(nreceived_or_error.value());
 
     set_can_read(!m_receive_buffer->is_empty());
+
+    if (!nreceived_or_error.is_error() && nreceived_or_error.value() > 0 && !(flags & MSG_PEEK))
+        protocol_did_read_receive_buffer();
+
     return nreceived_or_error;
 }
 
@@ -468,6 +472,35 @@ bool IPv4Socket::did_receive(const IPv4Address& source_address, u16 source_port,
     return true;
 }
 
+size_t IPv4Socket::did_receive_stream_data(ReadonlyBytes data)
+{
+    MutexLocker locker(mutex());
+    VERIFY(buffer_mode() == BufferMode::Bytes);
+
+    if (is_shut_down_for_reading() || !m_receive_buffer)
+        return 0;
+
+    auto nwritable = min(data.size(), m_receive_buffer->space_for_writing());
+    if (nwritable == 0)
+        return 0;
+    auto nwritten_or_error = m_receive_buffer->write(data.data(), nwritable);
+    if (nwritten_or_error.is_error())
+        return 0;
+    auto nwritten = nwritten_or_error.release_value();
+    m_bytes_received += nwritten;
+    set_can_read(!m_receive_buffer->is_empty());
+
+    dbgln_if(IPV4_SOCKET_DEBUG, "IPv4Socket({}): did_receive_stream_data {} bytes, total_received={}", this, nwritten, m_bytes_received);
+    return nwritten;
+}
+
+size_t IPv4Socket::receive_buffer_space() const
+{
+    if (!m_receive_buffer)
+        return 0;
+    return m_receive_buffer->space_for_writing();
+}
+
 ErrorOr<NonnullOwnPtr<KString>> IPv4Socket::pseudo_path(const OpenFileDescription&) const
 {
     if (m_role == Role::None)
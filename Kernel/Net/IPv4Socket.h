@@ -86,6 +86,8 @@ protected:
     virtual ErrorOr<u16> protocol_allocate_local_port() { return ENOPROTOOPT; }
     virtual ErrorOr<size_t> protocol_size(ReadonlyBytes /* raw_ipv4_packet */) { return ENOTIMPL; }
     virtual bool protocol_is_disconnected() const { return false; }
+    // Called after data was read out of the receive buffer of a byte-buffered socket.
+    virtual void protocol_did_read_receive_buffer() { }
 
     virtual void shut_down_for_reading() override;
 
@@ -95,6 +97,11 @@ protected:
     static ErrorOr<NonnullOwnPtr<DoubleBuffer>> try_create_receive_buffer();
     void drop_receive_buffer();
 
+    // For byte-buffered sockets that reassemble their stream themselves: appends as much of
+    // the given data to the receive buffer as fits, and returns how many bytes that was.
+    size_t did_receive_stream_data(ReadonlyBytes);
+    size_t receive_buffer_space() const;
+
 private:
     virtual bool is_ipv4() const override { return true; }
 
@@ -4,7 +4,6 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
-#include <Kernel/Arch/x86/InterruptDisabler.h>
 #include <Kernel/Heap/kmalloc.h>
 #include <Kernel/Net/EtherType.h>
 #include <Kernel/Net/NetworkAdapter.h>
@@ -73,11 +72,10 @@ void NetworkAdapter::fill_in_ipv4_header(PacketWithTimestamp& packet, IPv4Addres
 
 void NetworkAdapter::did_receive(ReadonlyBytes payload)
 {
-    InterruptDisabler disabler;
     m_packets_in++;
     m_bytes_in += payload.size();
 
-    if (m_packet_queue_size == max_packet_buffers) {
+    if (m_received_packet_count.load(AK::memory_order_relaxed) >= max_packet_buffers) {
         // FIXME: Keep track of the number of dropped packets
         return;
     }
@@ -90,46 +88,43 @@ void NetworkAdapter::did_receive(ReadonlyBytes payload)
 
     memcpy(packet->buffer->data(), payload.data(), payload.size());
 
-    m_packet_queue.append(*packet);
-    m_packet_queue_size++;
+    m_received_packet_count.fetch_add(1, AK::memory_order_relaxed);
+    auto* new_head = packet.leak_ref();
+    auto* old_head = m_received_packets.load(AK::memory_order_relaxed);
+    do {
+        new_head->next_received_packet = old_head;
+    } while (!m_received_packets.compare_exchange_strong(old_head, new_head, AK::memory_order_acq_rel));
 
-    if (on_receive)
+    if (!old_head && on_receive)
         on_receive();
 }
 
-size_t NetworkAdapter::dequeue_packet(u8* buffer, size_t buffer_size, Time& packet_timestamp)
+size_t NetworkAdapter::take_received_packets(PacketList& packets)
 {
-    InterruptDisabler disabler;
-    if (m_packet_queue.is_empty())
-        return 0;
-    auto packet_with_timestamp = m_packet_queue.take_first();
-    m_packet_queue_size--;
-    packet_timestamp = packet_with_timestamp->timestamp;
-    auto& packet_buffer = packet_with_timestamp->buffer;
-    size_t packet_size = packet_buffer->size();
-    VERIFY(packet_size <= buffer_size);
-    memcpy(buffer, packet_buffer->data(), packet_size);
-    release_packet_buffer(*packet_with_timestamp);
-    return packet_size;
+    auto* packet = m_received_packets.exchange(nullptr, AK::memory_order_acq_rel);
+    size_t count = 0;
+    // The stack has the newest packet on top, so prepending each one puts them back in order.
+    while (packet) {
+        auto* next_packet = packet->next_received_packet;
+        packet->next_received_packet = nullptr;
+        auto adopted_packet = adopt_ref(*packet);
+        packets.prepend(*adopted_packet);
+        packet = next_packet;
+        ++count;
+    }
+    m_received_packet_count.fetch_sub(count, AK::memory_order_relaxed);
+    return count;
 }
 
 RefPtr<PacketWithTimestamp> NetworkAdapter::acquire_packet_buffer(size_t size)
 {
-    InterruptDisabler disabler;
-    if (m_unused_packets.is_empty()) {
-        auto buffer_or_error = KBuffer::try_create_with_size(size, Memory::Region::Access::ReadWrite, "Packet Buffer", AllocationStrategy::AllocateNow);
-        if (buffer_or_error.is_error())
-            return {};
-        auto buffer = buffer_or_error.release_value();
-        auto packet = adopt_ref_if_nonnull(new (nothrow) PacketWithTimestamp { move(buffer), kgettimeofday() });
-        if (!packet)
+    auto packet = m_unused_packets.with([](auto& unused_packets) -> RefPtr<PacketWithTimestamp> {
+        if (unused_packets.is_empty())
             return {};
-        packet->buffer->set_size(size);
-        return packet;
-    }
+        return unused_packets.take_first();
+    });
 
-    auto packet = m_unused_packets.take_first();
-    if (packet->buffer->capacity() >= size) {
+    if (packet && packet->buffer->capacity() >= size) {
         packet->timestamp = kgettimeofday();
         packet->buffer->set_size(size);
         return packet;
@@ -147,8 +142,9 @@ RefPtr<PacketWithTimestamp> NetworkAdapter::acquire_packet_buffer(size_t size)
 
 void NetworkAdapter::release_packet_buffer(PacketWithTimestamp& packet)
 {
-    InterruptDisabler disabler;
-    m_unused_packets.append(packet);
+    m_unused_packets.with([&](auto& unused_packets) {
+        unused_packets.append(packet);
+    });
 }
 
 void NetworkAdapter::set_ipv4_address(const IPv4Address& address)
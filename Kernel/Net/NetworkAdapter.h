@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include <AK/Atomic.h>
 #include <AK/ByteBuffer.h>
 #include <AK/Function.h>
 #include <AK/IntrusiveList.h>
@@ -15,6 +16,7 @@
 #include <AK/Weakable.h>
 #include <Kernel/Bus/PCI/Definitions.h>
 #include <Kernel/KBuffer.h>
+#include <Kernel/Locking/SpinlockProtected.h>
 #include <Kernel/Net/ARP.h>
 #include <Kernel/Net/EthernetFrameHeader.h>
 #include <Kernel/Net/ICMP.h>
@@ -39,6 +41,9 @@ struct PacketWithTimestamp : public RefCounted<PacketWithTimestamp> {
     NonnullOwnPtr<KBuffer> buffer;
     Time timestamp;
     IntrusiveListNode<PacketWithTimestamp, RefPtr<PacketWithTimestamp>> packet_node;
+    // Links received packets that haven't been picked up by the receive thread yet. While a packet
+    // is on that list, the list holds a reference to it.
+    PacketWithTimestamp* next_received_packet { nullptr };
 };
 
 class NetworkAdapter : public RefCounted<NetworkAdapter>
@@ -71,9 +76,11 @@ public:
     void send(const MACAddress&, const ARPPacket&);
     void fill_in_ipv4_header(PacketWithTimestamp&, IPv4Address const&, MACAddress const&, IPv4Address const&, IPv4Protocol, size_t, u8 type_of_service, u8 ttl);
 
-    size_t dequeue_packet(u8* buffer, size_t buffer_size, Time& packet_timestamp);
+    using PacketList = IntrusiveList<&PacketWithTimestamp::packet_node>;
 
-    bool has_queued_packets() const { return !m_packet_queue.is_empty(); }
+    // Moves every packet received since the last call into the given list, oldest first.
+    // The packets must be given back with release_packet_buffer() once they've been handled.
+    size_t take_received_packets(PacketList&);
 
     u32 mtu() const { return m_mtu; }
     void set_mtu(u32 mtu) { m_mtu = mtu; }
@@ -89,6 +96,8 @@ public:
     constexpr size_t layer3_payload_offset() const { return sizeof(EthernetFrameHeader); }
     constexpr size_t ipv4_payload_offset() const { return layer3_payload_offset() + sizeof(IPv4Packet); }
 
+    // Called when a packet is received while no others were queued up, so whoever handles
+    // them is only woken up once per batch.
     Function<void()> on_receive;
 
     void send_packet(ReadonlyBytes);
@@ -108,11 +117,11 @@ private:
     // FIXME: Make this configurable
     static constexpr size_t max_packet_buffers = 1024;
 
-    using PacketList = IntrusiveList<&PacketWithTimestamp::packet_node>;
-
-    PacketList m_packet_queue;
-    size_t m_packet_queue_size { 0 };
-    PacketList m_unused_packets;
+    // Received packets are handed from the IRQ handler to the receive thread through a lock-free
+    // stack: did_receive() pushes onto it, and take_received_packets() takes the whole stack at once.
+    Atomic<PacketWithTimestamp*> m_received_packets { nullptr };
+    Atomic<size_t> m_received_packet_count { 0 };
+    SpinlockProtected<PacketList> m_unused_packets;
     NonnullOwnPtr<KString> m_name;
     u32 m_packets_in { 0 };
     u32 m_bytes_in { 0 };
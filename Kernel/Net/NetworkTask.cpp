@@ -4,6 +4,7 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/Singleton.h>
 #include <Kernel/Debug.h>
 #include <Kernel/Locking/Mutex.h>
 #include <Kernel/Locking/MutexProtected.h>
@@ -22,6 +23,9 @@
 #include <Kernel/Net/UDP.h>
 #include <Kernel/Net/UDPSocket.h>
 #include <Kernel/Process.h>
+#include <Kernel/Scheduler.h>
+#include <Kernel/Time/TimeManagement.h>
+#include <Kernel/WaitQueue.h>
 
 namespace Kernel {
 
@@ -29,16 +33,32 @@ static void handle_arp(EthernetFrameHeader const&, size_t frame_size);
 static void handle_ipv4(EthernetFrameHeader const&, size_t frame_size, Time const& packet_timestamp);
 static void handle_icmp(EthernetFrameHeader const&, IPv4Packet const&, Time const& packet_timestamp);
 static void handle_udp(IPv4Packet const&, Time const& packet_timestamp);
-static void handle_tcp(IPv4Packet const&, Time const& packet_timestamp);
+static void handle_tcp(IPv4Packet const&);
 static void send_delayed_tcp_ack(RefPtr<TCPSocket> socket);
 static void send_tcp_rst(IPv4Packet const& ipv4_packet, TCPPacket const& tcp_packet, RefPtr<NetworkAdapter> adapter);
 static void flush_delayed_tcp_acks();
-static void retransmit_tcp_packets();
+static Optional<Time> retransmit_tcp_packets();
+
+static Process* network_task_process = nullptr;
+static Singleton<MutexProtected<HashTable<RefPtr<TCPSocket>>>> s_delayed_ack_sockets;
+
+// When there's more than one processor to schedule them on, every network adapter gets its own
+// receive thread, so traffic arriving on different adapters is handled on different processors.
+// With just one processor, that would only add context switches, so the NetworkTask thread
+// receives packets from every adapter itself.
+struct ReceiveWorker {
+    explicit ReceiveWorker(NetworkAdapter& adapter)
+        : adapter(adapter)
+    {
+    }
 
-static Thread* network_task = nullptr;
-static HashTable<RefPtr<TCPSocket>>* delayed_ack_sockets;
+    NonnullRefPtr<NetworkAdapter> adapter;
+    WaitQueue wait_queue;
+};
 
 [[noreturn]] static void NetworkTask_main(void*);
+[[noreturn]] static void receive_worker_main(void*);
+static bool receive_packets(NetworkAdapter&);
 
 void NetworkTask::spawn()
 {
@@ -46,21 +66,19 @@ void NetworkTask::spawn()
     auto name = KString::try_create("NetworkTask");
     if (name.is_error())
         TODO();
-    (void)Process::create_kernel_process(thread, name.release_value(), NetworkTask_main, nullptr);
-    network_task = thread;
+    network_task_process = Process::create_kernel_process(thread, name.release_value(), NetworkTask_main, nullptr).leak_ref();
 }
 
 bool NetworkTask::is_current()
 {
-    return Thread::current() == network_task;
+    return &Thread::current()->process() == network_task_process;
 }
 
 void NetworkTask_main(void*)
 {
-    delayed_ack_sockets = new HashTable<RefPtr<TCPSocket>>;
+    bool use_receive_workers = Scheduler::schedulable_processor_count() > 1;
+    WaitQueue wait_queue;
 
-    WaitQueue packet_wait_queue;
-    int pending_packets = 0;
     NetworkingManagement::the().for_each([&](auto& adapter) {
         dmesgln("NetworkTask: {} network adapter found: hw={}", adapter.class_name(), adapter.mac_address().to_string());
 
@@ -70,64 +88,103 @@ void NetworkTask_main(void*)
             adapter.set_ipv4_gateway({ 0, 0, 0, 0 });
         }
 
-        adapter.on_receive = [&]() {
-            pending_packets++;
-            packet_wait_queue.wake_all();
-        };
-    });
+        if (!use_receive_workers) {
+            adapter.on_receive = [&]() {
+                wait_queue.wake_all();
+            };
+            return;
+        }
 
-    auto dequeue_packet = [&pending_packets](u8* buffer, size_t buffer_size, Time& packet_timestamp) -> size_t {
-        if (pending_packets == 0)
-            return 0;
-        size_t packet_size = 0;
-        NetworkingManagement::the().for_each([&](auto& adapter) {
-            if (packet_size || !adapter.has_queued_packets())
-                return;
-            packet_size = adapter.dequeue_packet(buffer, buffer_size, packet_timestamp);
-            pending_packets--;
-            dbgln_if(NETWORK_TASK_DEBUG, "NetworkTask: Dequeued packet from {} ({} bytes)", adapter.name(), packet_size);
-        });
-        return packet_size;
-    };
+        // NOTE: Workers live as long as their adapters, which is forever.
+        auto* worker = new ReceiveWorker(adapter);
+        adapter.on_receive = [worker]() {
+            worker->wait_queue.wake_one();
+        };
 
-    size_t buffer_size = 64 * KiB;
-    auto region_or_error = MM.allocate_kernel_region(buffer_size, "Kernel Packet Buffer", Memory::Region::Access::ReadWrite);
-    if (region_or_error.is_error())
-        TODO();
-    auto buffer_region = region_or_error.release_value();
-    auto buffer = (u8*)buffer_region->vaddr().get();
-    Time packet_timestamp;
+        auto name = KString::formatted("NetworkTask [{}]", adapter.name());
+        if (name.is_error())
+            TODO();
+        auto thread = Process::current().create_kernel_thread(receive_worker_main, worker, THREAD_PRIORITY_NORMAL, name.release_value(), THREAD_AFFINITY_DEFAULT, false);
+        if (!thread)
+            TODO();
+    });
 
+    // If the adapters have their own receive workers, this thread is left to deal with the timers:
+    // retransmissions, and delayed ACKs for sockets that didn't receive anything else.
     for (;;) {
-        flush_delayed_tcp_acks();
-        retransmit_tcp_packets();
-        size_t packet_size = dequeue_packet(buffer, buffer_size, packet_timestamp);
-        if (!packet_size) {
-            auto timeout_time = Time::from_milliseconds(500);
-            auto timeout = Thread::BlockTimeout { false, &timeout_time };
-            [[maybe_unused]] auto result = packet_wait_queue.wait_on(timeout, "NetworkTask");
-            continue;
-        }
-        if (packet_size < sizeof(EthernetFrameHeader)) {
-            dbgln("NetworkTask: Packet is too small to be an Ethernet packet! ({})", packet_size);
-            continue;
+        if (!use_receive_workers) {
+            bool did_receive_packets = false;
+            NetworkingManagement::the().for_each([&](auto& adapter) {
+                if (receive_packets(adapter))
+                    did_receive_packets = true;
+            });
+            if (did_receive_packets)
+                continue;
         }
-        auto& eth = *(EthernetFrameHeader const*)buffer;
-        dbgln_if(ETHERNET_DEBUG, "NetworkTask: From {} to {}, ether_type={:#04x}, packet_size={}", eth.source().to_string(), eth.destination().to_string(), eth.ether_type(), packet_size);
-
-        switch (eth.ether_type()) {
-        case EtherType::ARP:
-            handle_arp(eth, packet_size);
-            break;
-        case EtherType::IPv4:
-            handle_ipv4(eth, packet_size, packet_timestamp);
-            break;
-        case EtherType::IPv6:
-            // ignore
-            break;
-        default:
-            dbgln_if(ETHERNET_DEBUG, "NetworkTask: Unknown ethernet type {:#04x}", eth.ether_type());
+
+        flush_delayed_tcp_acks();
+        auto next_retransmit_time = retransmit_tcp_packets();
+        auto timeout_time = Time::from_milliseconds(500);
+        if (next_retransmit_time.has_value()) {
+            auto now = TimeManagement::the().monotonic_time();
+            auto time_until_retransmit = next_retransmit_time.value() > now ? next_retransmit_time.value() - now : Time::zero();
+            timeout_time = max(min(timeout_time, time_until_retransmit), Time::from_milliseconds(1));
         }
+        auto timeout = Thread::BlockTimeout { false, &timeout_time };
+        [[maybe_unused]] auto result = wait_queue.wait_on(timeout, "NetworkTask");
+    }
+}
+
+static void handle_frame(ReadonlyBytes frame, Time const& packet_timestamp)
+{
+    if (frame.size() < sizeof(EthernetFrameHeader)) {
+        dbgln("NetworkTask: Packet is too small to be an Ethernet packet! ({})", frame.size());
+        return;
+    }
+    auto& eth = *(EthernetFrameHeader const*)frame.data();
+    dbgln_if(ETHERNET_DEBUG, "NetworkTask: From {} to {}, ether_type={:#04x}, packet_size={}", eth.source().to_string(), eth.destination().to_string(), eth.ether_type(), frame.size());
+
+    switch (eth.ether_type()) {
+    case EtherType::ARP:
+        handle_arp(eth, frame.size());
+        break;
+    case EtherType::IPv4:
+        handle_ipv4(eth, frame.size(), packet_timestamp);
+        break;
+    case EtherType::IPv6:
+        // ignore
+        break;
+    default:
+        dbgln_if(ETHERNET_DEBUG, "NetworkTask: Unknown ethernet type {:#04x}", eth.ether_type());
+    }
+}
+
+// Takes everything the adapter has queued up at once and handles it as a batch,
+// then sends the ACKs that were delayed while doing so.
+bool receive_packets(NetworkAdapter& adapter)
+{
+    NetworkAdapter::PacketList packets;
+    auto packet_count = adapter.take_received_packets(packets);
+    if (packet_count == 0)
+        return false;
+
+    dbgln_if(NETWORK_TASK_DEBUG, "NetworkTask: Handling {} packets from {}", packet_count, adapter.name());
+    while (!packets.is_empty()) {
+        auto packet = packets.take_first();
+        handle_frame(packet->bytes(), packet->timestamp);
+        adapter.release_packet_buffer(*packet);
+    }
+
+    flush_delayed_tcp_acks();
+    return true;
+}
+
+void receive_worker_main(void* worker_ptr)
+{
+    auto& worker = *static_cast<ReceiveWorker*>(worker_ptr);
+    for (;;) {
+        if (!receive_packets(*worker.adapter))
+            worker.wait_queue.wait_forever("NetworkTask");
     }
 }
 
@@ -216,7 +273,7 @@ void handle_ipv4(EthernetFrameHeader const& eth, size_t frame_size, Time const&
     case IPv4Protocol::UDP:
         return handle_udp(packet, packet_timestamp);
     case IPv4Protocol::TCP:
-        return handle_tcp(packet, packet_timestamp);
+        return handle_tcp(packet);
     default:
         dbgln_if(IPV4_DEBUG, "handle_ipv4: Unhandled protocol {:#02x}", packet.protocol());
         break;
@@ -310,13 +367,24 @@ void send_delayed_tcp_ack(RefPtr<TCPSocket> socket)
         return;
     }
 
-    delayed_ack_sockets->set(move(socket));
+    s_delayed_ack_sockets->with_exclusive([&](auto& delayed_ack_sockets) {
+        delayed_ack_sockets.set(move(socket));
+    });
 }
 
 void flush_delayed_tcp_acks()
 {
+    // Several receive threads may get here at once, so take the set out of the table rather than
+    // holding its lock while locking the sockets (which have to be locked before the table).
+    HashTable<RefPtr<TCPSocket>> delayed_ack_sockets;
+    s_delayed_ack_sockets->with_exclusive([&](auto& table) {
+        swap(delayed_ack_sockets, table);
+    });
+    if (delayed_ack_sockets.is_empty())
+        return;
+
     Vector<RefPtr<TCPSocket>, 32> remaining_sockets;
-    for (auto& socket : *delayed_ack_sockets) {
+    for (auto& socket : delayed_ack_sockets) {
         MutexLocker locker(socket->mutex());
         if (socket->should_delay_next_ack()) {
             MUST(remaining_sockets.try_append(socket));
@@ -325,13 +393,14 @@ void flush_delayed_tcp_acks()
         [[maybe_unused]] auto result = socket->send_ack();
     }
 
-    if (remaining_sockets.size() != delayed_ack_sockets->size()) {
-        delayed_ack_sockets->clear();
-        if (remaining_sockets.size() > 0)
-            dbgln("flush_delayed_tcp_acks: {} sockets remaining", remaining_sockets.size());
+    if (remaining_sockets.is_empty())
+        return;
+    if (remaining_sockets.size() != delayed_ack_sockets.size())
+        dbgln("flush_delayed_tcp_acks: {} sockets remaining", remaining_sockets.size());
+    s_delayed_ack_sockets->with_exclusive([&](auto& table) {
         for (auto&& socket : remaining_sockets)
-            delayed_ack_sockets->set(move(socket));
-    }
+            table.set(move(socket));
+    });
 }
 
 void send_tcp_rst(IPv4Packet const& ipv4_packet, TCPPacket const& tcp_packet, RefPtr<NetworkAdapter> adapter)
@@ -368,7 +437,7 @@ void send_tcp_rst(IPv4Packet const& ipv4_packet, TCPPacket const& tcp_packet, Re
     routing_decision.adapter->release_packet_buffer(*packet);
 }
 
-void handle_tcp(IPv4Packet const& ipv4_packet, Time const& packet_timestamp)
+void handle_tcp(IPv4Packet const& ipv4_packet)
 {
     if (ipv4_packet.payload_size() < sizeof(TCPPacket)) {
         dbgln("handle_tcp: IPv4 payload is too small to be a TCP packet ({}, need {})", ipv4_packet.payload_size(), sizeof(TCPPacket));
@@ -457,6 +526,7 @@ void handle_tcp(IPv4Packet const& ipv4_packet, Time const& packet_timestamp)
             auto client = client_or_error.release_value();
             MutexLocker locker(client->mutex());
             dbgln_if(TCP_DEBUG, "handle_tcp: created new client socket with tuple {}", client->tuple().to_string());
+            client->process_syn_options(tcp_packet);
             client->set_sequence_number(1000);
             client->set_ack_number(tcp_packet.sequence_number() + payload_size + 1);
             [[maybe_unused]] auto rc2 = client->send_tcp_packet(TCPFlags::SYN | TCPFlags::ACK);
@@ -619,41 +689,30 @@ void handle_tcp(IPv4Packet const& ipv4_packet, Time const& packet_timestamp)
             return;
         }
 
-        if (tcp_packet.sequence_number() != socket->ack_number()) {
-            dbgln_if(TCP_DEBUG, "Discarding out of order packet: seq {} vs. ack {}", tcp_packet.sequence_number(), socket->ack_number());
-            if (socket->duplicate_acks() < TCPSocket::maximum_duplicate_acks) {
-                dbgln_if(TCP_DEBUG, "Sending ACK with same ack number to trigger fast retransmission");
-                socket->set_duplicate_acks(socket->duplicate_acks() + 1);
-                [[maybe_unused]] auto result = socket->send_ack(true);
-            }
+        switch (socket->receive_segment(tcp_packet, payload_size)) {
+        case TCPSocket::ReceiveResult::NothingToDo:
+            return;
+        case TCPSocket::ReceiveResult::Accepted:
+            dbgln_if(TCP_DEBUG, "Got packet with ack_no={}, seq_no={}, payload_size={}, acking it with new ack_no={}, seq_no={}",
+                tcp_packet.ack_number(), tcp_packet.sequence_number(), payload_size, socket->ack_number(), socket->sequence_number());
+            send_delayed_tcp_ack(socket);
+            return;
+        case TCPSocket::ReceiveResult::NeedsImmediateAck: {
+            dbgln_if(TCP_DEBUG, "Got packet with seq_no={}, payload_size={} that needs an immediate ACK (ack_no={})",
+                tcp_packet.sequence_number(), payload_size, socket->ack_number());
+            [[maybe_unused]] auto result = socket->send_ack(true);
             return;
         }
-
-        socket->set_duplicate_acks(0);
-
-        if (tcp_packet.has_fin()) {
-            if (payload_size != 0)
-                socket->did_receive(ipv4_packet.source(), tcp_packet.source_port(), { &ipv4_packet, sizeof(IPv4Packet) + ipv4_packet.payload_size() }, packet_timestamp);
-
-            socket->set_ack_number(tcp_packet.sequence_number() + payload_size + 1);
+        case TCPSocket::ReceiveResult::ReachedFIN:
             send_delayed_tcp_ack(socket);
             socket->set_state(TCPSocket::State::CloseWait);
             socket->set_connected(false);
             return;
         }
-
-        if (payload_size) {
-            if (socket->did_receive(ipv4_packet.source(), tcp_packet.source_port(), { &ipv4_packet, sizeof(IPv4Packet) + ipv4_packet.payload_size() }, packet_timestamp)) {
-                socket->set_ack_number(tcp_packet.sequence_number() + payload_size);
-                dbgln_if(TCP_DEBUG, "Got packet with ack_no={}, seq_no={}, payload_size={}, acking it with new ack_no={}, seq_no={}",
-                    tcp_packet.ack_number(), tcp_packet.sequence_number(), payload_size, socket->ack_number(), socket->sequence_number());
-                send_delayed_tcp_ack(socket);
-            }
-        }
     }
 }
 
-void retransmit_tcp_packets()
+Optional<Time> retransmit_tcp_packets()
 {
     // We must keep the sockets alive until after we've unlocked the hash table
     // in case retransmit_packets() realizes that it wants to close the socket.
@@ -664,10 +723,15 @@ void retransmit_tcp_packets()
         (void)sockets.try_append(socket);
     });
 
+    Optional<Time> next_retransmit_time;
     for (auto& socket : sockets) {
         MutexLocker socket_locker(socket.mutex());
         socket.retransmit_packets();
+        auto socket_retransmit_time = socket.next_retransmit_time();
+        if (!next_retransmit_time.has_value() || socket_retransmit_time < next_retransmit_time.value())
+            next_retransmit_time = socket_retransmit_time;
     }
+    return next_retransmit_time;
 }
 
 }
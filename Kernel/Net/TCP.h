@@ -6,6 +6,8 @@
 
 #pragma once
 
+#include <AK/IterationDecision.h>
+#include <AK/Span.h>
 #include <AK/StdLibExtras.h>
 #include <Kernel/Net/IPv4.h>
 
@@ -22,6 +24,15 @@ struct TCPFlags {
     };
 };
 
+enum class TCPOptionKind : u8 {
+    End = 0,
+    NoOperation = 1,
+    MSS = 2,
+    WindowScale = 3,
+    SACKPermitted = 4,
+    SACK = 5,
+};
+
 class [[gnu::packed]] TCPOptionMSS {
 public:
     TCPOptionMSS(u16 value)
@@ -39,6 +50,38 @@ private:
 
 static_assert(AssertSize<TCPOptionMSS, 4>());
 
+class [[gnu::packed]] TCPOptionWindowScale {
+public:
+    TCPOptionWindowScale(u8 shift_count)
+        : m_shift_count(shift_count)
+    {
+    }
+
+    u8 shift_count() const { return m_shift_count; }
+
+private:
+    u8 m_option_kind { (u8)TCPOptionKind::WindowScale };
+    u8 m_option_length { sizeof(TCPOptionWindowScale) };
+    u8 m_shift_count { 0 };
+};
+
+static_assert(AssertSize<TCPOptionWindowScale, 3>());
+
+class [[gnu::packed]] TCPOptionSACKPermitted {
+private:
+    u8 m_option_kind { (u8)TCPOptionKind::SACKPermitted };
+    u8 m_option_length { sizeof(TCPOptionSACKPermitted) };
+};
+
+static_assert(AssertSize<TCPOptionSACKPermitted, 2>());
+
+struct [[gnu::packed]] TCPSACKBlock {
+    NetworkOrdered<u32> left_edge;
+    NetworkOrdered<u32> right_edge;
+};
+
+static_assert(AssertSize<TCPSACKBlock, 8>());
+
 class [[gnu::packed]] TCPPacket {
 public:
     TCPPacket() = default;
@@ -78,6 +121,31 @@ public:
     u16 urgent() const { return m_urgent; }
     void set_urgent(u16 urgent) { m_urgent = urgent; }
 
+    // Calls the callback with the kind and data (excluding the kind and length bytes) of every option
+    // in the header. Stops at the end of the option list, or at the first malformed option.
+    template<typename Callback>
+    void for_each_option(Callback callback) const
+    {
+        if (header_size() <= sizeof(TCPPacket))
+            return;
+        ReadonlyBytes options { ((u8 const*)this) + sizeof(TCPPacket), header_size() - sizeof(TCPPacket) };
+        while (!options.is_empty()) {
+            auto kind = static_cast<TCPOptionKind>(options[0]);
+            if (kind == TCPOptionKind::End)
+                return;
+            if (kind == TCPOptionKind::NoOperation) {
+                options = options.slice(1);
+                continue;
+            }
+            if (options.size() < 2 || options[1] < 2 || options[1] > options.size())
+                return;
+            size_t option_length = options[1];
+            if (callback(kind, options.slice(2, option_length - 2)) == IterationDecision::Break)
+                return;
+            options = options.slice(option_length);
+        }
+    }
+
     const void* payload() const { return ((const u8*)this) + header_size(); }
     void* payload() { return ((u8*)this) + header_size(); }
 
@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <Kernel/Net/TCPCongestionControl.h>
+
+namespace Kernel {
+
+ErrorOr<NonnullOwnPtr<TCPCongestionControl>> TCPCongestionControl::try_create_default()
+{
+    return adopt_nonnull_own_or_enomem<TCPCongestionControl>(new (nothrow) TCPNewReno);
+}
+
+TCPCongestionControl::TCPCongestionControl()
+{
+    m_congestion_window = initial_window();
+}
+
+void TCPCongestionControl::set_maximum_segment_size(size_t maximum_segment_size)
+{
+    m_maximum_segment_size = maximum_segment_size;
+    m_congestion_window = initial_window();
+}
+
+size_t TCPCongestionControl::initial_window() const
+{
+    if (m_maximum_segment_size > 2190)
+        return 2 * m_maximum_segment_size;
+    if (m_maximum_segment_size > 1095)
+        return 3 * m_maximum_segment_size;
+    return 4 * m_maximum_segment_size;
+}
+
+void TCPNewReno::on_ack(size_t bytes_acked)
+{
+    if (is_in_slow_start()) {
+        m_congestion_window += min(bytes_acked, m_maximum_segment_size);
+        return;
+    }
+
+    // Congestion avoidance: grow by one segment per window's worth of acknowledged data.
+    m_bytes_acked += bytes_acked;
+    if (m_bytes_acked >= m_congestion_window) {
+        m_bytes_acked -= m_congestion_window;
+        m_congestion_window += m_maximum_segment_size;
+    }
+}
+
+void TCPNewReno::on_enter_fast_recovery(size_t bytes_in_flight)
+{
+    m_slow_start_threshold = max(bytes_in_flight / 2, 2 * m_maximum_segment_size);
+    // The three duplicate ACKs mean three segments have left the network.
+    m_congestion_window = m_slow_start_threshold + 3 * m_maximum_segment_size;
+    m_bytes_acked = 0;
+}
+
+void TCPNewReno::on_duplicate_ack_in_fast_recovery()
+{
+    m_congestion_window += m_maximum_segment_size;
+}
+
+void TCPNewReno::on_partial_ack(size_t bytes_acked)
+{
+    // Deflate by the amount of new data acknowledged, then add back one segment if at least
+    // that much was acknowledged, so that roughly ssthresh bytes remain in flight.
+    m_congestion_window -= min(bytes_acked, m_congestion_window);
+    if (bytes_acked >= m_maximum_segment_size)
+        m_congestion_window += m_maximum_segment_size;
+    m_congestion_window = max(m_congestion_window, m_maximum_segment_size);
+}
+
+void TCPNewReno::on_exit_fast_recovery()
+{
+    m_congestion_window = m_slow_start_threshold;
+}
+
+void TCPNewReno::on_retransmit_timeout(size_t bytes_in_flight)
+{
+    m_slow_start_threshold = max(bytes_in_flight / 2, 2 * m_maximum_segment_size);
+    m_congestion_window = m_maximum_segment_size;
+    m_bytes_acked = 0;
+}
+
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Error.h>
+#include <AK/NumericLimits.h>
+#include <AK/OwnPtr.h>
+#include <AK/StringView.h>
+#include <AK/Types.h>
+
+namespace Kernel {
+
+// Decides how much data a TCP connection may have in flight at once. TCPSocket detects
+// losses and retransmits; a congestion control algorithm only decides how the congestion
+// window grows on ACKs and how it shrinks when the network drops something.
+class TCPCongestionControl {
+public:
+    static ErrorOr<NonnullOwnPtr<TCPCongestionControl>> try_create_default();
+    virtual ~TCPCongestionControl() = default;
+
+    virtual StringView name() const = 0;
+
+    size_t congestion_window() const { return m_congestion_window; }
+    size_t slow_start_threshold() const { return m_slow_start_threshold; }
+    bool is_in_slow_start() const { return m_congestion_window < m_slow_start_threshold; }
+
+    // Called while the connection is being set up, once we know how large our segments will be.
+    void set_maximum_segment_size(size_t);
+
+    // New data was acknowledged outside of fast recovery.
+    virtual void on_ack(size_t bytes_acked) = 0;
+    // Three duplicate ACKs told us a segment was lost, and we are entering fast recovery.
+    virtual void on_enter_fast_recovery(size_t bytes_in_flight) = 0;
+    // Another duplicate ACK arrived during fast recovery, so one more segment has left the network.
+    virtual void on_duplicate_ack_in_fast_recovery() = 0;
+    // Some, but not all, of the data outstanding when fast recovery began was acknowledged.
+    virtual void on_partial_ack(size_t bytes_acked) = 0;
+    // Everything that was outstanding when fast recovery began has been acknowledged.
+    virtual void on_exit_fast_recovery() = 0;
+    // The retransmission timer expired.
+    virtual void on_retransmit_timeout(size_t bytes_in_flight) = 0;
+
+protected:
+    TCPCongestionControl();
+
+    // RFC 5681 says the initial window depends on the segment size.
+    size_t initial_window() const;
+
+    size_t m_maximum_segment_size { 536 };
+    size_t m_congestion_window { 0 };
+    size_t m_slow_start_threshold { NumericLimits<size_t>::max() };
+};
+
+// RFC 5681 slow start and congestion avoidance, with the RFC 6582 (NewReno) fast recovery changes.
+class TCPNewReno final : public TCPCongestionControl {
+public:
+    TCPNewReno() = default;
+
+    virtual StringView name() const override { return "newreno"sv; }
+
+    virtual void on_ack(size_t bytes_acked) override;
+    virtual void on_enter_fast_recovery(size_t bytes_in_flight) override;
+    virtual void on_duplicate_ack_in_fast_recovery() override;
+    virtual void on_partial_ack(size_t bytes_acked) override;
+    virtual void on_exit_fast_recovery() override;
+    virtual void on_retransmit_timeout(size_t bytes_in_flight) override;
+
+private:
+    // Bytes acknowledged during congestion avoidance since the window last grew (RFC 3465 byte counting).
+    size_t m_bytes_acked { 0 };
+};
+
+}
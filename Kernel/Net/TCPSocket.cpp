@@ -19,9 +19,27 @@
 #include <Kernel/Net/TCPSocket.h>
 #include <Kernel/Process.h>
 #include <Kernel/Random.h>
+#include <Kernel/Time/TimeManagement.h>
 
 namespace Kernel {
 
+// RFC 6298 says the retransmission timeout should be at least one second. We stick to that, as our
+// delayed ACKs can take up to 500 ms, but let it grow further when the round trip time calls for it.
+static constexpr i64 minimum_retransmission_timeout_us = 1'000'000;
+static constexpr i64 maximum_retransmission_timeout_us = 60'000'000;
+static constexpr i64 clock_granularity_us = 1'000;
+
+// Sequence numbers wrap around, so they have to be compared relative to each other.
+static constexpr bool sequence_less_than(u32 a, u32 b)
+{
+    return static_cast<i32>(a - b) < 0;
+}
+
+static constexpr bool sequence_less_than_or_equal(u32 a, u32 b)
+{
+    return static_cast<i32>(a - b) <= 0;
+}
+
 void TCPSocket::for_each(Function<void(const TCPSocket&)> callback)
 {
     sockets_by_tuple().for_each_shared([&](const auto& it) {
@@ -153,10 +171,11 @@ void TCPSocket::release_for_accept(RefPtr<TCPSocket> socket)
     [[maybe_unused]] auto rc = queue_connection_from(*socket);
 }
 
-TCPSocket::TCPSocket(int protocol, NonnullOwnPtr<DoubleBuffer> receive_buffer, NonnullOwnPtr<KBuffer> scratch_buffer)
+TCPSocket::TCPSocket(int protocol, NonnullOwnPtr<DoubleBuffer> receive_buffer, NonnullOwnPtr<KBuffer> scratch_buffer, NonnullOwnPtr<TCPCongestionControl> congestion_control)
     : IPv4Socket(SOCK_STREAM, protocol, move(receive_buffer), move(scratch_buffer))
+    , m_congestion_control(move(congestion_control))
 {
-    m_last_retransmit_time = kgettimeofday();
+    m_last_retransmit_time = TimeManagement::the().monotonic_time();
 }
 
 TCPSocket::~TCPSocket()
@@ -170,7 +189,8 @@ ErrorOr<NonnullRefPtr<TCPSocket>> TCPSocket::try_create(int protocol, NonnullOwn
 {
     // Note: Scratch buffer is only used for SOCK_STREAM sockets.
     auto scratch_buffer = TRY(KBuffer::try_create_with_size(65536));
-    return adopt_nonnull_ref_or_enomem(new (nothrow) TCPSocket(protocol, move(receive_buffer), move(scratch_buffer)));
+    auto congestion_control = TRY(TCPCongestionControl::try_create_default());
+    return adopt_nonnull_ref_or_enomem(new (nothrow) TCPSocket(protocol, move(receive_buffer), move(scratch_buffer), move(congestion_control)));
 }
 
 ErrorOr<size_t> TCPSocket::protocol_size(ReadonlyBytes raw_ipv4_packet)
@@ -196,12 +216,53 @@ ErrorOr<size_t> TCPSocket::protocol_send(const UserOrKernelBuffer& data, size_t
     RoutingDecision routing_decision = route_to(peer_address(), local_address(), bound_interface());
     if (routing_decision.is_zero())
         return set_so_error(EHOSTUNREACH);
-    size_t mss = routing_decision.adapter->mtu() - sizeof(IPv4Packet) - sizeof(TCPPacket);
-    data_length = min(data_length, mss);
+    auto sendable = m_unacked_packets.with_shared([&](auto& unacked_packets) {
+        return sendable_bytes(unacked_packets);
+    });
+    if (sendable == 0)
+        return set_so_error(EAGAIN);
+    data_length = min(data_length, min(maximum_segment_size(*routing_decision.adapter), sendable));
     TRY(send_tcp_packet(TCPFlags::PUSH | TCPFlags::ACK, &data, data_length, &routing_decision));
     return data_length;
 }
 
+static size_t maximum_segment_size_for_adapter(NetworkAdapter const& adapter)
+{
+    // The IPv4 total length field is 16 bits wide, so that's as large as a packet can get, no matter what the link could carry.
+    size_t mtu = min<size_t>(adapter.mtu(), NumericLimits<u16>::max());
+    return mtu - sizeof(IPv4Packet) - sizeof(TCPPacket);
+}
+
+size_t TCPSocket::maximum_segment_size(NetworkAdapter const& adapter) const
+{
+    return min(maximum_segment_size_for_adapter(adapter), m_peer_maximum_segment_size);
+}
+
+size_t TCPSocket::sendable_bytes(UnackedPackets const& unacked_packets) const
+{
+    auto congestion_window = m_congestion_control->congestion_window();
+    auto bytes_in_flight = unacked_packets.bytes_in_flight();
+    size_t congestion_room = congestion_window > bytes_in_flight ? congestion_window - bytes_in_flight : 0;
+    size_t peer_room = m_send_window_size > unacked_packets.size ? m_send_window_size - unacked_packets.size : 0;
+    auto room = min(congestion_room, peer_room);
+
+    // Avoid the silly window syndrome (RFC 1122 4.2.3.4) by only sending less than a
+    // full segment when nothing else is outstanding.
+    // FIXME: Add a persist timer, so a zero window from the peer can't stall us if its window update gets lost.
+    if (room < m_maximum_segment_size && !unacked_packets.packets.is_empty())
+        return 0;
+    return room;
+}
+
+u16 TCPSocket::advertised_window(bool is_syn)
+{
+    // The window field of a SYN is never scaled.
+    u8 scale = is_syn ? 0 : m_receive_window_scale;
+    auto window = min<size_t>(receive_buffer_space() >> scale, NumericLimits<u16>::max());
+    m_last_advertised_window = window << scale;
+    return window;
+}
+
 ErrorOr<void> TCPSocket::send_ack(bool allow_duplicate)
 {
     if (!allow_duplicate && m_last_ack_number_sent == m_ack_number)
@@ -217,8 +278,54 @@ ErrorOr<void> TCPSocket::send_tcp_packet(u16 flags, const UserOrKernelBuffer* pa
 
     auto ipv4_payload_offset = routing_decision.adapter->ipv4_payload_offset();
 
-    const bool has_mss_option = flags == TCPFlags::SYN;
-    const size_t options_size = has_mss_option ? sizeof(TCPOptionMSS) : 0;
+    // We always offer window scaling and SACK in a SYN, but only agree to them in a SYN|ACK if the peer offered them.
+    const bool is_syn = flags & TCPFlags::SYN;
+    const bool has_window_scale_option = is_syn && (!(flags & TCPFlags::ACK) || m_window_scaling_enabled);
+    const bool has_sack_permitted_option = is_syn && (!(flags & TCPFlags::ACK) || m_sack_enabled);
+
+    if (has_window_scale_option) {
+        // Pick the smallest scale that lets us advertise our whole receive buffer.
+        m_receive_window_scale = 0;
+        while (m_receive_window_scale < 14 && (receive_buffer_space() >> m_receive_window_scale) > NumericLimits<u16>::max())
+            ++m_receive_window_scale;
+    }
+
+    Array<TCPSACKBlock, 4> sack_blocks;
+    size_t sack_block_count = 0;
+    // Our MSS leaves no room for options in full-sized segments, so SACK blocks only go out on pure ACKs.
+    if (!is_syn && (flags & TCPFlags::ACK) && payload_size == 0 && m_sack_enabled)
+        sack_block_count = fill_in_sack_blocks(sack_blocks.span());
+
+    // Options are padded with NOPs to a multiple of 4 bytes, so the header needs no further padding.
+    u8 options[40];
+    size_t options_size = 0;
+    auto append_no_operations = [&](size_t count) {
+        memset(options + options_size, (u8)TCPOptionKind::NoOperation, count);
+        options_size += count;
+    };
+    auto append_option = [&](auto const& option) {
+        memcpy(options + options_size, &option, sizeof(option));
+        options_size += sizeof(option);
+    };
+    if (is_syn)
+        append_option(TCPOptionMSS { static_cast<u16>(maximum_segment_size_for_adapter(*routing_decision.adapter)) });
+    if (has_window_scale_option) {
+        append_no_operations(1);
+        append_option(TCPOptionWindowScale { m_receive_window_scale });
+    }
+    if (has_sack_permitted_option) {
+        append_no_operations(2);
+        append_option(TCPOptionSACKPermitted {});
+    }
+    if (sack_block_count > 0) {
+        append_no_operations(2);
+        options[options_size++] = (u8)TCPOptionKind::SACK;
+        options[options_size++] = 2 + sack_block_count * sizeof(TCPSACKBlock);
+        memcpy(options + options_size, sack_blocks.data(), sack_block_count * sizeof(TCPSACKBlock));
+        options_size += sack_block_count * sizeof(TCPSACKBlock);
+    }
+    VERIFY(options_size % sizeof(u32) == 0);
+
     const size_t tcp_header_size = sizeof(TCPPacket) + options_size;
     const size_t buffer_size = ipv4_payload_offset + tcp_header_size + payload_size;
     auto packet = routing_decision.adapter->acquire_packet_buffer(buffer_size);
@@ -232,7 +339,7 @@ ErrorOr<void> TCPSocket::send_tcp_packet(u16 flags, const UserOrKernelBuffer* pa
     VERIFY(local_port());
     tcp_packet.set_source_port(local_port());
     tcp_packet.set_destination_port(peer_port());
-    tcp_packet.set_window_size(NumericLimits<u16>::max());
+    tcp_packet.set_window_size(advertised_window(is_syn));
     tcp_packet.set_sequence_number(m_sequence_number);
     tcp_packet.set_data_offset(tcp_header_size / sizeof(u32));
     tcp_packet.set_flags(flags);
@@ -250,17 +357,18 @@ ErrorOr<void> TCPSocket::send_tcp_packet(u16 flags, const UserOrKernelBuffer* pa
         tcp_packet.set_ack_number(m_ack_number);
     }
 
+    auto packet_sequence_number = m_sequence_number;
     if (flags & TCPFlags::SYN) {
+        m_send_unacknowledged = m_sequence_number;
+        m_highest_sacked = m_sequence_number;
         ++m_sequence_number;
     } else {
         m_sequence_number += payload_size;
     }
 
-    if (has_mss_option) {
-        u16 mss = routing_decision.adapter->mtu() - sizeof(IPv4Packet) - sizeof(TCPPacket);
-        TCPOptionMSS mss_option { mss };
-        VERIFY(packet->buffer->size() >= ipv4_payload_offset + sizeof(TCPPacket) + sizeof(mss_option));
-        memcpy(packet->buffer->data() + ipv4_payload_offset + sizeof(TCPPacket), &mss_option, sizeof(mss_option));
+    if (options_size > 0) {
+        VERIFY(packet->buffer->size() >= ipv4_payload_offset + tcp_header_size);
+        memcpy(packet->buffer->data() + ipv4_payload_offset + sizeof(TCPPacket), options, options_size);
     }
 
     tcp_packet.set_checksum(compute_tcp_checksum(local_address(), peer_address(), tcp_packet, payload_size));
@@ -271,7 +379,11 @@ ErrorOr<void> TCPSocket::send_tcp_packet(u16 flags, const UserOrKernelBuffer* pa
     m_bytes_out += buffer_size;
     if (tcp_packet.has_syn() || payload_size > 0) {
         m_unacked_packets.with_exclusive([&](auto& unacked_packets) {
-            unacked_packets.packets.append({ m_sequence_number, move(packet), ipv4_payload_offset, *routing_decision.adapter });
+            auto sent_time = TimeManagement::the().monotonic_time(TimePrecision::Precise);
+            // RFC 6298 says the retransmission timer starts once there is outstanding data.
+            if (unacked_packets.packets.is_empty())
+                m_last_retransmit_time = sent_time;
+            unacked_packets.packets.append({ packet_sequence_number, m_sequence_number, payload_size, move(packet), ipv4_payload_offset, *routing_decision.adapter, sent_time });
             unacked_packets.size += payload_size;
             enqueue_for_retransmit();
         });
@@ -284,53 +396,429 @@ ErrorOr<void> TCPSocket::send_tcp_packet(u16 flags, const UserOrKernelBuffer* pa
 
 void TCPSocket::receive_tcp_packet(const TCPPacket& packet, u16 size)
 {
+    if (packet.has_syn() && m_state != State::Listen)
+        process_syn_options(packet);
+
     if (packet.has_ack()) {
-        u32 ack_number = packet.ack_number();
+        auto previous_send_window_size = m_send_window_size;
+        // The window field of a SYN is never scaled.
+        u8 scale = packet.has_syn() ? 0 : m_send_window_scale;
+        m_send_window_size = static_cast<u32>(packet.window_size()) << scale;
+        process_ack(packet, size - packet.header_size(), m_send_window_size != previous_send_window_size);
+    }
 
-        dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: receive_tcp_packet: {}", ack_number);
+    m_packets_in++;
+    m_bytes_in += packet.header_size() + size;
+}
+
+void TCPSocket::process_syn_options(TCPPacket const& packet)
+{
+    Optional<u16> peer_maximum_segment_size;
+    Optional<u8> peer_window_scale;
+    bool peer_permits_sack = false;
+    packet.for_each_option([&](TCPOptionKind kind, ReadonlyBytes data) {
+        switch (kind) {
+        case TCPOptionKind::MSS:
+            if (data.size() == sizeof(u16))
+                peer_maximum_segment_size = (data[0] << 8) | data[1];
+            break;
+        case TCPOptionKind::WindowScale:
+            // RFC 7323 says shift counts above 14 must be treated as 14.
+            if (data.size() == 1)
+                peer_window_scale = min(data[0], (u8)14);
+            break;
+        case TCPOptionKind::SACKPermitted:
+            peer_permits_sack = true;
+            break;
+        default:
+            break;
+        }
+        return IterationDecision::Continue;
+    });
+
+    m_peer_maximum_segment_size = peer_maximum_segment_size.value_or(default_maximum_segment_size);
+    m_window_scaling_enabled = peer_window_scale.has_value();
+    m_send_window_scale = peer_window_scale.value_or(0);
+    if (!m_window_scaling_enabled)
+        m_receive_window_scale = 0;
+    m_sack_enabled = peer_permits_sack;
+
+    auto routing_decision = route_to(peer_address(), local_address(), bound_interface());
+    if (!routing_decision.is_zero())
+        m_maximum_segment_size = maximum_segment_size(*routing_decision.adapter);
+    else
+        m_maximum_segment_size = m_peer_maximum_segment_size;
+    m_congestion_control->set_maximum_segment_size(m_maximum_segment_size);
 
+    dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket({}) peer options: mss={}, window_scale={}, sack={}", this, m_peer_maximum_segment_size, m_send_window_scale, m_sack_enabled);
+}
+
+void TCPSocket::process_ack(TCPPacket const& packet, size_t payload_size, bool window_changed)
+{
+    u32 ack_number = packet.ack_number();
+
+    dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: process_ack: {}", ack_number);
+
+    if (sequence_less_than(m_sequence_number, ack_number)) {
+        dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: ignoring ACK for data we haven't sent ({} vs. {})", ack_number, m_sequence_number);
+        return;
+    }
+
+    auto now = TimeManagement::the().monotonic_time(TimePrecision::Precise);
+
+    m_unacked_packets.with_exclusive([&](auto& unacked_packets) {
+        if (m_sack_enabled)
+            process_sack_blocks(packet, unacked_packets);
+
+        size_t bytes_acked = 0;
+        Optional<Time> round_trip_time;
         int removed = 0;
-        m_unacked_packets.with_exclusive([&](auto& unacked_packets) {
-            while (!unacked_packets.packets.is_empty()) {
-                auto& packet = unacked_packets.packets.first();
-
-                dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: iterate: {}", packet.ack_number);
-
-                if (packet.ack_number <= ack_number) {
-                    auto old_adapter = packet.adapter.strong_ref();
-                    if (old_adapter)
-                        old_adapter->release_packet_buffer(*packet.buffer);
-                    TCPPacket& tcp_packet = *(TCPPacket*)(packet.buffer->buffer->data() + packet.ipv4_payload_offset);
-                    auto payload_size = packet.buffer->buffer->data() + packet.buffer->buffer->size() - (u8*)tcp_packet.payload();
-                    unacked_packets.size -= payload_size;
-                    evaluate_block_conditions();
-                    unacked_packets.packets.take_first();
-                    removed++;
-                } else {
-                    break;
+        while (!unacked_packets.packets.is_empty()) {
+            auto& unacked_packet = unacked_packets.packets.first();
+
+            dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: iterate: {}", unacked_packet.ack_number);
+
+            if (!sequence_less_than_or_equal(unacked_packet.ack_number, ack_number))
+                break;
+
+            // Karn's algorithm: we can't tell which transmission of a retransmitted packet is being ACKed, so it can't be timed.
+            if (unacked_packet.tx_counter == 0)
+                round_trip_time = now - unacked_packet.sent_time;
+
+            auto old_adapter = unacked_packet.adapter.strong_ref();
+            if (old_adapter)
+                old_adapter->release_packet_buffer(*unacked_packet.buffer);
+            unacked_packets.size -= unacked_packet.payload_size;
+            if (unacked_packet.sacked)
+                unacked_packets.sacked_size -= unacked_packet.payload_size;
+            if (unacked_packet.lost)
+                unacked_packets.lost_size -= unacked_packet.payload_size;
+            bytes_acked += unacked_packet.payload_size;
+            unacked_packets.packets.take_first();
+            removed++;
+        }
+
+        dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: process_ack acknowledged {} packets", removed);
+
+        if (sequence_less_than(m_send_unacknowledged, ack_number)) {
+            m_send_unacknowledged = ack_number;
+            m_duplicate_ack_count = 0;
+            m_retransmit_attempts = 0;
+            m_last_retransmit_time = now;
+            if (round_trip_time.has_value())
+                update_round_trip_time(round_trip_time.value());
+
+            if (!m_in_fast_recovery) {
+                m_congestion_control->on_ack(bytes_acked);
+                retransmit_lost_packets(unacked_packets, false);
+            } else if (sequence_less_than_or_equal(m_recovery_point, ack_number)) {
+                m_in_fast_recovery = false;
+                m_congestion_control->on_exit_fast_recovery();
+                retransmit_lost_packets(unacked_packets, false);
+            } else {
+                // A partial ACK means the packet right after it was lost as well.
+                m_congestion_control->on_partial_ack(bytes_acked);
+                if (!unacked_packets.packets.is_empty()) {
+                    auto& next_packet = unacked_packets.packets.first();
+                    if (!next_packet.sacked && !next_packet.lost) {
+                        next_packet.lost = true;
+                        unacked_packets.lost_size += next_packet.payload_size;
+                    }
                 }
+                if (m_sack_enabled)
+                    mark_lost_packets_below_highest_sack(unacked_packets);
+                retransmit_lost_packets(unacked_packets, true);
             }
+            evaluate_block_conditions();
+        } else if (ack_number == m_send_unacknowledged && payload_size == 0 && !packet.has_syn() && !packet.has_fin()
+            && !window_changed && !unacked_packets.packets.is_empty()) {
+            ++m_duplicate_ack_count;
+            dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: duplicate ACK #{} for {}", m_duplicate_ack_count, ack_number);
+            if (m_in_fast_recovery) {
+                m_congestion_control->on_duplicate_ack_in_fast_recovery();
+                if (m_sack_enabled)
+                    mark_lost_packets_below_highest_sack(unacked_packets);
+                retransmit_lost_packets(unacked_packets, false);
+                evaluate_block_conditions();
+            } else if (m_duplicate_ack_count == duplicate_ack_threshold) {
+                enter_fast_recovery(unacked_packets);
+            }
+        } else if (window_changed) {
+            evaluate_block_conditions();
+        }
 
-            if (unacked_packets.packets.is_empty()) {
-                m_retransmit_attempts = 0;
-                dequeue_for_retransmit();
+        if (unacked_packets.packets.is_empty()) {
+            m_retransmit_attempts = 0;
+            dequeue_for_retransmit();
+        }
+    });
+}
+
+void TCPSocket::process_sack_blocks(TCPPacket const& packet, UnackedPackets& unacked_packets)
+{
+    packet.for_each_option([&](TCPOptionKind kind, ReadonlyBytes data) {
+        if (kind != TCPOptionKind::SACK)
+            return IterationDecision::Continue;
+
+        for (size_t offset = 0; offset + sizeof(TCPSACKBlock) <= data.size(); offset += sizeof(TCPSACKBlock)) {
+            auto const& block = *reinterpret_cast<TCPSACKBlock const*>(data.data() + offset);
+            u32 left_edge = block.left_edge;
+            u32 right_edge = block.right_edge;
+            if (!sequence_less_than(left_edge, right_edge) || sequence_less_than(m_sequence_number, right_edge))
+                continue;
+            if (sequence_less_than(m_highest_sacked, right_edge))
+                m_highest_sacked = right_edge;
+
+            for (auto& unacked_packet : unacked_packets.packets) {
+                if (unacked_packet.sacked || unacked_packet.payload_size == 0)
+                    continue;
+                u32 packet_end = unacked_packet.sequence_number + unacked_packet.payload_size;
+                if (!sequence_less_than_or_equal(left_edge, unacked_packet.sequence_number) || !sequence_less_than_or_equal(packet_end, right_edge))
+                    continue;
+                unacked_packet.sacked = true;
+                unacked_packets.sacked_size += unacked_packet.payload_size;
+                if (unacked_packet.lost) {
+                    unacked_packet.lost = false;
+                    unacked_packets.lost_size -= unacked_packet.payload_size;
+                }
             }
+        }
+        return IterationDecision::Break;
+    });
+}
 
-            dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: receive_tcp_packet acknowledged {} packets", removed);
-        });
+void TCPSocket::mark_lost_packets_below_highest_sack(UnackedPackets& unacked_packets)
+{
+    // Anything the peer has received data beyond, but not this packet itself, most likely got
+    // lost. We only do this during recovery, so unlike RFC 6675 we don't wait for more SACKs.
+    for (auto& unacked_packet : unacked_packets.packets) {
+        if (!sequence_less_than(unacked_packet.sequence_number, m_highest_sacked))
+            break;
+        if (unacked_packet.sacked || unacked_packet.lost || unacked_packet.tx_counter > 0 || unacked_packet.payload_size == 0)
+            continue;
+        unacked_packet.lost = true;
+        unacked_packets.lost_size += unacked_packet.payload_size;
     }
+}
 
-    m_packets_in++;
-    m_bytes_in += packet.header_size() + size;
+void TCPSocket::enter_fast_recovery(UnackedPackets& unacked_packets)
+{
+    dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket({}) entering fast recovery at {}", this, m_send_unacknowledged);
+
+    m_in_fast_recovery = true;
+    m_recovery_point = m_sequence_number;
+    m_congestion_control->on_enter_fast_recovery(unacked_packets.bytes_in_flight());
+
+    for (auto& unacked_packet : unacked_packets.packets) {
+        if (unacked_packet.sacked)
+            continue;
+        if (!unacked_packet.lost) {
+            unacked_packet.lost = true;
+            unacked_packets.lost_size += unacked_packet.payload_size;
+        }
+        break;
+    }
+    if (m_sack_enabled)
+        mark_lost_packets_below_highest_sack(unacked_packets);
+
+    retransmit_lost_packets(unacked_packets, true);
 }
 
-bool TCPSocket::should_delay_next_ack() const
+void TCPSocket::retransmit_lost_packets(UnackedPackets& unacked_packets, bool force_first)
+{
+    if (unacked_packets.lost_size == 0 && !force_first)
+        return;
+
+    auto routing_decision = route_to(peer_address(), local_address(), bound_interface());
+    if (routing_decision.is_zero())
+        return;
+
+    auto congestion_window = m_congestion_control->congestion_window();
+    for (auto& unacked_packet : unacked_packets.packets) {
+        if (!unacked_packet.lost)
+            continue;
+        if (!force_first && unacked_packets.bytes_in_flight() + unacked_packet.payload_size > congestion_window)
+            break;
+        force_first = false;
+        unacked_packet.lost = false;
+        unacked_packets.lost_size -= unacked_packet.payload_size;
+        retransmit_packet(unacked_packet, routing_decision);
+    }
+}
+
+void TCPSocket::update_round_trip_time(Time sample)
 {
-    // FIXME: We don't know the MSS here so make a reasonable guess.
-    const size_t mss = 1500;
+    auto sample_us = sample.to_microseconds();
+    if (!m_has_round_trip_time_sample) {
+        m_smoothed_round_trip_time_us = sample_us;
+        m_round_trip_time_variation_us = sample_us / 2;
+        m_has_round_trip_time_sample = true;
+    } else {
+        auto delta = m_smoothed_round_trip_time_us - sample_us;
+        if (delta < 0)
+            delta = -delta;
+        m_round_trip_time_variation_us = (3 * m_round_trip_time_variation_us + delta) / 4;
+        m_smoothed_round_trip_time_us = (7 * m_smoothed_round_trip_time_us + sample_us) / 8;
+    }
+    auto timeout_us = m_smoothed_round_trip_time_us + max(clock_granularity_us, 4 * m_round_trip_time_variation_us);
+    m_retransmission_timeout_us = clamp(timeout_us, minimum_retransmission_timeout_us, maximum_retransmission_timeout_us);
+}
+
+Time TCPSocket::retransmission_timeout() const
+{
+    // RFC 6298 (and RFC 1122 before it) say we must back off exponentially, even for SYN packets.
+    auto timeout_us = m_retransmission_timeout_us << min(m_retransmit_attempts, maximum_retransmits);
+    return Time::from_microseconds(min(timeout_us, maximum_retransmission_timeout_us));
+}
+
+TCPSocket::ReceiveResult TCPSocket::receive_segment(TCPPacket const& packet, size_t payload_size)
+{
+    u32 sequence_number = packet.sequence_number();
+    ReadonlyBytes payload { static_cast<u8 const*>(packet.payload()), payload_size };
+    bool has_fin = packet.has_fin();
+
+    if (payload.is_empty() && !has_fin)
+        return ReceiveResult::NothingToDo;
+
+    if (sequence_less_than(m_ack_number, sequence_number)) {
+        dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket({}) holding on to out of order segment: seq {} vs. ack {}", this, sequence_number, m_ack_number);
+        queue_out_of_order_segment(sequence_number, payload, has_fin);
+        // Our duplicate ACK (and its SACK blocks) tell the peer about the gap.
+        return ReceiveResult::NeedsImmediateAck;
+    }
 
+    // Skip whatever part of the segment we already have.
+    u32 already_received = m_ack_number - sequence_number;
+    if (already_received > payload.size())
+        return ReceiveResult::NeedsImmediateAck;
+    payload = payload.slice(already_received);
+    if (payload.is_empty() && !has_fin)
+        return ReceiveResult::NeedsImmediateAck;
+
+    bool fills_gap = !m_out_of_order_segments.is_empty();
+    auto nreceived = did_receive_stream_data(payload);
+    m_ack_number += nreceived;
+    if (nreceived < payload.size()) {
+        dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket({}) receive buffer is full, only took {} of {} bytes", this, nreceived, payload.size());
+        return ReceiveResult::NeedsImmediateAck;
+    }
+
+    if (has_fin) {
+        ++m_ack_number;
+        m_out_of_order_segments.clear();
+        return ReceiveResult::ReachedFIN;
+    }
+
+    if (deliver_out_of_order_segments())
+        return ReceiveResult::ReachedFIN;
+
+    // RFC 5681 says we should immediately ACK a segment that fills in a gap.
+    return fills_gap ? ReceiveResult::NeedsImmediateAck : ReceiveResult::Accepted;
+}
+
+void TCPSocket::queue_out_of_order_segment(u32 sequence_number, ReadonlyBytes payload, bool has_fin)
+{
+    // Only hold on to what fits into the window we advertised.
+    u32 end = sequence_number + payload.size();
+    if (end - m_ack_number > receive_buffer_space() || m_out_of_order_segments.size() >= maximum_out_of_order_segments) {
+        dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket({}) dropping out of order segment {}-{}", this, sequence_number, end);
+        return;
+    }
+
+    size_t index = 0;
+    for (; index < m_out_of_order_segments.size(); ++index) {
+        auto& segment = m_out_of_order_segments[index];
+        if (segment.sequence_number == sequence_number && segment.size >= payload.size() && segment.has_fin == has_fin)
+            return;
+        if (sequence_less_than(sequence_number, segment.sequence_number))
+            break;
+    }
+
+    OwnPtr<KBuffer> data;
+    if (!payload.is_empty()) {
+        auto data_or_error = KBuffer::try_create_with_bytes(payload);
+        if (data_or_error.is_error()) {
+            dbgln("TCPSocket: unable to allocate storage for out of order segment");
+            return;
+        }
+        data = data_or_error.release_value();
+    }
+    (void)m_out_of_order_segments.try_insert(index, { sequence_number, payload.size(), move(data), has_fin });
+}
+
+bool TCPSocket::deliver_out_of_order_segments()
+{
+    while (!m_out_of_order_segments.is_empty()) {
+        auto& segment = m_out_of_order_segments.first();
+        if (sequence_less_than(m_ack_number, segment.sequence_number))
+            return false;
+
+        u32 already_received = m_ack_number - segment.sequence_number;
+        if (already_received > segment.size || (already_received == segment.size && !segment.has_fin)) {
+            m_out_of_order_segments.remove(0);
+            continue;
+        }
+
+        if (already_received < segment.size) {
+            auto remaining = segment.data->bytes().slice(already_received);
+            auto nreceived = did_receive_stream_data(remaining);
+            m_ack_number += nreceived;
+            // If the receive buffer is full, keep the rest around until there is room.
+            if (nreceived < remaining.size())
+                return false;
+        }
+
+        bool has_fin = segment.has_fin;
+        m_out_of_order_segments.remove(0);
+        if (has_fin) {
+            ++m_ack_number;
+            m_out_of_order_segments.clear();
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t TCPSocket::fill_in_sack_blocks(Span<TCPSACKBlock> blocks) const
+{
+    // FIXME: RFC 2018 wants the block containing the most recently received segment to come first.
+    size_t count = 0;
+    for (auto& segment : m_out_of_order_segments) {
+        if (segment.size == 0)
+            continue;
+        u32 left_edge = segment.sequence_number;
+        u32 right_edge = segment.sequence_number + segment.size;
+        if (count > 0 && sequence_less_than_or_equal(left_edge, blocks[count - 1].right_edge)) {
+            if (sequence_less_than(blocks[count - 1].right_edge, right_edge))
+                blocks[count - 1].right_edge = right_edge;
+            continue;
+        }
+        if (count == blocks.size())
+            break;
+        blocks[count].left_edge = left_edge;
+        blocks[count].right_edge = right_edge;
+        ++count;
+    }
+    return count;
+}
+
+void TCPSocket::protocol_did_read_receive_buffer()
+{
+    if (m_state != State::Established && m_state != State::FinWait1 && m_state != State::FinWait2)
+        return;
+
+    // Let the peer know once reading has opened up the window a good deal (like RFC 1122 4.2.3.3
+    // suggests), as it may be waiting on the small window we advertised while the buffer was full.
+    auto window = receive_buffer_space();
+    if (window < 2 * m_last_advertised_window || window < m_last_advertised_window + m_maximum_segment_size)
+        return;
+    (void)send_ack(true);
+}
+
+bool TCPSocket::should_delay_next_ack() const
+{
     // RFC 1122 says we should send an ACK for every two full-sized segments.
-    if (m_ack_number >= m_last_ack_number_sent + 2 * mss)
+    if (!sequence_less_than(m_ack_number, m_last_ack_number_sent + 2 * m_maximum_segment_size))
         return false;
 
     // RFC 1122 says we should not delay ACKs for more than 500 milliseconds.
@@ -549,15 +1037,8 @@ void TCPSocket::dequeue_for_retransmit()
 
 void TCPSocket::retransmit_packets()
 {
-    auto now = kgettimeofday();
-
-    // RFC6298 says we should have at least one second between retransmits. According to
-    // RFC1122 we must do exponential backoff - even for SYN packets.
-    i64 retransmit_interval = 1;
-    for (decltype(m_retransmit_attempts) i = 0; i < m_retransmit_attempts; i++)
-        retransmit_interval *= 2;
-
-    if (m_last_retransmit_time > now - Time::from_seconds(retransmit_interval))
+    auto now = TimeManagement::the().monotonic_time();
+    if (now < next_retransmit_time())
         return;
 
     dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket({}) handling retransmit", this);
@@ -572,46 +1053,60 @@ void TCPSocket::retransmit_packets()
         return;
     }
 
-    auto routing_decision = route_to(peer_address(), local_address(), bound_interface());
-    if (routing_decision.is_zero())
-        return;
-
     m_unacked_packets.with_exclusive([&](auto& unacked_packets) {
-        for (auto& packet : unacked_packets.packets) {
-            packet.tx_counter++;
-
-            if constexpr (TCP_SOCKET_DEBUG) {
-                auto& tcp_packet = *(const TCPPacket*)(packet.buffer->buffer->data() + packet.ipv4_payload_offset);
-                dbgln("Sending TCP packet from {}:{} to {}:{} with ({}{}{}{}) seq_no={}, ack_no={}, tx_counter={}",
-                    local_address(), local_port(),
-                    peer_address(), peer_port(),
-                    (tcp_packet.has_syn() ? "SYN " : ""),
-                    (tcp_packet.has_ack() ? "ACK " : ""),
-                    (tcp_packet.has_fin() ? "FIN " : ""),
-                    (tcp_packet.has_rst() ? "RST " : ""),
-                    tcp_packet.sequence_number(),
-                    tcp_packet.ack_number(),
-                    packet.tx_counter);
-            }
+        if (unacked_packets.packets.is_empty())
+            return;
+
+        m_congestion_control->on_retransmit_timeout(unacked_packets.bytes_in_flight());
+        m_in_fast_recovery = false;
+        m_duplicate_ack_count = 0;
+
+        // Everything the peer hasn't SACKed is presumed lost. We resend the first packet now,
+        // and the rest as ACKs open up the congestion window again.
+        for (auto& unacked_packet : unacked_packets.packets) {
+            if (unacked_packet.sacked || unacked_packet.lost)
+                continue;
+            unacked_packet.lost = true;
+            unacked_packets.lost_size += unacked_packet.payload_size;
+        }
+        retransmit_lost_packets(unacked_packets, true);
+    });
+}
 
-            size_t ipv4_payload_offset = routing_decision.adapter->ipv4_payload_offset();
-            if (ipv4_payload_offset != packet.ipv4_payload_offset) {
-                // FIXME: Add support for this. This can happen if after a route change
-                // we ended up on another adapter which doesn't have the same layer 2 type
-                // like the previous adapter.
-                VERIFY_NOT_REACHED();
-            }
+void TCPSocket::retransmit_packet(OutgoingPacket& packet, RoutingDecision& routing_decision)
+{
+    packet.tx_counter++;
+
+    if constexpr (TCP_SOCKET_DEBUG) {
+        auto& tcp_packet = *(const TCPPacket*)(packet.buffer->buffer->data() + packet.ipv4_payload_offset);
+        dbgln("Sending TCP packet from {}:{} to {}:{} with ({}{}{}{}) seq_no={}, ack_no={}, tx_counter={}",
+            local_address(), local_port(),
+            peer_address(), peer_port(),
+            (tcp_packet.has_syn() ? "SYN " : ""),
+            (tcp_packet.has_ack() ? "ACK " : ""),
+            (tcp_packet.has_fin() ? "FIN " : ""),
+            (tcp_packet.has_rst() ? "RST " : ""),
+            tcp_packet.sequence_number(),
+            tcp_packet.ack_number(),
+            packet.tx_counter);
+    }
 
-            auto packet_buffer = packet.buffer->bytes();
+    size_t ipv4_payload_offset = routing_decision.adapter->ipv4_payload_offset();
+    if (ipv4_payload_offset != packet.ipv4_payload_offset) {
+        // FIXME: Add support for this. This can happen if after a route change
+        // we ended up on another adapter which doesn't have the same layer 2 type
+        // like the previous adapter.
+        VERIFY_NOT_REACHED();
+    }
 
-            routing_decision.adapter->fill_in_ipv4_header(*packet.buffer,
-                local_address(), routing_decision.next_hop, peer_address(),
-                IPv4Protocol::TCP, packet_buffer.size() - ipv4_payload_offset, type_of_service(), ttl());
-            routing_decision.adapter->send_packet(packet_buffer);
-            m_packets_out++;
-            m_bytes_out += packet_buffer.size();
-        }
-    });
+    auto packet_buffer = packet.buffer->bytes();
+
+    routing_decision.adapter->fill_in_ipv4_header(*packet.buffer,
+        local_address(), routing_decision.next_hop, peer_address(),
+        IPv4Protocol::TCP, packet_buffer.size() - ipv4_payload_offset, type_of_service(), ttl());
+    routing_decision.adapter->send_packet(packet_buffer);
+    m_packets_out++;
+    m_bytes_out += packet_buffer.size();
 }
 
 bool TCPSocket::can_write(const OpenFileDescription& file_description, u64 size) const
@@ -622,11 +1117,8 @@ bool TCPSocket::can_write(const OpenFileDescription& file_description, u64 size)
     if (m_state == State::SynSent || m_state == State::SynReceived)
         return false;
 
-    if (!file_description.is_blocking())
-        return true;
-
     return m_unacked_packets.with_shared([&](auto& unacked_packets) {
-        return unacked_packets.size + size <= m_send_window_size;
+        return sendable_bytes(unacked_packets) > 0;
     });
 }
 }
@@ -10,9 +10,13 @@
 #include <AK/Function.h>
 #include <AK/HashMap.h>
 #include <AK/SinglyLinkedList.h>
+#include <AK/Vector.h>
 #include <AK/WeakPtr.h>
+#include <Kernel/KBuffer.h>
 #include <Kernel/Locking/MutexProtected.h>
 #include <Kernel/Net/IPv4Socket.h>
+#include <Kernel/Net/TCP.h>
+#include <Kernel/Net/TCPCongestionControl.h>
 
 namespace Kernel {
 
@@ -133,15 +137,28 @@ public:
     u32 packets_out() const { return m_packets_out; }
     u32 bytes_out() const { return m_bytes_out; }
 
-    // FIXME: Make this configurable?
-    static constexpr u32 maximum_duplicate_acks = 5;
-    void set_duplicate_acks(u32 acks) { m_duplicate_acks = acks; }
-    u32 duplicate_acks() const { return m_duplicate_acks; }
+    size_t congestion_window() const { return m_congestion_control->congestion_window(); }
+    size_t send_window_size() const { return m_send_window_size; }
+    Time smoothed_round_trip_time() const { return Time::from_microseconds(m_smoothed_round_trip_time_us); }
 
     ErrorOr<void> send_ack(bool allow_duplicate = false);
     ErrorOr<void> send_tcp_packet(u16 flags, const UserOrKernelBuffer* = nullptr, size_t = 0, RoutingDecision* = nullptr);
     void receive_tcp_packet(const TCPPacket&, u16 size);
 
+    // Parses the options of a SYN we received from the peer.
+    void process_syn_options(TCPPacket const&);
+
+    enum class ReceiveResult {
+        NothingToDo,
+        Accepted,
+        NeedsImmediateAck,
+        ReachedFIN,
+    };
+
+    // Delivers the payload (and FIN) of an incoming segment in sequence order, holding on to
+    // segments that arrive ahead of a gap until the gap is filled.
+    ReceiveResult receive_segment(TCPPacket const&, size_t payload_size);
+
     bool should_delay_next_ack() const;
 
     static MutexProtected<HashMap<IPv4SocketTuple, TCPSocket*>>& sockets_by_tuple();
@@ -156,6 +173,7 @@ public:
     void release_for_accept(RefPtr<TCPSocket>);
 
     void retransmit_packets();
+    Time next_retransmit_time() const { return m_last_retransmit_time + retransmission_timeout(); }
 
     virtual ErrorOr<void> close() override;
 
@@ -167,7 +185,7 @@ protected:
     void set_direction(Direction direction) { m_direction = direction; }
 
 private:
-    explicit TCPSocket(int protocol, NonnullOwnPtr<DoubleBuffer> receive_buffer, NonnullOwnPtr<KBuffer> scratch_buffer);
+    explicit TCPSocket(int protocol, NonnullOwnPtr<DoubleBuffer> receive_buffer, NonnullOwnPtr<KBuffer> scratch_buffer, NonnullOwnPtr<TCPCongestionControl>);
     virtual StringView class_name() const override { return "TCPSocket"sv; }
 
     virtual void shut_down_for_writing() override;
@@ -180,10 +198,31 @@ private:
     virtual bool protocol_is_disconnected() const override;
     virtual ErrorOr<void> protocol_bind() override;
     virtual ErrorOr<void> protocol_listen(bool did_allocate_port) override;
+    virtual void protocol_did_read_receive_buffer() override;
 
     void enqueue_for_retransmit();
     void dequeue_for_retransmit();
 
+    struct OutgoingPacket;
+    struct UnackedPackets;
+
+    size_t maximum_segment_size(NetworkAdapter const&) const;
+    size_t sendable_bytes(UnackedPackets const&) const;
+    u16 advertised_window(bool is_syn);
+
+    void process_ack(TCPPacket const&, size_t payload_size, bool window_changed);
+    void process_sack_blocks(TCPPacket const&, UnackedPackets&);
+    void mark_lost_packets_below_highest_sack(UnackedPackets&);
+    void enter_fast_recovery(UnackedPackets&);
+    void retransmit_lost_packets(UnackedPackets&, bool force_first);
+    void retransmit_packet(OutgoingPacket&, RoutingDecision&);
+    void update_round_trip_time(Time sample);
+    Time retransmission_timeout() const;
+
+    void queue_out_of_order_segment(u32 sequence_number, ReadonlyBytes payload, bool has_fin);
+    bool deliver_out_of_order_segments();
+    size_t fill_in_sack_blocks(Span<TCPSACKBlock>) const;
+
     WeakPtr<TCPSocket> m_originator;
     HashMap<IPv4SocketTuple, NonnullRefPtr<TCPSocket>> m_pending_release_for_accept;
     Direction m_direction { Direction::Unspecified };
@@ -198,33 +237,80 @@ private:
     u32 m_bytes_out { 0 };
 
     struct OutgoingPacket {
+        u32 sequence_number { 0 };
         u32 ack_number { 0 };
+        size_t payload_size { 0 };
         RefPtr<PacketWithTimestamp> buffer;
         size_t ipv4_payload_offset;
         WeakPtr<NetworkAdapter> adapter;
+        Time sent_time;
         int tx_counter { 0 };
+        // The peer told us through a SACK block that it has this packet.
+        bool sacked { false };
+        // We believe this packet was lost and haven't retransmitted it yet.
+        bool lost { false };
     };
 
     struct UnackedPackets {
         SinglyLinkedList<OutgoingPacket> packets;
         size_t size { 0 };
+        size_t sacked_size { 0 };
+        size_t lost_size { 0 };
+
+        size_t bytes_in_flight() const { return size - sacked_size - lost_size; }
     };
 
     MutexProtected<UnackedPackets> m_unacked_packets;
 
-    u32 m_duplicate_acks { 0 };
+    // Oldest sequence number we have sent that the peer hasn't acknowledged yet.
+    u32 m_send_unacknowledged { 0 };
+
+    NonnullOwnPtr<TCPCongestionControl> m_congestion_control;
+    static constexpr u32 duplicate_ack_threshold = 3;
+    u32 m_duplicate_ack_count { 0 };
+    bool m_in_fast_recovery { false };
+    // Fast recovery ends once everything sent before it began has been acknowledged.
+    u32 m_recovery_point { 0 };
+    u32 m_highest_sacked { 0 };
+
+    static constexpr size_t default_maximum_segment_size = 536;
+    size_t m_peer_maximum_segment_size { default_maximum_segment_size };
+    size_t m_maximum_segment_size { default_maximum_segment_size };
+
+    bool m_window_scaling_enabled { false };
+    u8 m_send_window_scale { 0 };
+    u8 m_receive_window_scale { 0 };
+    bool m_sack_enabled { false };
 
     u32 m_last_ack_number_sent { 0 };
     Time m_last_ack_sent_time;
+    size_t m_last_advertised_window { 0 };
 
     // FIXME: Make this configurable (sysctl)
     static constexpr u32 maximum_retransmits = 5;
     Time m_last_retransmit_time;
     u32 m_retransmit_attempts { 0 };
 
-    // FIXME: Parse window size TCP option from the peer
+    // RFC 6298 retransmission timer state, in microseconds.
+    bool m_has_round_trip_time_sample { false };
+    i64 m_smoothed_round_trip_time_us { 0 };
+    i64 m_round_trip_time_variation_us { 0 };
+    i64 m_retransmission_timeout_us { 1'000'000 };
+
+    // The window the peer advertised, already scaled.
     u32 m_send_window_size { 64 * KiB };
 
+    struct OutOfOrderSegment {
+        u32 sequence_number { 0 };
+        size_t size { 0 };
+        OwnPtr<KBuffer> data;
+        bool has_fin { false };
+    };
+
+    // Segments that arrived ahead of m_ack_number, sorted by sequence number.
+    Vector<OutOfOrderSegment> m_out_of_order_segments;
+    static constexpr size_t maximum_out_of_order_segments = 256;
+
     IntrusiveListNode<TCPSocket> m_retransmit_list_node;
 
 public:
@@ -227,10 +227,11 @@ Process::Process(NonnullOwnPtr<KString> name, UserID uid, GroupID gid, ProcessID
     : m_name(move(name))
     , m_is_kernel_process(is_kernel_process)
     , m_executable(move(executable))
-    , m_cwd(move(cwd))
     , m_tty(tty)
     , m_wait_blocker_set(*this)
 {
+    m_current_directory.with([&](auto& current_directory) { current_directory = move(cwd); });
+
     // Ensure that we protect the process data when exiting the constructor.
     ProtectedDataMutationScope scope { *this };
 
@@ -278,6 +279,24 @@ Process::~Process()
     VERIFY(!m_alarm_timer);
 
     PerformanceManager::add_process_exit_event(*this);
+
+    delete m_syscall_statistics.load();
+}
+
+SyscallStatistics* Process::ensure_syscall_statistics()
+{
+    if (auto* statistics = m_syscall_statistics.load(AK::MemoryOrder::memory_order_acquire))
+        return statistics;
+    auto statistics_or_error = SyscallStatistics::try_create();
+    if (statistics_or_error.is_error())
+        return nullptr;
+    auto* new_statistics = statistics_or_error.release_value().leak_ptr();
+    SyscallStatistics* expected = nullptr;
+    if (m_syscall_statistics.compare_exchange_strong(expected, new_statistics, AK::MemoryOrder::memory_order_acq_rel))
+        return new_statistics;
+    // Another thread beat us to it.
+    delete new_statistics;
+    return expected;
 }
 
 // Make sure the compiler doesn't "optimize away" this function:
@@ -493,11 +512,13 @@ siginfo_t Process::wait_info() const
     return siginfo;
 }
 
-Custody& Process::current_directory()
+NonnullRefPtr<Custody> Process::current_directory()
 {
-    if (!m_cwd)
-        m_cwd = VirtualFileSystem::the().root_custody();
-    return *m_cwd;
+    return m_current_directory.with([&](auto& current_directory) -> NonnullRefPtr<Custody> {
+        if (!current_directory)
+            current_directory = VirtualFileSystem::the().root_custody();
+        return *current_directory;
+    });
 }
 
 ErrorOr<NonnullOwnPtr<KString>> Process::get_syscall_path_argument(Userspace<char const*> user_path, size_t path_length)
@@ -594,7 +615,9 @@ void Process::finalize()
     m_fds.with_exclusive([](auto& fds) { fds.clear(); });
     m_tty = nullptr;
     m_executable = nullptr;
-    m_cwd = nullptr;
+    // NOTE: Drop the custody outside of the spinlock, releasing it may require blocking.
+    auto current_directory = m_current_directory.with([](auto& current_directory) { return move(current_directory); });
+    current_directory = nullptr;
     m_arguments.clear();
     m_environment.clear();
 
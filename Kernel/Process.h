@@ -32,6 +32,7 @@
 #include <Kernel/ProcessExposed.h>
 #include <Kernel/ProcessGroup.h>
 #include <Kernel/StdLib.h>
+#include <Kernel/SyscallStatistics.h>
 #include <Kernel/Thread.h>
 #include <Kernel/UnixTypes.h>
 #include <LibC/elf.h>
@@ -81,8 +82,6 @@ enum class VeilState {
     Locked,
 };
 
-using FutexQueues = HashMap<FlatPtr, RefPtr<FutexQueue>>;
-
 struct LoadResult;
 
 class Process final
@@ -270,6 +269,11 @@ public:
     ErrorOr<FlatPtr> sys$create_inode_watcher(u32 flags);
     ErrorOr<FlatPtr> sys$inode_watcher_add_watch(Userspace<const Syscall::SC_inode_watcher_add_watch_params*> user_params);
     ErrorOr<FlatPtr> sys$inode_watcher_remove_watch(int fd, int wd);
+    ErrorOr<FlatPtr> sys$epoll_create(int flags);
+    ErrorOr<FlatPtr> sys$epoll_ctl(int epoll_fd, int op, int fd, Userspace<const epoll_event*>);
+    ErrorOr<FlatPtr> sys$epoll_wait(Userspace<const Syscall::SC_epoll_wait_params*>);
+    ErrorOr<FlatPtr> sys$io_ring_setup(u32 entry_count, int flags, Userspace<io_ring_params*>);
+    ErrorOr<FlatPtr> sys$io_ring_enter(int ring_fd, u32 to_submit, u32 min_complete, u32 flags);
     ErrorOr<FlatPtr> sys$dbgputstr(Userspace<const char*>, size_t);
     ErrorOr<FlatPtr> sys$dump_backtrace();
     ErrorOr<FlatPtr> sys$gettid();
@@ -402,6 +406,7 @@ public:
     ErrorOr<FlatPtr> sys$get_stack_bounds(Userspace<FlatPtr*> stack_base, Userspace<size_t*> stack_size);
     ErrorOr<FlatPtr> sys$ptrace(Userspace<const Syscall::SC_ptrace_params*>);
     ErrorOr<FlatPtr> sys$sendfd(int sockfd, int fd);
+    ErrorOr<FlatPtr> sys$sendfile(int out_fd, int in_fd, Userspace<off_t*> offset, size_t count);
     ErrorOr<FlatPtr> sys$recvfd(int sockfd, int options);
     ErrorOr<FlatPtr> sys$sysconf(int name);
     ErrorOr<FlatPtr> sys$disown(ProcessID);
@@ -430,7 +435,7 @@ public:
     u32 m_ticks_in_user_for_dead_children { 0 };
     u32 m_ticks_in_kernel_for_dead_children { 0 };
 
-    Custody& current_directory();
+    NonnullRefPtr<Custody> current_directory();
     Custody* executable() { return m_executable.ptr(); }
     const Custody* executable() const { return m_executable.ptr(); }
 
@@ -467,6 +472,7 @@ public:
     {
         return m_unveiled_paths;
     }
+    Mutex& unveil_lock() const { return m_unveil_lock; }
 
     bool wait_for_tracer_at_next_execve() const
     {
@@ -502,6 +508,10 @@ public:
     PerformanceEventBuffer* perf_events() { return m_perf_event_buffer; }
     PerformanceEventBuffer const* perf_events() const { return m_perf_event_buffer; }
 
+    SyscallStatistics const* syscall_statistics() const { return m_syscall_statistics.load(AK::MemoryOrder::memory_order_acquire); }
+    // Returns nullptr if we couldn't allocate the statistics, in which case the syscall simply isn't accounted for.
+    SyscallStatistics* ensure_syscall_statistics();
+
     Memory::AddressSpace& address_space() { return *m_space; }
     Memory::AddressSpace const& address_space() const { return *m_space; }
 
@@ -551,6 +561,7 @@ private:
     bool has_tracee_thread(ProcessID tracer_pid);
 
     void clear_futex_queues_on_exec();
+    ErrorOr<FutexKey> futex_key_for(FlatPtr user_address, bool is_private, RefPtr<Memory::VMObject>* = nullptr);
 
     ErrorOr<void> remap_range_as_stack(FlatPtr address, size_t size);
 
@@ -561,6 +572,7 @@ public:
     ErrorOr<void> procfs_get_unveil_stats(KBufferBuilder& builder) const;
     ErrorOr<void> procfs_get_pledge_stats(KBufferBuilder& builder) const;
     ErrorOr<void> procfs_get_virtual_memory_stats(KBufferBuilder& builder) const;
+    ErrorOr<void> procfs_get_syscall_statistics(KBufferBuilder& builder) const;
     ErrorOr<void> procfs_get_binary_link(KBufferBuilder& builder) const;
     ErrorOr<void> procfs_get_current_work_directory_link(KBufferBuilder& builder) const;
     mode_t binary_link_required_mode() const;
@@ -779,7 +791,7 @@ private:
     bool m_should_generate_coredump { false };
 
     RefPtr<Custody> m_executable;
-    RefPtr<Custody> m_cwd;
+    SpinlockProtected<RefPtr<Custody>> m_current_directory;
 
     NonnullOwnPtrVector<KString> m_arguments;
     NonnullOwnPtrVector<KString> m_environment;
@@ -797,11 +809,12 @@ private:
 
     VeilState m_veil_state { VeilState::None };
     UnveilNode m_unveiled_paths { "/", { .full_path = "/" } };
+    mutable Mutex m_unveil_lock { "Unveil" };
 
     OwnPtr<PerformanceEventBuffer> m_perf_event_buffer;
 
-    FutexQueues m_futex_queues;
-    Spinlock m_futex_lock;
+    // Allocated by the first syscall made while syscall accounting is enabled, and never freed before the process is.
+    Atomic<SyscallStatistics*> m_syscall_statistics { nullptr };
 
     // This member is used in the implementation of ptrace's PT_TRACEME flag.
     // If it is set to true, the process will stop at the next execve syscall
@@ -31,6 +31,7 @@ enum class MainProcessProperty {
     PerformanceEvents = 6,
     VirtualMemoryStats = 7,
     TTYLink = 8,
+    SyscallStatistics = 9,
 };
 
 enum class ProcessSubDirectory {
@@ -145,6 +145,7 @@ ErrorOr<void> Process::procfs_get_pledge_stats(KBufferBuilder& builder) const
 ErrorOr<void> Process::procfs_get_unveil_stats(KBufferBuilder& builder) const
 {
     JsonArraySerializer array { builder };
+    MutexLocker locker(m_unveil_lock, Mutex::Mode::Shared);
     for (auto const& unveiled_path : unveiled_paths()) {
         if (!unveiled_path.was_explicitly_unveiled())
             continue;
@@ -246,6 +247,7 @@ ErrorOr<void> Process::procfs_get_virtual_memory_stats(KBufferBuilder& builder)
             region_object.add("size", region->size());
             region_object.add("amount_resident", region->amount_resident());
             region_object.add("amount_dirty", region->amount_dirty());
+            region_object.add("amount_huge", region->amount_mapped_with_huge_pages());
             region_object.add("cow_pages", region->cow_pages());
             region_object.add("name", region->name());
             region_object.add("vmobject", region->vmobject().class_name());
@@ -267,9 +269,18 @@ ErrorOr<void> Process::procfs_get_virtual_memory_stats(KBufferBuilder& builder)
     return {};
 }
 
+ErrorOr<void> Process::procfs_get_syscall_statistics(KBufferBuilder& builder) const
+{
+    if (auto const* statistics = syscall_statistics())
+        return statistics->to_json(builder);
+    JsonArraySerializer array { builder };
+    array.finish();
+    return {};
+}
+
 ErrorOr<void> Process::procfs_get_current_work_directory_link(KBufferBuilder& builder) const
 {
-    return builder.append(TRY(const_cast<Process&>(*this).current_directory().try_serialize_absolute_path())->view());
+    return builder.append(TRY(const_cast<Process&>(*this).current_directory()->try_serialize_absolute_path())->view());
 }
 
 mode_t Process::binary_link_required_mode() const
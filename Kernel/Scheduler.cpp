@@ -10,6 +10,7 @@
 #include <AK/Time.h>
 #include <Kernel/Arch/x86/InterruptDisabler.h>
 #include <Kernel/Arch/x86/TrapFrame.h>
+#include <Kernel/CommandLine.h>
 #include <Kernel/Debug.h>
 #include <Kernel/Panic.h>
 #include <Kernel/PerformanceManager.h>
@@ -20,9 +21,6 @@
 #include <Kernel/Time/TimeManagement.h>
 #include <Kernel/kstdio.h>
 
-// Remove this once SMP is stable and can be enabled by default
-#define SCHEDULE_ON_ALL_PROCESSORS 0
-
 namespace Kernel {
 
 RecursiveSpinlock g_scheduler_lock;
@@ -48,9 +46,72 @@ struct ThreadReadyQueues {
     u32 mask {};
     static constexpr size_t count = sizeof(mask) * 8;
     Array<ThreadReadyQueue, count> queues;
+
+    // Returns the highest priority thread that may run on a processor in affinity_mask
+    // and isn't already running somewhere else.
+    Thread* find_runnable_thread(u32 affinity_mask)
+    {
+        auto priority_mask = mask;
+        while (priority_mask != 0) {
+            auto priority = bit_scan_forward(priority_mask);
+            VERIFY(priority > 0);
+            auto& ready_queue = queues[--priority];
+            for (auto& thread : ready_queue.thread_list) {
+                VERIFY(thread.m_runnable_priority == (int)priority);
+                if (thread.is_active())
+                    continue;
+                if (!(thread.affinity() & affinity_mask))
+                    continue;
+                return &thread;
+            }
+            priority_mask &= ~(1u << priority);
+        }
+        return nullptr;
+    }
+
+    void append(Thread& thread, u32 priority)
+    {
+        VERIFY(thread.m_runnable_priority < 0);
+        thread.m_runnable_priority = (int)priority;
+        VERIFY(!thread.m_ready_queue_node.is_in_list());
+        auto& ready_queue = queues[priority];
+        bool was_empty = ready_queue.thread_list.is_empty();
+        ready_queue.thread_list.append(thread);
+        if (was_empty)
+            mask |= (1u << priority);
+    }
+
+    void remove(Thread& thread)
+    {
+        auto priority = thread.m_runnable_priority;
+        VERIFY(mask & (1u << priority));
+        auto& ready_queue = queues[priority];
+        thread.m_runnable_priority = -1;
+        ready_queue.thread_list.remove(thread);
+        if (ready_queue.thread_list.is_empty())
+            mask &= ~(1u << priority);
+    }
+};
+
+// Every processor has its own set of ready queues, so that processors don't all contend
+// on one lock whenever they switch context. A thread is queued on the processor it is most
+// likely to run on next, and idle processors steal work from the busy ones.
+struct alignas(64) ProcessorReadyQueues {
+    SpinlockProtected<ThreadReadyQueues> ready_queues;
+    // The number of threads in ready_queues, which can be looked at without taking the lock.
+    Atomic<u32> thread_count { 0 };
+    // Held by the processor while it switches context, and released by the thread it switched to.
+    RecursiveSpinlock context_switch_lock;
 };
 
-static Singleton<SpinlockProtected<ThreadReadyQueues>> g_ready_queues;
+// Thread affinity is a 32-bit mask, so that's how many processors we can schedule threads on.
+static constexpr u32 max_scheduled_processors = sizeof(u32) * 8;
+
+// How many more runnable threads the processor a thread last ran on may have than the least
+// loaded one before the thread is moved away from it, giving up on its warm caches.
+static constexpr u32 load_imbalance_threshold = 2;
+
+static Singleton<Array<ProcessorReadyQueues, max_scheduled_processors>> s_processor_ready_queues;
 
 static SpinlockProtected<TotalTimeScheduled> g_total_time_scheduled;
 
@@ -63,7 +124,7 @@ static void dump_thread_list(bool = false);
 static inline u32 thread_priority_to_priority_index(u32 thread_priority)
 {
     // Converts the priority in the range of THREAD_PRIORITY_MIN...THREAD_PRIORITY_MAX
-    // to a index into g_ready_queues where 0 is the highest priority bucket
+    // to a index into the ready queues where 0 is the highest priority bucket
     VERIFY(thread_priority >= THREAD_PRIORITY_MIN && thread_priority <= THREAD_PRIORITY_MAX);
     constexpr u32 thread_priority_count = THREAD_PRIORITY_MAX - THREAD_PRIORITY_MIN + 1;
     static_assert(thread_priority_count > 0);
@@ -72,81 +133,146 @@ static inline u32 thread_priority_to_priority_index(u32 thread_priority)
     return priority_bucket;
 }
 
-Thread& Scheduler::pull_next_runnable_thread()
+// Only the BSP runs threads unless scheduling on the APs was asked for on the command line.
+static bool s_schedule_on_all_processors { false };
+
+u32 Scheduler::schedulable_processor_count()
 {
-    auto affinity_mask = 1u << Processor::current_id();
+    if (!s_schedule_on_all_processors)
+        return 1;
+    return min(Processor::count(), max_scheduled_processors);
+}
 
-    return g_ready_queues->with([&](auto& ready_queues) -> Thread& {
-        auto priority_mask = ready_queues.mask;
-        while (priority_mask != 0) {
-            auto priority = bit_scan_forward(priority_mask);
-            VERIFY(priority > 0);
-            auto& ready_queue = ready_queues.queues[--priority];
-            for (auto& thread : ready_queue.thread_list) {
-                VERIFY(thread.m_runnable_priority == (int)priority);
-                if (thread.is_active())
-                    continue;
-                if (!(thread.affinity() & affinity_mask))
-                    continue;
-                thread.m_runnable_priority = -1;
-                ready_queue.thread_list.remove(thread);
-                if (ready_queue.thread_list.is_empty())
-                    ready_queues.mask &= ~(1u << priority);
-                // Mark it as active because we are using this thread. This is similar
-                // to comparing it with Processor::current_thread, but when there are
-                // multiple processors there's no easy way to check whether the thread
-                // is actually still needed. This prevents accidental finalization when
-                // a thread is no longer in Running state, but running on another core.
-
-                // We need to mark it active here so that this thread won't be
-                // scheduled on another core if it were to be queued before actually
-                // switching to it.
-                // FIXME: Figure out a better way maybe?
-                thread.set_active(true);
-                return thread;
-            }
-            priority_mask &= ~(1u << priority);
-        }
-        return *Processor::idle_thread();
-    });
+static u32 schedulable_processor_mask()
+{
+    auto processor_count = Scheduler::schedulable_processor_count();
+    if (processor_count == max_scheduled_processors)
+        return NumericLimits<u32>::max();
+    return (1u << processor_count) - 1;
 }
 
-Thread* Scheduler::peek_next_runnable_thread()
+static u32 processor_load(u32 cpu)
 {
-    auto affinity_mask = 1u << Processor::current_id();
+    auto load = (*s_processor_ready_queues)[cpu].thread_count.load(AK::MemoryOrder::memory_order_relaxed);
+    // A processor that isn't idle is also running a thread that isn't on its ready queues.
+    if (!(Processor::idle_processor_mask() & (1u << cpu)))
+        load++;
+    return load;
+}
 
-    return g_ready_queues->with([&](auto& ready_queues) -> Thread* {
-        auto priority_mask = ready_queues.mask;
-        while (priority_mask != 0) {
-            auto priority = bit_scan_forward(priority_mask);
-            VERIFY(priority > 0);
-            auto& ready_queue = ready_queues.queues[--priority];
-            for (auto& thread : ready_queue.thread_list) {
-                VERIFY(thread.m_runnable_priority == (int)priority);
-                if (thread.is_active())
-                    continue;
-                if (!(thread.affinity() & affinity_mask))
-                    continue;
-                return &thread;
+// Picks the processor on whose ready queues a thread that just became runnable should be put.
+static u32 select_processor_for(Thread const& thread)
+{
+    auto allowed_mask = thread.affinity() & schedulable_processor_mask();
+    if (allowed_mask == 0) {
+        // None of the processors this thread may run on are scheduling threads yet,
+        // so just leave it on the first one it is allowed to run on.
+        auto affinity = thread.affinity();
+        return affinity != 0 ? bit_scan_forward(affinity) - 1 : 0;
+    }
+
+    auto last_cpu = thread.cpu();
+    bool can_stay = last_cpu < max_scheduled_processors && (allowed_mask & (1u << last_cpu));
+
+    // The caches of the processor the thread last ran on are most likely to still be
+    // warm, so prefer it if it's idle. Otherwise, any idle processor is better than
+    // waiting for a busy one.
+    auto idle_mask = Processor::idle_processor_mask() & allowed_mask;
+    if (can_stay && (idle_mask & (1u << last_cpu)))
+        return last_cpu;
+    if (idle_mask != 0)
+        return bit_scan_forward(idle_mask) - 1;
+
+    u32 least_loaded_cpu = 0;
+    u32 least_load = NumericLimits<u32>::max();
+    for (auto mask = allowed_mask; mask != 0;) {
+        auto cpu = bit_scan_forward(mask) - 1;
+        mask &= ~(1u << cpu);
+        auto load = processor_load(cpu);
+        if (load < least_load) {
+            least_loaded_cpu = cpu;
+            least_load = load;
+        }
+    }
+
+    if (can_stay && processor_load(last_cpu) <= least_load + load_imbalance_threshold)
+        return last_cpu;
+    return least_loaded_cpu;
+}
+
+// Looks for a runnable thread for the current processor, first on its own ready queues and then on
+// everyone else's. If take_thread is true, the thread is also removed from the ready queues.
+static Thread* find_next_runnable_thread(bool take_thread)
+{
+    auto current_cpu = Processor::current_id();
+    VERIFY(current_cpu < max_scheduled_processors);
+    auto affinity_mask = 1u << current_cpu;
+
+    auto try_processor = [&](u32 cpu) -> Thread* {
+        auto& processor_ready_queues = (*s_processor_ready_queues)[cpu];
+        if (processor_ready_queues.thread_count.load(AK::MemoryOrder::memory_order_relaxed) == 0)
+            return nullptr;
+        return processor_ready_queues.ready_queues.with([&](auto& ready_queues) -> Thread* {
+            auto* thread = ready_queues.find_runnable_thread(affinity_mask);
+            if (thread && take_thread) {
+                ready_queues.remove(*thread);
+                processor_ready_queues.thread_count.fetch_sub(1, AK::MemoryOrder::memory_order_relaxed);
             }
-            priority_mask &= ~(1u << priority);
+            return thread;
+        });
+    };
+
+    if (auto* thread = try_processor(current_cpu))
+        return thread;
+
+    // Nothing to do here, so steal work from another processor. Start with our neighbour so that
+    // processors looking for work at the same time don't all go after the same ready queues.
+    auto processor_count = schedulable_processor_count();
+    for (u32 i = 1; i < processor_count; i++) {
+        if (auto* thread = try_processor((current_cpu + i) % processor_count)) {
+            dbgln_if(SCHEDULER_DEBUG, "Scheduler[{}]: Stealing {} from processor {}", current_cpu, *thread, (current_cpu + i) % processor_count);
+            return thread;
         }
+    }
+    return nullptr;
+}
 
-        // Unlike in pull_next_runnable_thread() we don't want to fall back to
-        // the idle thread. We just want to see if we have any other thread ready
-        // to be scheduled.
-        return nullptr;
-    });
+Thread& Scheduler::pull_next_runnable_thread()
+{
+    while (auto* thread = find_next_runnable_thread(true)) {
+        // Other processors may have blocked, stopped or killed the thread after we found it, but
+        // they can't do so while we hold its lock. If it's still runnable, it's ours to run now.
+        // This also marks it as active, so that it won't be finalized or scheduled on another core
+        // if it were to be queued again before we actually switched to it.
+        if (thread->try_set_running())
+            return *thread;
+    }
+
+    auto& idle_thread = *Processor::idle_thread();
+    // NOTE: If we're already running the idle thread, it stays in the Running state.
+    (void)idle_thread.try_set_running();
+    return idle_thread;
+}
+
+Thread* Scheduler::peek_next_runnable_thread()
+{
+    // Unlike in pull_next_runnable_thread() we don't want to fall back to
+    // the idle thread. We just want to see if we have any other thread ready
+    // to be scheduled.
+    return find_next_runnable_thread(false);
 }
 
 bool Scheduler::dequeue_runnable_thread(Thread& thread, bool check_affinity)
 {
+    VERIFY(thread.get_lock().is_locked_by_current_processor());
     if (thread.is_idle_thread())
         return true;
 
-    return g_ready_queues->with([&](auto& ready_queues) {
-        auto priority = thread.m_runnable_priority;
-        if (priority < 0) {
+    // NOTE: The thread's lock keeps it from moving to another processor's ready queues under us,
+    //       but a processor looking for work may still take it off them first.
+    auto& processor_ready_queues = (*s_processor_ready_queues)[thread.m_runnable_cpu];
+    return processor_ready_queues.ready_queues.with([&](auto& ready_queues) {
+        if (thread.m_runnable_priority < 0) {
             VERIFY(!thread.m_ready_queue_node.is_in_list());
             return false;
         }
@@ -154,42 +280,38 @@ bool Scheduler::dequeue_runnable_thread(Thread& thread, bool check_affinity)
         if (check_affinity && !(thread.affinity() & (1 << Processor::current_id())))
             return false;
 
-        VERIFY(ready_queues.mask & (1u << priority));
-        auto& ready_queue = ready_queues.queues[priority];
-        thread.m_runnable_priority = -1;
-        ready_queue.thread_list.remove(thread);
-        if (ready_queue.thread_list.is_empty())
-            ready_queues.mask &= ~(1u << priority);
+        ready_queues.remove(thread);
+        processor_ready_queues.thread_count.fetch_sub(1, AK::MemoryOrder::memory_order_relaxed);
         return true;
     });
 }
 
 void Scheduler::enqueue_runnable_thread(Thread& thread)
 {
-    VERIFY(g_scheduler_lock.is_locked_by_current_processor());
+    VERIFY(thread.get_lock().is_locked_by_current_processor());
     if (thread.is_idle_thread())
         return;
     auto priority = thread_priority_to_priority_index(thread.priority());
+    auto cpu = select_processor_for(thread);
 
-    g_ready_queues->with([&](auto& ready_queues) {
-        VERIFY(thread.m_runnable_priority < 0);
-        thread.m_runnable_priority = (int)priority;
-        VERIFY(!thread.m_ready_queue_node.is_in_list());
-        auto& ready_queue = ready_queues.queues[priority];
-        bool was_empty = ready_queue.thread_list.is_empty();
-        ready_queue.thread_list.append(thread);
-        if (was_empty)
-            ready_queues.mask |= (1u << priority);
+    auto& processor_ready_queues = (*s_processor_ready_queues)[cpu];
+    processor_ready_queues.ready_queues.with([&](auto& ready_queues) {
+        ready_queues.append(thread, priority);
+        thread.m_runnable_cpu = cpu;
+        processor_ready_queues.thread_count.fetch_add(1, AK::MemoryOrder::memory_order_relaxed);
     });
+
+    // If we picked an idle processor, make sure it notices the new thread right away.
+    Processor::smp_wake_idle_processor(cpu);
 }
 
 UNMAP_AFTER_INIT void Scheduler::start()
 {
     VERIFY_INTERRUPTS_DISABLED();
 
-    // We need to acquire our scheduler lock, which will be released
+    // We need to acquire our context switch lock, which will be released
     // by the idle thread once control transferred there
-    g_scheduler_lock.lock();
+    context_switch_lock().lock();
 
     auto& processor = Processor::current();
     VERIFY(processor.is_initialized());
@@ -199,7 +321,10 @@ UNMAP_AFTER_INIT void Scheduler::start()
     idle_thread.did_schedule();
     idle_thread.set_initialized(true);
     processor.init_context(idle_thread, false);
-    idle_thread.set_state(Thread::State::Running);
+    {
+        SpinlockLocker scheduler_lock(g_scheduler_lock);
+        idle_thread.set_state(Thread::State::Running);
+    }
     VERIFY(idle_thread.affinity() == (1u << processor.id()));
     processor.initialize_context_switching(idle_thread);
     VERIFY_NOT_REACHED();
@@ -222,7 +347,12 @@ void Scheduler::pick_next()
             Processor::set_current_in_scheduler(false);
         });
 
-    SpinlockLocker lock(g_scheduler_lock);
+    // Picking the next thread only takes the locks of the ready queues we look at, and the lock of
+    // the thread we end up with. Other processors don't care about us switching context, so our own
+    // context switch lock is all that we hold across the switch. Since the thread we switch to
+    // may have been switched out on another processor, it releases the lock of whichever
+    // processor it's running on now, rather than the one it locked.
+    auto flags = context_switch_lock().lock();
 
     if constexpr (SCHEDULER_RUNNABLE_DEBUG) {
         dump_thread_list();
@@ -237,11 +367,13 @@ void Scheduler::pick_next()
     }
 
     // We need to leave our first critical section before switching context,
-    // but since we're still holding the scheduler lock we're still in a critical section
+    // but since we're still holding the context switch lock we're still in a critical section
     critical.leave();
 
     thread_to_schedule.set_ticks_left(time_slice_for(thread_to_schedule));
     context_switch(&thread_to_schedule);
+
+    context_switch_lock().unlock(flags);
 }
 
 void Scheduler::yield()
@@ -278,8 +410,7 @@ void Scheduler::context_switch(Thread* thread)
 
     // If the last process hasn't blocked (still marked as running),
     // mark it as runnable for the next round.
-    if (from_thread->state() == Thread::State::Running)
-        from_thread->set_state(Thread::State::Runnable);
+    from_thread->set_runnable_if_running();
 
 #ifdef LOG_EVERY_CONTEXT_SWITCH
     const auto msg = "Scheduler[{}]: {} -> {} [prio={}] {:#04x}:{:p}";
@@ -294,7 +425,6 @@ void Scheduler::context_switch(Thread* thread)
         proc.init_context(*thread, false);
         thread->set_initialized(true);
     }
-    thread->set_state(Thread::State::Running);
 
     PerformanceManager::add_context_switch_perf_event(*from_thread, *thread);
 
@@ -308,7 +438,7 @@ void Scheduler::context_switch(Thread* thread)
 
 void Scheduler::enter_current(Thread& prev_thread)
 {
-    VERIFY(g_scheduler_lock.is_locked_by_current_processor());
+    VERIFY(context_switch_lock().is_locked_by_current_processor());
 
     // We already recorded the scheduled time when entering the trap, so this merely accounts for the kernel time since then
     auto scheduler_time = Scheduler::current_time();
@@ -318,9 +448,15 @@ void Scheduler::enter_current(Thread& prev_thread)
 
     // NOTE: When doing an exec(), we will context switch from and to the same thread!
     //       In that case, we must not mark the previous thread as inactive.
-    if (&prev_thread != current_thread)
+    if (&prev_thread != current_thread) {
         prev_thread.set_active(false);
 
+        // A processor that went looking for work while the thread was still switching out here
+        // had to leave it on its ready queues, so let it know that it can run the thread now.
+        if (prev_thread.state() == Thread::State::Runnable)
+            Processor::smp_wake_idle_processor(prev_thread.m_runnable_cpu);
+    }
+
     if (prev_thread.state() == Thread::State::Dying) {
         // If the thread we switched from is marked as dying, then notify
         // the finalizer. Note that as soon as we leave the scheduler lock
@@ -335,7 +471,7 @@ void Scheduler::leave_on_first_switch(u32 flags)
     // At this point, enter_current has already be called, but because
     // Scheduler::context_switch is not in the call stack we need to
     // clean up and release locks manually here
-    g_scheduler_lock.unlock(flags);
+    context_switch_lock().unlock(flags);
 
     VERIFY(Processor::current_in_scheduler());
     Processor::set_current_in_scheduler(false);
@@ -345,7 +481,7 @@ void Scheduler::prepare_after_exec()
 {
     // This is called after exec() when doing a context "switch" into
     // the new process. This is called from Processor::assume_context
-    VERIFY(g_scheduler_lock.is_locked_by_current_processor());
+    VERIFY(context_switch_lock().is_locked_by_current_processor());
 
     VERIFY(!Processor::current_in_scheduler());
     Processor::set_current_in_scheduler(true);
@@ -354,14 +490,21 @@ void Scheduler::prepare_after_exec()
 void Scheduler::prepare_for_idle_loop()
 {
     // This is called when the CPU finished setting up the idle loop
-    // and is about to run it. We need to acquire he scheduler lock
-    VERIFY(!g_scheduler_lock.is_locked_by_current_processor());
-    g_scheduler_lock.lock();
+    // and is about to run it. We need to acquire the context switch lock
+    VERIFY(!context_switch_lock().is_locked_by_current_processor());
+    context_switch_lock().lock();
 
     VERIFY(!Processor::current_in_scheduler());
     Processor::set_current_in_scheduler(true);
 }
 
+RecursiveSpinlock& Scheduler::context_switch_lock()
+{
+    auto current_cpu = Processor::current_id();
+    VERIFY(current_cpu < max_scheduled_processors);
+    return (*s_processor_ready_queues)[current_cpu].context_switch_lock;
+}
+
 Process* Scheduler::colonel()
 {
     VERIFY(s_colonel_process);
@@ -383,6 +526,8 @@ UNMAP_AFTER_INIT void Scheduler::initialize()
 {
     VERIFY(Processor::is_initialized()); // sanity check
 
+    s_schedule_on_all_processors = kernel_command_line().is_smp_scheduling_enabled();
+
     // Figure out a good scheduling time source
     if (Processor::current().has_feature(CPUFeature::TSC)) {
         // TODO: only use if TSC is running at a constant frequency?
@@ -446,10 +591,8 @@ void Scheduler::timer_tick(const RegisterState& regs)
     VERIFY(current_thread->current_trap());
     VERIFY(current_thread->current_trap()->regs == &regs);
 
-#if !SCHEDULE_ON_ALL_PROCESSORS
-    if (!Processor::is_bootstrap_processor())
-        return; // TODO: This prevents scheduling on other CPUs!
-#endif
+    if (!s_schedule_on_all_processors && !Processor::is_bootstrap_processor())
+        return;
 
     if (current_thread->process().is_kernel_process()) {
         // Because the previous mode when entering/exiting kernel threads never changes
@@ -514,12 +657,8 @@ void Scheduler::idle_loop(void*)
 
         proc.idle_end();
         VERIFY_INTERRUPTS_ENABLED();
-#if SCHEDULE_ON_ALL_PROCESSORS
-        yield();
-#else
-        if (Processor::current_id() == 0)
+        if (s_schedule_on_all_processors || Processor::is_bootstrap_processor())
             yield();
-#endif
     }
 }
 
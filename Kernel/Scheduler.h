@@ -43,6 +43,9 @@ public:
     static void leave_on_first_switch(u32 flags);
     static void prepare_after_exec();
     static void prepare_for_idle_loop();
+    static RecursiveSpinlock& context_switch_lock();
+    // The number of processors that threads get to run on, starting with the BSP.
+    static u32 schedulable_processor_count();
     static Process* colonel();
     static void idle_loop(void*);
     static void invoke_async();
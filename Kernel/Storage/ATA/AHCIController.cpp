@@ -68,6 +68,24 @@ void AHCIController::start_request(const ATADevice& device, AsyncBlockDeviceRequ
     port->start_request(request);
 }
 
+size_t AHCIController::max_outstanding_requests(const ATADevice& device) const
+{
+    VERIFY(m_handlers.size() > 0);
+    auto port = m_handlers[0].port_at_index(device.ata_address().port);
+    if (!port)
+        return 1;
+    return port->max_outstanding_commands();
+}
+
+size_t AHCIController::max_transfer_size(const ATADevice& device) const
+{
+    VERIFY(m_handlers.size() > 0);
+    auto port = m_handlers[0].port_at_index(device.ata_address().port);
+    if (!port)
+        return PAGE_SIZE;
+    return AHCIPort::max_transfer_size;
+}
+
 void AHCIController::complete_current_request(AsyncDeviceRequest::RequestResult)
 {
     VERIFY_NOT_REACHED();
@@ -8,9 +8,9 @@
 // please look at Documentation/Kernel/AHCILocking.md
 
 #include <AK/Atomic.h>
+#include <AK/ScopeGuard.h>
 #include <Kernel/Locking/Spinlock.h>
 #include <Kernel/Memory/MemoryManager.h>
-#include <Kernel/Memory/ScatterGatherList.h>
 #include <Kernel/Memory/TypedMapping.h>
 #include <Kernel/Storage/ATA/AHCIPort.h>
 #include <Kernel/Storage/ATA/ATA.h>
@@ -39,12 +39,9 @@ AHCIPort::AHCIPort(const AHCIPortHandler& handler, volatile AHCI::PortRegisters&
 
     m_fis_receive_page = MM.allocate_supervisor_physical_page().release_value_but_fixme_should_propagate_errors();
 
-    for (size_t index = 0; index < 1; index++) {
-        m_dma_buffers.append(MM.allocate_supervisor_physical_page().release_value_but_fixme_should_propagate_errors());
-    }
-    for (size_t index = 0; index < 1; index++) {
-        m_command_table_pages.append(MM.allocate_supervisor_physical_page().release_value_but_fixme_should_propagate_errors());
-    }
+    // Note: We need at least one command slot to identify the device. Once we know whether
+    // it supports NCQ, we allocate more of them.
+    MUST(try_allocate_command_slot());
 
     m_command_list_region = MM.allocate_dma_buffer_page("AHCI Port Command List", Memory::Region::Access::ReadWrite, m_command_list_page).release_value_but_fixme_should_propagate_errors();
 
@@ -53,6 +50,39 @@ AHCIPort::AHCIPort(const AHCIPortHandler& handler, volatile AHCI::PortRegisters&
     dbgln_if(AHCI_DEBUG, "AHCI Port {}: Command list region at {}", representative_port_index(), m_command_list_region->vaddr());
 }
 
+ErrorOr<void> AHCIPort::try_allocate_command_slot()
+{
+    CommandSlot slot;
+    slot.command_table_region = TRY(MM.allocate_dma_buffer_page("AHCI Command Table", Memory::Region::Access::ReadWrite, slot.command_table_page));
+    slot.dma_region = TRY(MM.allocate_dma_buffer_pages(max_transfer_size, "AHCI DMA Buffer", Memory::Region::Access::ReadWrite, slot.dma_pages));
+    TRY(m_command_slots.try_append(move(slot)));
+    return {};
+}
+
+void AHCIPort::configure_command_slots(ATAIdentifyBlock const& identify_block)
+{
+    VERIFY(m_lock.is_locked());
+    // Note: Word 76 bit 8 tells whether the device supports NCQ, and word 75 holds its maximum queue depth minus one.
+    size_t command_slots_count = 1;
+    bool device_supports_native_command_queuing = identify_block.serial_ata_capabilities != 0xffff && (identify_block.serial_ata_capabilities & (1 << 8));
+    if (!is_atapi_attached() && m_parent_handler->hba_capabilities().native_command_queuing_supported && device_supports_native_command_queuing) {
+        command_slots_count = min(max_command_slots, m_parent_handler->hba_capabilities().max_command_list_entries_count);
+        command_slots_count = min(command_slots_count, static_cast<size_t>(identify_block.queue_depth & 0x1f) + 1);
+    }
+
+    while (m_command_slots.size() < command_slots_count) {
+        if (auto result = try_allocate_command_slot(); result.is_error()) {
+            dmesgln("AHCI Port {}: Failed to allocate command slot: {}", representative_port_index(), result.error());
+            break;
+        }
+    }
+
+    m_usable_command_slots = min(command_slots_count, m_command_slots.size());
+    m_native_command_queuing_enabled = m_usable_command_slots > 1;
+    if (m_native_command_queuing_enabled)
+        dmesgln("AHCI Port {}: Using NCQ with {} command slots", representative_port_index(), m_usable_command_slots);
+}
+
 void AHCIPort::clear_sata_error_register() const
 {
     dbgln_if(AHCI_DEBUG, "AHCI Port {}: Clearing SATA error register.", representative_port_index());
@@ -97,43 +127,87 @@ void AHCIPort::handle_interrupt()
         });
         return;
     }
-    if (m_interrupt_status.is_set(AHCI::PortInterruptFlag::DHR) || m_interrupt_status.is_set(AHCI::PortInterruptFlag::PS)) {
-        m_wait_for_completion = false;
+    if (m_interrupt_status.is_set(AHCI::PortInterruptFlag::DHR) || m_interrupt_status.is_set(AHCI::PortInterruptFlag::SDB) || m_interrupt_status.is_set(AHCI::PortInterruptFlag::PS)) {
+        // Note: We clear the interrupt status before looking at which commands have finished,
+        // so that any command finishing after that raises another interrupt.
+        m_interrupt_status.clear();
+
+        // A command has finished once the HBA cleared its bit in PxCI, and with NCQ, the device
+        // cleared its bit in PxSACT. Several of them may have finished with a single interrupt.
+        u32 finished_commands = 0;
+        {
+            SpinlockLocker lock(m_hard_lock);
+            finished_commands = m_issued_commands & ~(m_port_registers.ci | m_port_registers.sact);
+            m_issued_commands &= ~finished_commands;
+            m_finished_commands |= finished_commands;
+        }
 
         // Now schedule reading/writing the buffer as soon as we leave the irq handler.
         // This is important so that we can safely access the buffers, which could
         // trigger page faults
-        if (!m_current_request) {
+        if (!finished_commands) {
             dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request handled, probably identify request", representative_port_index());
         } else {
             g_io_work->queue([this]() {
-                dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request handled", representative_port_index());
-                MutexLocker locker(m_lock);
-                VERIFY(m_current_request);
-                VERIFY(m_current_scatter_list);
-                if (!m_connected_device) {
-                    dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request success", representative_port_index());
-                    complete_current_request(AsyncDeviceRequest::Failure);
-                    return;
-                }
-                if (m_current_request->request_type() == AsyncBlockDeviceRequest::Read) {
-                    if (auto result = m_current_request->write_to_buffer(m_current_request->buffer(), m_current_scatter_list->dma_region().as_ptr(), m_connected_device->block_size() * m_current_request->block_count()); result.is_error()) {
-                        dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request failure, memory fault occurred when reading in data.", representative_port_index());
-                        m_current_scatter_list = nullptr;
-                        complete_current_request(AsyncDeviceRequest::MemoryFault);
-                        return;
-                    }
-                }
-                m_current_scatter_list = nullptr;
-                dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request success", representative_port_index());
-                complete_current_request(AsyncDeviceRequest::Success);
+                complete_finished_commands();
             });
         }
+        return;
     }
 
     m_interrupt_status.clear();
 }
 
+void AHCIPort::complete_finished_commands()
+{
+    MutexLocker locker(m_lock);
+    u32 finished_commands = 0;
+    {
+        SpinlockLocker lock(m_hard_lock);
+        finished_commands = exchange(m_finished_commands, 0);
+    }
+
+    for (size_t slot_index = 0; slot_index < m_command_slots.size(); slot_index++) {
+        if (!(finished_commands & (1u << slot_index)))
+            continue;
+        auto& slot = m_command_slots[slot_index];
+        // Note: The slot is free again before the request completes, as completing it may start the next one.
+        RefPtr<AsyncBlockDeviceRequest> request = move(slot.request);
+        if (!request)
+            continue;
+        dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request in command slot {} handled", representative_port_index(), slot_index);
+        if (!m_connected_device) {
+            dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request failure, device is gone", representative_port_index());
+            request->complete(AsyncDeviceRequest::Failure);
+            continue;
+        }
+        if (request->request_type() == AsyncBlockDeviceRequest::Read) {
+            if (auto result = request->write_to_buffer(request->buffer(), slot.dma_region->vaddr().as_ptr(), m_connected_device->block_size() * request->block_count()); result.is_error()) {
+                dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request failure, memory fault occurred when reading in data.", representative_port_index());
+                request->complete(AsyncDeviceRequest::MemoryFault);
+                continue;
+            }
+        }
+        dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request success", representative_port_index());
+        request->complete(AsyncDeviceRequest::Success);
+    }
+}
+
+void AHCIPort::fail_outstanding_requests()
+{
+    VERIFY(m_lock.is_locked());
+    {
+        SpinlockLocker lock(m_hard_lock);
+        m_issued_commands = 0;
+        m_finished_commands = 0;
+    }
+    for (auto& slot : m_command_slots) {
+        RefPtr<AsyncBlockDeviceRequest> request = move(slot.request);
+        if (request)
+            request->complete(AsyncDeviceRequest::Failure);
+    }
+}
+
 bool AHCIPort::is_interrupts_enabled() const
 {
     return !m_interrupt_enable.is_cleared();
@@ -142,12 +216,15 @@ bool AHCIPort::is_interrupts_enabled() const
 void AHCIPort::recover_from_fatal_error()
 {
     MutexLocker locker(m_lock);
-    SpinlockLocker lock(m_hard_lock);
-    dmesgln("{}: AHCI Port {} fatal error, shutting down!", m_parent_handler->hba_controller()->pci_address(), representative_port_index());
-    dmesgln("{}: AHCI Port {} fatal error, SError {}", m_parent_handler->hba_controller()->pci_address(), representative_port_index(), (u32)m_port_registers.serr);
-    stop_command_list_processing();
-    stop_fis_receiving();
-    m_interrupt_enable.clear();
+    {
+        SpinlockLocker lock(m_hard_lock);
+        dmesgln("{}: AHCI Port {} fatal error, shutting down!", m_parent_handler->hba_controller()->pci_address(), representative_port_index());
+        dmesgln("{}: AHCI Port {} fatal error, SError {}", m_parent_handler->hba_controller()->pci_address(), representative_port_index(), (u32)m_port_registers.serr);
+        stop_command_list_processing();
+        stop_fis_receiving();
+        m_interrupt_enable.clear();
+    }
+    fail_outstanding_requests();
 }
 
 void AHCIPort::eject()
@@ -163,10 +240,11 @@ void AHCIPort::eject()
     if (!spin_until_ready())
         return;
 
-    auto unused_command_header = try_to_find_unused_command_header();
+    auto unused_command_header = try_to_find_unused_command_slot();
     VERIFY(unused_command_header.has_value());
+    auto& command_slot = m_command_slots[unused_command_header.value()];
     auto* command_list_entries = (volatile AHCI::CommandHeader*)m_command_list_region->vaddr().as_ptr();
-    command_list_entries[unused_command_header.value()].ctba = m_command_table_pages[unused_command_header.value()].paddr().get();
+    command_list_entries[unused_command_header.value()].ctba = command_slot.command_table_page->paddr().get();
     command_list_entries[unused_command_header.value()].ctbau = 0;
     command_list_entries[unused_command_header.value()].prdbc = 0;
     command_list_entries[unused_command_header.value()].prdtl = 0;
@@ -177,8 +255,7 @@ void AHCIPort::eject()
     // handshake error bit in PxSERR register if CFL is incorrect.
     command_list_entries[unused_command_header.value()].attributes = (size_t)FIS::DwordCount::RegisterHostToDevice | AHCI::CommandHeaderAttributes::P | AHCI::CommandHeaderAttributes::C | AHCI::CommandHeaderAttributes::A;
 
-    auto command_table_region = MM.allocate_kernel_region(m_command_table_pages[unused_command_header.value()].paddr().page_base(), Memory::page_round_up(sizeof(AHCI::CommandTable)).value(), "AHCI Command Table", Memory::Region::Access::ReadWrite, Memory::Region::Cacheable::No).release_value();
-    auto& command_table = *(volatile AHCI::CommandTable*)command_table_region->vaddr().as_ptr();
+    auto& command_table = *(volatile AHCI::CommandTable*)command_slot.command_table_region->vaddr().as_ptr();
     memset(const_cast<u8*>(command_table.command_fis), 0, 64);
     auto& fis = *(volatile FIS::HostToDevice::Register*)command_table.command_fis;
     fis.header.fis_type = (u8)FIS::Type::RegisterHostToDevice;
@@ -226,6 +303,9 @@ void AHCIPort::eject()
 bool AHCIPort::reset()
 {
     MutexLocker locker(m_lock);
+    // Note: Whatever was in flight is lost with the reset. The requests are failed once
+    // we let go of the hard lock, as completing them may start new ones.
+    ScopeGuard fail_requests_guard = [this] { fail_outstanding_requests(); };
     SpinlockLocker lock(m_hard_lock);
 
     dbgln_if(AHCI_DEBUG, "AHCI Port {}: Resetting", representative_port_index());
@@ -287,6 +367,7 @@ bool AHCIPort::initialize()
     u64 max_addressable_sector = 0;
     if (identify_device()) {
         auto identify_block = Memory::map_typed<ATAIdentifyBlock>(m_parent_handler->get_identify_metadata_physical_region(m_port_index)).release_value_but_fixme_should_propagate_errors();
+        configure_command_slots(*identify_block);
         // Check if word 106 is valid before using it!
         if ((identify_block->physical_sector_size_to_logical_sector_size >> 14) == 1) {
             if (identify_block->physical_sector_size_to_logical_sector_size & (1 << 12)) {
@@ -434,67 +515,63 @@ void AHCIPort::set_sleep_state() const
     m_port_registers.cmd = (m_port_registers.cmd & 0x0ffffff) | (0b1000 << 28);
 }
 
-size_t AHCIPort::calculate_descriptors_count(size_t block_count) const
-{
-    VERIFY(m_connected_device);
-    size_t needed_dma_regions_count = Memory::page_round_up((block_count * m_connected_device->block_size())).value() / PAGE_SIZE;
-    VERIFY(needed_dma_regions_count <= m_dma_buffers.size());
-    return needed_dma_regions_count;
-}
-
-Optional<AsyncDeviceRequest::RequestResult> AHCIPort::prepare_and_set_scatter_list(AsyncBlockDeviceRequest& request)
-{
-    VERIFY(m_lock.is_locked());
-    VERIFY(request.block_count() > 0);
-
-    NonnullRefPtrVector<Memory::PhysicalPage> allocated_dma_regions;
-    for (size_t index = 0; index < calculate_descriptors_count(request.block_count()); index++) {
-        allocated_dma_regions.append(m_dma_buffers.at(index));
-    }
-
-    m_current_scatter_list = Memory::ScatterGatherList::try_create(request, allocated_dma_regions.span(), m_connected_device->block_size());
-    if (!m_current_scatter_list)
-        return AsyncDeviceRequest::Failure;
-    if (request.request_type() == AsyncBlockDeviceRequest::Write) {
-        if (auto result = request.read_from_buffer(request.buffer(), m_current_scatter_list->dma_region().as_ptr(), m_connected_device->block_size() * request.block_count()); result.is_error()) {
-            return AsyncDeviceRequest::MemoryFault;
+size_t AHCIPort::fill_physical_region_descriptors(volatile AHCI::CommandTable& command_table, CommandSlot const& slot, size_t byte_count) const
+{
+    VERIFY(byte_count > 0 && byte_count <= max_transfer_size);
+    size_t descriptors_count = 0;
+    size_t page_index = 0;
+    while (byte_count > 0) {
+        // Note: Physically contiguous pages of the DMA buffer are covered by a single descriptor.
+        auto base = slot.dma_pages[page_index].paddr();
+        size_t descriptor_byte_count = 0;
+        while (byte_count > 0 && slot.dma_pages[page_index].paddr() == base.offset(descriptor_byte_count)) {
+            auto page_byte_count = min(byte_count, PAGE_SIZE);
+            descriptor_byte_count += page_byte_count;
+            byte_count -= page_byte_count;
+            page_index++;
         }
+        dbgln_if(AHCI_DEBUG, "AHCI Port {}: Add a transfer scatter entry @ {}, {} bytes", representative_port_index(), base, descriptor_byte_count);
+        command_table.descriptors[descriptors_count].base_high = 0;
+        command_table.descriptors[descriptors_count].base_low = base.get();
+        command_table.descriptors[descriptors_count].reserved = 0;
+        command_table.descriptors[descriptors_count].byte_count = descriptor_byte_count - 1;
+        descriptors_count++;
     }
-    return {};
+    return descriptors_count;
 }
 
 void AHCIPort::start_request(AsyncBlockDeviceRequest& request)
 {
     MutexLocker locker(m_lock);
     dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request start", representative_port_index());
-    VERIFY(!m_current_request);
-    VERIFY(!m_current_scatter_list);
-
-    m_current_request = request;
+    VERIFY(request.block_count() > 0);
 
-    auto result = prepare_and_set_scatter_list(request);
-    if (result.has_value()) {
+    auto fail_request = [&](AsyncDeviceRequest::RequestResult result) {
         dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request failure.", representative_port_index());
         locker.unlock();
-        complete_current_request(result.value());
-        return;
-    }
+        request.complete(result);
+    };
 
-    auto success = access_device(request.request_type(), request.block_index(), request.block_count());
-    if (!success) {
-        dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request failure.", representative_port_index());
-        locker.unlock();
-        complete_current_request(AsyncDeviceRequest::Failure);
-        return;
+    if (!m_connected_device || !is_operable())
+        return fail_request(AsyncDeviceRequest::Failure);
+
+    // Note: The device never has more requests outstanding than we have usable command slots.
+    auto slot_index = try_to_find_unused_command_slot();
+    VERIFY(slot_index.has_value());
+    auto& slot = m_command_slots[slot_index.value()];
+
+    size_t byte_count = request.block_count() * m_connected_device->block_size();
+    VERIFY(byte_count <= max_transfer_size);
+    if (request.request_type() == AsyncBlockDeviceRequest::Write) {
+        if (auto result = request.read_from_buffer(request.buffer(), slot.dma_region->vaddr().as_ptr(), byte_count); result.is_error())
+            return fail_request(AsyncDeviceRequest::MemoryFault);
     }
-}
 
-void AHCIPort::complete_current_request(AsyncDeviceRequest::RequestResult result)
-{
-    VERIFY(m_current_request);
-    auto current_request = m_current_request;
-    m_current_request.clear();
-    current_request->complete(result);
+    slot.request = request;
+    if (!access_device(request.request_type(), request.block_index(), request.block_count(), slot_index.value())) {
+        slot.request = nullptr;
+        return fail_request(AsyncDeviceRequest::Failure);
+    }
 }
 
 bool AHCIPort::spin_until_ready() const
@@ -513,59 +590,36 @@ bool AHCIPort::spin_until_ready() const
     return true;
 }
 
-bool AHCIPort::access_device(AsyncBlockDeviceRequest::RequestType direction, u64 lba, u8 block_count)
+bool AHCIPort::access_device(AsyncBlockDeviceRequest::RequestType direction, u64 lba, u16 block_count, u8 slot_index)
 {
     VERIFY(m_connected_device);
     VERIFY(is_operable());
     VERIFY(m_lock.is_locked());
-    VERIFY(m_current_scatter_list);
     SpinlockLocker lock(m_hard_lock);
+    auto& slot = m_command_slots[slot_index];
 
-    dbgln_if(AHCI_DEBUG, "AHCI Port {}: Do a {}, lba {}, block count {}", representative_port_index(), direction == AsyncBlockDeviceRequest::RequestType::Write ? "write" : "read", lba, block_count);
-    if (!spin_until_ready())
+    dbgln_if(AHCI_DEBUG, "AHCI Port {}: Do a {}, lba {}, block count {}, command slot {}", representative_port_index(), direction == AsyncBlockDeviceRequest::RequestType::Write ? "write" : "read", lba, block_count, slot_index);
+    // Note: With NCQ, the device accepts new commands while others are still outstanding.
+    if (!m_issued_commands && !spin_until_ready())
         return false;
 
-    auto unused_command_header = try_to_find_unused_command_header();
-    VERIFY(unused_command_header.has_value());
+    auto& command_table = *(volatile AHCI::CommandTable*)slot.command_table_region->vaddr().as_ptr();
+    memset(const_cast<u8*>(command_table.command_fis), 0, 64);
+    auto descriptors_count = fill_physical_region_descriptors(command_table, slot, block_count * m_connected_device->block_size());
+
     auto* command_list_entries = (volatile AHCI::CommandHeader*)m_command_list_region->vaddr().as_ptr();
-    command_list_entries[unused_command_header.value()].ctba = m_command_table_pages[unused_command_header.value()].paddr().get();
-    command_list_entries[unused_command_header.value()].ctbau = 0;
-    command_list_entries[unused_command_header.value()].prdbc = 0;
-    command_list_entries[unused_command_header.value()].prdtl = m_current_scatter_list->scatters_count();
+    command_list_entries[slot_index].ctba = slot.command_table_page->paddr().get();
+    command_list_entries[slot_index].ctbau = 0;
+    command_list_entries[slot_index].prdbc = 0;
+    command_list_entries[slot_index].prdtl = descriptors_count;
 
     // Note: we must set the correct Dword count in this register. Real hardware
     // AHCI controllers do care about this field! QEMU doesn't care if we don't
     // set the correct CFL field in this register, real hardware will set an
     // handshake error bit in PxSERR register if CFL is incorrect.
-    command_list_entries[unused_command_header.value()].attributes = (size_t)FIS::DwordCount::RegisterHostToDevice | AHCI::CommandHeaderAttributes::P | (is_atapi_attached() ? AHCI::CommandHeaderAttributes::A : 0) | (direction == AsyncBlockDeviceRequest::RequestType::Write ? AHCI::CommandHeaderAttributes::W : 0);
-
-    dbgln_if(AHCI_DEBUG, "AHCI Port {}: CLE: ctba={:#08x}, ctbau={:#08x}, prdbc={:#08x}, prdtl={:#04x}, attributes={:#04x}", representative_port_index(), (u32)command_list_entries[unused_command_header.value()].ctba, (u32)command_list_entries[unused_command_header.value()].ctbau, (u32)command_list_entries[unused_command_header.value()].prdbc, (u16)command_list_entries[unused_command_header.value()].prdtl, (u16)command_list_entries[unused_command_header.value()].attributes);
-
-    auto command_table_region = MM.allocate_kernel_region(m_command_table_pages[unused_command_header.value()].paddr().page_base(), Memory::page_round_up(sizeof(AHCI::CommandTable)).value(), "AHCI Command Table", Memory::Region::Access::ReadWrite, Memory::Region::Cacheable::No).release_value();
-    auto& command_table = *(volatile AHCI::CommandTable*)command_table_region->vaddr().as_ptr();
+    command_list_entries[slot_index].attributes = (size_t)FIS::DwordCount::RegisterHostToDevice | AHCI::CommandHeaderAttributes::P | (is_atapi_attached() ? AHCI::CommandHeaderAttributes::A : 0) | (direction == AsyncBlockDeviceRequest::RequestType::Write ? AHCI::CommandHeaderAttributes::W : 0);
 
-    dbgln_if(AHCI_DEBUG, "AHCI Port {}: Allocated command table at {}", representative_port_index(), command_table_region->vaddr());
-
-    memset(const_cast<u8*>(command_table.command_fis), 0, 64);
-
-    size_t scatter_entry_index = 0;
-    size_t data_transfer_count = (block_count * m_connected_device->block_size());
-    for (auto scatter_page : m_current_scatter_list->vmobject().physical_pages()) {
-        VERIFY(data_transfer_count != 0);
-        VERIFY(scatter_page);
-        dbgln_if(AHCI_DEBUG, "AHCI Port {}: Add a transfer scatter entry @ {}", representative_port_index(), scatter_page->paddr());
-        command_table.descriptors[scatter_entry_index].base_high = 0;
-        command_table.descriptors[scatter_entry_index].base_low = scatter_page->paddr().get();
-        if (data_transfer_count <= PAGE_SIZE) {
-            command_table.descriptors[scatter_entry_index].byte_count = data_transfer_count - 1;
-            data_transfer_count = 0;
-        } else {
-            command_table.descriptors[scatter_entry_index].byte_count = PAGE_SIZE - 1;
-            data_transfer_count -= PAGE_SIZE;
-        }
-        scatter_entry_index++;
-    }
-    command_table.descriptors[scatter_entry_index].byte_count = (PAGE_SIZE - 1) | (1 << 31);
+    dbgln_if(AHCI_DEBUG, "AHCI Port {}: CLE: ctba={:#08x}, ctbau={:#08x}, prdbc={:#08x}, prdtl={:#04x}, attributes={:#04x}", representative_port_index(), (u32)command_list_entries[slot_index].ctba, (u32)command_list_entries[slot_index].ctbau, (u32)command_list_entries[slot_index].prdbc, (u16)command_list_entries[slot_index].prdtl, (u16)command_list_entries[slot_index].attributes);
 
     memset(const_cast<u8*>(command_table.atapi_command), 0, 32);
 
@@ -574,6 +628,11 @@ bool AHCIPort::access_device(AsyncBlockDeviceRequest::RequestType direction, u64
     if (is_atapi_attached()) {
         fis.command = ATA_CMD_PACKET;
         TODO();
+    } else if (m_native_command_queuing_enabled) {
+        if (direction == AsyncBlockDeviceRequest::RequestType::Write)
+            fis.command = ATA_CMD_WRITE_FPDMA_QUEUED;
+        else
+            fis.command = ATA_CMD_READ_FPDMA_QUEUED;
     } else {
         if (direction == AsyncBlockDeviceRequest::RequestType::Write)
             fis.command = ATA_CMD_WRITE_DMA_EXT;
@@ -592,17 +651,24 @@ bool AHCIPort::access_device(AsyncBlockDeviceRequest::RequestType direction, u64
     fis.lba_low[0] = lba & 0xff;
     fis.lba_low[1] = (lba >> 8) & 0xff;
     fis.lba_low[2] = (lba >> 16) & 0xff;
-    fis.count = (block_count);
+    if (m_native_command_queuing_enabled) {
+        // Note: Queued commands take the block count in the features register, and their tag in the count register.
+        fis.features_low = block_count & 0xff;
+        fis.features_high = (block_count >> 8) & 0xff;
+        fis.count = slot_index << 3;
+    } else {
+        fis.count = block_count;
+    }
 
     // The below loop waits until the port is no longer busy before issuing a new command
-    if (!spin_until_ready())
+    if (!m_issued_commands && !spin_until_ready())
         return false;
 
     full_memory_barrier();
-    mark_command_header_ready_to_process(unused_command_header.value());
+    mark_command_header_ready_to_process(slot_index);
     full_memory_barrier();
 
-    dbgln_if(AHCI_DEBUG, "AHCI Port {}: Do a {}, lba {}, block count {} @ {}, ended", representative_port_index(), direction == AsyncBlockDeviceRequest::RequestType::Write ? "write" : "read", lba, block_count, m_dma_buffers[0].paddr());
+    dbgln_if(AHCI_DEBUG, "AHCI Port {}: Do a {}, lba {}, block count {} @ {}, ended", representative_port_index(), direction == AsyncBlockDeviceRequest::RequestType::Write ? "write" : "read", lba, block_count, slot.dma_pages[0].paddr());
     return true;
 }
 
@@ -613,10 +679,11 @@ bool AHCIPort::identify_device()
     if (!spin_until_ready())
         return false;
 
-    auto unused_command_header = try_to_find_unused_command_header();
+    auto unused_command_header = try_to_find_unused_command_slot();
     VERIFY(unused_command_header.has_value());
+    auto& command_slot = m_command_slots[unused_command_header.value()];
     auto* command_list_entries = (volatile AHCI::CommandHeader*)m_command_list_region->vaddr().as_ptr();
-    command_list_entries[unused_command_header.value()].ctba = m_command_table_pages[unused_command_header.value()].paddr().get();
+    command_list_entries[unused_command_header.value()].ctba = command_slot.command_table_page->paddr().get();
     command_list_entries[unused_command_header.value()].ctbau = 0;
     command_list_entries[unused_command_header.value()].prdbc = 512;
     command_list_entries[unused_command_header.value()].prdtl = 1;
@@ -625,8 +692,7 @@ bool AHCIPort::identify_device()
     // QEMU doesn't care if we don't set the correct CFL field in this register, real hardware will set an handshake error bit in PxSERR register.
     command_list_entries[unused_command_header.value()].attributes = (size_t)FIS::DwordCount::RegisterHostToDevice | AHCI::CommandHeaderAttributes::P;
 
-    auto command_table_region = MM.allocate_kernel_region(m_command_table_pages[unused_command_header.value()].paddr().page_base(), Memory::page_round_up(sizeof(AHCI::CommandTable)).value(), "AHCI Command Table", Memory::Region::Access::ReadWrite).release_value();
-    auto& command_table = *(volatile AHCI::CommandTable*)command_table_region->vaddr().as_ptr();
+    auto& command_table = *(volatile AHCI::CommandTable*)command_slot.command_table_region->vaddr().as_ptr();
     memset(const_cast<u8*>(command_table.command_fis), 0, 64);
     command_table.descriptors[0].base_high = 0;
     command_table.descriptors[0].base_low = m_parent_handler->get_identify_metadata_physical_region(m_port_index).get();
@@ -700,16 +766,14 @@ bool AHCIPort::shutdown()
     return true;
 }
 
-Optional<u8> AHCIPort::try_to_find_unused_command_header()
+Optional<u8> AHCIPort::try_to_find_unused_command_slot()
 {
     VERIFY(m_lock.is_locked());
-    u32 commands_issued = m_port_registers.ci;
-    for (size_t index = 0; index < 32; index++) {
-        if (!(commands_issued & 1)) {
-            dbgln_if(AHCI_DEBUG, "AHCI Port {}: unused command header at index {}", representative_port_index(), index);
+    for (size_t index = 0; index < m_usable_command_slots; index++) {
+        if (!m_command_slots[index].request) {
+            dbgln_if(AHCI_DEBUG, "AHCI Port {}: unused command slot at index {}", representative_port_index(), index);
             return index;
         }
-        commands_issued >>= 1;
     }
     return {};
 }
@@ -723,15 +787,18 @@ void AHCIPort::start_command_list_processing() const
     m_port_registers.cmd = m_port_registers.cmd | 1;
 }
 
-void AHCIPort::mark_command_header_ready_to_process(u8 command_header_index) const
+void AHCIPort::mark_command_header_ready_to_process(u8 command_header_index)
 {
     VERIFY(m_lock.is_locked());
     VERIFY(m_hard_lock.is_locked());
     VERIFY(is_operable());
-    VERIFY(!m_wait_for_completion);
-    m_wait_for_completion = true;
+    VERIFY(!(m_issued_commands & (1u << command_header_index)));
     dbgln_if(AHCI_DEBUG, "AHCI Port {}: Marking command header at index {} as ready to process.", representative_port_index(), command_header_index);
-    m_port_registers.ci = 1 << command_header_index;
+    m_issued_commands |= 1u << command_header_index;
+    // Note: A queued command has to be marked as active in PxSACT before it is issued.
+    if (m_native_command_queuing_enabled)
+        m_port_registers.sact = 1u << command_header_index;
+    m_port_registers.ci = 1u << command_header_index;
 }
 
 void AHCIPort::stop_command_list_processing() const
@@ -8,6 +8,7 @@
 
 #include <AK/OwnPtr.h>
 #include <AK/RefPtr.h>
+#include <AK/Vector.h>
 #include <AK/WeakPtr.h>
 #include <AK/Weakable.h>
 #include <Kernel/Devices/Device.h>
@@ -16,7 +17,6 @@
 #include <Kernel/Locking/Spinlock.h>
 #include <Kernel/Memory/AnonymousVMObject.h>
 #include <Kernel/Memory/PhysicalPage.h>
-#include <Kernel/Memory/ScatterGatherList.h>
 #include <Kernel/PhysicalAddress.h>
 #include <Kernel/Random.h>
 #include <Kernel/Sections.h>
@@ -28,6 +28,7 @@
 namespace Kernel {
 
 class AsyncBlockDeviceRequest;
+struct ATAIdentifyBlock;
 
 class AHCIPortHandler;
 class AHCIPort
@@ -37,6 +38,11 @@ class AHCIPort
     friend class AHCIController;
 
 public:
+    // Every command slot has its own DMA buffer of this size, so this is the largest transfer a single request can do.
+    static constexpr size_t max_transfer_size = 128 * KiB;
+    // With NCQ, we keep at most this many commands in flight on a port.
+    static constexpr size_t max_command_slots = 8;
+
     UNMAP_AFTER_INIT static NonnullRefPtr<AHCIPort> create(const AHCIPortHandler&, volatile AHCI::PortRegisters&, u32 port_index);
 
     u32 port_index() const { return m_port_index; }
@@ -45,6 +51,7 @@ public:
     bool is_atapi_attached() const { return m_port_registers.sig == (u32)AHCI::DeviceSignature::ATAPI; };
 
     RefPtr<StorageDevice> connected_device() const { return m_connected_device; }
+    size_t max_outstanding_commands() const { return m_usable_command_slots; }
 
     bool reset();
     UNMAP_AFTER_INIT bool initialize_without_reset();
@@ -70,11 +77,22 @@ private:
     ALWAYS_INLINE void spin_up() const;
     ALWAYS_INLINE void power_on() const;
 
+    struct CommandSlot {
+        RefPtr<Memory::PhysicalPage> command_table_page;
+        OwnPtr<Memory::Region> command_table_region;
+        NonnullRefPtrVector<Memory::PhysicalPage> dma_pages;
+        OwnPtr<Memory::Region> dma_region;
+        RefPtr<AsyncBlockDeviceRequest> request;
+    };
+
+    ErrorOr<void> try_allocate_command_slot();
+    void configure_command_slots(ATAIdentifyBlock const&);
+
     void start_request(AsyncBlockDeviceRequest&);
-    void complete_current_request(AsyncDeviceRequest::RequestResult);
-    bool access_device(AsyncBlockDeviceRequest::RequestType, u64 lba, u8 block_count);
-    size_t calculate_descriptors_count(size_t block_count) const;
-    [[nodiscard]] Optional<AsyncDeviceRequest::RequestResult> prepare_and_set_scatter_list(AsyncBlockDeviceRequest& request);
+    void complete_finished_commands();
+    void fail_outstanding_requests();
+    bool access_device(AsyncBlockDeviceRequest::RequestType, u64 lba, u16 block_count, u8 slot_index);
+    size_t fill_physical_region_descriptors(volatile AHCI::CommandTable&, CommandSlot const&, size_t byte_count) const;
 
     ALWAYS_INLINE bool is_interrupts_enabled() const;
 
@@ -83,7 +101,7 @@ private:
     bool identify_device();
 
     ALWAYS_INLINE void start_command_list_processing() const;
-    ALWAYS_INLINE void mark_command_header_ready_to_process(u8 command_header_index) const;
+    ALWAYS_INLINE void mark_command_header_ready_to_process(u8 command_header_index);
     ALWAYS_INLINE void stop_command_list_processing() const;
 
     ALWAYS_INLINE void start_fis_receiving() const;
@@ -94,7 +112,7 @@ private:
 
     void set_interface_state(AHCI::DeviceDetectionInitialization);
 
-    Optional<u8> try_to_find_unused_command_header();
+    Optional<u8> try_to_find_unused_command_slot();
 
     ALWAYS_INLINE bool is_interface_disabled() const { return (m_port_registers.ssts & 0xf) == 4; };
 
@@ -103,14 +121,17 @@ private:
     // Data members
 
     EntropySource m_entropy_source;
-    RefPtr<AsyncBlockDeviceRequest> m_current_request;
     Spinlock m_hard_lock;
     Mutex m_lock { "AHCIPort" };
 
-    mutable bool m_wait_for_completion { false };
+    Vector<CommandSlot, max_command_slots> m_command_slots;
+    size_t m_usable_command_slots { 1 };
+    bool m_native_command_queuing_enabled { false };
+
+    // Note: These are protected by m_hard_lock, as the IRQ handler updates them.
+    u32 m_issued_commands { 0 };
+    u32 m_finished_commands { 0 };
 
-    NonnullRefPtrVector<Memory::PhysicalPage> m_dma_buffers;
-    NonnullRefPtrVector<Memory::PhysicalPage> m_command_table_pages;
     RefPtr<Memory::PhysicalPage> m_command_list_page;
     OwnPtr<Memory::Region> m_command_list_region;
     RefPtr<Memory::PhysicalPage> m_fis_receive_page;
@@ -122,7 +143,6 @@ private:
     AHCI::PortInterruptStatusBitField m_interrupt_status;
     AHCI::PortInterruptEnableBitField m_interrupt_enable;
 
-    RefPtr<Memory::ScatterGatherList> m_current_scatter_list;
     bool m_disabled_by_firmware { false };
 };
 }
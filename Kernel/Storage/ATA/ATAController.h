@@ -23,6 +23,11 @@ class ATAController
 public:
     virtual void start_request(const ATADevice&, AsyncBlockDeviceRequest&) = 0;
 
+    // How many requests the controller can work on at once for the given device,
+    // and how many bytes each of them may transfer.
+    virtual size_t max_outstanding_requests(const ATADevice&) const { return 1; }
+    virtual size_t max_transfer_size(const ATADevice&) const { return PAGE_SIZE; }
+
 protected:
     ATAController() = default;
 };
@@ -32,4 +32,20 @@ void ATADevice::start_request(AsyncBlockDeviceRequest& request)
     controller->start_request(*this, request);
 }
 
+size_t ATADevice::max_outstanding_requests() const
+{
+    auto controller = m_controller.strong_ref();
+    if (!controller)
+        return 1;
+    return controller->max_outstanding_requests(*this);
+}
+
+size_t ATADevice::max_blocks_per_request() const
+{
+    auto controller = m_controller.strong_ref();
+    if (!controller)
+        return StorageDevice::max_blocks_per_request();
+    return max<size_t>(controller->max_transfer_size(*this) / block_size(), 1);
+}
+
 }
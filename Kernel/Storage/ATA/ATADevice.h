@@ -31,6 +31,10 @@ public:
 
     // ^BlockDevice
     virtual void start_request(AsyncBlockDeviceRequest&) override;
+    virtual size_t max_outstanding_requests() const override;
+
+    // ^StorageDevice
+    virtual size_t max_blocks_per_request() const override;
 
     u16 ata_capabilites() const { return m_capabilities; }
     const Address& ata_address() const { return m_ata_address; }
@@ -77,6 +77,7 @@ private:
     AK::Time m_ready_timeout;
     u32 m_bar;
     u8 m_dbl_stride;
+    u16 m_io_queue_depth { IO_QUEUE_SIZE };
     static Atomic<u8> controller_id;
 };
 }
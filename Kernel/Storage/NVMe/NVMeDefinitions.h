@@ -97,7 +97,7 @@ static constexpr u16 CQ_STATUS_FIELD(u16 x)
     return (x & CQ_STATUS_FIELD_MASK) >> 1;
 }
 
-static constexpr u16 IO_QUEUE_SIZE = 64; // TODO:Need to be configurable
+static constexpr u16 IO_QUEUE_SIZE = 64; // Upper bound, clamped to CAP.MQES. TODO:Need to be configurable
 
 // IDENTIFY
 static constexpr u16 NVMe_IDENTIFY_SIZE = 4096;
@@ -28,6 +28,9 @@ public:
     CommandSet command_set() const override { return CommandSet::NVMe; };
     void start_request(AsyncBlockDeviceRequest& request) override;
 
+    // All IO queues have the same depth, and a request may land on any of them.
+    virtual size_t max_outstanding_requests() const override { return m_queues.first().max_outstanding_commands(); }
+
 private:
     u16 m_nsid;
     NonnullRefPtrVector<NVMeQueue> m_queues;
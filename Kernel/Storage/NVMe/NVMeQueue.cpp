@@ -15,21 +15,22 @@
 namespace Kernel {
 ErrorOr<NonnullRefPtr<NVMeQueue>> NVMeQueue::try_create(u16 qid, Optional<u8> irq, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> cq_dma_page, OwnPtr<Memory::Region> sq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> sq_dma_page, Memory::TypedMapping<volatile DoorbellRegister> db_regs)
 {
-    // Note: Allocate DMA region for RW operation. For now the requests don't exceed more than 4096 bytes (Storage device takes care of it)
-    RefPtr<Memory::PhysicalPage> rw_dma_page;
-    auto rw_dma_region = TRY(MM.allocate_dma_buffer_page("NVMe Queue Read/Write DMA"sv, Memory::Region::Access::ReadWrite, rw_dma_page));
+    // Note: Allocate a DMA page for each command identifier of an IO queue, so that many RW operations can be in flight at once.
+    //       For now the requests don't exceed more than 4096 bytes (Storage device takes care of it)
+    OwnPtr<Memory::Region> rw_dma_region;
+    NonnullRefPtrVector<Memory::PhysicalPage> rw_dma_pages;
+    if (qid != 0)
+        rw_dma_region = TRY(MM.allocate_dma_buffer_pages((q_depth - 1) * PAGE_SIZE, "NVMe Queue Read/Write DMA"sv, Memory::Region::Access::ReadWrite, rw_dma_pages));
     if (!irq.has_value()) {
-        auto queue = TRY(adopt_nonnull_ref_or_enomem(new (nothrow) NVMePollQueue(move(rw_dma_region), *rw_dma_page, qid, q_depth, move(cq_dma_region), cq_dma_page, move(sq_dma_region), sq_dma_page, move(db_regs))));
+        auto queue = TRY(adopt_nonnull_ref_or_enomem(new (nothrow) NVMePollQueue(move(rw_dma_region), move(rw_dma_pages), qid, q_depth, move(cq_dma_region), cq_dma_page, move(sq_dma_region), sq_dma_page, move(db_regs))));
         return queue;
     }
-    auto queue = TRY(adopt_nonnull_ref_or_enomem(new (nothrow) NVMeInterruptQueue(move(rw_dma_region), *rw_dma_page, qid, irq.value(), q_depth, move(cq_dma_region), cq_dma_page, move(sq_dma_region), sq_dma_page, move(db_regs))));
+    auto queue = TRY(adopt_nonnull_ref_or_enomem(new (nothrow) NVMeInterruptQueue(move(rw_dma_region), move(rw_dma_pages), qid, irq.value(), q_depth, move(cq_dma_region), cq_dma_page, move(sq_dma_region), sq_dma_page, move(db_regs))));
     return queue;
 }
 
-UNMAP_AFTER_INIT NVMeQueue::NVMeQueue(NonnullOwnPtr<Memory::Region> rw_dma_region, Memory::PhysicalPage const& rw_dma_page, u16 qid, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> cq_dma_page, OwnPtr<Memory::Region> sq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> sq_dma_page, Memory::TypedMapping<volatile DoorbellRegister> db_regs)
-    : m_current_request(nullptr)
-    , m_rw_dma_region(move(rw_dma_region))
-    , m_qid(qid)
+UNMAP_AFTER_INIT NVMeQueue::NVMeQueue(OwnPtr<Memory::Region> rw_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> rw_dma_pages, u16 qid, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> cq_dma_page, OwnPtr<Memory::Region> sq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> sq_dma_page, Memory::TypedMapping<volatile DoorbellRegister> db_regs)
+    : m_qid(qid)
     , m_admin_queue(qid == 0)
     , m_qdepth(q_depth)
     , m_cq_dma_region(move(cq_dma_region))
@@ -37,11 +38,18 @@ UNMAP_AFTER_INIT NVMeQueue::NVMeQueue(NonnullOwnPtr<Memory::Region> rw_dma_regio
     , m_sq_dma_region(move(sq_dma_region))
     , m_sq_dma_page(sq_dma_page)
     , m_db_regs(move(db_regs))
-    , m_rw_dma_page(rw_dma_page)
-
+    , m_rw_dma_region(move(rw_dma_region))
+    , m_rw_dma_pages(move(rw_dma_pages))
 {
     m_sqe_array = { reinterpret_cast<NVMeSubmission*>(m_sq_dma_region->vaddr().as_ptr()), m_qdepth };
     m_cqe_array = { reinterpret_cast<NVMeCompletion*>(m_cq_dma_region->vaddr().as_ptr()), m_qdepth };
+
+    if (!m_admin_queue) {
+        m_requests.resize(max_outstanding_commands());
+        m_free_command_ids.ensure_capacity(max_outstanding_commands());
+        for (size_t cmdid = max_outstanding_commands(); cmdid > 0; --cmdid)
+            m_free_command_ids.unchecked_append(cmdid - 1);
+    }
 }
 
 bool NVMeQueue::cqe_available()
@@ -64,38 +72,119 @@ void NVMeQueue::update_cqe_head()
 u32 NVMeQueue::process_cq()
 {
     u32 nr_of_processed_cqes = 0;
-    while (cqe_available()) {
+    while (true) {
         u16 status;
         u16 cmdid;
+        {
+            SpinlockLocker lock(m_cq_lock);
+            if (!cqe_available())
+                break;
+            status = CQ_STATUS_FIELD(m_cqe_array[m_cq_head].status);
+            cmdid = m_cqe_array[m_cq_head].command_id;
+            dbgln_if(NVME_DEBUG, "NVMe: Completion with status {:x} and command identifier {}. CQ_HEAD: {}", status, cmdid, m_cq_head);
+            update_cqe_head();
+        }
         ++nr_of_processed_cqes;
-        status = CQ_STATUS_FIELD(m_cqe_array[m_cq_head].status);
-        cmdid = m_cqe_array[m_cq_head].command_id;
-        dbgln_if(NVME_DEBUG, "NVMe: Completion with status {:x} and command identifier {}. CQ_HEAD: {}", status, cmdid, m_cq_head);
         // TODO: We don't use AsyncBlockDevice requests for admin queue as it is only applicable for a block device (NVMe namespace)
         //  But admin commands precedes namespace creation. Unify requests to avoid special conditions
-        if (m_admin_queue == false) {
-            // As the block layer calls are now sync (as we wait on each requests),
-            // everything is operated on a single request similar to BMIDE driver.
-            // TODO: Remove this constraint eventually.
-            VERIFY(cmdid == m_prev_sq_tail);
-            if (m_current_request) {
-                complete_current_request(status);
-            }
-        }
-        update_cqe_head();
+        // NOTE: The completion queue lock is not held here, as completing a request may submit the next one.
+        if (m_admin_queue == false)
+            complete_request(cmdid, status);
     }
     if (nr_of_processed_cqes) {
+        SpinlockLocker lock(m_cq_lock);
         update_cq_doorbell();
     }
     return nr_of_processed_cqes;
 }
 
+Optional<u16> NVMeQueue::allocate_command_id_or_defer(AsyncBlockDeviceRequest& request, u16 nsid, u64 index, u32 count)
+{
+    {
+        SpinlockLocker lock(m_request_lock);
+        // Note: Requests that are already waiting go first.
+        if (!m_free_command_ids.is_empty() && m_deferred_ios.is_empty()) {
+            auto cmdid = m_free_command_ids.take_last();
+            VERIFY(!m_requests[cmdid].request);
+            m_requests[cmdid].request = request;
+            return cmdid;
+        }
+        // Note: This has to happen under the request lock, so that a command identifier released in the meantime isn't missed.
+        if (!m_deferred_ios.try_append({ request, nsid, index, count }).is_error())
+            return {};
+    }
+    dbgln("NVMe: Could not defer a request on queue {}", m_qid);
+    request.complete(AsyncDeviceRequest::Failure);
+    return {};
+}
+
+bool NVMeQueue::is_command_outstanding(u16 cmdid)
+{
+    SpinlockLocker lock(m_request_lock);
+    return !m_requests[cmdid].request.is_null();
+}
+
+void NVMeQueue::end_io(u16 cmdid, u16 status)
+{
+    RefPtr<AsyncBlockDeviceRequest> request;
+    {
+        SpinlockLocker lock(m_request_lock);
+        VERIFY(cmdid < m_requests.size());
+        request = m_requests[cmdid].request;
+    }
+    VERIFY(request);
+
+    auto result = AsyncDeviceRequest::Success;
+    if (status) {
+        result = AsyncDeviceRequest::Failure;
+    } else if (request->request_type() == AsyncBlockDeviceRequest::RequestType::Read) {
+        if (auto copy_result = request->write_to_buffer(request->buffer(), rw_dma_buffer(cmdid), 512 * request->block_count()); copy_result.is_error())
+            result = AsyncDeviceRequest::MemoryFault;
+    }
+
+    // The command identifier (and its DMA page) can only be handed out again once the data has been copied out.
+    release_command_id(cmdid);
+    request->complete(result);
+    submit_deferred_ios();
+}
+
+void NVMeQueue::release_command_id(u16 cmdid)
+{
+    SpinlockLocker lock(m_request_lock);
+    m_requests[cmdid].request = nullptr;
+    m_free_command_ids.unchecked_append(cmdid);
+}
+
+void NVMeQueue::submit_deferred_ios()
+{
+    // Note: On a poll queue, submitting a request also completes it (and possibly others), which ends up back here.
+    //       Only one caller drains the deferred requests at a time, so that this loop doesn't turn into a recursion
+    //       as deep as the list of deferred requests. Any command identifier released in the meantime is picked up
+    //       by the next iteration.
+    while (true) {
+        u16 cmdid;
+        Optional<NVMeDeferredIO> deferred_io;
+        {
+            SpinlockLocker lock(m_request_lock);
+            if (m_submitting_deferred_ios)
+                return;
+            if (m_deferred_ios.is_empty() || m_free_command_ids.is_empty())
+                return;
+            m_submitting_deferred_ios = true;
+            cmdid = m_free_command_ids.take_last();
+            deferred_io = m_deferred_ios.take_first();
+            VERIFY(!m_requests[cmdid].request);
+            m_requests[cmdid].request = deferred_io->request;
+        }
+        submit_io(cmdid, deferred_io->request, deferred_io->nsid, deferred_io->index, deferred_io->count);
+        SpinlockLocker lock(m_request_lock);
+        m_submitting_deferred_ios = false;
+    }
+}
+
 void NVMeQueue::submit_sqe(NVMeSubmission& sub)
 {
     SpinlockLocker lock(m_sq_lock);
-    // For now let's use sq tail as a unique command id.
-    sub.cmdid = m_sq_tail;
-    m_prev_sq_tail = m_sq_tail;
 
     memcpy(&m_sqe_array[m_sq_tail], &sub, sizeof(NVMeSubmission));
     {
@@ -113,9 +202,11 @@ void NVMeQueue::submit_sqe(NVMeSubmission& sub)
 
 u16 NVMeQueue::submit_sync_sqe(NVMeSubmission& sub)
 {
-    // For now let's use sq tail as a unique command id.
+    // Synchronous commands are only used on the admin queue, one at a time,
+    // so the sq tail is a unique command id.
     u16 cqe_cid;
     u16 cid = m_sq_tail;
+    sub.cmdid = cid;
 
     submit_sqe(sub);
     do {
@@ -136,37 +227,41 @@ u16 NVMeQueue::submit_sync_sqe(NVMeSubmission& sub)
 
 void NVMeQueue::read(AsyncBlockDeviceRequest& request, u16 nsid, u64 index, u32 count)
 {
-    NVMeSubmission sub {};
-    SpinlockLocker m_lock(m_request_lock);
-    m_current_request = request;
-
-    sub.op = OP_NVME_READ;
-    sub.rw.nsid = nsid;
-    sub.rw.slba = AK::convert_between_host_and_little_endian(index);
-    // No. of lbas is 0 based
-    sub.rw.length = AK::convert_between_host_and_little_endian((count - 1) & 0xFFFF);
-    sub.rw.data_ptr.prp1 = reinterpret_cast<u64>(AK::convert_between_host_and_little_endian(m_rw_dma_page->paddr().as_ptr()));
-
-    full_memory_barrier();
-    submit_sqe(sub);
+    if (auto cmdid = allocate_command_id_or_defer(request, nsid, index, count); cmdid.has_value())
+        submit_io(cmdid.value(), request, nsid, index, count);
+    else
+        submit_deferred_ios();
 }
 
 void NVMeQueue::write(AsyncBlockDeviceRequest& request, u16 nsid, u64 index, u32 count)
 {
-    NVMeSubmission sub {};
-    SpinlockLocker m_lock(m_request_lock);
-    m_current_request = request;
+    if (auto cmdid = allocate_command_id_or_defer(request, nsid, index, count); cmdid.has_value())
+        submit_io(cmdid.value(), request, nsid, index, count);
+    else
+        submit_deferred_ios();
+}
 
-    if (auto result = m_current_request->read_from_buffer(m_current_request->buffer(), m_rw_dma_region->vaddr().as_ptr(), 512 * m_current_request->block_count()); result.is_error()) {
-        complete_current_request(AsyncDeviceRequest::MemoryFault);
-        return;
+void NVMeQueue::submit_io(u16 cmdid, AsyncBlockDeviceRequest& request, u16 nsid, u64 index, u32 count)
+{
+    NVMeSubmission sub {};
+    if (request.request_type() == AsyncBlockDeviceRequest::RequestType::Read) {
+        sub.op = OP_NVME_READ;
+    } else {
+        if (auto result = request.read_from_buffer(request.buffer(), rw_dma_buffer(cmdid), 512 * request.block_count()); result.is_error()) {
+            NonnullRefPtr<AsyncBlockDeviceRequest> protect_request = request;
+            release_command_id(cmdid);
+            request.complete(AsyncDeviceRequest::MemoryFault);
+            submit_deferred_ios();
+            return;
+        }
+        sub.op = OP_NVME_WRITE;
     }
-    sub.op = OP_NVME_WRITE;
+    sub.cmdid = cmdid;
     sub.rw.nsid = nsid;
     sub.rw.slba = AK::convert_between_host_and_little_endian(index);
     // No. of lbas is 0 based
     sub.rw.length = AK::convert_between_host_and_little_endian((count - 1) & 0xFFFF);
-    sub.rw.data_ptr.prp1 = reinterpret_cast<u64>(AK::convert_between_host_and_little_endian(m_rw_dma_page->paddr().as_ptr()));
+    sub.rw.data_ptr.prp1 = reinterpret_cast<u64>(AK::convert_between_host_and_little_endian(rw_dma_address(cmdid).as_ptr()));
 
     full_memory_barrier();
     submit_sqe(sub);
@@ -27,6 +27,21 @@ struct DoorbellRegister {
 };
 
 class AsyncBlockDeviceRequest;
+
+// An IO command that has been submitted to the controller and not yet completed.
+// The command identifier is the index of the entry in NVMeQueue::m_requests.
+struct NVMeIO {
+    RefPtr<AsyncBlockDeviceRequest> request;
+};
+
+// An IO request that is waiting for a command identifier to become free.
+struct NVMeDeferredIO {
+    NonnullRefPtr<AsyncBlockDeviceRequest> request;
+    u16 nsid;
+    u64 index;
+    u32 count;
+};
+
 class NVMeQueue : public RefCounted<NVMeQueue> {
 public:
     static ErrorOr<NonnullRefPtr<NVMeQueue>> try_create(u16 qid, Optional<u8> irq, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> cq_dma_page, OwnPtr<Memory::Region> sq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> sq_dma_page, Memory::TypedMapping<volatile DoorbellRegister> db_regs);
@@ -37,34 +52,43 @@ public:
     virtual void submit_sqe(NVMeSubmission&);
     virtual ~NVMeQueue();
 
+    // One submission queue slot is always left empty, so that a full queue can be told apart from an empty one.
+    size_t max_outstanding_commands() const { return m_qdepth - 1; }
+
 protected:
     u32 process_cq();
     void update_sq_doorbell()
     {
         m_db_regs->sq_tail = m_sq_tail;
     }
-    NVMeQueue(NonnullOwnPtr<Memory::Region> rw_dma_region, Memory::PhysicalPage const& rw_dma_page, u16 qid, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> cq_dma_page, OwnPtr<Memory::Region> sq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> sq_dma_page, Memory::TypedMapping<volatile DoorbellRegister> db_regs);
+    NVMeQueue(OwnPtr<Memory::Region> rw_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> rw_dma_pages, u16 qid, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> cq_dma_page, OwnPtr<Memory::Region> sq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> sq_dma_page, Memory::TypedMapping<volatile DoorbellRegister> db_regs);
+
+    bool is_command_outstanding(u16 cmdid);
+    void end_io(u16 cmdid, u16 status);
 
 private:
     bool cqe_available();
     void update_cqe_head();
-    virtual void complete_current_request(u16 status) = 0;
+    virtual void complete_request(u16 cmdid, u16 status) = 0;
     void update_cq_doorbell()
     {
         m_db_regs->cq_head = m_cq_head;
     }
+    Optional<u16> allocate_command_id_or_defer(AsyncBlockDeviceRequest&, u16 nsid, u64 index, u32 count);
+    void release_command_id(u16 cmdid);
+    void submit_deferred_ios();
+    void submit_io(u16 cmdid, AsyncBlockDeviceRequest&, u16 nsid, u64 index, u32 count);
+    u8* rw_dma_buffer(u16 cmdid) { return m_rw_dma_region->vaddr().offset(cmdid * PAGE_SIZE).as_ptr(); }
+    PhysicalAddress rw_dma_address(u16 cmdid) const { return m_rw_dma_pages[cmdid].paddr(); }
 
 protected:
     Spinlock m_cq_lock { LockRank::Interrupts };
-    RefPtr<AsyncBlockDeviceRequest> m_current_request;
-    NonnullOwnPtr<Memory::Region> m_rw_dma_region;
     Spinlock m_request_lock;
 
 private:
     u16 m_qid {};
     u8 m_cq_valid_phase { 1 };
     u16 m_sq_tail {};
-    u16 m_prev_sq_tail {};
     u16 m_cq_head {};
     bool m_admin_queue { false };
     u32 m_qdepth {};
@@ -76,6 +100,13 @@ private:
     NonnullRefPtrVector<Memory::PhysicalPage> m_sq_dma_page;
     Span<NVMeCompletion> m_cqe_array;
     Memory::TypedMapping<volatile DoorbellRegister> m_db_regs;
-    NonnullRefPtr<Memory::PhysicalPage> m_rw_dma_page;
+    // IO queues have one DMA page per command identifier, so every outstanding command has its own buffer.
+    OwnPtr<Memory::Region> m_rw_dma_region;
+    NonnullRefPtrVector<Memory::PhysicalPage> m_rw_dma_pages;
+    Vector<NVMeIO> m_requests;
+    Vector<u16> m_free_command_ids;
+    // Requests only wait here while every command identifier is in use; they are submitted oldest first once one is released.
+    Vector<NVMeDeferredIO> m_deferred_ios;
+    bool m_submitting_deferred_ios { false };
 };
 }
@@ -27,36 +27,78 @@ StringView StorageDevice::class_name() const
     return "StorageDevice"sv;
 }
 
-ErrorOr<size_t> StorageDevice::read(OpenFileDescription&, u64 offset, UserOrKernelBuffer& outbuf, size_t len)
+size_t StorageDevice::max_blocks_per_transfer() const
 {
-    u64 index = offset >> block_size_log();
-    size_t whole_blocks = len >> block_size_log();
-    size_t remaining = len - (whole_blocks << block_size_log());
+    return max_blocks_per_request() * max_outstanding_requests();
+}
 
-    // PATAChannel will chuck a wobbly if we try to read more than PAGE_SIZE
-    // at a time, because it uses a single page for its DMA buffer.
-    if (whole_blocks >= m_blocks_per_page) {
-        whole_blocks = m_blocks_per_page;
-        remaining = 0;
-    }
+ErrorOr<void> StorageDevice::transfer_whole_blocks(AsyncBlockDeviceRequest::RequestType request_type, u64 index, size_t block_count, UserOrKernelBuffer const& buffer)
+{
+    // Note: Callers (e.g. the write-behind in BlockBasedFileSystem) hand us long runs of adjacent blocks in one go.
+    // We split them into as few requests as the device allows, and queue as many of those as it can take at once.
+    auto blocks_per_transfer = max_blocks_per_transfer();
+    for (size_t block = 0; block < block_count; block += blocks_per_transfer)
+        TRY(transfer_whole_blocks_at_once(request_type, index + block, min(blocks_per_transfer, block_count - block), buffer.offset(block * block_size())));
+    return {};
+}
 
-    dbgln_if(STORAGE_DEVICE_DEBUG, "StorageDevice::read() index={}, whole_blocks={}, remaining={}", index, whole_blocks, remaining);
+ErrorOr<void> StorageDevice::transfer_whole_blocks_at_once(AsyncBlockDeviceRequest::RequestType request_type, u64 index, size_t block_count, UserOrKernelBuffer const& buffer)
+{
+    auto blocks_per_request = max_blocks_per_request();
+    Vector<NonnullRefPtr<AsyncBlockDeviceRequest>> requests;
+    TRY(requests.try_ensure_capacity(ceil_div(block_count, blocks_per_request)));
+
+    // Note: All requests are queued before we wait for any of them, so that a device
+    // which can handle several requests at once (e.g. an AHCI port with NCQ) sees all of them.
+    ErrorOr<void> result {};
+    for (size_t block = 0; block < block_count; block += blocks_per_request) {
+        auto request_block_count = min(blocks_per_request, block_count - block);
+        auto request_or_error = try_make_request<AsyncBlockDeviceRequest>(request_type, index + block, request_block_count, buffer.offset(block * block_size()), request_block_count * block_size());
+        if (request_or_error.is_error()) {
+            result = request_or_error.release_error();
+            break;
+        }
+        requests.unchecked_append(request_or_error.release_value());
+    }
 
-    if (whole_blocks > 0) {
-        auto read_request = TRY(try_make_request<AsyncBlockDeviceRequest>(AsyncBlockDeviceRequest::Read, index, whole_blocks, outbuf, whole_blocks * block_size()));
-        auto result = read_request->wait();
-        if (result.wait_result().was_interrupted())
-            return EINTR;
-        switch (result.request_result()) {
+    // Note: Every request refers to the caller's buffer, so we have to wait for all of them to complete,
+    //       even after one failed or a signal interrupted the wait.
+    bool was_interrupted = false;
+    for (auto& request : requests) {
+        auto request_result = request->wait();
+        while (request_result.wait_result().was_interrupted()) {
+            was_interrupted = true;
+            request_result = request->wait();
+        }
+        if (result.is_error())
+            continue;
+        switch (request_result.request_result()) {
         case AsyncDeviceRequest::Failure:
         case AsyncDeviceRequest::Cancelled:
-            return EIO;
+            result = EIO;
+            break;
         case AsyncDeviceRequest::MemoryFault:
-            return EFAULT;
+            result = EFAULT;
+            break;
         default:
             break;
         }
     }
+    if (was_interrupted && !result.is_error())
+        return EINTR;
+    return result;
+}
+
+ErrorOr<size_t> StorageDevice::read(OpenFileDescription&, u64 offset, UserOrKernelBuffer& outbuf, size_t len)
+{
+    u64 index = offset >> block_size_log();
+    size_t whole_blocks = len >> block_size_log();
+    size_t remaining = len - (whole_blocks << block_size_log());
+
+    dbgln_if(STORAGE_DEVICE_DEBUG, "StorageDevice::read() index={}, whole_blocks={}, remaining={}", index, whole_blocks, remaining);
+
+    if (whole_blocks > 0)
+        TRY(transfer_whole_blocks(AsyncBlockDeviceRequest::Read, index, whole_blocks, outbuf));
 
     off_t pos = whole_blocks * block_size();
 
@@ -95,13 +137,6 @@ ErrorOr<size_t> StorageDevice::write(OpenFileDescription&, u64 offset, const Use
     size_t whole_blocks = len >> block_size_log();
     size_t remaining = len - (whole_blocks << block_size_log());
 
-    // PATAChannel will chuck a wobbly if we try to write more than PAGE_SIZE
-    // at a time, because it uses a single page for its DMA buffer.
-    if (whole_blocks >= m_blocks_per_page) {
-        whole_blocks = m_blocks_per_page;
-        remaining = 0;
-    }
-
     // We try to allocate the temporary block buffer for partial writes *before* we start any full block writes,
     // to try and prevent partial writes
     Optional<ByteBuffer> partial_write_block;
@@ -110,21 +145,8 @@ ErrorOr<size_t> StorageDevice::write(OpenFileDescription&, u64 offset, const Use
 
     dbgln_if(STORAGE_DEVICE_DEBUG, "StorageDevice::write() index={}, whole_blocks={}, remaining={}", index, whole_blocks, remaining);
 
-    if (whole_blocks > 0) {
-        auto write_request = TRY(try_make_request<AsyncBlockDeviceRequest>(AsyncBlockDeviceRequest::Write, index, whole_blocks, inbuf, whole_blocks * block_size()));
-        auto result = write_request->wait();
-        if (result.wait_result().was_interrupted())
-            return EINTR;
-        switch (result.request_result()) {
-        case AsyncDeviceRequest::Failure:
-        case AsyncDeviceRequest::Cancelled:
-            return EIO;
-        case AsyncDeviceRequest::MemoryFault:
-            return EFAULT;
-        default:
-            break;
-        }
-    }
+    if (whole_blocks > 0)
+        TRY(transfer_whole_blocks(AsyncBlockDeviceRequest::Write, index, whole_blocks, inbuf));
 
     off_t pos = whole_blocks * block_size();
 
@@ -36,6 +36,10 @@ public:
 public:
     virtual u64 max_addressable_block() const { return m_max_addressable_block; }
 
+    // Reads and writes larger than this are split into several requests, which are
+    // handed to the device all at once so it can work on them concurrently.
+    virtual size_t max_blocks_per_request() const { return m_blocks_per_page; }
+
     // ^BlockDevice
     virtual ErrorOr<size_t> read(OpenFileDescription&, u64, UserOrKernelBuffer&, size_t) override;
     virtual bool can_read(const OpenFileDescription&, u64) const override;
@@ -61,6 +65,10 @@ protected:
     virtual StringView class_name() const override;
 
 private:
+    size_t max_blocks_per_transfer() const;
+    ErrorOr<void> transfer_whole_blocks(AsyncBlockDeviceRequest::RequestType, u64 index, size_t block_count, UserOrKernelBuffer const&);
+    ErrorOr<void> transfer_whole_blocks_at_once(AsyncBlockDeviceRequest::RequestType, u64 index, size_t block_count, UserOrKernelBuffer const&);
+
     mutable IntrusiveListNode<StorageDevice, RefPtr<StorageDevice>> m_list_node;
     NonnullRefPtrVector<DiskPartition> m_partitions;
 
@@ -14,7 +14,9 @@
 #include <Kernel/Process.h>
 #include <Kernel/Scheduler.h>
 #include <Kernel/Sections.h>
+#include <Kernel/SyscallStatistics.h>
 #include <Kernel/ThreadTracer.h>
+#include <Kernel/Time/TimeManagement.h>
 
 namespace Kernel {
 
@@ -124,6 +126,14 @@ ErrorOr<FlatPtr> handle(RegisterState& regs, FlatPtr function, FlatPtr arg1, Fla
         return ENOSYS;
     }
 
+    // NOTE: We measure from before we take the big lock, as waiting for it is part of the syscall's latency.
+    SyscallStatistics* statistics = nullptr;
+    Time start_time;
+    if (g_syscall_statistics_enabled.load(AK::MemoryOrder::memory_order_relaxed) && function != SC_exit && function != SC_exit_thread) {
+        statistics = process.ensure_syscall_statistics();
+        start_time = TimeManagement::the().monotonic_time(TimePrecision::Precise);
+    }
+
     MutexLocker mutex_locker;
     const auto needs_big_lock = syscall_metadata.needs_lock == NeedsBigProcessLock::Yes;
     if (needs_big_lock) {
@@ -159,6 +169,11 @@ ErrorOr<FlatPtr> handle(RegisterState& regs, FlatPtr function, FlatPtr arg1, Fla
         result = (process.*(syscall_metadata.handler))(arg1, arg2, arg3, arg4);
     }
 
+    if (statistics) {
+        auto latency = TimeManagement::the().monotonic_time(TimePrecision::Precise) - start_time;
+        statistics->add(static_cast<Function>(function), static_cast<u64>(max<i64>(latency.to_nanoseconds(), 0)));
+    }
+
     return result;
 }
 
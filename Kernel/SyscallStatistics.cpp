@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/BuiltinWrappers.h>
+#include <AK/JsonArraySerializer.h>
+#include <AK/JsonObjectSerializer.h>
+#include <Kernel/KBufferBuilder.h>
+#include <Kernel/SyscallStatistics.h>
+
+namespace Kernel {
+
+Atomic<bool> g_syscall_statistics_enabled { false };
+
+ErrorOr<NonnullOwnPtr<SyscallStatistics>> SyscallStatistics::try_create()
+{
+    return adopt_nonnull_own_or_enomem(new (nothrow) SyscallStatistics);
+}
+
+static size_t histogram_bucket_for(u64 latency_ns)
+{
+    auto latency_us = latency_ns / 1000;
+    if (latency_us == 0)
+        return 0;
+    // Bucket n covers [2^(n-1), 2^n) microseconds.
+    auto bucket = static_cast<size_t>(sizeof(u64) * 8 - count_leading_zeroes(latency_us));
+    return min(bucket, SyscallStatistics::histogram_bucket_count - 1);
+}
+
+void SyscallStatistics::add(Syscall::Function function, u64 latency_ns)
+{
+    VERIFY(function < Syscall::Function::__Count);
+    auto& entry = m_entries[function];
+    entry.count++;
+    entry.total_ns += latency_ns;
+    entry.histogram[histogram_bucket_for(latency_ns)]++;
+
+    auto max_ns = entry.max_ns.load();
+    while (latency_ns > max_ns) {
+        if (entry.max_ns.compare_exchange_strong(max_ns, latency_ns))
+            break;
+    }
+}
+
+ErrorOr<void> SyscallStatistics::to_json(KBufferBuilder& builder) const
+{
+    JsonArraySerializer array { builder };
+    for (size_t function = 0; function < m_entries.size(); ++function) {
+        auto const& entry = m_entries[function];
+        auto count = entry.count.load();
+        if (count == 0)
+            continue;
+        auto object = array.add_object();
+        object.add("name", Syscall::to_string(static_cast<Syscall::Function>(function)));
+        object.add("count", count);
+        object.add("total_ns", entry.total_ns.load());
+        object.add("max_ns", entry.max_ns.load());
+        auto histogram = object.add_array("histogram");
+        for (auto const& bucket : entry.histogram)
+            histogram.add(bucket.load());
+        histogram.finish();
+        object.finish();
+    }
+    array.finish();
+    return {};
+}
+
+}
@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Array.h>
+#include <AK/Atomic.h>
+#include <AK/Error.h>
+#include <AK/NonnullOwnPtr.h>
+#include <Kernel/API/Syscall.h>
+
+namespace Kernel {
+
+class KBufferBuilder;
+
+// Controlled by /proc/sys/syscall_statistics. Accounting is off by default, as it needs a precise
+// timestamp around every syscall.
+extern Atomic<bool> g_syscall_statistics_enabled;
+
+// Per-process counts and latency histograms of every syscall, exposed as /proc/<pid>/syscalls.
+class SyscallStatistics {
+    AK_MAKE_NONCOPYABLE(SyscallStatistics);
+    AK_MAKE_NONMOVABLE(SyscallStatistics);
+
+public:
+    // Bucket 0 counts syscalls that took less than 1 microsecond, and every following bucket
+    // covers twice the range of the one before it. The last one counts everything slower.
+    static constexpr size_t histogram_bucket_count = 24;
+
+    static ErrorOr<NonnullOwnPtr<SyscallStatistics>> try_create();
+
+    void add(Syscall::Function, u64 latency_ns);
+    ErrorOr<void> to_json(KBufferBuilder&) const;
+
+private:
+    SyscallStatistics() = default;
+
+    struct Entry {
+        Atomic<u64, AK::MemoryOrder::memory_order_relaxed> count { 0 };
+        Atomic<u64, AK::MemoryOrder::memory_order_relaxed> total_ns { 0 };
+        Atomic<u64, AK::MemoryOrder::memory_order_relaxed> max_ns { 0 };
+        Array<Atomic<u64, AK::MemoryOrder::memory_order_relaxed>, histogram_bucket_count> histogram {};
+    };
+
+    Array<Entry, Syscall::Function::__Count> m_entries {};
+};
+
+}
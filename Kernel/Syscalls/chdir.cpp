@@ -15,7 +15,9 @@ ErrorOr<FlatPtr> Process::sys$chdir(Userspace<const char*> user_path, size_t pat
     VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this);
     TRY(require_promise(Pledge::rpath));
     auto path = TRY(get_syscall_path_argument(user_path, path_length));
-    m_cwd = TRY(VirtualFileSystem::the().open_directory(path->view(), current_directory()));
+    RefPtr<Custody> new_directory = TRY(VirtualFileSystem::the().open_directory(path->view(), current_directory()));
+    // NOTE: The previous directory is released after we drop the spinlock.
+    m_current_directory.with([&](auto& current_directory) { swap(current_directory, new_directory); });
     return 0;
 }
 
@@ -28,7 +30,8 @@ ErrorOr<FlatPtr> Process::sys$fchdir(int fd)
         return ENOTDIR;
     if (!description->metadata().may_execute(*this))
         return EACCES;
-    m_cwd = description->custody();
+    RefPtr<Custody> new_directory = description->custody();
+    m_current_directory.with([&](auto& current_directory) { swap(current_directory, new_directory); });
     return 0;
 }
 
@@ -40,7 +43,7 @@ ErrorOr<FlatPtr> Process::sys$getcwd(Userspace<char*> buffer, size_t size)
     if (size > NumericLimits<ssize_t>::max())
         return EINVAL;
 
-    auto path = TRY(current_directory().try_serialize_absolute_path());
+    auto path = TRY(current_directory()->try_serialize_absolute_path());
     size_t ideal_size = path->length() + 1;
     auto size_to_copy = min(ideal_size, size);
     TRY(copy_to_user(buffer, path->characters(), size_to_copy));
@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/ScopeGuard.h>
+#include <Kernel/Debug.h>
+#include <Kernel/FileSystem/EPoll.h>
+#include <Kernel/FileSystem/OpenFileDescription.h>
+#include <Kernel/Process.h>
+
+namespace Kernel {
+
+using BlockFlags = Thread::FileBlocker::BlockFlags;
+
+ErrorOr<FlatPtr> Process::sys$epoll_create(int flags)
+{
+    VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this)
+    TRY(require_promise(Pledge::stdio));
+
+    if ((flags & EPOLL_CLOEXEC) != flags)
+        return EINVAL;
+
+    auto fd_allocation = TRY(allocate_fd());
+    auto epoll = TRY(EPoll::try_create());
+    auto description = TRY(OpenFileDescription::try_create(move(epoll)));
+    description->set_readable(true);
+
+    return m_fds.with_exclusive([&](auto& fds) -> ErrorOr<FlatPtr> {
+        fds[fd_allocation.fd].set(move(description), (flags & EPOLL_CLOEXEC) ? FD_CLOEXEC : 0);
+        return fd_allocation.fd;
+    });
+}
+
+ErrorOr<FlatPtr> Process::sys$epoll_ctl(int epoll_fd, int op, int fd, Userspace<const epoll_event*> user_event)
+{
+    VERIFY_NO_PROCESS_BIG_LOCK(this)
+    TRY(require_promise(Pledge::stdio));
+
+    auto epoll_description = TRY(open_file_description(epoll_fd));
+    if (!epoll_description->is_epoll())
+        return EINVAL;
+    auto& epoll = *epoll_description->epoll();
+
+    // NOTE: Removing an fd doesn't need it to be open anymore.
+    if (op == EPOLL_CTL_DEL) {
+        TRY(epoll.remove(fd));
+        return 0;
+    }
+
+    auto event = TRY(copy_typed_from_user(user_event));
+    auto description = TRY(open_file_description(fd));
+    // FIXME: Support watching an EPoll from another one. This needs loop detection.
+    if (description->is_epoll())
+        return EINVAL;
+
+    switch (op) {
+    case EPOLL_CTL_ADD:
+        TRY(epoll.add(fd, *description, event));
+        return 0;
+    case EPOLL_CTL_MOD:
+        TRY(epoll.modify(fd, *description, event));
+        return 0;
+    default:
+        return EINVAL;
+    }
+}
+
+ErrorOr<FlatPtr> Process::sys$epoll_wait(Userspace<const Syscall::SC_epoll_wait_params*> user_params)
+{
+    VERIFY_NO_PROCESS_BIG_LOCK(this)
+    TRY(require_promise(Pledge::stdio));
+
+    auto params = TRY(copy_typed_from_user(user_params));
+    if (params.max_events <= 0)
+        return EINVAL;
+
+    auto epoll_description = TRY(open_file_description(params.epoll_fd));
+    if (!epoll_description->is_epoll())
+        return EINVAL;
+    auto& epoll = *epoll_description->epoll();
+
+    Optional<Time> timeout_time;
+    if (params.timeout)
+        timeout_time = TRY(copy_time_from_user(params.timeout));
+
+    sigset_t sigmask = {};
+    if (params.sigmask)
+        TRY(copy_from_user(&sigmask, params.sigmask));
+
+    // NOTE: There can't be more ready events than open file descriptions.
+    size_t max_events = min(static_cast<size_t>(params.max_events), OpenFileDescriptions::max_open());
+    Vector<epoll_event> events;
+    TRY(events.try_resize(max_events));
+
+    auto* current_thread = Thread::current();
+
+    u32 previous_signal_mask = 0;
+    if (params.sigmask)
+        previous_signal_mask = current_thread->update_signal_mask(sigmask);
+    ScopeGuard rollback_signal_mask([&]() {
+        if (params.sigmask)
+            current_thread->update_signal_mask(previous_signal_mask);
+    });
+
+    // NOTE: We may be woken up for files that turn out not to be ready after all,
+    //       so the timeout has to be absolute for us to be able to block again.
+    Thread::BlockTimeout timeout;
+    if (timeout_time.has_value())
+        timeout = Thread::BlockTimeout(false, &timeout_time.value());
+
+    for (;;) {
+        auto event_count = TRY(epoll.collect_ready_events(events.span()));
+        if (event_count > 0) {
+            TRY(copy_to_user(params.events, events.data(), event_count * sizeof(epoll_event)));
+            return event_count;
+        }
+        if (timeout_time.has_value() && timeout_time.value().is_zero())
+            return 0;
+
+        dbgln_if(POLL_SELECT_DEBUG, "epoll_wait: blocking on fd {}, timeout={}", params.epoll_fd, params.timeout);
+
+        Thread::SelectBlocker::FDVector fds_info;
+        fds_info.unchecked_append({ epoll_description, BlockFlags::Read });
+        auto block_result = current_thread->block<Thread::SelectBlocker>(timeout, fds_info);
+        if (block_result.was_interrupted())
+            return EINTR;
+        if (block_result == Thread::BlockResult::InterruptedByTimeout)
+            return 0;
+    }
+}
+
+}
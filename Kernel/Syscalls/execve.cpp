@@ -42,8 +42,8 @@ struct LoadResult {
     WeakPtr<Memory::Region> stack_region;
 };
 
-static constexpr size_t auxiliary_vector_size = 15;
-static Array<ELF::AuxiliaryValue, auxiliary_vector_size> generate_auxiliary_vector(FlatPtr load_base, FlatPtr entry_eip, UserID uid, UserID euid, GroupID gid, GroupID egid, StringView executable_path, Optional<Process::ScopedDescriptionAllocation> const& main_program_fd_allocation);
+static constexpr size_t auxiliary_vector_size = 16;
+static Array<ELF::AuxiliaryValue, auxiliary_vector_size> generate_auxiliary_vector(FlatPtr load_base, FlatPtr entry_eip, UserID uid, UserID euid, GroupID gid, GroupID egid, StringView executable_path, Optional<Process::ScopedDescriptionAllocation> const& main_program_fd_allocation, FlatPtr time_page_address);
 
 static bool validate_stack_size(NonnullOwnPtrVector<KString> const& arguments, NonnullOwnPtrVector<KString>& environment)
 {
@@ -480,6 +480,10 @@ ErrorOr<void> Process::do_exec(NonnullRefPtr<OpenFileDescription> main_program_d
     auto* signal_trampoline_region = TRY(load_result.space->allocate_region_with_vmobject(signal_trampoline_range, g_signal_trampoline_region->vmobject(), 0, "Signal trampoline", PROT_READ | PROT_EXEC, true));
     signal_trampoline_region->set_syscall_region(true);
 
+    // Every program gets the time page, so that LibC can read the clocks without any syscalls.
+    auto time_page_range = TRY(load_result.space->try_allocate_range({}, PAGE_SIZE));
+    auto* time_page_region = TRY(load_result.space->allocate_region_with_vmobject(time_page_range, TimeManagement::the().time_page_vmobject(), 0, "Kernel time page"sv, PROT_READ, true));
+
     // (For dynamically linked executable) Allocate an FD for passing the main executable to the dynamic loader.
     Optional<ScopedDescriptionAllocation> main_program_fd_allocation;
     if (has_interpreter)
@@ -561,7 +565,7 @@ ErrorOr<void> Process::do_exec(NonnullRefPtr<OpenFileDescription> main_program_d
     }
     VERIFY(new_main_thread);
 
-    auto auxv = generate_auxiliary_vector(load_result.load_base, load_result.entry_eip, uid(), euid(), gid(), egid(), path->view(), main_program_fd_allocation);
+    auto auxv = generate_auxiliary_vector(load_result.load_base, load_result.entry_eip, uid(), euid(), gid(), egid(), path->view(), main_program_fd_allocation, time_page_region->vaddr().get());
 
     // NOTE: We create the new stack before disabling interrupts since it will zero-fault
     //       and we don't want to deal with faults after this point.
@@ -638,7 +642,7 @@ ErrorOr<void> Process::do_exec(NonnullRefPtr<OpenFileDescription> main_program_d
     return {};
 }
 
-static Array<ELF::AuxiliaryValue, auxiliary_vector_size> generate_auxiliary_vector(FlatPtr load_base, FlatPtr entry_eip, UserID uid, UserID euid, GroupID gid, GroupID egid, StringView executable_path, Optional<Process::ScopedDescriptionAllocation> const& main_program_fd_allocation)
+static Array<ELF::AuxiliaryValue, auxiliary_vector_size> generate_auxiliary_vector(FlatPtr load_base, FlatPtr entry_eip, UserID uid, UserID euid, GroupID gid, GroupID egid, StringView executable_path, Optional<Process::ScopedDescriptionAllocation> const& main_program_fd_allocation, FlatPtr time_page_address)
 {
     return { {
         // PHDR/EXECFD
@@ -658,6 +662,7 @@ static Array<ELF::AuxiliaryValue, auxiliary_vector_size> generate_auxiliary_vect
         { ELF::AuxiliaryValue::HwCap, (long)CPUID(1).edx() },
 
         { ELF::AuxiliaryValue::ClockTick, (long)TimeManagement::the().ticks_per_second() },
+        { ELF::AuxiliaryValue::TimePage, (void*)time_page_address },
 
         // FIXME: Also take into account things like extended filesystem permissions? That's what linux does...
         { ELF::AuxiliaryValue::Secure, ((uid != euid) || (gid != egid)) ? 1 : 0 },
@@ -893,13 +898,16 @@ ErrorOr<FlatPtr> Process::sys$execve(Userspace<const Syscall::SC_execve_params*>
 
     auto* current_thread = Thread::current();
     if (current_thread == new_main_thread) {
-        // We need to enter the scheduler lock before changing the state
+        // We need to enter the context switch lock before changing the state
         // and it will be released after the context switch into that
         // thread. We should also still be in our critical section
-        VERIFY(!g_scheduler_lock.is_locked_by_current_processor());
+        VERIFY(!Scheduler::context_switch_lock().is_locked_by_current_processor());
         VERIFY(Processor::in_critical() == 1);
-        g_scheduler_lock.lock();
-        current_thread->set_state(Thread::State::Running);
+        Scheduler::context_switch_lock().lock();
+        {
+            SpinlockLocker scheduler_lock(g_scheduler_lock);
+            current_thread->set_state(Thread::State::Running);
+        }
         Processor::assume_context(*current_thread, prev_flags);
         VERIFY_NOT_REACHED();
     }
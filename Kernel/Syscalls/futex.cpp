@@ -11,24 +11,97 @@
 
 namespace Kernel {
 
+// The futexes of all processes share a single table. Each bucket of it has its own lock,
+// so that threads waiting on or waking up unrelated futexes rarely get in each other's way.
+struct FutexBucket {
+    Spinlock lock;
+    FutexQueue::BucketList queues;
+    // NOTE: This is only changed while holding the lock, but read without it.
+    //       That way, waking up a futex that nobody waits on takes no locks at all.
+    Atomic<size_t> queue_count { 0 };
+
+    RefPtr<FutexQueue> find_queue_locked(FutexKey const& key)
+    {
+        VERIFY(lock.is_locked());
+        for (auto& queue : queues) {
+            if (queue.key() == key)
+                return queue;
+        }
+        return {};
+    }
+
+    void add_queue_locked(FutexQueue& queue)
+    {
+        VERIFY(lock.is_locked());
+        queues.append(queue);
+        queue_count.fetch_add(1, AK::MemoryOrder::memory_order_relaxed);
+    }
+
+    void remove_queue_if_unused_locked(FutexQueue& queue)
+    {
+        VERIFY(lock.is_locked());
+        if (!queue.try_remove())
+            return;
+        queues.remove(queue);
+        queue_count.fetch_sub(1, AK::MemoryOrder::memory_order_relaxed);
+    }
+};
+
+static constexpr size_t futex_bucket_count = 256;
+static Singleton<Array<FutexBucket, futex_bucket_count>> s_futex_buckets;
+
+static FutexBucket& futex_bucket_for(FutexKey const& key)
+{
+    return (*s_futex_buckets)[key.hash() % futex_bucket_count];
+}
+
 void Process::clear_futex_queues_on_exec()
 {
-    SpinlockLocker lock(m_futex_lock);
-    for (auto& it : m_futex_queues) {
-        bool did_wake_all;
-        it.value->wake_all(did_wake_all);
-        VERIFY(did_wake_all); // No one should be left behind...
+    // The futexes of the new program must not end up in the queues of the old one, which are keyed on the same process.
+    for (auto& bucket : *s_futex_buckets) {
+        if (bucket.queue_count.load(AK::MemoryOrder::memory_order_relaxed) == 0)
+            continue;
+        SpinlockLocker lock(bucket.lock);
+        for (auto it = bucket.queues.begin(); it != bucket.queues.end();) {
+            auto& queue = *it;
+            ++it;
+            if (queue.key().object != this)
+                continue;
+            queue.wake_all();
+            queue.remove();
+            bucket.queues.remove(queue);
+            bucket.queue_count.fetch_sub(1, AK::MemoryOrder::memory_order_relaxed);
+        }
     }
-    m_futex_queues.clear();
+}
+
+ErrorOr<FutexKey> Process::futex_key_for(FlatPtr user_address, bool is_private, RefPtr<Memory::VMObject>* vmobject)
+{
+    if (user_address % alignof(u32) != 0)
+        return EINVAL;
+    // Private futexes can skip looking for the memory region, which is what most of them are.
+    if (is_private)
+        return FutexKey { this, user_address };
+
+    MutexLocker locker(address_space().mapping_lock());
+    auto* region = address_space().find_region_containing(Memory::VirtualRange { VirtualAddress(user_address), sizeof(u32) });
+    if (!region)
+        return EFAULT;
+    if (!region->is_shared())
+        return FutexKey { this, user_address };
+    if (vmobject)
+        *vmobject = region->vmobject();
+    return FutexKey { &region->vmobject(), region->offset_in_vmobject_from_vaddr(VirtualAddress(user_address)) };
 }
 
 ErrorOr<FlatPtr> Process::sys$futex(Userspace<const Syscall::SC_futex_params*> user_params)
 {
-    VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this);
+    VERIFY_NO_PROCESS_BIG_LOCK(this);
     auto params = TRY(copy_typed_from_user(user_params));
 
     Thread::BlockTimeout timeout;
     u32 cmd = params.futex_op & FUTEX_CMD_MASK;
+    bool is_private = (params.futex_op & FUTEX_PRIVATE_FLAG) != 0;
 
     bool use_realtime_clock = (params.futex_op & FUTEX_CLOCK_REALTIME) != 0;
     if (use_realtime_clock && cmd != FUTEX_WAIT && cmd != FUTEX_WAIT_BITSET) {
@@ -56,79 +129,72 @@ ErrorOr<FlatPtr> Process::sys$futex(Userspace<const Syscall::SC_futex_params*> u
     }
     }
 
-    auto find_futex_queue = [&](FlatPtr user_address, bool create_if_not_found, bool* did_create = nullptr) -> RefPtr<FutexQueue> {
-        VERIFY(!create_if_not_found || did_create != nullptr);
-        auto* queues = &m_futex_queues;
-        auto it = m_futex_queues.find(user_address);
-        if (it != m_futex_queues.end())
-            return it->value;
-        if (create_if_not_found) {
-            *did_create = true;
-            auto futex_queue = adopt_ref(*new FutexQueue);
-            auto result = queues->set(user_address, futex_queue);
-            VERIFY(result == AK::HashSetResult::InsertedNewEntry);
-            return futex_queue;
-        }
-        return {};
-    };
-
-    auto remove_futex_queue = [&](FlatPtr user_address) {
-        if (auto it = m_futex_queues.find(user_address); it != m_futex_queues.end()) {
-            if (it->value->try_remove()) {
-                m_futex_queues.remove(it);
-            }
-        }
-    };
-
-    auto do_wake = [&](FlatPtr user_address, u32 count, Optional<u32> bitmask) -> int {
+    auto do_wake = [&](FlatPtr user_address, u32 count, Optional<u32> bitmask) -> ErrorOr<FlatPtr> {
         if (count == 0)
             return 0;
-        SpinlockLocker locker(m_futex_lock);
-        auto futex_queue = find_futex_queue(user_address, false);
+        auto key = TRY(futex_key_for(user_address, is_private));
+        auto& bucket = futex_bucket_for(key);
+        // NOTE: This pairs with the fence in do_wait(). Either we see the queue of a thread about to wait,
+        //       or it sees the new futex value that userspace stored before asking us to wake it up.
+        atomic_thread_fence(AK::MemoryOrder::memory_order_seq_cst);
+        if (bucket.queue_count.load(AK::MemoryOrder::memory_order_relaxed) == 0)
+            return 0;
+
+        SpinlockLocker locker(bucket.lock);
+        auto futex_queue = bucket.find_queue_locked(key);
         if (!futex_queue)
             return 0;
-        bool is_empty;
-        u32 woke_count = futex_queue->wake_n(count, bitmask, is_empty);
-        if (is_empty) {
-            // If there are no more waiters, we want to get rid of the futex!
-            remove_futex_queue(user_address);
-        }
-        return (int)woke_count;
+        u32 woke_count = futex_queue->wake_n(count, bitmask);
+        // If there are no more waiters, we want to get rid of the futex!
+        bucket.remove_queue_if_unused_locked(*futex_queue);
+        return woke_count;
     };
 
     auto user_address = FlatPtr(params.userspace_address);
     auto user_address2 = FlatPtr(params.userspace_address2);
 
     auto do_wait = [&](u32 bitset) -> ErrorOr<FlatPtr> {
-        bool did_create;
+        RefPtr<Memory::VMObject> vmobject;
+        auto key = TRY(futex_key_for(user_address, is_private, &vmobject));
+        auto& bucket = futex_bucket_for(key);
+
+        // We let everyone know that we're about to wait before we look at the futex value,
+        // so that whoever changes it after we looked is going to wake us up.
         RefPtr<FutexQueue> futex_queue;
-        do {
-            auto user_value = user_atomic_load_relaxed(params.userspace_address);
-            if (!user_value.has_value())
-                return EFAULT;
-            if (user_value.value() != params.val) {
-                dbgln_if(FUTEX_DEBUG, "futex wait: EAGAIN. user value: {:p} @ {:p} != val: {}", user_value.value(), params.userspace_address, params.val);
-                return EAGAIN;
+        {
+            SpinlockLocker locker(bucket.lock);
+            futex_queue = bucket.find_queue_locked(key);
+            if (!futex_queue) {
+                futex_queue = TRY(adopt_nonnull_ref_or_enomem(new (nothrow) FutexQueue(key, move(vmobject))));
+                bucket.add_queue_locked(*futex_queue);
             }
-            atomic_thread_fence(AK::MemoryOrder::memory_order_acquire);
+            // NOTE: Queues are only removed while holding the bucket lock, so this one is still around.
+            bool did_queue_imminent_wait = futex_queue->queue_imminent_wait();
+            VERIFY(did_queue_imminent_wait);
+        }
+        atomic_thread_fence(AK::MemoryOrder::memory_order_seq_cst);
 
-            SpinlockLocker locker(m_futex_lock);
-            did_create = false;
-            futex_queue = find_futex_queue(user_address, true, &did_create);
-            VERIFY(futex_queue);
-            // We need to try again if we didn't create this queue and the existing queue
-            // was removed before we were able to queue an imminent wait.
-        } while (!did_create && !futex_queue->queue_imminent_wait());
+        auto user_value = user_atomic_load_relaxed(params.userspace_address);
+        if (!user_value.has_value() || user_value.value() != params.val) {
+            SpinlockLocker locker(bucket.lock);
+            futex_queue->cancel_imminent_wait();
+            bucket.remove_queue_if_unused_locked(*futex_queue);
+            if (!user_value.has_value())
+                return EFAULT;
+            dbgln_if(FUTEX_DEBUG, "futex wait: EAGAIN. user value: {:p} @ {:p} != val: {}", user_value.value(), params.userspace_address, params.val);
+            return EAGAIN;
+        }
+        atomic_thread_fence(AK::MemoryOrder::memory_order_acquire);
 
         // We must not hold the lock before blocking. But we have a reference
         // to the FutexQueue so that we can keep it alive.
 
         Thread::BlockResult block_result = futex_queue->wait_on(timeout, bitset);
 
-        SpinlockLocker locker(m_futex_lock);
-        if (futex_queue->is_empty_and_no_imminent_waits()) {
+        {
             // If there are no more waiters, we want to get rid of the futex!
-            remove_futex_queue(user_address);
+            SpinlockLocker locker(bucket.lock);
+            bucket.remove_queue_if_unused_locked(*futex_queue);
         }
         if (block_result == Thread::BlockResult::InterruptedByTimeout) {
             return ETIMEDOUT;
@@ -137,6 +203,10 @@ ErrorOr<FlatPtr> Process::sys$futex(Userspace<const Syscall::SC_futex_params*> u
     };
 
     auto do_requeue = [&](Optional<u32> val3) -> ErrorOr<FlatPtr> {
+        auto key = TRY(futex_key_for(user_address, is_private));
+        RefPtr<Memory::VMObject> target_vmobject;
+        auto target_key = TRY(futex_key_for(user_address2, is_private, &target_vmobject));
+
         auto user_value = user_atomic_load_relaxed(params.userspace_address);
         if (!user_value.has_value())
             return EFAULT;
@@ -144,25 +214,40 @@ ErrorOr<FlatPtr> Process::sys$futex(Userspace<const Syscall::SC_futex_params*> u
             return EAGAIN;
         atomic_thread_fence(AK::MemoryOrder::memory_order_acquire);
 
-        int woken_or_requeued = 0;
-        SpinlockLocker locker(m_futex_lock);
-        if (auto futex_queue = find_futex_queue(user_address, false)) {
-            RefPtr<FutexQueue> target_futex_queue;
-            bool is_empty, is_target_empty;
-            woken_or_requeued = futex_queue->wake_n_requeue(
-                params.val, [&]() -> FutexQueue* {
-                    // NOTE: futex_queue's lock is being held while this callback is called
-                    // The reason we're doing this in a callback is that we don't want to always
-                    // create a target queue, only if we actually have anything to move to it!
-                    target_futex_queue = find_futex_queue(user_address2, true);
-                    return target_futex_queue.ptr();
-                },
-                params.val2, is_empty, is_target_empty);
-            if (is_empty)
-                remove_futex_queue(user_address);
-            if (is_target_empty && target_futex_queue)
-                remove_futex_queue(user_address2);
-        }
+        auto& bucket = futex_bucket_for(key);
+        auto& target_bucket = futex_bucket_for(target_key);
+        // NOTE: We always take the bucket locks in the same order, so that two threads requeueing
+        //       between the same buckets in opposite directions can't deadlock.
+        auto* first_bucket = min(&bucket, &target_bucket);
+        auto* second_bucket = max(&bucket, &target_bucket);
+        SpinlockLocker first_locker(first_bucket->lock);
+        Optional<SpinlockLocker<Spinlock>> second_locker;
+        if (second_bucket != first_bucket)
+            second_locker.emplace(second_bucket->lock);
+
+        auto futex_queue = bucket.find_queue_locked(key);
+        if (!futex_queue)
+            return 0;
+
+        RefPtr<FutexQueue> target_futex_queue;
+        u32 woken_or_requeued = futex_queue->wake_n_requeue(
+            params.val, [&]() -> FutexQueue* {
+                // NOTE: futex_queue's lock is being held while this callback is called
+                // The reason we're doing this in a callback is that we don't want to always
+                // create a target queue, only if we actually have anything to move to it!
+                target_futex_queue = target_bucket.find_queue_locked(target_key);
+                if (!target_futex_queue) {
+                    target_futex_queue = adopt_ref_if_nonnull(new (nothrow) FutexQueue(target_key, move(target_vmobject)));
+                    if (!target_futex_queue)
+                        return nullptr;
+                    target_bucket.add_queue_locked(*target_futex_queue);
+                }
+                return target_futex_queue.ptr();
+            },
+            params.val2);
+        bucket.remove_queue_if_unused_locked(*futex_queue);
+        if (target_futex_queue)
+            target_bucket.remove_queue_if_unused_locked(*target_futex_queue);
         return woken_or_requeued;
     };
 
@@ -204,7 +289,7 @@ ErrorOr<FlatPtr> Process::sys$futex(Userspace<const Syscall::SC_futex_params*> u
         if (!oldval.has_value())
             return EFAULT;
         atomic_thread_fence(AK::MemoryOrder::memory_order_acquire);
-        auto result = do_wake(user_address, params.val, {});
+        auto result = TRY(do_wake(user_address, params.val, {}));
         if (params.val2 > 0) {
             bool compare_result;
             switch (_FUTEX_CMP(params.val3)) {
@@ -230,7 +315,7 @@ ErrorOr<FlatPtr> Process::sys$futex(Userspace<const Syscall::SC_futex_params*> u
                 return EINVAL;
             }
             if (compare_result)
-                result += do_wake(user_address2, params.val2, {});
+                result += TRY(do_wake(user_address2, params.val2, {}));
         }
         return result;
     }
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <Kernel/FileSystem/IORing.h>
+#include <Kernel/FileSystem/OpenFileDescription.h>
+#include <Kernel/Process.h>
+
+namespace Kernel {
+
+ErrorOr<FlatPtr> Process::sys$io_ring_setup(u32 entry_count, int flags, Userspace<io_ring_params*> user_params)
+{
+    VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this)
+    TRY(require_promise(Pledge::stdio));
+
+    if ((flags & IO_RING_CLOEXEC) != flags)
+        return EINVAL;
+
+    auto fd_allocation = TRY(allocate_fd());
+    auto ring = TRY(IORing::try_create(*this, entry_count));
+    TRY(copy_to_user(user_params, &ring->params()));
+    auto description = TRY(OpenFileDescription::try_create(move(ring)));
+    description->set_readable(true);
+
+    return m_fds.with_exclusive([&](auto& fds) -> ErrorOr<FlatPtr> {
+        fds[fd_allocation.fd].set(move(description), (flags & IO_RING_CLOEXEC) ? FD_CLOEXEC : 0);
+        return fd_allocation.fd;
+    });
+}
+
+ErrorOr<FlatPtr> Process::sys$io_ring_enter(int ring_fd, u32 to_submit, u32 min_complete, u32 flags)
+{
+    VERIFY_NO_PROCESS_BIG_LOCK(this)
+    TRY(require_promise(Pledge::stdio));
+
+    if ((flags & IO_RING_ENTER_GETEVENTS) != flags)
+        return EINVAL;
+
+    auto description = TRY(open_file_description(ring_fd));
+    if (!description->is_io_ring())
+        return EINVAL;
+    auto& ring = *description->io_ring();
+    if (!ring.is_owned_by(*this))
+        return EPERM;
+
+    size_t submitted = 0;
+    if (to_submit > 0)
+        submitted = TRY(ring.submit(to_submit));
+
+    for (;;) {
+        ring.complete_finished_file_requests();
+        ring.retry_woken_requests();
+        if (!(flags & IO_RING_ENTER_GETEVENTS))
+            break;
+        // NOTE: Whatever we took from the submission queue is gone now, so we can only report being
+        //       interrupted if we didn't take anything. Otherwise, the process would submit it again.
+        auto result = ring.wait_for_completions(min_complete);
+        if (result.is_error()) {
+            if (submitted > 0)
+                break;
+            return result.release_error();
+        }
+        if (ring.completions_available() >= min(static_cast<size_t>(min_complete), static_cast<size_t>(ring.params().cq_entries)))
+            break;
+    }
+    return submitted;
+}
+
+}
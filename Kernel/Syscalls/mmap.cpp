@@ -120,7 +120,7 @@ static bool validate_inode_mmap_prot(const Process& process, int prot, const Ino
 
 ErrorOr<FlatPtr> Process::sys$mmap(Userspace<const Syscall::SC_mmap_params*> user_params)
 {
-    VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this)
+    VERIFY_NO_PROCESS_BIG_LOCK(this)
     TRY(require_promise(Pledge::stdio));
     auto params = TRY(copy_typed_from_user(user_params));
 
@@ -167,6 +167,7 @@ ErrorOr<FlatPtr> Process::sys$mmap(Userspace<const Syscall::SC_mmap_params*> use
     bool map_noreserve = flags & MAP_NORESERVE;
     bool map_randomized = flags & MAP_RANDOMIZED;
     bool map_fixed_noreplace = flags & MAP_FIXED_NOREPLACE;
+    bool map_huge = flags & MAP_HUGE;
 
     if (map_shared && map_private)
         return EINVAL;
@@ -183,6 +184,17 @@ ErrorOr<FlatPtr> Process::sys$mmap(Userspace<const Syscall::SC_mmap_params*> use
     if (map_stack && (!map_private || !map_anonymous))
         return EINVAL;
 
+    if (map_huge && !map_anonymous)
+        return EINVAL;
+
+    // Large anonymous mappings transparently get huge pages when they fault, and MAP_HUGE asks for them
+    // regardless of size. Either way, the mapping has to be aligned to a huge page for that to work.
+    bool wants_huge_pages = map_huge || (map_anonymous && !map_stack && !map_noreserve && rounded_size >= Memory::huge_page_size);
+    if (wants_huge_pages)
+        alignment = max(alignment, Memory::huge_page_size);
+
+    MutexLocker mapping_locker(address_space().mapping_lock());
+
     Memory::Region* region = nullptr;
 
     auto range = TRY([&]() -> ErrorOr<Memory::VirtualRange> {
@@ -244,6 +256,8 @@ ErrorOr<FlatPtr> Process::sys$mmap(Userspace<const Syscall::SC_mmap_params*> use
         region->set_shared(true);
     if (map_stack)
         region->set_stack(true);
+    if (wants_huge_pages)
+        region->set_wants_huge_pages(true);
     region->set_name(move(name));
 
     PerformanceManager::add_mmap_perf_event(*this, *region);
@@ -253,7 +267,7 @@ ErrorOr<FlatPtr> Process::sys$mmap(Userspace<const Syscall::SC_mmap_params*> use
 
 ErrorOr<FlatPtr> Process::sys$mprotect(Userspace<void*> addr, size_t size, int prot)
 {
-    VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this)
+    VERIFY_NO_PROCESS_BIG_LOCK(this)
     TRY(require_promise(Pledge::stdio));
 
     if (prot & PROT_EXEC) {
@@ -267,6 +281,8 @@ ErrorOr<FlatPtr> Process::sys$mprotect(Userspace<void*> addr, size_t size, int p
     if (!is_user_range(range_to_mprotect))
         return EFAULT;
 
+    MutexLocker mapping_locker(address_space().mapping_lock());
+
     if (auto* whole_region = address_space().find_region_from_range(range_to_mprotect)) {
         if (!whole_region->is_mmap())
             return EPERM;
@@ -395,7 +411,7 @@ ErrorOr<FlatPtr> Process::sys$mprotect(Userspace<void*> addr, size_t size, int p
 
 ErrorOr<FlatPtr> Process::sys$madvise(Userspace<void*> address, size_t size, int advice)
 {
-    VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this)
+    VERIFY_NO_PROCESS_BIG_LOCK(this)
     TRY(require_promise(Pledge::stdio));
 
     auto range_to_madvise = TRY(Memory::expand_range_to_page_boundaries(address.ptr(), size));
@@ -406,6 +422,8 @@ ErrorOr<FlatPtr> Process::sys$madvise(Userspace<void*> address, size_t size, int
     if (!is_user_range(range_to_madvise))
         return EFAULT;
 
+    MutexLocker mapping_locker(address_space().mapping_lock());
+
     auto* region = address_space().find_region_from_range(range_to_madvise);
     if (!region)
         return EINVAL;
@@ -426,7 +444,7 @@ ErrorOr<FlatPtr> Process::sys$madvise(Userspace<void*> address, size_t size, int
 
 ErrorOr<FlatPtr> Process::sys$set_mmap_name(Userspace<const Syscall::SC_set_mmap_name_params*> user_params)
 {
-    VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this)
+    VERIFY_NO_PROCESS_BIG_LOCK(this)
     TRY(require_promise(Pledge::stdio));
     auto params = TRY(copy_typed_from_user(user_params));
 
@@ -436,6 +454,7 @@ ErrorOr<FlatPtr> Process::sys$set_mmap_name(Userspace<const Syscall::SC_set_mmap
     auto name = TRY(try_copy_kstring_from_user(params.name));
     auto range = TRY(Memory::expand_range_to_page_boundaries((FlatPtr)params.addr, params.size));
 
+    MutexLocker mapping_locker(address_space().mapping_lock());
     auto* region = address_space().find_region_from_range(range);
     if (!region)
         return EINVAL;
@@ -450,8 +469,9 @@ ErrorOr<FlatPtr> Process::sys$set_mmap_name(Userspace<const Syscall::SC_set_mmap
 
 ErrorOr<FlatPtr> Process::sys$munmap(Userspace<void*> addr, size_t size)
 {
-    VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this)
+    VERIFY_NO_PROCESS_BIG_LOCK(this)
     TRY(require_promise(Pledge::stdio));
+    MutexLocker mapping_locker(address_space().mapping_lock());
     TRY(address_space().unmap_mmap_range(addr.vaddr(), size));
     return 0;
 }
@@ -464,6 +484,8 @@ ErrorOr<FlatPtr> Process::sys$mremap(Userspace<const Syscall::SC_mremap_params*>
 
     auto old_range = TRY(Memory::expand_range_to_page_boundaries((FlatPtr)params.old_address, params.old_size));
 
+    MutexLocker mapping_locker(address_space().mapping_lock());
+
     auto* old_region = address_space().find_region_from_range(old_range);
     if (!old_region)
         return EINVAL;
@@ -520,17 +542,20 @@ ErrorOr<FlatPtr> Process::sys$allocate_tls(Userspace<const char*> initial_data,
     if (multiple_threads)
         return EINVAL;
 
-    auto range = TRY(address_space().try_allocate_range({}, size));
-    auto* region = TRY(address_space().allocate_region(range, "Master TLS"sv, PROT_READ | PROT_WRITE));
+    VirtualAddress master_tls_vaddr;
+    {
+        MutexLocker mapping_locker(address_space().mapping_lock());
+        auto range = TRY(address_space().try_allocate_range({}, size));
+        auto* region = TRY(address_space().allocate_region(range, "Master TLS"sv, PROT_READ | PROT_WRITE));
 
-    m_master_tls_region = region->make_weak_ptr();
-    m_master_tls_size = size;
-    m_master_tls_alignment = PAGE_SIZE;
+        m_master_tls_region = region->make_weak_ptr();
+        m_master_tls_size = size;
+        m_master_tls_alignment = PAGE_SIZE;
+        master_tls_vaddr = region->vaddr();
 
-    {
         Kernel::SmapDisabler disabler;
         void* fault_at;
-        if (!Kernel::safe_memcpy((char*)m_master_tls_region.unsafe_ptr()->vaddr().as_ptr(), (char*)initial_data.ptr(), size, fault_at))
+        if (!Kernel::safe_memcpy((char*)region->vaddr().as_ptr(), (char*)initial_data.ptr(), size, fault_at))
             return EFAULT;
     }
 
@@ -545,7 +570,7 @@ ErrorOr<FlatPtr> Process::sys$allocate_tls(Userspace<const char*> initial_data,
     fs_base_msr.set(main_thread->thread_specific_data().get());
 #endif
 
-    return m_master_tls_region.unsafe_ptr()->vaddr().get();
+    return master_tls_vaddr.get();
 }
 
 ErrorOr<FlatPtr> Process::sys$msyscall(Userspace<void*> address)
@@ -562,6 +587,7 @@ ErrorOr<FlatPtr> Process::sys$msyscall(Userspace<void*> address)
     if (!Memory::is_user_address(address.vaddr()))
         return EFAULT;
 
+    MutexLocker mapping_locker(address_space().mapping_lock());
     auto* region = address_space().find_region_containing(Memory::VirtualRange { address.vaddr(), 1 });
     if (!region)
         return EINVAL;
@@ -589,6 +615,8 @@ ErrorOr<FlatPtr> Process::sys$msync(Userspace<void*> address, size_t size, int f
     // Note: This is not specified
     auto rounded_size = TRY(Memory::page_round_up(size));
 
+    MutexLocker mapping_locker(address_space().mapping_lock());
+
     // FIXME: We probably want to sync all mappings in the address+size range.
     auto* region = address_space().find_region_containing(Memory::VirtualRange { address.vaddr(), rounded_size });
     // All regions from address upto address+size shall be mapped
@@ -195,6 +195,8 @@ ErrorOr<void> Process::peek_user_data(Span<u8> destination, Userspace<const u8*>
 ErrorOr<void> Process::poke_user_data(Userspace<FlatPtr*> address, FlatPtr data)
 {
     Memory::VirtualRange range = { address.vaddr(), sizeof(FlatPtr) };
+    // munmap() and mprotect() don't take the big lock, so keep the region from going away under us.
+    MutexLocker mapping_locker(address_space().mapping_lock());
     auto* region = address_space().find_region_containing(range);
     if (!region)
         return EFAULT;
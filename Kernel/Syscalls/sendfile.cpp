@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/NumericLimits.h>
+#include <Kernel/FileSystem/Inode.h>
+#include <Kernel/FileSystem/OpenFileDescription.h>
+#include <Kernel/KBuffer.h>
+#include <Kernel/Memory/Region.h>
+#include <Kernel/Process.h>
+
+namespace Kernel {
+
+// How much of the input we map (or read) at once, before handing it to the output.
+static constexpr size_t sendfile_chunk_size = 256 * KiB;
+
+ErrorOr<FlatPtr> Process::sys$sendfile(int out_fd, int in_fd, Userspace<off_t*> user_offset, size_t count)
+{
+    VERIFY_NO_PROCESS_BIG_LOCK(this)
+    TRY(require_promise(Pledge::stdio));
+    if (count > NumericLimits<ssize_t>::max())
+        return EINVAL;
+
+    auto in_description = TRY(open_file_description(in_fd));
+    if (!in_description->is_readable())
+        return EBADF;
+    if (in_description->is_directory())
+        return EISDIR;
+    // NOTE: We have to be able to go back to the data that the output didn't take, so the input has to be seekable.
+    //       Moving data between pipes and sockets is left to read() and write().
+    if (!in_description->file().is_seekable())
+        return EINVAL;
+
+    auto out_description = TRY(open_file_description(out_fd));
+    if (!out_description->is_writable())
+        return EBADF;
+
+    off_t offset;
+    if (user_offset) {
+        TRY(copy_from_user(&offset, user_offset));
+        if (offset < 0)
+            return EINVAL;
+    } else {
+        offset = in_description->offset();
+    }
+    if (Checked<off_t>::addition_would_overflow(offset, count))
+        return EOVERFLOW;
+
+    auto* inode = in_description->inode();
+    bool use_page_cache = inode && inode->has_page_cache() && !in_description->is_direct();
+
+    // When the input isn't in the page cache, we have to copy it through a kernel buffer.
+    OwnPtr<KBuffer> bounce_buffer;
+    if (!use_page_cache)
+        bounce_buffer = TRY(KBuffer::try_create_with_size(min(count, sendfile_chunk_size), Memory::Region::Access::ReadWrite, "sendfile"sv));
+
+    auto send_chunk = [&](off_t position, size_t chunk_size) -> ErrorOr<size_t> {
+        if (!use_page_cache) {
+            auto buffer = UserOrKernelBuffer::for_kernel_buffer(bounce_buffer->data());
+            auto nread = TRY(in_description->read(buffer, position, chunk_size));
+            if (nread == 0)
+                return 0;
+            return TRY(do_write(*out_description, buffer, nread));
+        }
+
+        auto file_size = inode->size();
+        if (static_cast<u64>(position) >= file_size)
+            return 0;
+        chunk_size = min<u64>(chunk_size, file_size - position);
+
+        if (auto readahead = in_description->update_readahead(position, chunk_size); readahead.has_value())
+            inode->start_readahead(readahead->first_page, readahead->page_count);
+
+        // The output reads straight out of the page cache, without a copy into an intermediate buffer.
+        auto first_page = position / PAGE_SIZE;
+        auto end_page = ceil_div(static_cast<u64>(position) + chunk_size, static_cast<u64>(PAGE_SIZE));
+        auto region = TRY(inode->map_cached_pages(first_page, end_page - first_page));
+        auto buffer = UserOrKernelBuffer::for_kernel_buffer(region->vaddr().offset(position % PAGE_SIZE).as_ptr());
+        auto nwritten = TRY(do_write(*out_description, buffer, chunk_size));
+        Thread::current()->did_file_read(nwritten);
+        return nwritten;
+    };
+
+    size_t total_nsent = 0;
+    while (total_nsent < count) {
+        auto chunk_size = min(count - total_nsent, sendfile_chunk_size);
+        auto nsent_or_error = send_chunk(offset + total_nsent, chunk_size);
+        if (nsent_or_error.is_error()) {
+            if (total_nsent == 0)
+                return nsent_or_error.release_error();
+            break;
+        }
+        auto nsent = nsent_or_error.value();
+        total_nsent += nsent;
+        // We're either at the end of the input, or the output is non-blocking and full.
+        if (nsent < chunk_size)
+            break;
+    }
+
+    if (user_offset) {
+        off_t new_offset = offset + total_nsent;
+        TRY(copy_to_user(user_offset, &new_offset));
+    } else {
+        TRY(in_description->seek(offset + total_nsent, SEEK_SET));
+    }
+    return total_nsent;
+}
+
+}
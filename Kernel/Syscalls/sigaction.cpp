@@ -138,6 +138,8 @@ ErrorOr<void> Process::remap_range_as_stack(FlatPtr address, size_t size)
     if (!is_user_range(range_to_remap))
         return EFAULT;
 
+    MutexLocker mapping_locker(address_space().mapping_lock());
+
     if (auto* whole_region = address_space().find_region_from_range(range_to_remap)) {
         if (!whole_region->is_mmap())
             return EPERM;
@@ -30,6 +30,7 @@ ErrorOr<FlatPtr> Process::sys$unveil(Userspace<const Syscall::SC_unveil_params*>
     auto params = TRY(copy_typed_from_user(user_params));
 
     if (!params.path.characters && !params.permissions.characters) {
+        MutexLocker locker(m_unveil_lock);
         m_veil_state = VeilState::Locked;
         return 0;
     }
@@ -92,6 +93,10 @@ ErrorOr<FlatPtr> Process::sys$unveil(Userspace<const Syscall::SC_unveil_params*>
         return custody_or_error.release_error();
     }
 
+    MutexLocker locker(m_unveil_lock);
+    if (m_veil_state == VeilState::Locked)
+        return EPERM;
+
     auto path_parts = KLexicalPath::parts(new_unveiled_path->view());
     auto it = path_parts.begin();
     auto& matching_node = m_unveiled_paths.traverse_until_last_accessible_node(it, path_parts.end());
@@ -4,24 +4,36 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/Singleton.h>
 #include <Kernel/FileSystem/VirtualFileSystem.h>
 #include <Kernel/Process.h>
 #include <Kernel/Sections.h>
 #include <Kernel/Tasks/SyncTask.h>
 #include <Kernel/Time/TimeManagement.h>
+#include <Kernel/WaitQueue.h>
 
 namespace Kernel {
 
+static Singleton<WaitQueue> s_sync_wait_queue;
+
 UNMAP_AFTER_INIT void SyncTask::spawn()
 {
+    // Note: Memory allocation wakes us up when it runs low, so don't leave allocating the queue until then.
+    s_sync_wait_queue.ensure_instance();
     RefPtr<Thread> syncd_thread;
     (void)Process::create_kernel_process(syncd_thread, KString::must_create("SyncTask"), [] {
         dbgln("SyncTask is running");
         for (;;) {
             VirtualFileSystem::sync();
-            (void)Thread::current()->sleep(Time::from_seconds(1));
+            auto timeout = Time::from_seconds(1);
+            (void)s_sync_wait_queue->wait_on(Thread::BlockTimeout(false, &timeout));
         }
     });
 }
 
+void SyncTask::wake()
+{
+    s_sync_wait_queue->wake_one();
+}
+
 }
@@ -10,5 +10,8 @@ namespace Kernel {
 class SyncTask {
 public:
     static void spawn();
+
+    // Flushes (and, if memory is tight, shrinks) the file system caches right away instead of at the next tick.
+    static void wake();
 };
 }
@@ -260,6 +260,12 @@ Thread::BlockResult Thread::block_impl(BlockTimeout const& timeout, Blocker& blo
     return result;
 }
 
+void Thread::set_page_mapping_region(NonnullOwnPtr<Memory::Region> region)
+{
+    VERIFY(!m_page_mapping_region);
+    m_page_mapping_region = move(region);
+}
+
 void Thread::block(Kernel::Mutex& lock, SpinlockLocker<Spinlock>& lock_lock, u32 lock_count)
 {
     VERIFY(!Processor::current_in_irq());
@@ -477,6 +483,7 @@ void Thread::exit(void* exit_value)
     u32 unlock_count;
     [[maybe_unused]] auto rc = unlock_process_if_locked(unlock_count);
     if (m_thread_specific_range.has_value()) {
+        MutexLocker mapping_locker(process().address_space().mapping_lock());
         auto* region = process().address_space().find_region_from_range(m_thread_specific_range.value());
         process().address_space().deallocate_region(*region);
     }
@@ -1191,12 +1198,13 @@ void Thread::set_state(State new_state, u8 stop_signal)
 {
     State previous_state;
     VERIFY(g_scheduler_lock.is_locked_by_current_processor());
-    if (new_state == m_state)
-        return;
 
     {
         SpinlockLocker thread_lock(m_lock);
+        // NOTE: The Scheduler may switch us in or out while we wait for our lock.
         previous_state = m_state;
+        if (previous_state == new_state)
+            return;
         if (previous_state == Thread::State::Invalid) {
             // If we were *just* created, we may have already pending signals
             if (has_unmasked_pending_signals()) {
@@ -1207,11 +1215,16 @@ void Thread::set_state(State new_state, u8 stop_signal)
 
         m_state = new_state;
         dbgln_if(THREAD_DEBUG, "Set thread {} state to {}", *this, state_string());
+
+        // The Scheduler doesn't take g_scheduler_lock to pick threads off the ready queues,
+        // so they need to be updated before we let go of our lock.
+        if (previous_state == Thread::State::Runnable)
+            Scheduler::dequeue_runnable_thread(*this);
+        else if (new_state == Thread::State::Runnable)
+            Scheduler::enqueue_runnable_thread(*this);
     }
 
-    if (previous_state == Thread::State::Runnable) {
-        Scheduler::dequeue_runnable_thread(*this);
-    } else if (previous_state == Thread::State::Stopped) {
+    if (previous_state == Thread::State::Stopped) {
         m_stop_state = State::Invalid;
         auto& process = this->process();
         if (process.set_stopped(false)) {
@@ -1231,10 +1244,7 @@ void Thread::set_state(State new_state, u8 stop_signal)
         }
     }
 
-    if (m_state == Thread::State::Runnable) {
-        Scheduler::enqueue_runnable_thread(*this);
-        Processor::smp_wake_n_idle_processors(1);
-    } else if (m_state == Thread::State::Stopped) {
+    if (m_state == Thread::State::Stopped) {
         // We don't want to restore to Running state, only Runnable!
         m_stop_state = previous_state != Thread::State::Running ? previous_state : Thread::State::Runnable;
         auto& process = this->process();
@@ -1263,6 +1273,31 @@ void Thread::set_state(State new_state, u8 stop_signal)
     }
 }
 
+bool Thread::try_set_running()
+{
+    SpinlockLocker thread_lock(m_lock);
+    if (m_state != Thread::State::Runnable)
+        return false;
+    // If we were stopped and resumed after the Scheduler took us off the ready queues, we're on them again.
+    if (m_runnable_priority >= 0)
+        Scheduler::dequeue_runnable_thread(*this);
+    m_state = Thread::State::Running;
+    // NOTE: This happens under our lock, so that Processor::capture_stack_trace() doesn't see us switching in.
+    set_active(true);
+    dbgln_if(THREAD_DEBUG, "Set thread {} state to {}", *this, state_string());
+    return true;
+}
+
+void Thread::set_runnable_if_running()
+{
+    SpinlockLocker thread_lock(m_lock);
+    if (m_state != Thread::State::Running)
+        return;
+    m_state = Thread::State::Runnable;
+    dbgln_if(THREAD_DEBUG, "Set thread {} state to {}", *this, state_string());
+    Scheduler::enqueue_runnable_thread(*this);
+}
+
 struct RecognizedSymbol {
     FlatPtr address;
     const KernelSymbol* symbol { nullptr };
@@ -1338,6 +1373,7 @@ ErrorOr<void> Thread::make_thread_specific_region(Badge<Process>)
     if (!process().m_master_tls_region)
         return {};
 
+    MutexLocker mapping_locker(process().address_space().mapping_lock());
     auto range = TRY(process().address_space().try_allocate_range({}, thread_specific_region_size()));
     auto* region = TRY(process().address_space().allocate_region(range, "Thread-specific", PROT_READ | PROT_WRITE));
 
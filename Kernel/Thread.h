@@ -151,6 +151,7 @@ class Thread
     friend class Process;
     friend class Scheduler;
     friend struct ThreadReadyQueue;
+    friend struct ThreadReadyQueues;
 
 public:
     inline static Thread* current()
@@ -908,8 +909,19 @@ public:
     FlatPtr kernel_stack_base() const { return m_kernel_stack_base; }
     FlatPtr kernel_stack_top() const { return m_kernel_stack_top; }
 
+    // See MemoryManager::map_page_for_current_thread().
+    Memory::Region* page_mapping_region() { return m_page_mapping_region.ptr(); }
+    void set_page_mapping_region(NonnullOwnPtr<Memory::Region>);
+    bool has_page_mapped() const { return m_has_page_mapped; }
+    void set_has_page_mapped(bool has_page_mapped) { m_has_page_mapped = has_page_mapped; }
+
     void set_state(State, u8 = 0);
 
+    // The Scheduler switches threads in and out with these, which only take the thread's own lock
+    // instead of g_scheduler_lock.
+    [[nodiscard]] bool try_set_running();
+    void set_runnable_if_running();
+
     [[nodiscard]] bool is_initialized() const { return m_initialized; }
     void set_initialized(bool initialized) { m_initialized = initialized; }
 
@@ -1134,6 +1146,7 @@ private:
 
     IntrusiveListNode<Thread> m_process_thread_list_node;
     int m_runnable_priority { -1 };
+    u32 m_runnable_cpu { 0 };
 
     friend class WaitQueue;
 
@@ -1223,6 +1236,8 @@ private:
     FlatPtr m_kernel_stack_base { 0 };
     FlatPtr m_kernel_stack_top { 0 };
     NonnullOwnPtr<Memory::Region> m_kernel_stack_region;
+    OwnPtr<Memory::Region> m_page_mapping_region;
+    bool m_has_page_mapped { false };
     VirtualAddress m_thread_specific_data;
     Optional<Memory::VirtualRange> m_thread_specific_range;
     Array<SignalActionData, NSIG> m_signal_action_data;
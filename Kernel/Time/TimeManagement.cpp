@@ -203,6 +203,11 @@ UNMAP_AFTER_INIT TimeManagement::TimeManagement()
     } else if (!probe_and_set_legacy_hardware_timers()) {
         VERIFY_NOT_REACHED();
     }
+
+    // NOTE: Userspace reads the TSC on whatever processor it happens to run on, so we rely on an invariant TSC,
+    //       which keeps ticking at the same rate regardless of power states, and is synchronized across processors.
+    auto& processor = Processor::current();
+    m_can_keep_time_with_tsc = processor.has_feature(CPUFeature::TSC) && processor.has_feature(CPUFeature::CONSTANT_TSC) && processor.has_feature(CPUFeature::NONSTOP_TSC);
 }
 
 Time TimeManagement::now()
@@ -433,12 +438,44 @@ bool TimeManagement::disable_profile_timer()
     return true;
 }
 
+void TimeManagement::calibrate_tsc(u64 tsc, Time const& time)
+{
+    // We keep measuring how fast the TSC runs compared to the time keeper, about a second at a time.
+    if (m_tsc_calibration_start_tsc == 0) {
+        m_tsc_calibration_start_tsc = tsc;
+        m_tsc_calibration_start_time = time;
+        return;
+    }
+    auto elapsed_ns = (time - m_tsc_calibration_start_time).to_nanoseconds();
+    if (elapsed_ns < 1'000'000'000)
+        return;
+    auto elapsed_tsc = tsc - m_tsc_calibration_start_tsc;
+    // NOTE: If we weren't called for a long while, we start over instead of overflowing.
+    if (elapsed_ns <= static_cast<i64>(NumericLimits<u32>::max()) && elapsed_tsc > 0) {
+        m_tsc_to_ns_multiplier = (static_cast<u64>(elapsed_ns) << 32) / elapsed_tsc;
+        u64 ns_per_update = 1'000'000'000ull / m_time_keeper_timer->ticks_per_second();
+        m_max_tsc_delta = m_tsc_to_ns_multiplier ? (ns_per_update << 32) / m_tsc_to_ns_multiplier : 0;
+    }
+    m_tsc_calibration_start_tsc = tsc;
+    m_tsc_calibration_start_time = time;
+}
+
 void TimeManagement::update_time_page()
 {
     auto& page = time_page();
+    auto monotonic_time_coarse = monotonic_time(TimePrecision::Coarse);
+    u64 tsc = 0;
+    if (m_can_keep_time_with_tsc) {
+        tsc = read_tsc();
+        calibrate_tsc(tsc, monotonic_time_coarse);
+    }
+
     u32 update_iteration = AK::atomic_fetch_add(&page.update2, 1u, AK::MemoryOrder::memory_order_acquire);
     page.clocks[CLOCK_REALTIME_COARSE] = m_epoch_time;
-    page.clocks[CLOCK_MONOTONIC_COARSE] = monotonic_time(TimePrecision::Coarse).to_timespec();
+    page.clocks[CLOCK_MONOTONIC_COARSE] = monotonic_time_coarse.to_timespec();
+    page.tsc_at_update = tsc;
+    page.tsc_to_ns_multiplier = m_max_tsc_delta ? m_tsc_to_ns_multiplier : 0;
+    page.max_tsc_delta = m_max_tsc_delta;
     AK::atomic_store(&page.update1, update_iteration + 1u, AK::MemoryOrder::memory_order_release);
 }
 
@@ -78,6 +78,7 @@ public:
 private:
     TimePage& time_page();
     void update_time_page();
+    void calibrate_tsc(u64 tsc, Time const& monotonic_time);
 
     bool probe_and_set_legacy_hardware_timers();
     bool probe_and_set_non_legacy_hardware_timers();
@@ -109,6 +110,13 @@ private:
     RefPtr<HardwareTimerBase> m_profile_timer;
 
     NonnullOwnPtr<Memory::Region> m_time_page_region;
+
+    // These are only accessed from the BSP, while updating the time page.
+    bool m_can_keep_time_with_tsc { false };
+    u64 m_tsc_calibration_start_tsc { 0 };
+    Time m_tsc_calibration_start_time;
+    u64 m_tsc_to_ns_multiplier { 0 };
+    u64 m_max_tsc_delta { 0 };
 };
 
 }
@@ -15,6 +15,9 @@
 namespace Kernel {
 
 extern WorkQueue* g_io_work;
+// File system background work (readahead, write-behind) waits on I/O, so it can't share g_io_work,
+// which completes the very requests it would be waiting for.
+extern WorkQueue* g_fs_work;
 
 class WorkQueue {
     AK_MAKE_NONCOPYABLE(WorkQueue);
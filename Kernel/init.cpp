@@ -299,6 +299,8 @@ void init_stage2(void*)
         APIC::the().boot_aps();
     }
 
+    MM.start_zeroed_page_pool_threads();
+
     // Initialize the PCI Bus as early as possible, for early boot (PCI based) serial logging
     PCI::initialize();
     PCISerialDevice::detect();
@@ -130,6 +130,7 @@ set(NT_DEBUG ON)
 set(NVME_DEBUG ON)
 set(OCCLUSIONS_DEBUG ON)
 set(OFFD_DEBUG ON)
+set(PAGE_CACHE_DEBUG ON)
 set(PAGE_FAULT_DEBUG ON)
 set(PARSER_DEBUG ON)
 set(PATA_DEBUG ON)
@@ -145,6 +146,7 @@ set(PROMISE_DEBUG ON)
 set(PS2MOUSE_DEBUG ON)
 set(PTHREAD_DEBUG ON)
 set(PTMX_DEBUG ON)
+set(READAHEAD_DEBUG ON)
 set(REACHABLE_DEBUG ON)
 set(REGEX_DEBUG ON)
 set(REQUESTSERVER_DEBUG ON)
@@ -2202,6 +2202,12 @@ public:
 )~~~");
     }
 
+    if (interface.extended_attributes.contains("CustomGet") || interface.extended_attributes.contains("CustomSet") || interface.is_legacy_platform_object()) {
+        generator.append(R"~~~(
+    virtual bool has_exotic_behavior_for(JS::PropertyKey const&) const override { return true; }
+)~~~");
+    }
+
     if (interface.extended_attributes.contains("CustomVisit")) {
         generator.append(R"~~~(
     virtual void visit_edges(JS::Cell::Visitor&) override;
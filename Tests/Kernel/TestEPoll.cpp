@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <LibTest/TestCase.h>
+#include <errno.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+TEST_CASE(epoll_level_triggered)
+{
+    int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    EXPECT(epoll_fd >= 0);
+    int pipe_fds[2];
+    EXPECT_EQ(pipe(pipe_fds), 0);
+
+    epoll_event event {};
+    event.events = EPOLLIN;
+    event.data.u64 = 0x1234'5678'9abcULL;
+    EXPECT_EQ(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, pipe_fds[0], &event), 0);
+    EXPECT_EQ(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, pipe_fds[0], &event), -1);
+    EXPECT_EQ(errno, EEXIST);
+
+    epoll_event events[4];
+    EXPECT_EQ(epoll_wait(epoll_fd, events, 4, 0), 0);
+
+    EXPECT_EQ(write(pipe_fds[1], "x", 1), 1);
+    // A level-triggered fd keeps being reported until it is no longer ready.
+    for (int i = 0; i < 2; ++i) {
+        EXPECT_EQ(epoll_wait(epoll_fd, events, 4, 0), 1);
+        EXPECT_EQ(events[0].events, EPOLLIN);
+        EXPECT_EQ(events[0].data.u64, 0x1234'5678'9abcULL);
+    }
+
+    char buffer;
+    EXPECT_EQ(read(pipe_fds[0], &buffer, 1), 1);
+    EXPECT_EQ(epoll_wait(epoll_fd, events, 4, 0), 0);
+
+    EXPECT_EQ(epoll_ctl(epoll_fd, EPOLL_CTL_DEL, pipe_fds[0], nullptr), 0);
+    EXPECT_EQ(epoll_ctl(epoll_fd, EPOLL_CTL_DEL, pipe_fds[0], nullptr), -1);
+    EXPECT_EQ(errno, ENOENT);
+
+    close(pipe_fds[0]);
+    close(pipe_fds[1]);
+    close(epoll_fd);
+}
+
+TEST_CASE(epoll_edge_triggered_and_oneshot)
+{
+    int epoll_fd = epoll_create1(0);
+    EXPECT(epoll_fd >= 0);
+    int pipe_fds[2];
+    EXPECT_EQ(pipe(pipe_fds), 0);
+
+    epoll_event event {};
+    event.events = EPOLLIN | EPOLLET;
+    event.data.fd = pipe_fds[0];
+    EXPECT_EQ(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, pipe_fds[0], &event), 0);
+
+    epoll_event events[4];
+    EXPECT_EQ(write(pipe_fds[1], "x", 1), 1);
+    EXPECT_EQ(epoll_wait(epoll_fd, events, 4, 0), 1);
+    EXPECT_EQ(events[0].data.fd, pipe_fds[0]);
+    // Nothing changed, so an edge-triggered fd is not reported again.
+    EXPECT_EQ(epoll_wait(epoll_fd, events, 4, 0), 0);
+    EXPECT_EQ(write(pipe_fds[1], "y", 1), 1);
+    EXPECT_EQ(epoll_wait(epoll_fd, events, 4, 0), 1);
+
+    event.events = EPOLLIN | EPOLLONESHOT;
+    EXPECT_EQ(epoll_ctl(epoll_fd, EPOLL_CTL_MOD, pipe_fds[0], &event), 0);
+    EXPECT_EQ(epoll_wait(epoll_fd, events, 4, 0), 1);
+    // A one-shot fd is disabled after it has been reported, until it is modified again.
+    EXPECT_EQ(epoll_wait(epoll_fd, events, 4, 0), 0);
+    EXPECT_EQ(epoll_ctl(epoll_fd, EPOLL_CTL_MOD, pipe_fds[0], &event), 0);
+    EXPECT_EQ(epoll_wait(epoll_fd, events, 4, 0), 1);
+
+    close(pipe_fds[0]);
+    close(pipe_fds[1]);
+    close(epoll_fd);
+}
+
+TEST_CASE(epoll_wait_blocks_until_ready)
+{
+    int epoll_fd = epoll_create1(0);
+    EXPECT(epoll_fd >= 0);
+    int pipe_fds[2];
+    EXPECT_EQ(pipe(pipe_fds), 0);
+
+    epoll_event event {};
+    event.events = EPOLLIN;
+    EXPECT_EQ(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, pipe_fds[0], &event), 0);
+
+    epoll_event events[1];
+    EXPECT_EQ(epoll_wait(epoll_fd, events, 1, 10), 0);
+
+    int child_pid = fork();
+    EXPECT(child_pid >= 0);
+    if (child_pid == 0) {
+        usleep(100'000);
+        (void)write(pipe_fds[1], "x", 1);
+        _exit(EXIT_SUCCESS);
+    }
+    EXPECT_EQ(epoll_wait(epoll_fd, events, 1, -1), 1);
+    EXPECT_EQ(events[0].events, EPOLLIN);
+
+    close(pipe_fds[0]);
+    close(pipe_fds[1]);
+    close(epoll_fd);
+}
+
+TEST_CASE(epoll_invalid_arguments)
+{
+    EXPECT_EQ(epoll_create(0), -1);
+    EXPECT_EQ(errno, EINVAL);
+
+    int epoll_fd = epoll_create(1);
+    EXPECT(epoll_fd >= 0);
+    epoll_event events[1];
+    EXPECT_EQ(epoll_wait(epoll_fd, events, 0, 0), -1);
+    EXPECT_EQ(errno, EINVAL);
+
+    epoll_event event {};
+    event.events = EPOLLIN;
+    EXPECT_EQ(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, epoll_fd, &event), -1);
+    EXPECT_EQ(errno, EINVAL);
+    close(epoll_fd);
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Vector.h>
+#include <LibTest/TestCase.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// NOTE: /tmp is a TmpFS, so the test files go somewhere on the root Ext2 file system instead.
+static int create_test_file(blksize_t& block_size)
+{
+    char path[] = "/home/anon/ext2-block-allocation.XXXXXX";
+    int fd = mkstemp(path);
+    VERIFY(fd >= 0);
+    unlink(path);
+
+    struct stat st;
+    VERIFY(fstat(fd, &st) == 0);
+    block_size = st.st_blksize;
+    return fd;
+}
+
+static void write_blocks(int fd, blksize_t block_size, size_t block_count)
+{
+    Vector<u8> data;
+    data.resize(block_size * block_count);
+    for (size_t i = 0; i < data.size(); ++i)
+        data[i] = i % 251;
+    EXPECT_EQ(write(fd, data.data(), data.size()), static_cast<ssize_t>(data.size()));
+}
+
+static void expect_contiguous_blocks(int fd, size_t block_count)
+{
+    int first_block = 0;
+    EXPECT_EQ(ioctl(fd, FIBMAP, &first_block), 0);
+    EXPECT_NE(first_block, 0);
+    for (size_t i = 1; i < block_count; ++i) {
+        int block = static_cast<int>(i);
+        EXPECT_EQ(ioctl(fd, FIBMAP, &block), 0);
+        EXPECT_EQ(block, first_block + static_cast<int>(i));
+    }
+}
+
+TEST_CASE(single_write_gets_contiguous_blocks)
+{
+    EXPECT_EQ(geteuid(), 0u);
+
+    blksize_t block_size = 0;
+    int fd = create_test_file(block_size);
+    write_blocks(fd, block_size, 64);
+    expect_contiguous_blocks(fd, 64);
+    close(fd);
+}
+
+TEST_CASE(appending_continues_after_the_last_block)
+{
+    EXPECT_EQ(geteuid(), 0u);
+
+    // Each append asks for the block right after the end of the file. Stay within the direct blocks,
+    // since the file system places an indirect block after the data that was written so far.
+    blksize_t block_size = 0;
+    int fd = create_test_file(block_size);
+    for (size_t i = 0; i < 12; ++i)
+        write_blocks(fd, block_size, 1);
+    expect_contiguous_blocks(fd, 12);
+    close(fd);
+}
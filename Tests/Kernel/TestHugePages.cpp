@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/JsonArray.h>
+#include <AK/JsonObject.h>
+#include <AK/JsonValue.h>
+#include <LibCore/File.h>
+#include <LibTest/TestCase.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static constexpr size_t huge_page_size = 2 * MiB;
+static constexpr size_t mapping_size = 2 * huge_page_size;
+
+static u8* map_huge(size_t size)
+{
+    auto* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE | MAP_HUGE, 0, 0);
+    EXPECT_NE(ptr, MAP_FAILED);
+    return static_cast<u8*>(ptr);
+}
+
+static void fill(u8* ptr, size_t size, u8 seed)
+{
+    for (size_t i = 0; i < size; i += PAGE_SIZE)
+        ptr[i] = static_cast<u8>((i / PAGE_SIZE) + seed);
+}
+
+static bool verify(u8 const* ptr, size_t size, u8 seed)
+{
+    for (size_t i = 0; i < size; i += PAGE_SIZE) {
+        if (ptr[i] != static_cast<u8>((i / PAGE_SIZE) + seed))
+            return false;
+    }
+    return true;
+}
+
+// Reads back from /proc/self/vm how much of the region at the given address the kernel maps with huge pages,
+// since reads and writes alone would work just as well if it had fallen back to single pages.
+static size_t amount_mapped_with_huge_pages(void const* address)
+{
+    auto file = Core::File::open("/proc/self/vm", Core::OpenMode::ReadOnly);
+    VERIFY(!file.is_error());
+    auto buffer = file.value()->read_all();
+    auto json = JsonValue::from_string({ buffer });
+    VERIFY(!json.is_error() && json.value().is_array());
+    size_t amount = 0;
+    json.value().as_array().for_each([&](auto& value) {
+        auto& region = value.as_object();
+        if (region.get("address").to_addr() == reinterpret_cast<FlatPtr>(address))
+            amount = region.get("amount_huge").to_addr();
+    });
+    return amount;
+}
+
+TEST_CASE(map_huge_requires_anonymous_memory)
+{
+    int fd = open("/bin/SystemServer", O_RDONLY);
+    EXPECT(fd >= 0);
+    auto* ptr = mmap(nullptr, huge_page_size, PROT_READ, MAP_PRIVATE | MAP_HUGE, fd, 0);
+    EXPECT_EQ(ptr, MAP_FAILED);
+    EXPECT_EQ(errno, EINVAL);
+    close(fd);
+}
+
+TEST_CASE(map_huge_is_aligned)
+{
+    auto* ptr = map_huge(mapping_size);
+    EXPECT_EQ(reinterpret_cast<FlatPtr>(ptr) % huge_page_size, 0u);
+    EXPECT_EQ(amount_mapped_with_huge_pages(ptr), 0u);
+    fill(ptr, mapping_size, 1);
+    EXPECT(verify(ptr, mapping_size, 1));
+    EXPECT_EQ(amount_mapped_with_huge_pages(ptr), mapping_size);
+    EXPECT_EQ(munmap(ptr, mapping_size), 0);
+}
+
+TEST_CASE(large_anonymous_mappings_are_aligned)
+{
+    auto* ptr = static_cast<u8*>(mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, 0, 0));
+    EXPECT_NE(ptr, MAP_FAILED);
+    EXPECT_EQ(reinterpret_cast<FlatPtr>(ptr) % huge_page_size, 0u);
+    fill(ptr, mapping_size, 6);
+    EXPECT_EQ(amount_mapped_with_huge_pages(ptr), mapping_size);
+    EXPECT_EQ(munmap(ptr, mapping_size), 0);
+}
+
+TEST_CASE(partial_mprotect_of_huge_page)
+{
+    auto* ptr = map_huge(mapping_size);
+    fill(ptr, mapping_size, 2);
+
+    EXPECT_EQ(mprotect(ptr + huge_page_size / 2, PAGE_SIZE, PROT_READ), 0);
+    EXPECT(verify(ptr, mapping_size, 2));
+
+    // The pages around the read-only one must still be writable.
+    ptr[huge_page_size / 2 - PAGE_SIZE] = 0xaa;
+    ptr[huge_page_size / 2 + PAGE_SIZE] = 0xbb;
+    EXPECT_EQ(ptr[huge_page_size / 2 - PAGE_SIZE], 0xaa);
+    EXPECT_EQ(ptr[huge_page_size / 2 + PAGE_SIZE], 0xbb);
+
+    EXPECT_EQ(munmap(ptr, mapping_size), 0);
+}
+
+TEST_CASE(partial_munmap_of_huge_page)
+{
+    auto* ptr = map_huge(mapping_size);
+    fill(ptr, mapping_size, 3);
+
+    EXPECT_EQ(munmap(ptr + PAGE_SIZE, PAGE_SIZE), 0);
+    // Only the huge page with the hole in it has to be split up.
+    EXPECT_EQ(amount_mapped_with_huge_pages(ptr), 0u);
+    EXPECT_EQ(amount_mapped_with_huge_pages(ptr + 2 * PAGE_SIZE), huge_page_size);
+    EXPECT(verify(ptr, PAGE_SIZE, 3));
+    EXPECT(verify(ptr + 2 * PAGE_SIZE, mapping_size - 2 * PAGE_SIZE, 5));
+
+    EXPECT_EQ(munmap(ptr, mapping_size), 0);
+}
+
+TEST_CASE(huge_page_copy_on_write_after_fork)
+{
+    auto* ptr = map_huge(mapping_size);
+    fill(ptr, mapping_size, 4);
+
+    int child_pid = fork();
+    EXPECT(child_pid >= 0);
+    if (child_pid == 0) {
+        bool saw_parent_data = verify(ptr, mapping_size, 4);
+        fill(ptr, mapping_size, 5);
+        exit(saw_parent_data && verify(ptr, mapping_size, 5) ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    // Write to one page while the child may still be reading, then make sure that neither side saw the other's writes.
+    ptr[PAGE_SIZE] = 0xcc;
+    int status = 0;
+    EXPECT_EQ(waitpid(child_pid, &status, 0), child_pid);
+    EXPECT(WIFEXITED(status));
+    EXPECT_EQ(WEXITSTATUS(status), EXIT_SUCCESS);
+
+    EXPECT_EQ(ptr[PAGE_SIZE], 0xcc);
+    ptr[PAGE_SIZE] = static_cast<u8>(1 + 4);
+    EXPECT(verify(ptr, mapping_size, 4));
+
+    EXPECT_EQ(munmap(ptr, mapping_size), 0);
+}
@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Atomic.h>
+#include <LibTest/TestCase.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/io_ring.h>
+#include <sys/mman.h>
+#include <sys/select.h>
+#include <unistd.h>
+
+struct Ring {
+    int fd { -1 };
+    io_ring_params params {};
+    u8* memory { nullptr };
+
+    io_ring_header& header() { return *reinterpret_cast<io_ring_header*>(memory); }
+    io_ring_sqe* submission_queue() { return reinterpret_cast<io_ring_sqe*>(memory + params.sqes_offset); }
+    io_ring_cqe* completion_queue() { return reinterpret_cast<io_ring_cqe*>(memory + params.cqes_offset); }
+
+    void push(io_ring_sqe const& sqe)
+    {
+        auto tail = header().sq_tail;
+        submission_queue()[tail & (params.sq_entries - 1)] = sqe;
+        AK::atomic_store(&header().sq_tail, tail + 1, AK::memory_order_release);
+    }
+
+    bool pop(io_ring_cqe& cqe)
+    {
+        auto head = header().cq_head;
+        if (head == AK::atomic_load(&header().cq_tail, AK::memory_order_acquire))
+            return false;
+        cqe = completion_queue()[head & (params.cq_entries - 1)];
+        AK::atomic_store(&header().cq_head, head + 1, AK::memory_order_release);
+        return true;
+    }
+};
+
+static Ring create_ring(unsigned entry_count)
+{
+    Ring ring;
+    ring.fd = io_ring_setup(entry_count, IO_RING_CLOEXEC, &ring.params);
+    VERIFY(ring.fd >= 0);
+    auto* memory = mmap(nullptr, ring.params.mmap_size, PROT_READ | PROT_WRITE, MAP_SHARED, ring.fd, 0);
+    VERIFY(memory != MAP_FAILED);
+    ring.memory = static_cast<u8*>(memory);
+    return ring;
+}
+
+static void destroy_ring(Ring& ring)
+{
+    munmap(ring.memory, ring.params.mmap_size);
+    close(ring.fd);
+}
+
+TEST_CASE(io_ring_setup_rejects_bad_sizes)
+{
+    io_ring_params params {};
+    EXPECT_EQ(io_ring_setup(0, 0, &params), -1);
+    EXPECT_EQ(errno, EINVAL);
+    EXPECT_EQ(io_ring_setup(3, 0, &params), -1);
+    EXPECT_EQ(errno, EINVAL);
+    EXPECT_EQ(io_ring_setup(IO_RING_MAX_ENTRIES * 2, 0, &params), -1);
+    EXPECT_EQ(errno, EINVAL);
+
+    int fd = io_ring_setup(8, 0, &params);
+    EXPECT(fd >= 0);
+    EXPECT_EQ(params.sq_entries, 8u);
+    EXPECT_EQ(params.cq_entries, 16u);
+    // Only a shared mapping of the whole ring makes sense.
+    EXPECT_EQ(mmap(nullptr, params.mmap_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0), MAP_FAILED);
+    EXPECT_EQ(errno, EINVAL);
+    close(fd);
+}
+
+TEST_CASE(io_ring_batches_requests)
+{
+    auto ring = create_ring(16);
+
+    int fd = open("/tmp/io-ring-test", O_RDWR | O_CREAT | O_TRUNC, 0600);
+    EXPECT(fd >= 0);
+    char const data[] = "Hello, ring!";
+    char buffer[sizeof(data)] {};
+
+    ring.push({ IO_RING_OP_NOP, 0, 0, -1, 0, 0, 0, 0, 1 });
+    ring.push({ IO_RING_OP_WRITE, 0, 0, fd, 0, reinterpret_cast<FlatPtr>(data), sizeof(data), 0, 2 });
+    ring.push({ IO_RING_OP_READ, 0, 0, fd, 0, reinterpret_cast<FlatPtr>(buffer), sizeof(buffer), 0, 3 });
+    ring.push({ IO_RING_OP_READ, 0, 0, 12345, 0, reinterpret_cast<FlatPtr>(buffer), sizeof(buffer), 0, 4 });
+    EXPECT_EQ(io_ring_enter(ring.fd, 4, 4, IO_RING_ENTER_GETEVENTS), 4);
+
+    // Requests that can complete right away do so in submission order. File system I/O finishes
+    // in the background, but a write and a read of the same file still happen in submission order.
+    io_ring_cqe cqe;
+    EXPECT(ring.pop(cqe));
+    EXPECT_EQ(cqe.user_data, 1u);
+    EXPECT_EQ(cqe.result, 0);
+    EXPECT(ring.pop(cqe));
+    EXPECT_EQ(cqe.user_data, 4u);
+    EXPECT_EQ(cqe.result, -EBADF);
+    EXPECT(ring.pop(cqe));
+    EXPECT_EQ(cqe.user_data, 2u);
+    EXPECT_EQ(cqe.result, static_cast<i32>(sizeof(data)));
+    EXPECT(ring.pop(cqe));
+    EXPECT_EQ(cqe.user_data, 3u);
+    EXPECT_EQ(cqe.result, static_cast<i32>(sizeof(data)));
+    EXPECT_EQ(memcmp(buffer, data, sizeof(data)), 0);
+    EXPECT(!ring.pop(cqe));
+
+    close(fd);
+    unlink("/tmp/io-ring-test");
+    destroy_ring(ring);
+}
+
+TEST_CASE(io_ring_parks_blocking_requests)
+{
+    auto ring = create_ring(4);
+    int pipe_fds[2];
+    EXPECT_EQ(pipe(pipe_fds), 0);
+
+    char buffer[8] {};
+    ring.push({ IO_RING_OP_READ, 0, 0, pipe_fds[0], IO_RING_CURRENT_OFFSET, reinterpret_cast<FlatPtr>(buffer), sizeof(buffer), 0, 42 });
+    EXPECT_EQ(io_ring_enter(ring.fd, 1, 0, 0), 1);
+
+    // The read can't complete until there is something in the pipe.
+    io_ring_cqe cqe;
+    EXPECT(!ring.pop(cqe));
+    fd_set fds;
+    FD_ZERO(&fds);
+    FD_SET(ring.fd, &fds);
+    timeval timeout {};
+    EXPECT_EQ(select(ring.fd + 1, &fds, nullptr, nullptr, &timeout), 0);
+
+    EXPECT_EQ(write(pipe_fds[1], "ping", 4), 4);
+    // The ring becomes readable once the parked request can make progress.
+    FD_SET(ring.fd, &fds);
+    EXPECT_EQ(select(ring.fd + 1, &fds, nullptr, nullptr, &timeout), 1);
+
+    EXPECT_EQ(io_ring_enter(ring.fd, 0, 1, IO_RING_ENTER_GETEVENTS), 0);
+    EXPECT(ring.pop(cqe));
+    EXPECT_EQ(cqe.user_data, 42u);
+    EXPECT_EQ(cqe.result, 4);
+    EXPECT_EQ(memcmp(buffer, "ping", 4), 0);
+
+    close(pipe_fds[0]);
+    close(pipe_fds[1]);
+    destroy_ring(ring);
+}
+
+TEST_CASE(io_ring_reads_files_in_the_background)
+{
+    auto ring = create_ring(4);
+    int fd = open("/tmp/io-ring-background-test", O_RDWR | O_CREAT | O_TRUNC, 0600);
+    EXPECT(fd >= 0);
+    EXPECT_EQ(write(fd, "pong", 4), 4);
+
+    char buffer[8] {};
+    ring.push({ IO_RING_OP_READ, 0, 0, fd, 0, reinterpret_cast<FlatPtr>(buffer), sizeof(buffer), 0, 7 });
+    EXPECT_EQ(io_ring_enter(ring.fd, 1, 0, 0), 1);
+
+    // Once the read has finished, the ring becomes readable, and entering it posts the result.
+    fd_set fds;
+    FD_ZERO(&fds);
+    FD_SET(ring.fd, &fds);
+    timeval timeout { 5, 0 };
+    EXPECT_EQ(select(ring.fd + 1, &fds, nullptr, nullptr, &timeout), 1);
+    EXPECT_EQ(io_ring_enter(ring.fd, 0, 0, 0), 0);
+
+    io_ring_cqe cqe;
+    EXPECT(ring.pop(cqe));
+    EXPECT_EQ(cqe.user_data, 7u);
+    EXPECT_EQ(cqe.result, 4);
+    EXPECT_EQ(memcmp(buffer, "pong", 4), 0);
+
+    close(fd);
+    unlink("/tmp/io-ring-background-test");
+    destroy_ring(ring);
+}
+
+TEST_CASE(io_ring_enter_rejects_other_files)
+{
+    int pipe_fds[2];
+    EXPECT_EQ(pipe(pipe_fds), 0);
+    EXPECT_EQ(io_ring_enter(pipe_fds[0], 0, 0, 0), -1);
+    EXPECT_EQ(errno, EINVAL);
+    close(pipe_fds[0]);
+    close(pipe_fds[1]);
+
+    auto ring = create_ring(4);
+    EXPECT_EQ(io_ring_enter(ring.fd, 0, 0, 0x80), -1);
+    EXPECT_EQ(errno, EINVAL);
+    destroy_ring(ring);
+}
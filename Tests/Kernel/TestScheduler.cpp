@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Atomic.h>
+#include <AK/HashTable.h>
+#include <AK/JsonArray.h>
+#include <AK/JsonValue.h>
+#include <AK/String.h>
+#include <AK/Vector.h>
+#include <LibCore/File.h>
+#include <LibCore/ProcessStatisticsReader.h>
+#include <LibTest/TestCase.h>
+#include <poll.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+static size_t processor_count()
+{
+    auto file = Core::File::open("/proc/cpuinfo", Core::OpenMode::ReadOnly);
+    VERIFY(!file.is_error());
+    auto buffer = file.value()->read_all();
+    auto json = JsonValue::from_string({ buffer });
+    VERIFY(!json.is_error() && json.value().is_array());
+    return json.value().as_array().size();
+}
+
+static bool is_scheduling_on_all_processors()
+{
+    auto file = Core::File::open("/proc/cmdline", Core::OpenMode::ReadOnly);
+    VERIFY(!file.is_error());
+    auto command_line = String::copy(file.value()->read_all());
+    return command_line.contains("smp_scheduling=on"sv);
+}
+
+static u64 now_ms()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000ull + now.tv_nsec / 1'000'000;
+}
+
+// A woken up thread should get to run long before this, even with every processor busy.
+static constexpr int max_wakeup_latency_ms = 1000;
+static constexpr u8 round_trip_count = 200;
+
+struct PingPongPair {
+    int ping_fds[2] { -1, -1 };
+    int pong_fds[2] { -1, -1 };
+    u8 round_trips { 0 };
+    u64 max_round_trip_ms { 0 };
+    bool lost_wakeup { false };
+    bool bad_data { false };
+};
+
+static bool wait_for_byte(int fd, u8& byte)
+{
+    pollfd pfd { fd, POLLIN, 0 };
+    if (poll(&pfd, 1, max_wakeup_latency_ms) != 1)
+        return false;
+    return read(fd, &byte, 1) == 1;
+}
+
+static void* pong_thread(void* argument)
+{
+    auto& pair = *static_cast<PingPongPair*>(argument);
+    for (u8 i = 0; i < round_trip_count; ++i) {
+        u8 byte;
+        if (!wait_for_byte(pair.ping_fds[0], byte)) {
+            pair.lost_wakeup = true;
+            break;
+        }
+        ++byte;
+        if (write(pair.pong_fds[1], &byte, 1) != 1)
+            break;
+    }
+    return nullptr;
+}
+
+static void* ping_thread(void* argument)
+{
+    auto& pair = *static_cast<PingPongPair*>(argument);
+    for (u8 i = 0; i < round_trip_count; ++i) {
+        auto start = now_ms();
+        u8 byte = i;
+        if (write(pair.ping_fds[1], &byte, 1) != 1)
+            break;
+        if (!wait_for_byte(pair.pong_fds[0], byte)) {
+            pair.lost_wakeup = true;
+            break;
+        }
+        if (byte != static_cast<u8>(i + 1)) {
+            pair.bad_data = true;
+            break;
+        }
+        pair.max_round_trip_ms = max(pair.max_round_trip_ms, now_ms() - start);
+        ++pair.round_trips;
+    }
+    return nullptr;
+}
+
+TEST_CASE(wakeups_between_thread_pairs)
+{
+    // Bounce a byte back and forth between more thread pairs than there are processors, so that
+    // every round trip wakes up a thread that has to be put on some processor's ready queues.
+    auto pair_count = processor_count() * 2;
+    Vector<PingPongPair> pairs;
+    pairs.resize(pair_count);
+    Vector<pthread_t> threads;
+
+    for (auto& pair : pairs) {
+        EXPECT_EQ(pipe(pair.ping_fds), 0);
+        EXPECT_EQ(pipe(pair.pong_fds), 0);
+        pthread_t pong;
+        pthread_t ping;
+        EXPECT_EQ(pthread_create(&pong, nullptr, pong_thread, &pair), 0);
+        EXPECT_EQ(pthread_create(&ping, nullptr, ping_thread, &pair), 0);
+        threads.append(pong);
+        threads.append(ping);
+    }
+
+    for (auto thread : threads)
+        EXPECT_EQ(pthread_join(thread, nullptr), 0);
+
+    for (auto& pair : pairs) {
+        EXPECT(!pair.lost_wakeup);
+        EXPECT(!pair.bad_data);
+        EXPECT_EQ(pair.round_trips, round_trip_count);
+        EXPECT(pair.max_round_trip_ms < static_cast<u64>(max_wakeup_latency_ms));
+        for (int fd : { pair.ping_fds[0], pair.ping_fds[1], pair.pong_fds[0], pair.pong_fds[1] })
+            close(fd);
+    }
+}
+
+static Atomic<bool> s_should_stop_spinning;
+
+static void* spin_thread(void*)
+{
+    while (!s_should_stop_spinning.load(AK::MemoryOrder::memory_order_relaxed))
+        ;
+    return nullptr;
+}
+
+TEST_CASE(busy_threads_run_on_more_than_one_processor)
+{
+    // Unless asked to, the kernel only runs threads on the BSP.
+    auto count = processor_count();
+    if (count < 2 || !is_scheduling_on_all_processors())
+        return;
+
+    s_should_stop_spinning = false;
+    Vector<pthread_t> threads;
+    for (size_t i = 0; i < count; ++i) {
+        pthread_t thread;
+        EXPECT_EQ(pthread_create(&thread, nullptr, spin_thread, nullptr), 0);
+        threads.append(thread);
+    }
+
+    // Every thread reports the processor it last ran on, so look at them a few times while they spin.
+    HashTable<u32> processors_used;
+    auto pid = getpid();
+    for (int i = 0; i < 10 && processors_used.size() < 2; ++i) {
+        usleep(50'000);
+        auto all_processes = Core::ProcessStatisticsReader::get_all();
+        EXPECT(all_processes.has_value());
+        for (auto& process : all_processes->processes) {
+            if (process.pid != pid)
+                continue;
+            for (auto& thread : process.threads) {
+                if (thread.tid != pid)
+                    processors_used.set(thread.cpu);
+            }
+        }
+    }
+
+    s_should_stop_spinning = true;
+    for (auto thread : threads)
+        EXPECT_EQ(pthread_join(thread, nullptr), 0);
+
+    EXPECT(processors_used.size() >= 2);
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Array.h>
+#include <LibTest/TestCase.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/sendfile.h>
+#include <unistd.h>
+
+static int create_test_file(size_t size)
+{
+    char path[] = "/tmp/sendfile.XXXXXX";
+    int fd = mkstemp(path);
+    VERIFY(fd >= 0);
+    unlink(path);
+    for (size_t i = 0; i < size; ++i) {
+        u8 byte = i % 251;
+        VERIFY(write(fd, &byte, 1) == 1);
+    }
+    VERIFY(lseek(fd, 0, SEEK_SET) == 0);
+    return fd;
+}
+
+TEST_CASE(sendfile_to_pipe)
+{
+    int in_fd = create_test_file(10000);
+    int pipe_fds[2];
+    EXPECT_EQ(pipe(pipe_fds), 0);
+
+    EXPECT_EQ(sendfile(pipe_fds[1], in_fd, nullptr, 5000), 5000);
+    // Without an offset, the file's own offset is used and advanced.
+    EXPECT_EQ(lseek(in_fd, 0, SEEK_CUR), 5000);
+
+    Array<u8, 5000> buffer;
+    EXPECT_EQ(read(pipe_fds[0], buffer.data(), buffer.size()), 5000);
+    for (size_t i = 0; i < buffer.size(); ++i)
+        EXPECT_EQ(buffer[i], i % 251);
+
+    close(pipe_fds[0]);
+    close(pipe_fds[1]);
+    close(in_fd);
+}
+
+TEST_CASE(sendfile_with_offset)
+{
+    int in_fd = create_test_file(10000);
+    int pipe_fds[2];
+    EXPECT_EQ(pipe(pipe_fds), 0);
+
+    off_t offset = 9000;
+    // Only what is left of the file is sent.
+    EXPECT_EQ(sendfile(pipe_fds[1], in_fd, &offset, 5000), 1000);
+    EXPECT_EQ(offset, 10000);
+    // With an offset, the file's own offset is left alone.
+    EXPECT_EQ(lseek(in_fd, 0, SEEK_CUR), 0);
+    EXPECT_EQ(sendfile(pipe_fds[1], in_fd, &offset, 5000), 0);
+
+    Array<u8, 1000> buffer;
+    EXPECT_EQ(read(pipe_fds[0], buffer.data(), buffer.size()), 1000);
+    for (size_t i = 0; i < buffer.size(); ++i)
+        EXPECT_EQ(buffer[i], (9000 + i) % 251);
+
+    close(pipe_fds[0]);
+    close(pipe_fds[1]);
+    close(in_fd);
+}
+
+TEST_CASE(sendfile_to_file)
+{
+    // Spans several pages, and doesn't start at a page boundary.
+    constexpr size_t size = 3 * 4096;
+    int in_fd = create_test_file(size + 123);
+    int out_fd = create_test_file(0);
+
+    off_t offset = 100;
+    EXPECT_EQ(sendfile(out_fd, in_fd, &offset, size), static_cast<ssize_t>(size));
+
+    Array<u8, size> buffer;
+    EXPECT_EQ(pread(out_fd, buffer.data(), buffer.size(), 0), static_cast<ssize_t>(buffer.size()));
+    for (size_t i = 0; i < buffer.size(); ++i)
+        EXPECT_EQ(buffer[i], (100 + i) % 251);
+
+    close(out_fd);
+    close(in_fd);
+}
+
+TEST_CASE(sendfile_from_pipe)
+{
+    int pipe_fds[2];
+    EXPECT_EQ(pipe(pipe_fds), 0);
+    int out_fd = create_test_file(0);
+
+    EXPECT_EQ(sendfile(out_fd, pipe_fds[0], nullptr, 1), -1);
+    EXPECT_EQ(errno, EINVAL);
+
+    close(out_fd);
+    close(pipe_fds[0]);
+    close(pipe_fds[1]);
+}
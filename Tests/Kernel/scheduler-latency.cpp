@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Atomic.h>
+#include <AK/Vector.h>
+#include <LibCore/ArgsParser.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// Bounces a byte back and forth between pairs of threads over pipes. Every round trip
+// makes both threads block and wake up again, so this mostly measures how quickly the
+// scheduler gets a woken thread running, and how well that scales with more pairs.
+
+struct PingPongContext {
+    int ping_fds[2] { -1, -1 };
+    int pong_fds[2] { -1, -1 };
+    Atomic<bool>* should_stop { nullptr };
+    u64 round_trips { 0 };
+    u64 total_latency_ns { 0 };
+    u64 max_latency_ns { 0 };
+    bool failed { false };
+};
+
+static u64 now_ns()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1'000'000'000ull + now.tv_nsec;
+}
+
+static void* pong_thread(void* context_ptr)
+{
+    auto& context = *static_cast<PingPongContext*>(context_ptr);
+    char byte;
+    for (;;) {
+        auto nread = read(context.ping_fds[0], &byte, 1);
+        if (nread == 0)
+            return nullptr;
+        if (nread != 1 || write(context.pong_fds[1], &byte, 1) != 1) {
+            perror("pong");
+            context.failed = true;
+            return nullptr;
+        }
+    }
+}
+
+static void* ping_thread(void* context_ptr)
+{
+    auto& context = *static_cast<PingPongContext*>(context_ptr);
+    char byte = 'x';
+    while (!context.should_stop->load()) {
+        auto start = now_ns();
+        if (write(context.ping_fds[1], &byte, 1) != 1 || read(context.pong_fds[0], &byte, 1) != 1) {
+            perror("ping");
+            context.failed = true;
+            break;
+        }
+        auto latency = now_ns() - start;
+        context.round_trips++;
+        context.total_latency_ns += latency;
+        if (latency > context.max_latency_ns)
+            context.max_latency_ns = latency;
+    }
+    // Closing our end of the ping pipe tells the pong thread to exit.
+    close(context.ping_fds[1]);
+    return nullptr;
+}
+
+int main(int argc, char** argv)
+{
+    int max_pairs = 8;
+    int duration = 2;
+
+    Core::ArgsParser args_parser;
+    args_parser.add_option(max_pairs, "Maximum number of thread pairs", "pairs", 'p', "count");
+    args_parser.add_option(duration, "Seconds to run each pair count for", "duration", 'd', "seconds");
+    args_parser.parse(argc, argv);
+
+    if (max_pairs < 1 || duration < 1) {
+        warnln("Invalid parameters");
+        return EXIT_FAILURE;
+    }
+
+    double single_pair_rate = 0;
+    for (int pair_count = 1; pair_count <= max_pairs; pair_count *= 2) {
+        Atomic<bool> should_stop { false };
+        Vector<PingPongContext> contexts;
+        contexts.resize(pair_count);
+        Vector<pthread_t> threads;
+        threads.resize(pair_count * 2);
+
+        for (auto& context : contexts) {
+            if (pipe(context.ping_fds) < 0 || pipe(context.pong_fds) < 0) {
+                perror("pipe");
+                return EXIT_FAILURE;
+            }
+            context.should_stop = &should_stop;
+        }
+
+        auto start = now_ns();
+        for (int i = 0; i < pair_count; ++i) {
+            if (int rc = pthread_create(&threads[i * 2], nullptr, pong_thread, &contexts[i]); rc != 0) {
+                warnln("pthread_create: {}", strerror(rc));
+                return EXIT_FAILURE;
+            }
+            if (int rc = pthread_create(&threads[i * 2 + 1], nullptr, ping_thread, &contexts[i]); rc != 0) {
+                warnln("pthread_create: {}", strerror(rc));
+                return EXIT_FAILURE;
+            }
+        }
+
+        sleep(duration);
+        should_stop.store(true);
+
+        for (auto thread : threads)
+            pthread_join(thread, nullptr);
+        auto elapsed_seconds = (now_ns() - start) / 1'000'000'000.0;
+
+        u64 round_trips = 0;
+        u64 total_latency_ns = 0;
+        u64 max_latency_ns = 0;
+        bool failed = false;
+        for (auto& context : contexts) {
+            round_trips += context.round_trips;
+            total_latency_ns += context.total_latency_ns;
+            max_latency_ns = max(max_latency_ns, context.max_latency_ns);
+            failed |= context.failed;
+            close(context.ping_fds[0]);
+            close(context.pong_fds[0]);
+            close(context.pong_fds[1]);
+        }
+
+        if (failed)
+            return EXIT_FAILURE;
+
+        double rate = round_trips / elapsed_seconds;
+        if (pair_count == 1)
+            single_pair_rate = rate;
+        double average_latency_us = round_trips > 0 ? total_latency_ns / 1000.0 / round_trips : 0.0;
+        outln("{:3} pair(s): {:10.0} round trips/s ({:.2}x), average {:.2} us, worst {:.2} us",
+            pair_count, rate, single_pair_rate > 0 ? rate / single_pair_rate : 0.0, average_latency_us, max_latency_ns / 1000.0);
+    }
+
+    return EXIT_SUCCESS;
+}
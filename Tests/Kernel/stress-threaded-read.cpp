@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Atomic.h>
+#include <AK/ByteBuffer.h>
+#include <AK/Vector.h>
+#include <LibCore/ArgsParser.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+struct ReaderContext {
+    int fd { -1 };
+    size_t block_size { 0 };
+    size_t file_size { 0 };
+    size_t index { 0 };
+    Atomic<bool>* should_stop { nullptr };
+    u64 bytes_read { 0 };
+    bool failed { false };
+};
+
+// Every block gets its own contents, so a read that returns the wrong block or stale data is caught.
+static u8 expected_byte(size_t block, size_t offset)
+{
+    u32 value = static_cast<u32>(block) * 2654435761u + static_cast<u32>(offset);
+    value ^= value >> 15;
+    return value & 0xff;
+}
+
+static void* reader_thread(void* context_ptr)
+{
+    auto& context = *static_cast<ReaderContext*>(context_ptr);
+    auto buffer_result = ByteBuffer::create_uninitialized(context.block_size);
+    if (buffer_result.is_error()) {
+        context.failed = true;
+        return nullptr;
+    }
+    auto buffer = buffer_result.release_value();
+
+    size_t block_count = context.file_size / context.block_size;
+    size_t block = context.index % block_count;
+    while (!context.should_stop->load()) {
+        auto nread = pread(context.fd, buffer.data(), context.block_size, block * context.block_size);
+        if (nread != static_cast<ssize_t>(context.block_size)) {
+            perror("pread");
+            context.failed = true;
+            return nullptr;
+        }
+        for (size_t i = 0; i < context.block_size; ++i) {
+            if (buffer[i] != expected_byte(block, i)) {
+                warnln("Reader {}: Discrepancy detected at block {} offset {}", context.index, block, i);
+                context.failed = true;
+                return nullptr;
+            }
+        }
+        context.bytes_read += nread;
+        block = (block + 1) % block_count;
+    }
+    return nullptr;
+}
+
+static double elapsed_seconds(timespec const& start, timespec const& end)
+{
+    return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1'000'000'000.0;
+}
+
+int main(int argc, char** argv)
+{
+    char const* target = "/tmp/stress-threaded-read";
+    int max_threads = 8;
+    int block_size = 4096;
+    int file_size = 1 * MiB;
+    int duration = 2;
+
+    Core::ArgsParser args_parser;
+    args_parser.add_option(max_threads, "Maximum number of reader threads", "threads", 't', "count");
+    args_parser.add_option(block_size, "Size of each read", "block-size", 'b', "size");
+    args_parser.add_option(file_size, "Size of the file to read from", "file-size", 's', "size");
+    args_parser.add_option(duration, "Seconds to run each thread count for", "duration", 'd', "seconds");
+    args_parser.add_positional_argument(target, "Scratch file path", "target", Core::ArgsParser::Required::No);
+    args_parser.parse(argc, argv);
+
+    if (max_threads < 1 || block_size < 1 || file_size < block_size || duration < 1) {
+        warnln("Invalid parameters");
+        return EXIT_FAILURE;
+    }
+
+    int fd = open(target, O_CREAT | O_TRUNC | O_RDWR, 0600);
+    if (fd < 0) {
+        perror("open");
+        return EXIT_FAILURE;
+    }
+    unlink(target);
+
+    auto pattern_result = ByteBuffer::create_zeroed(block_size);
+    if (pattern_result.is_error()) {
+        warnln("Failed to allocate a buffer of {} bytes", block_size);
+        return EXIT_FAILURE;
+    }
+    auto pattern = pattern_result.release_value();
+    for (int block = 0; (block + 1) * block_size <= file_size; ++block) {
+        for (int i = 0; i < block_size; ++i)
+            pattern[i] = expected_byte(block, i);
+        if (write(fd, pattern.data(), block_size) != block_size) {
+            perror("write");
+            return EXIT_FAILURE;
+        }
+    }
+
+    double single_thread_throughput = 0;
+    for (int thread_count = 1; thread_count <= max_threads; thread_count *= 2) {
+        Atomic<bool> should_stop { false };
+        Vector<ReaderContext> contexts;
+        contexts.resize(thread_count);
+        Vector<pthread_t> threads;
+        threads.resize(thread_count);
+
+        timespec start;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+
+        for (int i = 0; i < thread_count; ++i) {
+            contexts[i].fd = fd;
+            contexts[i].block_size = block_size;
+            contexts[i].file_size = file_size;
+            contexts[i].index = i;
+            contexts[i].should_stop = &should_stop;
+            if (int rc = pthread_create(&threads[i], nullptr, reader_thread, &contexts[i]); rc != 0) {
+                warnln("pthread_create: {}", strerror(rc));
+                return EXIT_FAILURE;
+            }
+        }
+
+        sleep(duration);
+        should_stop.store(true);
+
+        u64 total_bytes = 0;
+        bool failed = false;
+        for (int i = 0; i < thread_count; ++i) {
+            pthread_join(threads[i], nullptr);
+            total_bytes += contexts[i].bytes_read;
+            failed |= contexts[i].failed;
+        }
+
+        timespec end;
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        if (failed) {
+            warnln("FAIL: {} thread(s) read wrong data", thread_count);
+            return EXIT_FAILURE;
+        }
+
+        double throughput = total_bytes / elapsed_seconds(start, end) / MiB;
+        if (thread_count == 1)
+            single_thread_throughput = throughput;
+        outln("{:3} thread(s): {:10.2} MiB/s ({:.2}x)", thread_count, throughput, single_thread_throughput > 0 ? throughput / single_thread_throughput : 0.0);
+    }
+
+    close(fd);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/ByteBuffer.h>
+#include <LibCore/ArgsParser.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+// Pushes a fixed amount of data through a TCP connection over the loopback interface and
+// reports how long it took. This covers the whole send path: congestion and receive windows,
+// ACK clocking and retransmissions, so a stall anywhere shows up as a drop in throughput.
+
+struct ReceiverContext {
+    int listen_fd { -1 };
+    size_t buffer_size { 0 };
+    u64 bytes_received { 0 };
+    bool failed { false };
+};
+
+static void* receiver_thread(void* context_ptr)
+{
+    auto& context = *static_cast<ReceiverContext*>(context_ptr);
+    int fd = accept(context.listen_fd, nullptr, nullptr);
+    if (fd < 0) {
+        perror("accept");
+        context.failed = true;
+        return nullptr;
+    }
+
+    auto buffer_result = ByteBuffer::create_uninitialized(context.buffer_size);
+    if (buffer_result.is_error()) {
+        context.failed = true;
+        close(fd);
+        return nullptr;
+    }
+    auto buffer = buffer_result.release_value();
+
+    for (;;) {
+        auto nread = read(fd, buffer.data(), buffer.size());
+        if (nread == 0)
+            break;
+        if (nread < 0) {
+            perror("read");
+            context.failed = true;
+            break;
+        }
+        context.bytes_received += nread;
+    }
+    close(fd);
+    return nullptr;
+}
+
+static double elapsed_seconds(timespec const& start, timespec const& end)
+{
+    return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1'000'000'000.0;
+}
+
+int main(int argc, char** argv)
+{
+    int total_mib = 64;
+    int buffer_size = 64 * KiB;
+
+    Core::ArgsParser args_parser;
+    args_parser.add_option(total_mib, "Amount of data to send, in MiB", "size", 's', "MiB");
+    args_parser.add_option(buffer_size, "Size of each write and read", "buffer-size", 'b', "size");
+    args_parser.parse(argc, argv);
+
+    if (total_mib < 1 || buffer_size < 1) {
+        warnln("Invalid parameters");
+        return EXIT_FAILURE;
+    }
+
+    int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        perror("socket");
+        return EXIT_FAILURE;
+    }
+
+    sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+    if (bind(listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        perror("bind");
+        return EXIT_FAILURE;
+    }
+    socklen_t address_length = sizeof(address);
+    if (getsockname(listen_fd, reinterpret_cast<sockaddr*>(&address), &address_length) < 0) {
+        perror("getsockname");
+        return EXIT_FAILURE;
+    }
+    if (listen(listen_fd, 1) < 0) {
+        perror("listen");
+        return EXIT_FAILURE;
+    }
+
+    ReceiverContext context;
+    context.listen_fd = listen_fd;
+    context.buffer_size = buffer_size;
+    pthread_t receiver;
+    if (int rc = pthread_create(&receiver, nullptr, receiver_thread, &context); rc != 0) {
+        warnln("pthread_create: {}", strerror(rc));
+        return EXIT_FAILURE;
+    }
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        perror("socket");
+        return EXIT_FAILURE;
+    }
+    if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        perror("connect");
+        return EXIT_FAILURE;
+    }
+
+    auto buffer_result = ByteBuffer::create_zeroed(buffer_size);
+    if (buffer_result.is_error()) {
+        warnln("Failed to allocate a buffer of {} bytes", buffer_size);
+        return EXIT_FAILURE;
+    }
+    auto buffer = buffer_result.release_value();
+    for (int i = 0; i < buffer_size; ++i)
+        buffer[i] = i & 0xff;
+
+    timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    u64 total_bytes = static_cast<u64>(total_mib) * MiB;
+    u64 bytes_sent = 0;
+    while (bytes_sent < total_bytes) {
+        auto nwritten = write(fd, buffer.data(), min<u64>(buffer.size(), total_bytes - bytes_sent));
+        if (nwritten < 0) {
+            perror("write");
+            return EXIT_FAILURE;
+        }
+        bytes_sent += nwritten;
+    }
+    close(fd);
+
+    pthread_join(receiver, nullptr);
+
+    timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    close(listen_fd);
+
+    if (context.failed)
+        return EXIT_FAILURE;
+    if (context.bytes_received != total_bytes) {
+        warnln("Sent {} bytes, but only {} arrived", total_bytes, context.bytes_received);
+        return EXIT_FAILURE;
+    }
+
+    auto seconds = elapsed_seconds(start, end);
+    outln("Sent {} MiB in {:.2} s: {:.2} MiB/s", total_mib, seconds, total_bytes / seconds / MiB);
+    return EXIT_SUCCESS;
+}
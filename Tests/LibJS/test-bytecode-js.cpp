@@ -134,3 +134,46 @@ TEST_CASE(catch_exception)
                             "if (hitCatch !== true) throw new Exception('failed');\n"
                             "if (hitFinally !== true) throw new Exception('failed');");
 }
+
+TEST_CASE(registers_survive_nested_calls)
+{
+    EXPECT_NO_EXCEPTION_ALL("function inner(a, b) { var x = a * 2; var y = b + 1; return x + y; }\n"
+                            "function outer(a) { var before = a + 10; var r = inner(a, a + 1); return before + r; }\n"
+                            "if (outer(1) !== 16) throw new Exception('failed');\n"
+                            "if (outer(outer(1)) !== 76) throw new Exception('failed');\n"
+                            "function fact(n) { if (n <= 1) return 1; return n * fact(n - 1); }\n"
+                            "if (fact(10) !== 3628800) throw new Exception('failed');");
+}
+
+TEST_CASE(generator_keeps_registers_across_yields)
+{
+    EXPECT_NO_EXCEPTION_ALL("function inner(a, b) { var x = a * 2; var y = b + 1; return x + y; }\n"
+                            "function *g(a) { var local = a; var got = yield local + 1; local = local + inner(got, got); yield local; }\n"
+                            "var gen = g(1);\n"
+                            "if (gen.next().value !== 2) throw new Exception('failed');\n"
+                            // Calling into another function between the resumptions must not clobber the generator's registers.
+                            "if (gen.next(inner(3, 4)).value !== 35) throw new Exception('failed');");
+}
+
+TEST_CASE(exception_unwinds_across_calls)
+{
+    EXPECT_NO_EXCEPTION_ALL("function thrower(depth) { var mine = depth; if (depth === 0) throw 'bottom'; thrower(depth - 1); return mine; }\n"
+                            "function catcher() { var kept = 42; try { thrower(5); } catch (e) { if (e !== 'bottom') throw new Exception('failed'); } return kept; }\n"
+                            "if (catcher() !== 42) throw new Exception('failed');\n"
+                            "var finallyRan = false;\n"
+                            "function withFinally() { try { thrower(3); } finally { finallyRan = true; } }\n"
+                            "var caught;\n"
+                            "try { withFinally(); } catch (e) { caught = e; }\n"
+                            "if (caught !== 'bottom') throw new Exception('failed');\n"
+                            "if (finallyRan !== true) throw new Exception('failed');");
+}
+
+TEST_CASE(uncaught_exception_from_callee)
+{
+    SETUP_AND_PARSE("function thrower() { throw 1; }\n"
+                    "thrower();");
+
+    auto executable = JS::Bytecode::Generator::generate(program);
+    auto result = bytecode_interpreter.run(*executable);
+    EXPECT(result.is_error());
+}
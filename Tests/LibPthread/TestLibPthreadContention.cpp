@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <LibPthread/pthread.h>
+#include <LibTest/TestCase.h>
+
+static constexpr size_t thread_count = 8;
+
+struct SharedState {
+    pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+    pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+    pthread_cond_t waiting_cond = PTHREAD_COND_INITIALIZER;
+    size_t generation { 0 };
+    size_t waiting { 0 };
+    size_t counter { 0 };
+    bool done { false };
+};
+
+static void run_threads(void* (*function)(void*), SharedState& state)
+{
+    pthread_t threads[thread_count];
+    for (auto& thread : threads)
+        EXPECT_EQ(pthread_create(&thread, nullptr, function, &state), 0);
+    for (auto thread : threads)
+        EXPECT_EQ(pthread_join(thread, nullptr), 0);
+}
+
+static void* wait_for_broadcasts(void* argument)
+{
+    auto& state = *static_cast<SharedState*>(argument);
+    pthread_mutex_lock(&state.mutex);
+    size_t seen_generation = 0;
+    for (;;) {
+        ++state.waiting;
+        pthread_cond_signal(&state.waiting_cond);
+        while (state.generation == seen_generation && !state.done)
+            pthread_cond_wait(&state.cond, &state.mutex);
+        if (state.done)
+            break;
+        seen_generation = state.generation;
+    }
+    pthread_mutex_unlock(&state.mutex);
+    return nullptr;
+}
+
+// Every round, all threads wait on the same condition variable until a single broadcast wakes them up.
+static void broadcast_rounds(SharedState& state, size_t rounds)
+{
+    pthread_t threads[thread_count];
+    for (auto& thread : threads)
+        EXPECT_EQ(pthread_create(&thread, nullptr, wait_for_broadcasts, &state), 0);
+
+    pthread_mutex_lock(&state.mutex);
+    for (size_t round = 1; round <= rounds + 1; ++round) {
+        while (state.waiting < thread_count * round)
+            pthread_cond_wait(&state.waiting_cond, &state.mutex);
+        if (round > rounds)
+            state.done = true;
+        else
+            state.generation = round;
+        pthread_cond_broadcast(&state.cond);
+    }
+    pthread_mutex_unlock(&state.mutex);
+
+    for (auto thread : threads)
+        EXPECT_EQ(pthread_join(thread, nullptr), 0);
+    EXPECT_EQ(state.waiting, thread_count * (rounds + 1));
+}
+
+TEST_CASE(cond_broadcast_wakes_all_waiters)
+{
+    SharedState state;
+    broadcast_rounds(state, 10);
+}
+
+static void* increment_under_mutex(void* argument)
+{
+    auto& state = *static_cast<SharedState*>(argument);
+    for (size_t i = 0; i < 10'000; ++i) {
+        pthread_mutex_lock(&state.mutex);
+        ++state.counter;
+        pthread_mutex_unlock(&state.mutex);
+    }
+    return nullptr;
+}
+
+TEST_CASE(contended_mutex)
+{
+    SharedState state;
+    run_threads(increment_under_mutex, state);
+    EXPECT_EQ(state.counter, thread_count * 10'000);
+}
+
+BENCHMARK_CASE(contended_mutex_throughput)
+{
+    SharedState state;
+    for (size_t i = 0; i < 10; ++i)
+        run_threads(increment_under_mutex, state);
+    EXPECT_EQ(state.counter, 10 * thread_count * 10'000);
+}
+
+BENCHMARK_CASE(cond_broadcast_storm)
+{
+    SharedState state;
+    broadcast_rounds(state, 1'000);
+}
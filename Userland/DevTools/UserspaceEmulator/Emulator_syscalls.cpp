@@ -1021,22 +1021,23 @@ u32 Emulator::virt$madvise(FlatPtr, size_t, int)
 
 uid_t Emulator::virt$getuid()
 {
-    return getuid();
+    // NOTE: LibC caches our credentials, but we change them behind its back on behalf of the emulatee.
+    return syscall(SC_getuid);
 }
 
 uid_t Emulator::virt$geteuid()
 {
-    return geteuid();
+    return syscall(SC_geteuid);
 }
 
 gid_t Emulator::virt$getgid()
 {
-    return getgid();
+    return syscall(SC_getgid);
 }
 
 gid_t Emulator::virt$getegid()
 {
-    return getegid();
+    return syscall(SC_getegid);
 }
 
 int Emulator::virt$setuid(uid_t uid)
@@ -22,24 +22,26 @@ int profiling_free_buffer(pid_t);
 
 int futex(uint32_t* userspace_address, int futex_op, uint32_t value, const struct timespec* timeout, uint32_t* userspace_address2, uint32_t value3);
 
+// NOTE: These are meant for futexes that are private to the process, like the ones in LibC and LibPthread.
+//       The kernel can find those without looking at the memory they live in.
 static ALWAYS_INLINE int futex_wait(uint32_t* userspace_address, uint32_t value, const struct timespec* abstime, int clockid)
 {
     int op;
 
     if (abstime) {
         // NOTE: FUTEX_WAIT takes a relative timeout, so use FUTEX_WAIT_BITSET instead!
-        op = FUTEX_WAIT_BITSET;
+        op = FUTEX_WAIT_BITSET_PRIVATE;
         if (clockid == CLOCK_REALTIME || clockid == CLOCK_REALTIME_COARSE)
             op |= FUTEX_CLOCK_REALTIME;
     } else {
-        op = FUTEX_WAIT;
+        op = FUTEX_WAIT_PRIVATE;
     }
     return futex(userspace_address, op, value, abstime, NULL, FUTEX_BITSET_MATCH_ANY);
 }
 
 static ALWAYS_INLINE int futex_wake(uint32_t* userspace_address, uint32_t count)
 {
-    return futex(userspace_address, FUTEX_WAKE, count, NULL, NULL, 0);
+    return futex(userspace_address, FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0);
 }
 
 int purge(int mode);
@@ -35,6 +35,7 @@ __BEGIN_DECLS
 #define AT_EXECFN 31        /* a_ptr points to filename of executed program */
 #define AT_EXE_BASE 32      /* a_ptr holds base address where main program was loaded into memory */
 #define AT_EXE_SIZE 33      /* a_val holds the size of the main program in memory */
+#define AT_TIME_PAGE 34     /* a_ptr points to the kernel time page, mapped read-only */
 
 /* Auxiliary Vector types, from Intel386 ABI ver 1.0 section 2.3.3 */
 typedef struct
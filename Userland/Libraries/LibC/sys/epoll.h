@@ -0,0 +1,20 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <Kernel/API/POSIX/sys/epoll.h>
+#include <signal.h>
+
+__BEGIN_DECLS
+
+int epoll_create(int size);
+int epoll_create1(int flags);
+int epoll_ctl(int epoll_fd, int op, int fd, struct epoll_event* event);
+int epoll_wait(int epoll_fd, struct epoll_event* events, int max_events, int timeout);
+int epoll_pwait(int epoll_fd, struct epoll_event* events, int max_events, int timeout, const sigset_t* sigmask);
+
+__END_DECLS
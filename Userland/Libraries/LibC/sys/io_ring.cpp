@@ -0,0 +1,24 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <errno.h>
+#include <sys/io_ring.h>
+#include <syscall.h>
+
+extern "C" {
+
+int io_ring_setup(unsigned entry_count, int flags, struct io_ring_params* params)
+{
+    int rc = syscall(SC_io_ring_setup, entry_count, flags, params);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+
+int io_ring_enter(int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags)
+{
+    int rc = syscall(SC_io_ring_enter, ring_fd, to_submit, min_complete, flags);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+}
@@ -15,6 +15,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/auxv.h>
 #include <sys/time.h>
 #include <sys/times.h>
 #include <syscall.h>
@@ -411,6 +412,11 @@ static Kernel::TimePage* get_kernel_time_page()
     static Kernel::TimePage* s_kernel_time_page;
     // FIXME: Thread safety
     if (!s_kernel_time_page) {
+        // NOTE: The kernel maps the time page into every program it executes, so we should only have to ask for it if that failed.
+        if (auto address = getauxval(AT_TIME_PAGE)) {
+            s_kernel_time_page = (Kernel::TimePage*)address;
+            return s_kernel_time_page;
+        }
         auto rc = syscall(SC_map_time_page);
         if ((int)rc < 0 && (int)rc > -EMAXERRNO) {
             errno = -(int)rc;
@@ -421,21 +427,66 @@ static Kernel::TimePage* get_kernel_time_page()
     return s_kernel_time_page;
 }
 
+// Computes a precise clock from its coarse counterpart, plus the time that has passed since the kernel last updated it.
+static bool read_precise_clock_from_time_page(Kernel::TimePage& kernel_time_page, clockid_t clock_id, struct timespec* ts)
+{
+#if ARCH(I386) || ARCH(X86_64)
+    auto read_tsc = [] {
+        u32 lsw;
+        u32 msw;
+        asm volatile("rdtsc"
+                     : "=d"(msw), "=a"(lsw));
+        return ((u64)msw << 32) | lsw;
+    };
+
+    u32 update_iteration;
+    u64 elapsed_ns;
+    do {
+        update_iteration = AK::atomic_load(&kernel_time_page.update1, AK::memory_order_acquire);
+        auto multiplier = kernel_time_page.tsc_to_ns_multiplier;
+        if (!multiplier)
+            return false;
+        *ts = kernel_time_page.clocks[Kernel::time_page_coarse_clock_for(clock_id)];
+        // NOTE: Our TSC may be slightly behind the one the kernel read, if we're running on another processor.
+        i64 cycles = (i64)(read_tsc() - kernel_time_page.tsc_at_update);
+        cycles = clamp<i64>(cycles, 0, (i64)kernel_time_page.max_tsc_delta);
+        elapsed_ns = ((u64)cycles * multiplier) >> 32;
+    } while (update_iteration != AK::atomic_load(&kernel_time_page.update2, AK::memory_order_acquire));
+
+    ts->tv_nsec += elapsed_ns;
+    while (ts->tv_nsec >= 1'000'000'000) {
+        ts->tv_nsec -= 1'000'000'000;
+        ++ts->tv_sec;
+    }
+    return true;
+#else
+    (void)kernel_time_page;
+    (void)clock_id;
+    (void)ts;
+    return false;
+#endif
+}
+
 int clock_gettime(clockid_t clock_id, struct timespec* ts)
 {
-    if (Kernel::time_page_supports(clock_id)) {
+    if (Kernel::time_page_supports(clock_id) || Kernel::time_page_supports_with_tsc(clock_id)) {
         if (!ts) {
             errno = EFAULT;
             return -1;
         }
 
         if (auto* kernel_time_page = get_kernel_time_page()) {
-            u32 update_iteration;
-            do {
-                update_iteration = AK::atomic_load(&kernel_time_page->update1, AK::memory_order_acquire);
-                *ts = kernel_time_page->clocks[clock_id];
-            } while (update_iteration != AK::atomic_load(&kernel_time_page->update2, AK::memory_order_acquire));
-            return 0;
+            if (Kernel::time_page_supports_with_tsc(clock_id)) {
+                if (read_precise_clock_from_time_page(*kernel_time_page, clock_id, ts))
+                    return 0;
+            } else {
+                u32 update_iteration;
+                do {
+                    update_iteration = AK::atomic_load(&kernel_time_page->update1, AK::memory_order_acquire);
+                    *ts = kernel_time_page->clocks[clock_id];
+                } while (update_iteration != AK::atomic_load(&kernel_time_page->update2, AK::memory_order_acquire));
+                return 0;
+            }
         }
     }
 
@@ -4,6 +4,7 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/Atomic.h>
 #include <AK/ScopedValueRollback.h>
 #include <AK/String.h>
 #include <AK/Vector.h>
@@ -38,6 +39,31 @@ static __thread int s_cached_tid = 0;
 
 static int s_cached_pid = 0;
 
+// Only this process can change its own credentials, so we cache them until one of the set*id() functions below
+// succeeds. Every cached value is tagged with the generation it was read in, which keeps a thread that raced with
+// such a change from caching a stale value.
+static Atomic<u32> s_credentials_generation { 1 };
+static Atomic<u64> s_cached_uid { 0 };
+static Atomic<u64> s_cached_euid { 0 };
+static Atomic<u64> s_cached_gid { 0 };
+static Atomic<u64> s_cached_egid { 0 };
+
+static u32 cached_credential(Atomic<u64>& cache, int syscall_function)
+{
+    auto generation = s_credentials_generation.load(AK::memory_order_acquire);
+    auto cached = cache.load(AK::memory_order_relaxed);
+    if ((cached >> 32) == generation)
+        return static_cast<u32>(cached);
+    auto value = static_cast<u32>(syscall(syscall_function));
+    cache.store((static_cast<u64>(generation) << 32) | value, AK::memory_order_relaxed);
+    return value;
+}
+
+static void invalidate_cached_credentials()
+{
+    s_credentials_generation.fetch_add(1, AK::memory_order_release);
+}
+
 // https://pubs.opengroup.org/onlinepubs/9699919799/functions/lchown.html
 int lchown(const char* pathname, uid_t uid, gid_t gid)
 {
@@ -268,25 +294,25 @@ int execlp(const char* filename, const char* arg0, ...)
 // https://pubs.opengroup.org/onlinepubs/9699919799/functions/getuid.html
 uid_t geteuid()
 {
-    return syscall(SC_geteuid);
+    return cached_credential(s_cached_euid, SC_geteuid);
 }
 
 // https://pubs.opengroup.org/onlinepubs/9699919799/functions/getegid.html
 gid_t getegid()
 {
-    return syscall(SC_getegid);
+    return cached_credential(s_cached_egid, SC_getegid);
 }
 
 // https://pubs.opengroup.org/onlinepubs/9699919799/functions/getuid.html
 uid_t getuid()
 {
-    return syscall(SC_getuid);
+    return cached_credential(s_cached_uid, SC_getuid);
 }
 
 // https://pubs.opengroup.org/onlinepubs/9699919799/functions/getgid.html
 gid_t getgid()
 {
-    return syscall(SC_getgid);
+    return cached_credential(s_cached_gid, SC_getgid);
 }
 
 // https://pubs.opengroup.org/onlinepubs/9699919799/functions/getpid.html
@@ -656,42 +682,56 @@ unsigned int alarm(unsigned int seconds)
 int seteuid(uid_t euid)
 {
     int rc = syscall(SC_seteuid, euid);
+    if (rc >= 0)
+        invalidate_cached_credentials();
     __RETURN_WITH_ERRNO(rc, rc, -1);
 }
 
 int setegid(gid_t egid)
 {
     int rc = syscall(SC_setegid, egid);
+    if (rc >= 0)
+        invalidate_cached_credentials();
     __RETURN_WITH_ERRNO(rc, rc, -1);
 }
 
 int setuid(uid_t uid)
 {
     int rc = syscall(SC_setuid, uid);
+    if (rc >= 0)
+        invalidate_cached_credentials();
     __RETURN_WITH_ERRNO(rc, rc, -1);
 }
 
 int setgid(gid_t gid)
 {
     int rc = syscall(SC_setgid, gid);
+    if (rc >= 0)
+        invalidate_cached_credentials();
     __RETURN_WITH_ERRNO(rc, rc, -1);
 }
 
 int setreuid(uid_t ruid, uid_t euid)
 {
     int rc = syscall(SC_setreuid, ruid, euid);
+    if (rc >= 0)
+        invalidate_cached_credentials();
     __RETURN_WITH_ERRNO(rc, rc, -1);
 }
 
 int setresuid(uid_t ruid, uid_t euid, uid_t suid)
 {
     int rc = syscall(SC_setresuid, ruid, euid, suid);
+    if (rc >= 0)
+        invalidate_cached_credentials();
     __RETURN_WITH_ERRNO(rc, rc, -1);
 }
 
 int setresgid(gid_t rgid, gid_t egid, gid_t sgid)
 {
     int rc = syscall(SC_setresgid, rgid, egid, sgid);
+    if (rc >= 0)
+        invalidate_cached_credentials();
     __RETURN_WITH_ERRNO(rc, rc, -1);
 }
 
@@ -34,6 +34,11 @@
 #include <time.h>
 #include <unistd.h>
 
+#if defined(__serenity__) || defined(__linux__)
+#    include <sys/epoll.h>
+#    define EVENTLOOP_USE_EPOLL
+#endif
+
 #ifdef __serenity__
 extern bool s_global_initializers_ran;
 #endif
@@ -72,6 +77,87 @@ static thread_local HashTable<Notifier*>* s_notifiers;
 thread_local int EventLoop::s_wake_pipe_fds[2];
 thread_local bool EventLoop::s_wake_pipe_initialized { false };
 
+#ifdef EVENTLOOP_USE_EPOLL
+// With epoll, the kernel remembers which fds we are interested in, so we don't have to hand it
+// all of them again every time we wait, and it only tells us about the ones that are ready.
+// Several notifiers may watch the same fd, so we register the union of their event masks.
+struct NotifierRegistration {
+    Vector<Notifier*, 1> notifiers;
+    u32 registered_events { 0 };
+};
+static thread_local int s_epoll_fd { -1 };
+static thread_local HashMap<int, NotifierRegistration>* s_notifier_registrations;
+// Some fds (like regular files) can't be watched with epoll. select() considers them to be always ready, and so do we.
+static thread_local HashTable<int>* s_always_ready_fds;
+
+static int epoll_ctl_or_fallback(int op, int fd, u32 events)
+{
+    epoll_event event {};
+    event.events = events;
+    event.data.fd = fd;
+    int rc = epoll_ctl(s_epoll_fd, op, fd, &event);
+    // NOTE: Our idea of what is registered can be out of date, e.g. if the fd was closed and opened again.
+    if (rc < 0 && op == EPOLL_CTL_ADD && errno == EEXIST)
+        rc = epoll_ctl(s_epoll_fd, EPOLL_CTL_MOD, fd, &event);
+    else if (rc < 0 && op == EPOLL_CTL_MOD && errno == ENOENT)
+        rc = epoll_ctl(s_epoll_fd, EPOLL_CTL_ADD, fd, &event);
+    return rc;
+}
+
+static void initialize_epoll(int wake_pipe_read_fd)
+{
+    if (s_epoll_fd >= 0)
+        return;
+    s_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (s_epoll_fd < 0) {
+        perror("Core::EventLoop: epoll_create1");
+        VERIFY_NOT_REACHED();
+    }
+    if (epoll_ctl_or_fallback(EPOLL_CTL_ADD, wake_pipe_read_fd, EPOLLIN) < 0) {
+        perror("Core::EventLoop: epoll_ctl(wake pipe)");
+        VERIFY_NOT_REACHED();
+    }
+}
+
+static void update_epoll_registration(int fd)
+{
+    u32 events = 0;
+    auto it = s_notifier_registrations->find(fd);
+    if (it != s_notifier_registrations->end()) {
+        for (auto* notifier : it->value.notifiers) {
+            if (notifier->event_mask() & Notifier::Read)
+                events |= EPOLLIN;
+            if (notifier->event_mask() & Notifier::Write)
+                events |= EPOLLOUT;
+            if (notifier->event_mask() & Notifier::Exceptional)
+                VERIFY_NOT_REACHED();
+        }
+    }
+
+    u32 registered_events = it != s_notifier_registrations->end() ? it->value.registered_events : 0;
+    if (events == registered_events)
+        return;
+
+    if (events == 0) {
+        // NOTE: The fd may have been closed already, in which case it is gone from the epoll set anyway.
+        (void)epoll_ctl(s_epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+        s_always_ready_fds->remove(fd);
+        if (it != s_notifier_registrations->end())
+            it->value.registered_events = 0;
+        return;
+    }
+
+    if (epoll_ctl_or_fallback(registered_events ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, fd, events) < 0) {
+        if (errno != EPERM) {
+            dbgln("Core::EventLoop: Failed to watch fd {}: {}", fd, strerror(errno));
+            return;
+        }
+        s_always_ready_fds->set(fd);
+    }
+    it->value.registered_events = events;
+}
+#endif
+
 void EventLoop::initialize_wake_pipes()
 {
     if (!s_wake_pipe_initialized) {
@@ -320,6 +406,10 @@ EventLoop::EventLoop([[maybe_unused]] MakeInspectable make_inspectable)
         s_event_loop_stack = new Vector<EventLoop&>;
         s_timers = new HashMap<int, NonnullOwnPtr<EventLoopTimer>>;
         s_notifiers = new HashTable<Notifier*>;
+#ifdef EVENTLOOP_USE_EPOLL
+        s_notifier_registrations = new HashMap<int, NotifierRegistration>;
+        s_always_ready_fds = new HashTable<int>;
+#endif
     }
     s_main_event_loop.with_locked([&, this](auto*& main_event_loop) {
         if (main_event_loop == nullptr) {
@@ -340,6 +430,9 @@ EventLoop::EventLoop([[maybe_unused]] MakeInspectable make_inspectable)
     });
 
     initialize_wake_pipes();
+#ifdef EVENTLOOP_USE_EPOLL
+    initialize_epoll(s_wake_pipe_fds[0]);
+#endif
 
     dbgln_if(EVENTLOOP_DEBUG, "{} Core::EventLoop constructed :)", getpid());
 }
@@ -632,6 +725,16 @@ void EventLoop::notify_forked(ForkEvent event)
         s_notifiers->clear();
         s_wake_pipe_initialized = false;
         initialize_wake_pipes();
+#ifdef EVENTLOOP_USE_EPOLL
+        // NOTE: The epoll instance is shared with the parent, so we need one of our own.
+        s_notifier_registrations->clear();
+        s_always_ready_fds->clear();
+        if (s_epoll_fd >= 0) {
+            close(s_epoll_fd);
+            s_epoll_fd = -1;
+        }
+        initialize_epoll(s_wake_pipe_fds[0]);
+#endif
         if (auto* info = signals_info<false>()) {
             info->signal_handlers.clear();
             info->next_signal_id = 0;
@@ -646,6 +749,140 @@ void EventLoop::notify_forked(ForkEvent event)
     VERIFY_NOT_REACHED();
 }
 
+Optional<Time> EventLoop::get_wait_timeout(WaitMode mode)
+{
+    bool queued_events_is_empty;
+    {
+        Threading::MutexLocker locker(m_private->lock);
+        queued_events_is_empty = m_queued_events.is_empty();
+    }
+
+    if (mode != WaitMode::WaitForEvents || !queued_events_is_empty)
+        return Time::zero();
+
+    auto next_timer_expiration = get_next_timer_expiration();
+    if (!next_timer_expiration.has_value())
+        return {};
+    auto timeout = next_timer_expiration.value() - Time::now_monotonic_coarse();
+    if (timeout.is_negative())
+        return Time::zero();
+    return timeout;
+}
+
+// Returns true if there may be more events in the wake pipe than we could read at once.
+bool EventLoop::drain_wake_pipe()
+{
+    int wake_events[8];
+    ssize_t nread;
+    // We might receive another signal while read()ing here. The signal will go to the handle_signal properly,
+    // but we get interrupted. Therefore, just retry while we were interrupted.
+    do {
+        errno = 0;
+        nread = read(s_wake_pipe_fds[0], wake_events, sizeof(wake_events));
+        if (nread == 0)
+            break;
+    } while (nread < 0 && errno == EINTR);
+    if (nread < 0) {
+        perror("Core::EventLoop::wait_for_event: read from wake pipe");
+        VERIFY_NOT_REACHED();
+    }
+    VERIFY(nread > 0);
+    bool wake_requested = false;
+    int event_count = nread / sizeof(wake_events[0]);
+    for (int i = 0; i < event_count; i++) {
+        if (wake_events[i] != 0)
+            dispatch_signal(wake_events[i]);
+        else
+            wake_requested = true;
+    }
+
+    return !wake_requested && nread == sizeof(wake_events);
+}
+
+void EventLoop::dispatch_expired_timers()
+{
+    if (s_timers->is_empty())
+        return;
+
+    auto now = Time::now_monotonic_coarse();
+    for (auto& it : *s_timers) {
+        auto& timer = *it.value;
+        if (!timer.has_expired(now))
+            continue;
+        auto owner = timer.owner.strong_ref();
+        if (timer.fire_when_not_visible == TimerShouldFireWhenNotVisible::No
+            && owner && !owner->is_visible_for_timer_purposes()) {
+            continue;
+        }
+
+        dbgln_if(EVENTLOOP_DEBUG, "Core::EventLoop: Timer {} has expired, sending Core::TimerEvent to {}", timer.timer_id, *owner);
+
+        if (owner)
+            post_event(*owner, make<TimerEvent>(timer.timer_id));
+        if (timer.should_reload) {
+            timer.reload(now);
+        } else {
+            // FIXME: Support removing expired timers that don't want to reload.
+            VERIFY_NOT_REACHED();
+        }
+    }
+}
+
+#ifdef EVENTLOOP_USE_EPOLL
+void EventLoop::wait_for_event(WaitMode mode)
+{
+retry:
+    auto timeout = get_wait_timeout(mode);
+    int timeout_ms = -1;
+    if (!s_always_ready_fds->is_empty())
+        timeout_ms = 0;
+    else if (timeout.has_value())
+        timeout_ms = static_cast<int>(min<i64>(timeout.value().to_milliseconds(), NumericLimits<int>::max()));
+
+    epoll_event events[32];
+    int event_count;
+    do {
+        event_count = epoll_wait(s_epoll_fd, events, array_size(events), timeout_ms);
+        if (event_count < 0 && errno == EINTR && m_exit_requested)
+            return;
+    } while (event_count < 0 && errno == EINTR);
+    if (event_count < 0) {
+        int saved_errno = errno;
+        dbgln("Core::EventLoop::wait_for_event: {} ({}: {})", event_count, saved_errno, strerror(saved_errno));
+        VERIFY_NOT_REACHED();
+    }
+
+    for (int i = 0; i < event_count; ++i) {
+        if (events[i].data.fd == s_wake_pipe_fds[0] && drain_wake_pipe())
+            goto retry;
+    }
+
+    dispatch_expired_timers();
+
+    auto post_notifier_events = [&](int fd, bool readable, bool writable) {
+        auto it = s_notifier_registrations->find(fd);
+        if (it == s_notifier_registrations->end())
+            return;
+        for (auto* notifier : it->value.notifiers) {
+            if (readable && (notifier->event_mask() & Notifier::Event::Read))
+                post_event(*notifier, make<NotifierReadEvent>(fd));
+            if (writable && (notifier->event_mask() & Notifier::Event::Write))
+                post_event(*notifier, make<NotifierWriteEvent>(fd));
+        }
+    };
+
+    for (int i = 0; i < event_count; ++i) {
+        int fd = events[i].data.fd;
+        if (fd == s_wake_pipe_fds[0])
+            continue;
+        // NOTE: Like select(), we report errors and hangups as the fd being ready, so the owner finds out about them.
+        bool has_error = events[i].events & (EPOLLERR | EPOLLHUP);
+        post_notifier_events(fd, has_error || (events[i].events & EPOLLIN), has_error || (events[i].events & EPOLLOUT));
+    }
+    for (int fd : *s_always_ready_fds)
+        post_notifier_events(fd, true, true);
+}
+#else
 void EventLoop::wait_for_event(WaitMode mode)
 {
     fd_set rfds;
@@ -674,30 +911,13 @@ retry:
             VERIFY_NOT_REACHED();
     }
 
-    bool queued_events_is_empty;
-    {
-        Threading::MutexLocker locker(m_private->lock);
-        queued_events_is_empty = m_queued_events.is_empty();
-    }
-
-    Time now;
+    auto wait_timeout = get_wait_timeout(mode);
     struct timeval timeout = { 0, 0 };
-    bool should_wait_forever = false;
-    if (mode == WaitMode::WaitForEvents && queued_events_is_empty) {
-        auto next_timer_expiration = get_next_timer_expiration();
-        if (next_timer_expiration.has_value()) {
-            now = Time::now_monotonic_coarse();
-            auto computed_timeout = next_timer_expiration.value() - now;
-            if (computed_timeout.is_negative())
-                computed_timeout = Time::zero();
-            timeout = computed_timeout.to_timeval();
-        } else {
-            should_wait_forever = true;
-        }
-    }
+    if (wait_timeout.has_value())
+        timeout = wait_timeout.value().to_timeval();
 
 try_select_again:
-    int marked_fd_count = select(max_fd + 1, &rfds, &wfds, nullptr, should_wait_forever ? nullptr : &timeout);
+    int marked_fd_count = select(max_fd + 1, &rfds, &wfds, nullptr, wait_timeout.has_value() ? &timeout : nullptr);
     if (marked_fd_count < 0) {
         int saved_errno = errno;
         if (saved_errno == EINTR) {
@@ -709,59 +929,11 @@ try_select_again:
         VERIFY_NOT_REACHED();
     }
     if (FD_ISSET(s_wake_pipe_fds[0], &rfds)) {
-        int wake_events[8];
-        ssize_t nread;
-        // We might receive another signal while read()ing here. The signal will go to the handle_signal properly,
-        // but we get interrupted. Therefore, just retry while we were interrupted.
-        do {
-            errno = 0;
-            nread = read(s_wake_pipe_fds[0], wake_events, sizeof(wake_events));
-            if (nread == 0)
-                break;
-        } while (nread < 0 && errno == EINTR);
-        if (nread < 0) {
-            perror("Core::EventLoop::wait_for_event: read from wake pipe");
-            VERIFY_NOT_REACHED();
-        }
-        VERIFY(nread > 0);
-        bool wake_requested = false;
-        int event_count = nread / sizeof(wake_events[0]);
-        for (int i = 0; i < event_count; i++) {
-            if (wake_events[i] != 0)
-                dispatch_signal(wake_events[i]);
-            else
-                wake_requested = true;
-        }
-
-        if (!wake_requested && nread == sizeof(wake_events))
+        if (drain_wake_pipe())
             goto retry;
     }
 
-    if (!s_timers->is_empty()) {
-        now = Time::now_monotonic_coarse();
-    }
-
-    for (auto& it : *s_timers) {
-        auto& timer = *it.value;
-        if (!timer.has_expired(now))
-            continue;
-        auto owner = timer.owner.strong_ref();
-        if (timer.fire_when_not_visible == TimerShouldFireWhenNotVisible::No
-            && owner && !owner->is_visible_for_timer_purposes()) {
-            continue;
-        }
-
-        dbgln_if(EVENTLOOP_DEBUG, "Core::EventLoop: Timer {} has expired, sending Core::TimerEvent to {}", timer.timer_id, *owner);
-
-        if (owner)
-            post_event(*owner, make<TimerEvent>(timer.timer_id));
-        if (timer.should_reload) {
-            timer.reload(now);
-        } else {
-            // FIXME: Support removing expired timers that don't want to reload.
-            VERIFY_NOT_REACHED();
-        }
-    }
+    dispatch_expired_timers();
 
     if (!marked_fd_count)
         return;
@@ -777,6 +949,7 @@ try_select_again:
         }
     }
 }
+#endif
 
 bool EventLoopTimer::has_expired(const Time& now) const
 {
@@ -832,11 +1005,34 @@ bool EventLoop::unregister_timer(int timer_id)
 void EventLoop::register_notifier(Badge<Notifier>, Notifier& notifier)
 {
     s_notifiers->set(&notifier);
+#ifdef EVENTLOOP_USE_EPOLL
+    auto& registration = s_notifier_registrations->ensure(notifier.fd());
+    if (!registration.notifiers.contains_slow(&notifier))
+        registration.notifiers.append(&notifier);
+    update_epoll_registration(notifier.fd());
+#endif
 }
 
 void EventLoop::unregister_notifier(Badge<Notifier>, Notifier& notifier)
 {
     s_notifiers->remove(&notifier);
+#ifdef EVENTLOOP_USE_EPOLL
+    auto it = s_notifier_registrations->find(notifier.fd());
+    if (it == s_notifier_registrations->end())
+        return;
+    it->value.notifiers.remove_first_matching([&](auto* other) { return other == &notifier; });
+    update_epoll_registration(notifier.fd());
+    if (it->value.notifiers.is_empty())
+        s_notifier_registrations->remove(it);
+#endif
+}
+
+void EventLoop::update_notifier(Badge<Notifier>, [[maybe_unused]] Notifier& notifier)
+{
+#ifdef EVENTLOOP_USE_EPOLL
+    if (s_notifiers->contains(&notifier))
+        update_epoll_registration(notifier.fd());
+#endif
 }
 
 void EventLoop::wake()
@@ -70,6 +70,7 @@ public:
 
     static void register_notifier(Badge<Notifier>, Notifier&);
     static void unregister_notifier(Badge<Notifier>, Notifier&);
+    static void update_notifier(Badge<Notifier>, Notifier&);
 
     void quit(int);
     void unquit();
@@ -102,6 +103,9 @@ public:
 private:
     void wait_for_event(WaitMode);
     Optional<Time> get_next_timer_expiration();
+    Optional<Time> get_wait_timeout(WaitMode);
+    bool drain_wake_pipe();
+    void dispatch_expired_timers();
     static void dispatch_signal(int);
     static void handle_signal(int);
 
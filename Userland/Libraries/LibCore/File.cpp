@@ -11,6 +11,7 @@
 #include <AK/ScopeGuard.h>
 #include <LibCore/DirIterator.h>
 #include <LibCore/File.h>
+#include <LibCore/System.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <libgen.h>
@@ -415,7 +416,24 @@ ErrorOr<void, File::CopyError> File::copy_file(String const& dst_path, struct st
             return CopyError { errno, false };
     }
 
-    for (;;) {
+    // Let the kernel copy the data if it can, so it doesn't have to pass through our buffer.
+    bool use_sendfile = true;
+    size_t total_nsent = 0;
+    while (use_sendfile) {
+        auto nsent_or_error = System::sendfile(dst_fd, source.fd(), nullptr, 1 * MiB);
+        if (nsent_or_error.is_error()) {
+            if (total_nsent > 0)
+                return CopyError { nsent_or_error.error().code(), false };
+            // Not every kind of file can be sent, so we copy those ourselves below.
+            use_sendfile = false;
+            break;
+        }
+        if (nsent_or_error.value() == 0)
+            break;
+        total_nsent += nsent_or_error.value();
+    }
+
+    while (!use_sendfile) {
         char buffer[32768];
         ssize_t nread = ::read(source.fd(), buffer, sizeof(buffer));
         if (nread < 0) {
@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Atomic.h>
+#include <AK/ScopeGuard.h>
+#include <LibCore/EventLoop.h>
+#include <LibCore/IORing.h>
+#include <LibCore/System.h>
+#include <errno.h>
+#include <sys/mman.h>
+
+#ifdef __serenity__
+#    include <sys/io_ring.h>
+#endif
+
+namespace Core {
+
+// Only supported in serenity mode because we use the io_ring syscalls
+#ifdef __serenity__
+
+ErrorOr<NonnullRefPtr<IORing>> IORing::create(u32 entry_count)
+{
+    io_ring_params params {};
+    int fd = io_ring_setup(entry_count, IO_RING_CLOEXEC, &params);
+    if (fd < 0)
+        return Error::from_errno(errno);
+    ArmedScopeGuard close_fd([fd] { (void)System::close(fd); });
+
+    auto* memory = TRY(System::mmap(nullptr, params.mmap_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0, 0, "IORing"sv));
+    close_fd.disarm();
+
+    auto notifier = Notifier::construct(fd, Notifier::Event::Read);
+    return adopt_ref(*new IORing(fd, params, static_cast<u8*>(memory), move(notifier)));
+}
+
+IORing::IORing(int fd, io_ring_params const& params, u8* memory, NonnullRefPtr<Notifier> notifier)
+    : m_fd(fd)
+    , m_submission_queue_size(params.sq_entries)
+    , m_completion_queue_size(params.cq_entries)
+    , m_memory(memory)
+    , m_memory_size(params.mmap_size)
+    , m_header(reinterpret_cast<io_ring_header*>(memory))
+    , m_submission_queue(reinterpret_cast<io_ring_sqe*>(memory + params.sqes_offset))
+    , m_completion_queue(reinterpret_cast<io_ring_cqe*>(memory + params.cqes_offset))
+    , m_notifier(move(notifier))
+{
+    // NOTE: The ring is readable when requests have completed, or when some that couldn't make progress before
+    //       might be able to now. Entering the ring takes care of the latter, and then we collect the results.
+    m_notifier->on_ready_to_read = [this] {
+        NonnullRefPtr protector { *this };
+        if (auto result = enter(0, 0); result.is_error())
+            dbgln("IORing: Failed to enter the ring: {}", result.error());
+        run_completion_callbacks();
+    };
+}
+
+IORing::~IORing()
+{
+    m_notifier->on_ready_to_read = nullptr;
+    m_notifier->close();
+    (void)System::munmap(m_memory, m_memory_size);
+    (void)System::close(m_fd);
+}
+
+ErrorOr<void> IORing::read(int fd, Bytes buffer, Callback callback)
+{
+    return enqueue({ IO_RING_OP_READ, 0, 0, fd, IO_RING_CURRENT_OFFSET, reinterpret_cast<FlatPtr>(buffer.data()), static_cast<u32>(buffer.size()), 0, 0 }, move(callback));
+}
+
+ErrorOr<void> IORing::read(int fd, Bytes buffer, off_t offset, Callback callback)
+{
+    if (offset < 0)
+        return Error::from_errno(EINVAL);
+    return enqueue({ IO_RING_OP_READ, 0, 0, fd, static_cast<u64>(offset), reinterpret_cast<FlatPtr>(buffer.data()), static_cast<u32>(buffer.size()), 0, 0 }, move(callback));
+}
+
+ErrorOr<void> IORing::write(int fd, ReadonlyBytes buffer, Callback callback)
+{
+    return enqueue({ IO_RING_OP_WRITE, 0, 0, fd, IO_RING_CURRENT_OFFSET, reinterpret_cast<FlatPtr>(buffer.data()), static_cast<u32>(buffer.size()), 0, 0 }, move(callback));
+}
+
+ErrorOr<void> IORing::write(int fd, ReadonlyBytes buffer, off_t offset, Callback callback)
+{
+    if (offset < 0)
+        return Error::from_errno(EINVAL);
+    return enqueue({ IO_RING_OP_WRITE, 0, 0, fd, static_cast<u64>(offset), reinterpret_cast<FlatPtr>(buffer.data()), static_cast<u32>(buffer.size()), 0, 0 }, move(callback));
+}
+
+ErrorOr<void> IORing::recv(int fd, Bytes buffer, int flags, Callback callback)
+{
+    return enqueue({ IO_RING_OP_RECV, 0, 0, fd, 0, reinterpret_cast<FlatPtr>(buffer.data()), static_cast<u32>(buffer.size()), static_cast<u32>(flags), 0 }, move(callback));
+}
+
+ErrorOr<void> IORing::send(int fd, ReadonlyBytes buffer, int flags, Callback callback)
+{
+    return enqueue({ IO_RING_OP_SEND, 0, 0, fd, 0, reinterpret_cast<FlatPtr>(buffer.data()), static_cast<u32>(buffer.size()), static_cast<u32>(flags), 0 }, move(callback));
+}
+
+ErrorOr<void> IORing::accept(int fd, int flags, Callback callback)
+{
+    return enqueue({ IO_RING_OP_ACCEPT, 0, 0, fd, 0, 0, 0, static_cast<u32>(flags), 0 }, move(callback));
+}
+
+ErrorOr<void> IORing::fsync(int fd, Callback callback)
+{
+    return enqueue({ IO_RING_OP_FSYNC, 0, 0, fd, 0, 0, 0, 0, 0 }, move(callback));
+}
+
+ErrorOr<void> IORing::enqueue(io_ring_sqe const& request, Callback callback)
+{
+    auto sqe = request;
+    if (sqe.length > static_cast<u32>(NumericLimits<i32>::max()))
+        return Error::from_errno(EINVAL);
+
+    auto tail = m_header->sq_tail;
+    if (tail - AK::atomic_load(&m_header->sq_head, AK::memory_order_acquire) == m_submission_queue_size) {
+        // The submission queue is full, which only happens if we queued a lot of requests without returning to
+        // the event loop. The kernel may still refuse to take them if there is no room for their completions.
+        TRY(submit());
+        if (tail - AK::atomic_load(&m_header->sq_head, AK::memory_order_acquire) == m_submission_queue_size)
+            return Error::from_errno(EBUSY);
+    }
+
+    sqe.user_data = m_next_user_data++;
+    TRY(m_callbacks.try_set(sqe.user_data, move(callback)));
+    m_submission_queue[tail & (m_submission_queue_size - 1)] = sqe;
+    AK::atomic_store(&m_header->sq_tail, tail + 1, AK::memory_order_release);
+
+    // Everything queued before we get back to the event loop goes to the kernel with a single syscall.
+    if (!m_submit_scheduled) {
+        m_submit_scheduled = true;
+        deferred_invoke([protector = NonnullRefPtr { *this }]() mutable {
+            protector->m_submit_scheduled = false;
+            if (auto result = protector->submit(); result.is_error())
+                dbgln("IORing: Failed to submit requests: {}", result.error());
+        });
+    }
+    return {};
+}
+
+ErrorOr<void> IORing::enter(u32 min_complete, u32 flags)
+{
+    auto to_submit = m_header->sq_tail - AK::atomic_load(&m_header->sq_head, AK::memory_order_acquire);
+    for (;;) {
+        if (io_ring_enter(m_fd, to_submit, min_complete, flags) >= 0)
+            return {};
+        if (errno != EINTR)
+            return Error::from_errno(errno);
+        // NOTE: We only get interrupted if the kernel didn't take any of our requests, so we can simply try again.
+    }
+}
+
+ErrorOr<void> IORing::submit()
+{
+    if (m_header->sq_tail == AK::atomic_load(&m_header->sq_head, AK::memory_order_acquire))
+        return {};
+    return enter(0, 0);
+}
+
+ErrorOr<void> IORing::wait(size_t count)
+{
+    count = min(count, m_callbacks.size());
+    size_t completed = 0;
+    while (completed < count) {
+        TRY(enter(count - completed, IO_RING_ENTER_GETEVENTS));
+        completed += run_completion_callbacks();
+    }
+    return {};
+}
+
+size_t IORing::run_completion_callbacks()
+{
+    size_t completed = 0;
+    for (;;) {
+        // NOTE: Callbacks may wait on the ring themselves, so we can't hold on to the head across them.
+        auto head = m_header->cq_head;
+        if (head == AK::atomic_load(&m_header->cq_tail, AK::memory_order_acquire))
+            return completed;
+        auto cqe = m_completion_queue[head & (m_completion_queue_size - 1)];
+        // NOTE: We hand the slot back to the kernel before running the callback, as it may want to queue more requests.
+        AK::atomic_store(&m_header->cq_head, head + 1, AK::memory_order_release);
+        ++completed;
+
+        auto it = m_callbacks.find(cqe.user_data);
+        if (it == m_callbacks.end())
+            continue;
+        auto callback = move(it->value);
+        m_callbacks.remove(it);
+        if (cqe.result < 0)
+            callback(Error::from_errno(-cqe.result));
+        else
+            callback(static_cast<size_t>(cqe.result));
+    }
+}
+
+#endif
+
+}
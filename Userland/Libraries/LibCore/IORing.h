@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Function.h>
+#include <AK/HashMap.h>
+#include <AK/Noncopyable.h>
+#include <AK/NonnullRefPtr.h>
+#include <AK/RefCounted.h>
+#include <AK/Span.h>
+#include <LibCore/Notifier.h>
+#include <sys/types.h>
+
+struct io_ring_cqe;
+struct io_ring_header;
+struct io_ring_params;
+struct io_ring_sqe;
+
+namespace Core {
+
+// Hands I/O requests to the kernel through an I/O ring, so that any number of them cost a single syscall.
+// Requests are queued up and submitted together once control returns to the event loop (or when submit()
+// is called), and their callbacks run from the event loop as they complete, in no particular order.
+// Buffers passed to a request must stay alive until its callback has run.
+class IORing final : public RefCounted<IORing> {
+    AK_MAKE_NONCOPYABLE(IORing);
+
+public:
+    using Callback = Function<void(ErrorOr<size_t>)>;
+
+    static ErrorOr<NonnullRefPtr<IORing>> create(u32 entry_count = 256);
+    ~IORing();
+
+    // These fail with EBUSY if the kernel has too many of our requests to take any more right now.
+    ErrorOr<void> read(int fd, Bytes, Callback);
+    ErrorOr<void> read(int fd, Bytes, off_t offset, Callback);
+    ErrorOr<void> write(int fd, ReadonlyBytes, Callback);
+    ErrorOr<void> write(int fd, ReadonlyBytes, off_t offset, Callback);
+    ErrorOr<void> recv(int fd, Bytes, int flags, Callback);
+    ErrorOr<void> send(int fd, ReadonlyBytes, int flags, Callback);
+    // The callback gets the new file descriptor.
+    ErrorOr<void> accept(int fd, int flags, Callback);
+    ErrorOr<void> fsync(int fd, Callback);
+
+    // Hands all queued requests to the kernel now, instead of waiting for the event loop to do it.
+    ErrorOr<void> submit();
+    // Submits the queued requests, then blocks until at least `count` requests have completed and runs their callbacks.
+    ErrorOr<void> wait(size_t count = 1);
+
+    size_t pending_request_count() const { return m_callbacks.size(); }
+
+private:
+    IORing(int fd, io_ring_params const&, u8* memory, NonnullRefPtr<Notifier>);
+
+    ErrorOr<void> enqueue(io_ring_sqe const&, Callback);
+    ErrorOr<void> enter(u32 min_complete, u32 flags);
+    // Returns how many completions there were.
+    size_t run_completion_callbacks();
+
+    int m_fd { -1 };
+    u32 m_submission_queue_size { 0 };
+    u32 m_completion_queue_size { 0 };
+    u8* m_memory { nullptr };
+    size_t m_memory_size { 0 };
+    io_ring_header* m_header { nullptr };
+    io_ring_sqe* m_submission_queue { nullptr };
+    io_ring_cqe* m_completion_queue { nullptr };
+
+    u64 m_next_user_data { 0 };
+    HashMap<u64, Callback> m_callbacks;
+    NonnullRefPtr<Notifier> m_notifier;
+    bool m_submit_scheduled { false };
+};
+
+}
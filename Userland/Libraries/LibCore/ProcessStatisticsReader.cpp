@@ -108,6 +108,32 @@ Optional<AllProcessesStatistics> ProcessStatisticsReader::get_all()
     return get_all(proc_all_file);
 }
 
+Optional<Vector<SyscallStatistics>> ProcessStatisticsReader::get_syscall_statistics(pid_t pid)
+{
+    auto file = Core::File::construct(String::formatted("/proc/{}/syscalls", pid));
+    if (!file->open(Core::OpenMode::ReadOnly))
+        return {};
+
+    auto json = JsonValue::from_string(file->read_all());
+    if (json.is_error() || !json.value().is_array())
+        return {};
+
+    Vector<SyscallStatistics> syscalls;
+    json.value().as_array().for_each([&](auto& value) {
+        auto const& syscall_object = value.as_object();
+        SyscallStatistics syscall;
+        syscall.name = syscall_object.get("name").to_string();
+        syscall.count = syscall_object.get("count").to_u64();
+        syscall.total_ns = syscall_object.get("total_ns").to_u64();
+        syscall.max_ns = syscall_object.get("max_ns").to_u64();
+        syscall_object.get("histogram").as_array().for_each([&](auto& bucket) {
+            syscall.histogram.append(bucket.to_u64());
+        });
+        syscalls.append(move(syscall));
+    });
+    return syscalls;
+}
+
 String ProcessStatisticsReader::username_from_uid(uid_t uid)
 {
     if (s_usernames.is_empty()) {
@@ -64,6 +64,16 @@ struct ProcessStatistics {
     String username;
 };
 
+struct SyscallStatistics {
+    // Keep this in sync with /proc/<pid>/syscalls.
+    String name;
+    u64 count;
+    u64 total_ns;
+    u64 max_ns;
+    // Bucket 0 counts syscalls that took less than a microsecond, bucket n those that took [2^(n-1), 2^n) microseconds.
+    Vector<u64> histogram;
+};
+
 struct AllProcessesStatistics {
     Vector<ProcessStatistics> processes;
     u64 total_time_scheduled;
@@ -74,6 +84,8 @@ class ProcessStatisticsReader {
 public:
     static Optional<AllProcessesStatistics> get_all(RefPtr<Core::File>&);
     static Optional<AllProcessesStatistics> get_all();
+    // Syscall accounting has to be enabled through /proc/sys/syscall_statistics for this to return anything.
+    static Optional<Vector<SyscallStatistics>> get_syscall_statistics(pid_t);
 
 private:
     static String username_from_uid(uid_t);
@@ -25,6 +25,10 @@
 #    include <serenity.h>
 #endif
 
+#ifdef __linux__
+#    include <sys/sendfile.h>
+#endif
+
 #if defined(__linux__) && !defined(MFD_CLOEXEC)
 #    include <linux/memfd.h>
 #    include <sys/syscall.h>
@@ -366,6 +370,21 @@ ErrorOr<ssize_t> write(int fd, ReadonlyBytes buffer)
     return rc;
 }
 
+ErrorOr<size_t> sendfile([[maybe_unused]] int out_fd, [[maybe_unused]] int in_fd, [[maybe_unused]] off_t* offset, [[maybe_unused]] size_t count)
+{
+#if defined(__serenity__)
+    int rc = syscall(SC_sendfile, out_fd, in_fd, offset, count);
+    HANDLE_SYSCALL_RETURN_VALUE("sendfile"sv, rc, static_cast<size_t>(rc));
+#elif defined(__linux__)
+    ssize_t rc = ::sendfile(out_fd, in_fd, offset, count);
+    if (rc < 0)
+        return Error::from_syscall("sendfile"sv, -errno);
+    return static_cast<size_t>(rc);
+#else
+    return Error::from_errno(ENOTSUP);
+#endif
+}
+
 ErrorOr<void> kill(pid_t pid, int signal)
 {
     if (::kill(pid, signal) < 0)
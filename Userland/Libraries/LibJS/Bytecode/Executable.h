@@ -10,6 +10,7 @@
 #include <AK/NonnullOwnPtrVector.h>
 #include <LibJS/Bytecode/BasicBlock.h>
 #include <LibJS/Bytecode/IdentifierTable.h>
+#include <LibJS/Bytecode/PropertyLookupCache.h>
 #include <LibJS/Bytecode/StringTable.h>
 
 namespace JS::Bytecode {
@@ -19,6 +20,8 @@ struct Executable {
     NonnullOwnPtrVector<BasicBlock> basic_blocks;
     NonnullOwnPtr<StringTable> string_table;
     NonnullOwnPtr<IdentifierTable> identifier_table;
+    // The inline caches of GetById and PutById live out here, as instructions get copied around bytewise.
+    mutable Vector<PropertyLookupCache> property_lookup_caches;
     size_t number_of_registers { 0 };
 
     String const& get_string(StringTableIndex index) const { return string_table->get(index); }
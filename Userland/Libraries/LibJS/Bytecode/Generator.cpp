@@ -45,11 +45,14 @@ NonnullOwnPtr<Executable> Generator::generate(ASTNode const& node, FunctionKind
             generator.emit<Bytecode::Op::Yield>(nullptr);
         }
     }
+    Vector<PropertyLookupCache> property_lookup_caches;
+    property_lookup_caches.resize(generator.m_next_property_lookup_cache);
     return adopt_own(*new Executable {
         .name = {},
         .basic_blocks = move(generator.m_root_basic_blocks),
         .string_table = move(generator.m_string_table),
         .identifier_table = move(generator.m_identifier_table),
+        .property_lookup_caches = move(property_lookup_caches),
         .number_of_registers = generator.m_next_register });
 }
 
@@ -118,7 +121,7 @@ void Generator::emit_load_from_reference(JS::ASTNode const& node)
             emit<Bytecode::Op::GetByValue>(object_reg);
         } else {
             auto identifier_table_ref = intern_identifier(verify_cast<Identifier>(expression.property()).string());
-            emit<Bytecode::Op::GetById>(identifier_table_ref);
+            emit<Bytecode::Op::GetById>(identifier_table_ref, next_property_lookup_cache());
         }
         return;
     }
@@ -152,7 +155,7 @@ void Generator::emit_store_to_reference(JS::ASTNode const& node)
         } else {
             emit<Bytecode::Op::Load>(value_reg);
             auto identifier_table_ref = intern_identifier(verify_cast<Identifier>(expression.property()).string());
-            emit<Bytecode::Op::PutById>(object_reg, identifier_table_ref);
+            emit<Bytecode::Op::PutById>(object_reg, identifier_table_ref, next_property_lookup_cache());
         }
         return;
     }
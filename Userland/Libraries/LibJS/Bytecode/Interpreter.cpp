@@ -31,6 +31,7 @@ Interpreter::Interpreter(GlobalObject& global_object, Realm& realm)
 {
     VERIFY(!s_current);
     s_current = this;
+    m_register_stack.append({});
 }
 
 Interpreter::~Interpreter()
@@ -39,7 +40,50 @@ Interpreter::~Interpreter()
     s_current = nullptr;
 }
 
-Interpreter::ValueAndFrame Interpreter::run_and_return_frame(Executable const& executable, BasicBlock const* entry_point)
+Span<Value> Interpreter::push_register_window(size_t register_count)
+{
+    auto* chunk = &m_register_stack[m_register_stack_chunk_index];
+    if (chunk->used != 0 && chunk->values.size() - chunk->used < register_count) {
+        ++m_register_stack_chunk_index;
+        if (m_register_stack_chunk_index == m_register_stack.size())
+            m_register_stack.append({});
+        chunk = &m_register_stack[m_register_stack_chunk_index];
+    }
+
+    // Note: Chunks are only resized while empty, as that can move their values.
+    if (chunk->values.size() < register_count) {
+        VERIFY(chunk->used == 0);
+        chunk->values.resize(max(register_count, register_stack_chunk_size));
+    }
+
+    auto window = chunk->values.span().slice(chunk->used, register_count);
+    chunk->used += register_count;
+    for (auto& value : window)
+        value = {};
+    return window;
+}
+
+void Interpreter::pop_register_window(Span<Value> window)
+{
+    auto& chunk = m_register_stack[m_register_stack_chunk_index];
+    VERIFY(chunk.used >= window.size());
+    VERIFY(window.data() == chunk.values.data() + chunk.used - window.size());
+    chunk.used -= window.size();
+    if (chunk.used == 0 && m_register_stack_chunk_index > 0)
+        --m_register_stack_chunk_index;
+}
+
+void Interpreter::gather_roots(HashTable<Cell*>& roots)
+{
+    for (auto window : m_register_windows) {
+        for (auto& value : window) {
+            if (value.is_cell())
+                roots.set(&value.as_cell());
+        }
+    }
+}
+
+Interpreter::ValueAndFrame Interpreter::run_impl(Executable const& executable, BasicBlock const* entry_point, bool return_frame)
 {
     dbgln_if(JS_BYTECODE_DEBUG, "Bytecode::Interpreter will run unit {:p}", &executable);
 
@@ -63,13 +107,15 @@ Interpreter::ValueAndFrame Interpreter::run_and_return_frame(Executable const& e
     }
 
     auto block = entry_point ?: &executable.basic_blocks.first();
-    if (!m_manually_entered_frames.is_empty() && m_manually_entered_frames.last()) {
-        m_register_windows.append(make<RegisterWindow>(m_register_windows.last()));
+    // A resumed generator keeps running on its own registers, so they don't have to be copied back and forth.
+    bool runs_on_entered_frame = !m_manually_entered_frames.is_empty() && m_manually_entered_frames.last();
+    if (runs_on_entered_frame) {
+        VERIFY(registers().size() == executable.number_of_registers);
+        m_register_windows.append(registers());
     } else {
-        m_register_windows.append(make<RegisterWindow>());
+        m_register_windows.append(push_register_window(executable.number_of_registers));
     }
 
-    registers().resize(executable.number_of_registers);
     registers()[Register::global_object_index] = Value(&global_object());
     m_manually_entered_frames.append(false);
 
@@ -118,7 +164,10 @@ Interpreter::ValueAndFrame Interpreter::run_and_return_frame(Executable const& e
         if (will_return)
             break;
 
-        if (pc.at_end() && !will_jump)
+        if (will_jump)
+            continue;
+
+        if (pc.at_end())
             break;
 
         if (!m_saved_exception.is_null())
@@ -139,10 +188,15 @@ Interpreter::ValueAndFrame Interpreter::run_and_return_frame(Executable const& e
     }
 
     OwnPtr<RegisterWindow> frame;
-    if (!m_manually_entered_frames.last()) {
-        frame = m_register_windows.take_last();
-        m_manually_entered_frames.take_last();
+    VERIFY(!m_manually_entered_frames.last());
+    m_manually_entered_frames.take_last();
+    auto window = m_register_windows.take_last();
+    if (return_frame) {
+        frame = make<RegisterWindow>();
+        frame->append(window.data(), window.size());
     }
+    if (!runs_on_entered_frame)
+        pop_register_window(window);
 
     auto return_value = m_return_value.value_or(js_undefined());
     m_return_value = {};
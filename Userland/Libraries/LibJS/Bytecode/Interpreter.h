@@ -17,6 +17,7 @@
 
 namespace JS::Bytecode {
 
+// The registers of a suspended generator, which it owns while it's not running.
 using RegisterWindow = Vector<Value>;
 
 class Interpreter {
@@ -33,7 +34,7 @@ public:
 
     ThrowCompletionOr<Value> run(Bytecode::Executable const& executable, Bytecode::BasicBlock const* entry_point = nullptr)
     {
-        auto value_and_frame = run_and_return_frame(executable, entry_point);
+        auto value_and_frame = run_impl(executable, entry_point, false);
         return value_and_frame.value;
     }
 
@@ -41,25 +42,30 @@ public:
         ThrowCompletionOr<Value> value;
         OwnPtr<RegisterWindow> frame;
     };
-    ValueAndFrame run_and_return_frame(Bytecode::Executable const&, Bytecode::BasicBlock const* entry_point);
+    ValueAndFrame run_and_return_frame(Bytecode::Executable const& executable, Bytecode::BasicBlock const* entry_point)
+    {
+        return run_impl(executable, entry_point, true);
+    }
 
     ALWAYS_INLINE Value& accumulator() { return reg(Register::accumulator()); }
-    Value& reg(Register const& r) { return registers()[r.index()]; }
-    [[nodiscard]] RegisterWindow snapshot_frame() const { return m_register_windows.last(); }
+    ALWAYS_INLINE Value& reg(Register const& r) { return registers()[r.index()]; }
 
-    void enter_frame(RegisterWindow const& frame)
+    // The next executable will run directly on the given registers, instead of getting a fresh window.
+    void enter_frame(RegisterWindow& frame)
     {
         m_manually_entered_frames.append(true);
-        m_register_windows.append(make<RegisterWindow>(frame));
+        m_register_windows.append(frame.span());
     }
-    NonnullOwnPtr<RegisterWindow> pop_frame()
+    void pop_frame()
     {
         VERIFY(!m_manually_entered_frames.is_empty());
         VERIFY(m_manually_entered_frames.last());
         m_manually_entered_frames.take_last();
-        return m_register_windows.take_last();
+        m_register_windows.take_last();
     }
 
+    void gather_roots(HashTable<Cell*>&);
+
     void jump(Label const& label)
     {
         m_pending_jump = &label.block();
@@ -79,14 +85,30 @@ public:
     static Bytecode::PassManager& optimization_pipeline(OptimizationLevel = OptimizationLevel::Default);
 
 private:
-    RegisterWindow& registers() { return m_register_windows.last(); }
+    ValueAndFrame run_impl(Bytecode::Executable const&, Bytecode::BasicBlock const* entry_point, bool return_frame);
+
+    Span<Value> registers() { return m_register_windows.last(); }
+
+    Span<Value> push_register_window(size_t register_count);
+    void pop_register_window(Span<Value>);
+
+    // The registers of all running executables are windows into a stack of chunks, so calls don't
+    // have to allocate. A window never straddles two chunks, so references to registers stay valid
+    // while the stack grows.
+    static constexpr size_t register_stack_chunk_size = 16 * KiB;
+    struct RegisterStackChunk {
+        Vector<Value> values;
+        size_t used { 0 };
+    };
 
     static AK::Array<OwnPtr<PassManager>, static_cast<UnderlyingType<Interpreter::OptimizationLevel>>(Interpreter::OptimizationLevel::__Count)> s_optimization_pipelines;
 
     VM& m_vm;
     GlobalObject& m_global_object;
     Realm& m_realm;
-    NonnullOwnPtrVector<RegisterWindow> m_register_windows;
+    Vector<RegisterStackChunk> m_register_stack;
+    size_t m_register_stack_chunk_index { 0 };
+    Vector<Span<Value>> m_register_windows;
     Vector<bool> m_manually_entered_frames;
     Optional<BasicBlock const*> m_pending_jump;
     Value m_return_value;
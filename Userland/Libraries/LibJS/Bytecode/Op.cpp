@@ -10,6 +10,7 @@
 #include <LibJS/Bytecode/Interpreter.h>
 #include <LibJS/Bytecode/Op.h>
 #include <LibJS/Runtime/AbstractOperations.h>
+#include <LibJS/Runtime/Accessor.h>
 #include <LibJS/Runtime/Array.h>
 #include <LibJS/Runtime/BigInt.h>
 #include <LibJS/Runtime/DeclarativeEnvironment.h>
@@ -272,14 +273,35 @@ ThrowCompletionOr<void> SetVariable::execute_impl(Bytecode::Interpreter& interpr
 ThrowCompletionOr<void> GetById::execute_impl(Bytecode::Interpreter& interpreter) const
 {
     auto* object = TRY(interpreter.accumulator().to_object(interpreter.global_object()));
-    interpreter.accumulator() = TRY(object->get(interpreter.current_executable().get_identifier(m_property)));
+    PropertyKey property_key { interpreter.current_executable().get_identifier(m_property) };
+    auto& cache = interpreter.current_executable().property_lookup_caches[m_cache_index];
+
+    if (auto value = cache.get(*object, property_key); value.has_value()) {
+        if (!value->is_accessor()) {
+            interpreter.accumulator() = *value;
+            return {};
+        }
+        auto* getter = value->as_accessor().getter();
+        interpreter.accumulator() = getter ? TRY(call(interpreter.global_object(), *getter, object)) : js_undefined();
+        return {};
+    }
+
+    interpreter.accumulator() = TRY(object->get(property_key));
+    cache.update_after_get(*object, property_key);
     return {};
 }
 
 ThrowCompletionOr<void> PutById::execute_impl(Bytecode::Interpreter& interpreter) const
 {
     auto* object = TRY(interpreter.reg(m_base).to_object(interpreter.global_object()));
-    TRY(object->set(interpreter.current_executable().get_identifier(m_property), interpreter.accumulator(), Object::ShouldThrowExceptions::Yes));
+    PropertyKey property_key { interpreter.current_executable().get_identifier(m_property) };
+    auto& cache = interpreter.current_executable().property_lookup_caches[m_cache_index];
+
+    if (cache.put(*object, property_key, interpreter.accumulator()))
+        return {};
+
+    TRY(object->set(property_key, interpreter.accumulator(), Object::ShouldThrowExceptions::Yes));
+    cache.update_after_put(*object, property_key);
     return {};
 }
 
@@ -352,9 +374,7 @@ ThrowCompletionOr<void> Call::execute_impl(Bytecode::Interpreter& interpreter) c
     Value return_value;
 
     if (m_argument_count == 0 && m_type == CallType::Call) {
-        auto return_value_or_error = call(interpreter.global_object(), function, this_value);
-        if (!return_value_or_error.is_error())
-            return_value = return_value_or_error.release_value();
+        return_value = TRY(call(interpreter.global_object(), function, this_value));
     } else {
         MarkedVector<Value> argument_values { interpreter.vm().heap() };
         for (size_t i = 0; i < m_argument_count; ++i)
@@ -317,9 +317,10 @@ private:
 
 class GetById final : public Instruction {
 public:
-    explicit GetById(IdentifierTableIndex property)
+    GetById(IdentifierTableIndex property, u32 cache_index)
         : Instruction(Type::GetById)
         , m_property(property)
+        , m_cache_index(cache_index)
     {
     }
 
@@ -329,14 +330,17 @@ public:
 
 private:
     IdentifierTableIndex m_property;
+
+    u32 m_cache_index { 0 };
 };
 
 class PutById final : public Instruction {
 public:
-    explicit PutById(Register base, IdentifierTableIndex property)
+    PutById(Register base, IdentifierTableIndex property, u32 cache_index)
         : Instruction(Type::PutById)
         , m_base(base)
         , m_property(property)
+        , m_cache_index(cache_index)
     {
     }
 
@@ -347,6 +351,8 @@ public:
 private:
     Register m_base;
     IdentifierTableIndex m_property;
+
+    u32 m_cache_index { 0 };
 };
 
 class GetByValue final : public Instruction {
@@ -612,6 +618,8 @@ public:
 
 class FinishUnwind final : public Instruction {
 public:
+    constexpr static bool IsTerminator = true;
+
     FinishUnwind(Label next)
         : Instruction(Type::FinishUnwind)
         , m_next_target(move(next))
@@ -622,6 +630,8 @@ public:
     String to_string_impl(Bytecode::Executable const&) const;
     void replace_references_impl(BasicBlock const&, BasicBlock const&);
 
+    auto& next_target() const { return m_next_target; }
+
 private:
     Label m_next_target;
 };
@@ -91,6 +91,12 @@ void GenerateCFG::perform(PassPipelineExecutable& executable)
             continue;
         }
 
+        if (instruction.type() == Instruction::Type::FinishUnwind) {
+            auto& next_target = static_cast<Op::FinishUnwind const&>(instruction).next_target();
+            enter_label(&next_target, current_block);
+            continue;
+        }
+
         // Otherwise, pop the current block off, it doesn't jump anywhere.
         iterators.take_last();
         entered_blocks.take_last();
@@ -43,6 +43,19 @@ void MergeBlocks::perform(PassPipelineExecutable& executable)
             }
         }
 
+        {
+            // Merging drops the terminator, so only blocks ending in a plain jump can be merged;
+            // the unwind terminators do more than just transfer control.
+            InstructionStreamIterator it { entry.key->instruction_stream() };
+            Instruction const* terminator = nullptr;
+            while (!it.at_end()) {
+                terminator = &*it;
+                ++it;
+            }
+            if (!terminator || terminator->type() != Instruction::Type::Jump)
+                continue;
+        }
+
         if (auto cfg_iter = inverted_cfg.find(*entry.value.begin()); cfg_iter != inverted_cfg.end()) {
             auto& predecessor_entry = cfg_iter->value;
             if (predecessor_entry.size() != 1)
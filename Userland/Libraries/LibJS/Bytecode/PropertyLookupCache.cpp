@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <LibJS/Bytecode/PropertyLookupCache.h>
+#include <LibJS/Runtime/Object.h>
+
+namespace JS::Bytecode {
+
+PropertyLookupCache::Entry const* PropertyLookupCache::find_entry(Object const& object, PropertyKey const& property_key) const
+{
+    auto const& shape = object.shape();
+    for (auto const& entry : m_entries) {
+        if (entry.shape.ptr() != &shape)
+            continue;
+        // Note: Objects of different classes can share a shape, so we can't check this when filling the cache.
+        if (object.has_exotic_behavior_for(property_key))
+            return nullptr;
+        if (entry.in_prototype && entry.prototype_shape.ptr() != &shape.prototype()->shape())
+            return nullptr;
+        return &entry;
+    }
+    return nullptr;
+}
+
+Optional<Value> PropertyLookupCache::get(Object const& object, PropertyKey const& property_key) const
+{
+    auto const* entry = find_entry(object, property_key);
+    if (!entry)
+        return {};
+    if (entry->in_prototype)
+        return object.shape().prototype()->get_direct(entry->offset);
+    return object.get_direct(entry->offset);
+}
+
+bool PropertyLookupCache::put(Object& object, PropertyKey const& property_key, Value value)
+{
+    auto const* entry = find_entry(object, property_key);
+    if (!entry)
+        return false;
+    VERIFY(!entry->in_prototype);
+    object.put_direct(entry->offset, value);
+    return true;
+}
+
+void PropertyLookupCache::update_after_get(Object const& object, PropertyKey const& property_key)
+{
+    if (property_key.is_number() || object.has_exotic_behavior_for(property_key))
+        return;
+    auto const& shape = object.shape();
+    if (shape.is_unique())
+        return;
+
+    auto key = property_key.to_string_or_symbol();
+    if (auto metadata = shape.lookup(key); metadata.has_value()) {
+        add_entry(shape, nullptr, metadata->offset);
+        return;
+    }
+
+    // Note: We only look one level up the prototype chain, as that's where methods usually are.
+    auto const* prototype = shape.prototype();
+    if (!prototype || prototype->has_exotic_behavior_for(property_key))
+        return;
+    auto const& prototype_shape = prototype->shape();
+    if (prototype_shape.is_unique())
+        return;
+    if (auto metadata = prototype_shape.lookup(key); metadata.has_value())
+        add_entry(shape, &prototype_shape, metadata->offset);
+}
+
+void PropertyLookupCache::update_after_put(Object const& object, PropertyKey const& property_key)
+{
+    if (property_key.is_number() || object.has_exotic_behavior_for(property_key))
+        return;
+    auto const& shape = object.shape();
+    if (shape.is_unique())
+        return;
+
+    // Note: Only writable own data properties can be stored to directly. Setters and new properties take the slow path.
+    auto metadata = shape.lookup(property_key.to_string_or_symbol());
+    if (!metadata.has_value() || !metadata->attributes.is_writable() || object.get_direct(metadata->offset).is_accessor())
+        return;
+    add_entry(shape, nullptr, metadata->offset);
+}
+
+void PropertyLookupCache::add_entry(Shape const& shape, Shape const* prototype_shape, u32 offset)
+{
+    // Note: An entry for the same shape is replaced, e.g. after the prototype changed. Otherwise,
+    // once all entries are in use, we replace them in a round-robin fashion.
+    Entry* entry = nullptr;
+    for (auto& existing_entry : m_entries) {
+        if (existing_entry.shape.ptr() == &shape) {
+            entry = &existing_entry;
+            break;
+        }
+    }
+    if (!entry) {
+        entry = &m_entries[m_next_entry_index];
+        m_next_entry_index = (m_next_entry_index + 1) % max_entries;
+    }
+
+    entry->shape = shape.make_weak_ptr<Shape>();
+    entry->in_prototype = prototype_shape != nullptr;
+    entry->prototype_shape = prototype_shape ? prototype_shape->make_weak_ptr<Shape>() : WeakPtr<Shape> {};
+    entry->offset = offset;
+}
+
+}
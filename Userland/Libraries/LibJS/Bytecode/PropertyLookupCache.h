@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Array.h>
+#include <AK/Optional.h>
+#include <AK/WeakPtr.h>
+#include <LibJS/Forward.h>
+#include <LibJS/Runtime/Shape.h>
+
+namespace JS::Bytecode {
+
+// An inline cache for GetById and PutById, remembering where the property was found for the
+// last few shapes the instruction has seen.
+// Any change to an object's properties or prototype gives it a new shape, which simply misses the
+// cache. The exception are unique shapes, which change in place, so they are never cached.
+class PropertyLookupCache {
+public:
+    // Returns the raw property value (which may be an accessor), if the cache knows where it is.
+    Optional<Value> get(Object const&, PropertyKey const&) const;
+    void update_after_get(Object const&, PropertyKey const&);
+
+    // Returns whether the cache knew where to store the value.
+    bool put(Object&, PropertyKey const&, Value);
+    void update_after_put(Object const&, PropertyKey const&);
+
+private:
+    static constexpr size_t max_entries = 4;
+
+    struct Entry {
+        WeakPtr<Shape> shape;
+        // For properties of the prototype, the shape the prototype had.
+        WeakPtr<Shape> prototype_shape;
+        bool in_prototype { false };
+        u32 offset { 0 };
+    };
+
+    Entry const* find_entry(Object const&, PropertyKey const&) const;
+    void add_entry(Shape const&, Shape const* prototype_shape, u32 offset);
+
+    AK::Array<Entry, max_entries> m_entries;
+    size_t m_next_entry_index { 0 };
+};
+
+}
@@ -9,10 +9,21 @@
 #include <AK/Format.h>
 #include <AK/Forward.h>
 #include <AK/Noncopyable.h>
+#include <AK/StdLibExtras.h>
 #include <LibJS/Forward.h>
 
 namespace JS {
 
+// Cells of a class that declares this promise to call write_barrier() whenever they get a new edge after
+// they have been constructed, so that minor collections can skip them while they are in the old generation.
+// Cells of every other class (including subclasses of one that declares it) are always looked at.
+#define JS_DECLARE_WRITE_BARRIER(class_) \
+public:                                  \
+    using WriteBarrierClass = class_
+
+template<typename T>
+concept HasWriteBarrier = IsSame<typename T::WriteBarrierClass, T>;
+
 class Cell {
     AK_MAKE_NONCOPYABLE(Cell);
     AK_MAKE_NONMOVABLE(Cell);
@@ -24,6 +35,17 @@ public:
     bool is_marked() const { return m_mark; }
     void set_marked(bool b) { m_mark = b; }
 
+    // Cells that survive a collection move to the old generation, which minor collections don't sweep.
+    bool is_old() const { return m_is_old; }
+    void set_old(bool b) { m_is_old = b; }
+
+    // Old cells that may point to young ones are remembered, so that minor collections look at them.
+    bool is_remembered() const { return m_is_remembered; }
+    void set_remembered(bool b) { m_is_remembered = b; }
+
+    bool has_write_barrier() const { return m_has_write_barrier; }
+    void set_has_write_barrier(bool b) { m_has_write_barrier = b; }
+
     enum class State {
         Live,
         Dead,
@@ -57,9 +79,23 @@ public:
 protected:
     Cell() { }
 
+    // Must be called when an edge is stored into this cell, either right after storing it, or before handing out
+    // a reference through which it can be stored. A cell that is held on to across a collection stays remembered
+    // until the next one, so allocating between the barrier and the store is fine.
+    ALWAYS_INLINE void write_barrier()
+    {
+        if (m_is_old && !m_is_remembered)
+            remember();
+    }
+
 private:
+    void remember();
+
     bool m_mark : 1 { false };
-    State m_state : 7 { State::Live };
+    bool m_is_old : 1 { false };
+    bool m_is_remembered : 1 { false };
+    bool m_has_write_barrier : 1 { false };
+    State m_state : 4 { State::Live };
 };
 
 }
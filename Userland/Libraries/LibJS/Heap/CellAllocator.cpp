@@ -25,6 +25,8 @@ Cell* CellAllocator::allocate_cell(Heap& heap)
     }
 
     auto& block = *m_usable_blocks.last();
+    if (!block.is_in_nursery())
+        heap.add_nursery_block({}, block);
     auto* cell = block.allocate();
     VERIFY(cell);
     if (block.is_full())
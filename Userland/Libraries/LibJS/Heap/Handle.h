@@ -94,7 +94,7 @@ public:
     auto cell() { return m_handle.cell(); }
     auto cell() const { return m_handle.cell(); }
     auto value() const { return m_value; }
-    bool is_null() const { return m_handle.is_null(); }
+    bool is_null() const { return m_handle.is_null() && m_value.is_empty(); }
 
 private:
     explicit Handle(Value value)
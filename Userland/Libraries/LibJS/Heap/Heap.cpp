@@ -10,6 +10,7 @@
 #include <AK/StackInfo.h>
 #include <AK/TemporaryChange.h>
 #include <LibCore/ElapsedTimer.h>
+#include <LibJS/Bytecode/Interpreter.h>
 #include <LibJS/Heap/CellAllocator.h>
 #include <LibJS/Heap/Handle.h>
 #include <LibJS/Heap/Heap.h>
@@ -29,6 +30,70 @@ namespace JS {
 static int gc_perf_string_id;
 #endif
 
+// Cells are marked when they are first reached, and their edges are visited later from a work list.
+// This keeps marking long chains of cells (like linked lists or deep scopes) from recursing deeply.
+class MarkingVisitor final : public Cell::Visitor {
+public:
+    enum class Mode {
+        // Marks every reachable cell.
+        Everything,
+        // Takes old cells to be alive, and doesn't look any further from them.
+        YoungGeneration,
+        // Marks old cells as it goes, but young cells only have their edges visited once we switch to Everything,
+        // as they don't tell us when they change.
+        Incremental,
+    };
+
+    explicit MarkingVisitor(Mode mode)
+        : m_mode(mode)
+    {
+    }
+
+    void set_mode(Mode mode)
+    {
+        m_mode = mode;
+        if (m_mode != Mode::Everything)
+            return;
+        for (auto* cell : m_deferred_young_cells)
+            m_work_list.append(cell);
+        m_deferred_young_cells.clear();
+    }
+
+    virtual void visit_impl(Cell& cell) override
+    {
+        if (cell.is_marked())
+            return;
+        if (m_mode == Mode::YoungGeneration && cell.is_old())
+            return;
+        dbgln_if(HEAP_DEBUG, "  ! {}", &cell);
+
+        cell.set_marked(true);
+        if (m_mode == Mode::Incremental && !cell.is_old())
+            m_deferred_young_cells.append(&cell);
+        else
+            m_work_list.append(&cell);
+    }
+
+    void mark_all_reachable_cells()
+    {
+        while (!m_work_list.is_empty())
+            m_work_list.take_last()->visit_edges(*this);
+    }
+
+    // Returns whether there is nothing left to mark.
+    bool mark_reachable_cells(size_t cell_count)
+    {
+        for (; cell_count > 0 && !m_work_list.is_empty(); --cell_count)
+            m_work_list.take_last()->visit_edges(*this);
+        return m_work_list.is_empty();
+    }
+
+private:
+    Mode m_mode;
+    Vector<Cell*, 1024> m_work_list;
+    Vector<Cell*> m_deferred_young_cells;
+};
+
 Heap::Heap(VM& vm)
     : m_vm(vm)
 {
@@ -67,21 +132,59 @@ ALWAYS_INLINE CellAllocator& Heap::allocator_for_size(size_t cell_size)
     VERIFY_NOT_REACHED();
 }
 
+// While the old generation is being marked, we do a bit of it every so many allocations. Every step marks
+// a fraction of the old generation, so that we are done well before the nursery fills up.
+static constexpr size_t incremental_marking_step_interval = 1000;
+static constexpr size_t min_incremental_marking_step_size = 10000;
+static constexpr size_t incremental_marking_steps_per_cycle = 50;
+
 Cell* Heap::allocate_cell(size_t size)
 {
     if (should_collect_on_every_allocation()) {
-        collect_garbage();
+        collect_garbage_for_allocation();
     } else if (m_allocations_since_last_gc > m_max_allocations_between_gc) {
-        m_allocations_since_last_gc = 0;
-        collect_garbage();
+        // NOTE: If collections are deferred, we keep coming back here until they aren't anymore.
+        if (!m_gc_deferrals) {
+            if (m_is_incrementally_marking) {
+                finish_incremental_marking();
+            } else {
+                collect_young_generation();
+                if (m_old_cell_count >= m_old_generation_threshold)
+                    start_incremental_marking();
+            }
+        }
     } else {
         ++m_allocations_since_last_gc;
+        if (m_is_incrementally_marking && !m_gc_deferrals && m_allocations_since_last_gc % incremental_marking_step_interval == 0)
+            perform_incremental_marking_step(m_incremental_marking_step_size);
     }
 
     auto& allocator = allocator_for_size(size);
     return allocator.allocate_cell(*this);
 }
 
+void Heap::collect_garbage_for_allocation()
+{
+    if (m_gc_deferrals)
+        return;
+    // Go through every kind of collection as often as we can, to shake out missing edges and write barriers.
+    if (m_is_incrementally_marking) {
+        perform_incremental_marking_step(1);
+        return;
+    }
+    if (++m_minor_collections_since_incremental_marking % 16 == 0)
+        start_incremental_marking();
+    else
+        collect_young_generation();
+}
+
+void Heap::PauseStatistics::record(Time pause)
+{
+    ++pause_count;
+    total_time += pause;
+    longest_pause = max(longest_pause, pause);
+}
+
 void Heap::collect_garbage(CollectionType collection_type, bool print_report)
 {
     VERIFY(!m_collecting_garbage);
@@ -92,23 +195,206 @@ void Heap::collect_garbage(CollectionType collection_type, bool print_report)
     perf_event(PERF_EVENT_SIGNPOST, gc_perf_string_id, global_gc_counter++);
 #endif
 
-    auto collection_measurement_timer = Core::ElapsedTimer::start_new();
+    if (collection_type == CollectionType::CollectGarbage && m_gc_deferrals) {
+        m_should_gc_when_deferral_ends = true;
+        return;
+    }
+
+    // We have to find everything that is garbage right now, so what an ongoing incremental marking found won't do.
+    if (m_is_incrementally_marking)
+        abandon_incremental_marking();
+
+    Core::ElapsedTimer collection_measurement_timer { true };
+    collection_measurement_timer.start();
+    HashTable<Cell*> conservative_roots;
     if (collection_type == CollectionType::CollectGarbage) {
-        if (m_gc_deferrals) {
-            m_should_gc_when_deferral_ends = true;
-            return;
-        }
         HashTable<Cell*> roots;
-        gather_roots(roots);
+        gather_roots(roots, conservative_roots);
         mark_live_cells(roots);
+        unmark_uprooted_cells(Generation::All);
+    }
+    auto marking_time = collection_measurement_timer.elapsed_time();
+
+    forget_remembered_cells();
+    auto sweep_statistics = sweep_dead_cells(Generation::All);
+    update_remembered_cells(conservative_roots);
+    did_collect_everything(sweep_statistics);
+
+    auto time_spent = collection_measurement_timer.elapsed_time();
+    m_full_collection_statistics.record(time_spent);
+
+    if (print_report) {
+        size_t live_block_count = 0;
+        for_each_block([&](auto&) {
+            ++live_block_count;
+            return IterationDecision::Continue;
+        });
+
+        auto report_pauses = [](StringView name, PauseStatistics const& statistics) {
+            auto average_pause = statistics.pause_count ? statistics.total_time.to_microseconds() / static_cast<i64>(statistics.pause_count) : 0;
+            dbgln("{:>15}: {} ({} ms in total, {} us on average, {} us at most)", name, statistics.pause_count, statistics.total_time.to_milliseconds(), average_pause, statistics.longest_pause.to_microseconds());
+        };
+
+        dbgln("Garbage collection report");
+        dbgln("=============================================");
+        dbgln("     Time spent: {} ms", time_spent.to_milliseconds());
+        dbgln("        Marking: {} us", marking_time.to_microseconds());
+        dbgln("       Sweeping: {} us", (time_spent - marking_time).to_microseconds());
+        dbgln("     Live cells: {} ({} bytes)", sweep_statistics.live_cells, sweep_statistics.live_cell_bytes);
+        dbgln("Collected cells: {} ({} bytes)", sweep_statistics.collected_cells, sweep_statistics.collected_cell_bytes);
+        dbgln("    Live blocks: {} ({} bytes)", live_block_count, live_block_count * HeapBlock::block_size);
+        dbgln("   Freed blocks: {} ({} bytes)", sweep_statistics.freed_blocks, sweep_statistics.freed_blocks * HeapBlock::block_size);
+        dbgln("     Remembered: {} cells", m_remembered_cells.size());
+        report_pauses("Full", m_full_collection_statistics);
+        report_pauses("Minor", m_minor_collection_statistics);
+        report_pauses("Marking steps", m_incremental_marking_statistics);
+        dbgln("=============================================");
     }
-    sweep_dead_cells(print_report, collection_measurement_timer);
 }
 
-void Heap::gather_roots(HashTable<Cell*>& roots)
+void Heap::collect_young_generation()
+{
+    VERIFY(!m_collecting_garbage);
+    VERIFY(!m_is_incrementally_marking);
+    TemporaryChange change(m_collecting_garbage, true);
+
+    Core::ElapsedTimer collection_measurement_timer { true };
+    collection_measurement_timer.start();
+
+    HashTable<Cell*> roots;
+    HashTable<Cell*> conservative_roots;
+    gather_roots(roots, conservative_roots);
+
+    // Old cells are alive as far as we are concerned, so we only follow their edges if they may lead to young cells.
+    MarkingVisitor visitor(MarkingVisitor::Mode::YoungGeneration);
+    for (auto* root : roots)
+        visitor.visit(root);
+    for (auto* cell : m_remembered_cells)
+        cell->visit_edges(visitor);
+    visitor.mark_all_reachable_cells();
+    unmark_uprooted_cells(Generation::Young);
+
+    auto sweep_statistics = sweep_dead_cells(Generation::Young);
+    update_remembered_cells(conservative_roots);
+    m_old_cell_count += sweep_statistics.live_cells;
+    m_allocations_since_last_gc = 0;
+
+    m_minor_collection_statistics.record(collection_measurement_timer.elapsed_time());
+}
+
+void Heap::start_incremental_marking()
+{
+    VERIFY(!m_collecting_garbage);
+    VERIFY(!m_is_incrementally_marking);
+
+    // Everything is old once the nursery has been collected, and only old cells have a write barrier that tells us
+    // when they change behind our back. Young cells we run into are only looked at once we are done.
+    if (!m_nursery_blocks.is_empty())
+        collect_young_generation();
+
+    TemporaryChange change(m_collecting_garbage, true);
+    Core::ElapsedTimer step_measurement_timer { true };
+    step_measurement_timer.start();
+
+    m_is_incrementally_marking = true;
+    m_incremental_marking_visitor = make<MarkingVisitor>(MarkingVisitor::Mode::Incremental);
+    m_incremental_marking_step_size = max(min_incremental_marking_step_size, m_old_cell_count / incremental_marking_steps_per_cycle);
+    m_minor_collections_since_incremental_marking = 0;
+
+    HashTable<Cell*> roots;
+    HashTable<Cell*> conservative_roots;
+    gather_roots(roots, conservative_roots);
+    for (auto* root : roots)
+        m_incremental_marking_visitor->visit(root);
+
+    m_incremental_marking_statistics.record(step_measurement_timer.elapsed_time());
+}
+
+void Heap::perform_incremental_marking_step(size_t cell_count)
+{
+    VERIFY(m_is_incrementally_marking);
+    bool is_done;
+    {
+        TemporaryChange change(m_collecting_garbage, true);
+        Core::ElapsedTimer step_measurement_timer { true };
+        step_measurement_timer.start();
+        is_done = m_incremental_marking_visitor->mark_reachable_cells(cell_count);
+        m_incremental_marking_statistics.record(step_measurement_timer.elapsed_time());
+    }
+    if (is_done)
+        finish_incremental_marking();
+}
+
+void Heap::finish_incremental_marking()
+{
+    VERIFY(!m_collecting_garbage);
+    VERIFY(m_is_incrementally_marking);
+    TemporaryChange change(m_collecting_garbage, true);
+
+#ifdef __serenity__
+    static size_t global_gc_counter = 0;
+    perf_event(PERF_EVENT_SIGNPOST, gc_perf_string_id, global_gc_counter++);
+#endif
+
+    Core::ElapsedTimer collection_measurement_timer { true };
+    collection_measurement_timer.start();
+
+    // The mutator kept going while we were marking, so we have to look again at everything it may have changed:
+    // the roots, the old cells that got new edges (or don't tell us about them), and all the young cells.
+    HashTable<Cell*> roots;
+    HashTable<Cell*> conservative_roots;
+    gather_roots(roots, conservative_roots);
+    auto& visitor = *m_incremental_marking_visitor;
+    visitor.set_mode(MarkingVisitor::Mode::Everything);
+    for (auto* root : roots)
+        visitor.visit(root);
+    for (auto* cell : m_remembered_cells) {
+        if (cell->is_marked())
+            cell->visit_edges(visitor);
+    }
+    visitor.mark_all_reachable_cells();
+    unmark_uprooted_cells(Generation::All);
+
+    m_is_incrementally_marking = false;
+    m_incremental_marking_visitor = nullptr;
+
+    forget_remembered_cells();
+    auto sweep_statistics = sweep_dead_cells(Generation::All);
+    update_remembered_cells(conservative_roots);
+    did_collect_everything(sweep_statistics);
+
+    m_full_collection_statistics.record(collection_measurement_timer.elapsed_time());
+}
+
+void Heap::abandon_incremental_marking()
+{
+    VERIFY(m_is_incrementally_marking);
+    m_is_incrementally_marking = false;
+    m_incremental_marking_visitor = nullptr;
+    for_each_block([&](auto& block) {
+        block.template for_each_cell_in_state<Cell::State::Live>([](Cell* cell) {
+            cell->set_marked(false);
+        });
+        return IterationDecision::Continue;
+    });
+}
+
+void Heap::did_collect_everything(SweepStatistics const& sweep_statistics)
+{
+    m_old_cell_count = sweep_statistics.live_cells;
+    m_old_generation_threshold = max(m_old_generation_threshold, m_old_cell_count * 2);
+    m_allocations_since_last_gc = 0;
+}
+
+void Heap::gather_roots(HashTable<Cell*>& roots, HashTable<Cell*>& conservative_roots)
 {
     vm().gather_roots(roots);
-    gather_conservative_roots(roots);
+    gather_conservative_roots(conservative_roots);
+    for (auto* root : conservative_roots)
+        roots.set(root);
+
+    if (auto* bytecode_interpreter = Bytecode::Interpreter::current())
+        bytecode_interpreter->gather_roots(roots);
 
     for (auto& handle : m_handles)
         roots.set(handle.cell());
@@ -123,6 +409,19 @@ void Heap::gather_roots(HashTable<Cell*>& roots)
     }
 }
 
+static void add_possible_value(HashTable<FlatPtr>& possible_pointers, FlatPtr data)
+{
+    if constexpr (sizeof(FlatPtr) == sizeof(Value)) {
+        // Values keep a tag in the top bits of cell pointers, so we have to strip it to find the cell.
+        if (Value::is_boxed_cell(data)) {
+            possible_pointers.set(Value::unbox_cell_pointer(data));
+            return;
+        }
+    }
+    // On 32-bit targets, the pointer half of a Value is a plain pointer on its own.
+    possible_pointers.set(data);
+}
+
 __attribute__((no_sanitize("address"))) void Heap::gather_conservative_roots(HashTable<Cell*>& roots)
 {
     FlatPtr dummy;
@@ -137,14 +436,14 @@ __attribute__((no_sanitize("address"))) void Heap::gather_conservative_roots(Has
     auto* raw_jmp_buf = reinterpret_cast<FlatPtr const*>(buf);
 
     for (size_t i = 0; i < ((size_t)sizeof(buf)) / sizeof(FlatPtr); i += sizeof(FlatPtr))
-        possible_pointers.set(raw_jmp_buf[i]);
+        add_possible_value(possible_pointers, raw_jmp_buf[i]);
 
     auto stack_reference = bit_cast<FlatPtr>(&dummy);
     auto& stack_info = m_vm.stack_info();
 
     for (FlatPtr stack_address = stack_reference; stack_address < stack_info.top(); stack_address += sizeof(FlatPtr)) {
         auto data = *reinterpret_cast<FlatPtr*>(stack_address);
-        possible_pointers.set(data);
+        add_possible_value(possible_pointers, data);
     }
 
     HashTable<HeapBlock*> all_live_heap_blocks;
@@ -171,68 +470,77 @@ __attribute__((no_sanitize("address"))) void Heap::gather_conservative_roots(Has
     }
 }
 
-class MarkingVisitor final : public Cell::Visitor {
-public:
-    MarkingVisitor() { }
-
-    virtual void visit_impl(Cell& cell) override
-    {
-        if (cell.is_marked())
-            return;
-        dbgln_if(HEAP_DEBUG, "  ! {}", &cell);
-
-        cell.set_marked(true);
-        cell.visit_edges(*this);
-    }
-};
-
 void Heap::mark_live_cells(const HashTable<Cell*>& roots)
 {
     dbgln_if(HEAP_DEBUG, "mark_live_cells:");
 
-    MarkingVisitor visitor;
+    MarkingVisitor visitor(MarkingVisitor::Mode::Everything);
     for (auto* root : roots)
         visitor.visit(root);
+    visitor.mark_all_reachable_cells();
+}
 
-    for (auto& inverse_root : m_uprooted_cells)
-        inverse_root->set_marked(false);
-
-    m_uprooted_cells.clear();
+void Heap::unmark_uprooted_cells(Generation generation)
+{
+    // Old cells aren't marked by minor collections, so they stay uprooted until the next time everything is.
+    m_uprooted_cells.remove_all_matching([&](Cell* cell) {
+        if (generation == Generation::Young && cell->is_old())
+            return false;
+        cell->set_marked(false);
+        return true;
+    });
 }
 
-void Heap::sweep_dead_cells(bool print_report, const Core::ElapsedTimer& measurement_timer)
+Heap::SweepStatistics Heap::sweep_dead_cells(Generation generation)
 {
     dbgln_if(HEAP_DEBUG, "sweep_dead_cells:");
     Vector<HeapBlock*, 32> empty_blocks;
     Vector<HeapBlock*, 32> full_blocks_that_became_usable;
 
-    size_t collected_cells = 0;
-    size_t live_cells = 0;
-    size_t collected_cell_bytes = 0;
-    size_t live_cell_bytes = 0;
+    SweepStatistics statistics;
 
-    for_each_block([&](auto& block) {
+    auto sweep_block = [&](HeapBlock& block) {
         bool block_has_live_cells = false;
         bool block_was_full = block.is_full();
-        block.template for_each_cell_in_state<Cell::State::Live>([&](Cell* cell) {
+        block.for_each_cell_in_state<Cell::State::Live>([&](Cell* cell) {
+            if (generation == Generation::Young && cell->is_old()) {
+                block_has_live_cells = true;
+                return;
+            }
             if (!cell->is_marked()) {
                 dbgln_if(HEAP_DEBUG, "  ~ {}", cell);
                 block.deallocate(cell);
-                ++collected_cells;
-                collected_cell_bytes += block.cell_size();
+                ++statistics.collected_cells;
+                statistics.collected_cell_bytes += block.cell_size();
             } else {
                 cell->set_marked(false);
+                cell->set_old(true);
+                if (!cell->has_write_barrier() && !cell->is_remembered())
+                    add_remembered_cell(*cell);
                 block_has_live_cells = true;
-                ++live_cells;
-                live_cell_bytes += block.cell_size();
+                ++statistics.live_cells;
+                statistics.live_cell_bytes += block.cell_size();
             }
         });
         if (!block_has_live_cells)
             empty_blocks.append(&block);
         else if (block_was_full != block.is_full())
             full_blocks_that_became_usable.append(&block);
-        return IterationDecision::Continue;
-    });
+    };
+
+    if (generation == Generation::Young) {
+        for (auto* block : m_nursery_blocks)
+            sweep_block(*block);
+    } else {
+        for_each_block([&](auto& block) {
+            sweep_block(block);
+            return IterationDecision::Continue;
+        });
+    }
+
+    for (auto* block : m_nursery_blocks)
+        block->set_in_nursery(false);
+    m_nursery_blocks.clear();
 
     for (auto& weak_container : m_weak_containers)
         weak_container.remove_dead_cells({});
@@ -254,26 +562,59 @@ void Heap::sweep_dead_cells(bool print_report, const Core::ElapsedTimer& measure
         });
     }
 
-    int time_spent = measurement_timer.elapsed();
+    statistics.freed_blocks = empty_blocks.size();
+    return statistics;
+}
 
-    if (print_report) {
-        size_t live_block_count = 0;
-        for_each_block([&](auto&) {
-            ++live_block_count;
-            return IterationDecision::Continue;
-        });
+void Cell::remember()
+{
+    heap().remember_cell({}, *this);
+}
 
-        dbgln("Garbage collection report");
-        dbgln("=============================================");
-        dbgln("     Time spent: {} ms", time_spent);
-        dbgln("     Live cells: {} ({} bytes)", live_cells, live_cell_bytes);
-        dbgln("Collected cells: {} ({} bytes)", collected_cells, collected_cell_bytes);
-        dbgln("    Live blocks: {} ({} bytes)", live_block_count, live_block_count * HeapBlock::block_size);
-        dbgln("   Freed blocks: {} ({} bytes)", empty_blocks.size(), empty_blocks.size() * HeapBlock::block_size);
-        dbgln("=============================================");
+void Heap::remember_cell(Badge<Cell>, Cell& cell)
+{
+    add_remembered_cell(cell);
+}
+
+void Heap::add_remembered_cell(Cell& cell)
+{
+    VERIFY(!cell.is_remembered());
+    cell.set_remembered(true);
+    m_remembered_cells.append(&cell);
+}
+
+void Heap::forget_remembered_cells()
+{
+    for (auto* cell : m_remembered_cells)
+        cell->set_remembered(false);
+    m_remembered_cells.clear();
+}
+
+void Heap::update_remembered_cells(HashTable<Cell*> const& conservative_roots)
+{
+    // Cells with a write barrier will tell us again if they get new edges to young cells, and there are none left now.
+    m_remembered_cells.remove_all_matching([](Cell* cell) {
+        if (!cell->has_write_barrier())
+            return false;
+        cell->set_remembered(false);
+        return true;
+    });
+
+    // Whoever is holding on to these may have gone through the write barrier before the collection, and may store
+    // an edge into them after it. So we keep them remembered until the next collection.
+    for (auto* cell : conservative_roots) {
+        if (cell->state() == Cell::State::Live && !cell->is_remembered())
+            add_remembered_cell(*cell);
     }
 }
 
+void Heap::add_nursery_block(Badge<CellAllocator>, HeapBlock& block)
+{
+    VERIFY(!block.is_in_nursery());
+    block.set_in_nursery(true);
+    m_nursery_blocks.append(&block);
+}
+
 void Heap::did_create_handle(Badge<HandleImpl>, HandleImpl& impl)
 {
     VERIFY(!m_handles.contains(impl));
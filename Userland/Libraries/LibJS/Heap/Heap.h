@@ -11,6 +11,8 @@
 #include <AK/IntrusiveList.h>
 #include <AK/Noncopyable.h>
 #include <AK/NonnullOwnPtr.h>
+#include <AK/OwnPtr.h>
+#include <AK/Time.h>
 #include <AK/Types.h>
 #include <AK/Vector.h>
 #include <LibCore/Forward.h>
@@ -25,6 +27,12 @@
 
 namespace JS {
 
+class MarkingVisitor;
+
+// Cells start out young, in whatever blocks they were allocated in (the nursery), and move to the old generation
+// once they survive a collection. Most collections are minor ones, which only mark young cells, starting from the
+// roots and the remembered old cells that may point to them, and only sweep the nursery. Once the old generation
+// has grown enough, it is marked a bit at a time between allocations, and then swept along with everything else.
 class Heap {
     AK_MAKE_NONCOPYABLE(Heap);
     AK_MAKE_NONMOVABLE(Heap);
@@ -38,7 +46,10 @@ public:
     {
         auto* memory = allocate_cell(sizeof(T));
         new (memory) T(forward<Args>(args)...);
-        return static_cast<T*>(memory);
+        auto* cell = static_cast<T*>(memory);
+        if constexpr (HasWriteBarrier<T>)
+            cell->set_has_write_barrier(true);
+        return cell;
     }
 
     template<typename T, typename... Args>
@@ -47,6 +58,8 @@ public:
         auto* memory = allocate_cell(sizeof(T));
         new (memory) T(forward<Args>(args)...);
         auto* cell = static_cast<T*>(memory);
+        if constexpr (HasWriteBarrier<T>)
+            cell->set_has_write_barrier(true);
         cell->initialize(global_object);
         return cell;
     }
@@ -56,6 +69,7 @@ public:
         CollectEverything,
     };
 
+    // Collects everything that is garbage right now, all at once.
     void collect_garbage(CollectionType = CollectionType::CollectGarbage, bool print_report = false);
 
     VM& vm() { return m_vm; }
@@ -79,13 +93,41 @@ public:
 
     void uproot_cell(Cell* cell);
 
+    void remember_cell(Badge<Cell>, Cell&);
+    void add_nursery_block(Badge<CellAllocator>, HeapBlock&);
+
 private:
     Cell* allocate_cell(size_t);
+    void collect_garbage_for_allocation();
+
+    enum class Generation {
+        Young,
+        All,
+    };
+
+    struct SweepStatistics {
+        size_t collected_cells { 0 };
+        size_t live_cells { 0 };
+        size_t collected_cell_bytes { 0 };
+        size_t live_cell_bytes { 0 };
+        size_t freed_blocks { 0 };
+    };
 
-    void gather_roots(HashTable<Cell*>&);
+    void collect_young_generation();
+    void start_incremental_marking();
+    void perform_incremental_marking_step(size_t cell_count);
+    void finish_incremental_marking();
+    void abandon_incremental_marking();
+
+    void gather_roots(HashTable<Cell*>& roots, HashTable<Cell*>& conservative_roots);
     void gather_conservative_roots(HashTable<Cell*>&);
     void mark_live_cells(const HashTable<Cell*>& live_cells);
-    void sweep_dead_cells(bool print_report, const Core::ElapsedTimer&);
+    void unmark_uprooted_cells(Generation);
+    SweepStatistics sweep_dead_cells(Generation);
+    void forget_remembered_cells();
+    void add_remembered_cell(Cell&);
+    void update_remembered_cells(HashTable<Cell*> const& conservative_roots);
+    void did_collect_everything(SweepStatistics const&);
 
     CellAllocator& allocator_for_size(size_t);
 
@@ -101,6 +143,18 @@ private:
     size_t m_max_allocations_between_gc { 100000 };
     size_t m_allocations_since_last_gc { 0 };
 
+    // Once the old generation has grown to this many cells, we start marking it.
+    size_t m_old_generation_threshold { 100000 };
+    size_t m_old_cell_count { 0 };
+
+    Vector<HeapBlock*> m_nursery_blocks;
+    Vector<Cell*> m_remembered_cells;
+
+    bool m_is_incrementally_marking { false };
+    OwnPtr<MarkingVisitor> m_incremental_marking_visitor;
+    size_t m_incremental_marking_step_size { 0 };
+    size_t m_minor_collections_since_incremental_marking { 0 };
+
     bool m_should_collect_on_every_allocation { false };
 
     VM& m_vm;
@@ -119,6 +173,18 @@ private:
     bool m_should_gc_when_deferral_ends { false };
 
     bool m_collecting_garbage { false };
+
+    // Reported alongside each print_report collection, to keep an eye on pause times.
+    struct PauseStatistics {
+        size_t pause_count { 0 };
+        Time total_time;
+        Time longest_pause;
+
+        void record(Time);
+    };
+    PauseStatistics m_full_collection_statistics;
+    PauseStatistics m_minor_collection_statistics;
+    PauseStatistics m_incremental_marking_statistics;
 };
 
 }
@@ -67,6 +67,10 @@ public:
 
     Heap& heap() { return m_heap; }
 
+    // Blocks that cells have been allocated in since the last collection, and which minor collections sweep.
+    bool is_in_nursery() const { return m_is_in_nursery; }
+    void set_in_nursery(bool b) { m_is_in_nursery = b; }
+
     static HeapBlock* from_cell(const Cell* cell)
     {
         return reinterpret_cast<HeapBlock*>((FlatPtr)cell & ~(block_size - 1));
@@ -110,6 +114,7 @@ private:
     size_t m_cell_size { 0 };
     size_t m_next_lazy_freelist_index { 0 };
     FreelistEntry* m_freelist { nullptr };
+    bool m_is_in_nursery { false };
     alignas(Cell) u8 m_storage[];
 
 public:
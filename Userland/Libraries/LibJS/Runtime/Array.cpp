@@ -226,4 +226,10 @@ ThrowCompletionOr<MarkedVector<Value>> Array::internal_own_property_keys() const
     return { move(keys) };
 }
 
+bool Array::has_exotic_behavior_for(PropertyKey const& property_key) const
+{
+    // Note: An Array's "length" isn't in its shape, see internal_get_own_property() above.
+    return property_key.is_string() && property_key.as_string() == vm().names.length.as_string();
+}
+
 }
@@ -18,6 +18,7 @@ namespace JS {
 
 class Array : public Object {
     JS_OBJECT(Array, Object);
+    JS_DECLARE_WRITE_BARRIER(Array);
 
 public:
     static ThrowCompletionOr<Array*> create(GlobalObject&, size_t length, Object* prototype = nullptr);
@@ -41,6 +42,7 @@ public:
     virtual ThrowCompletionOr<bool> internal_define_own_property(PropertyKey const&, PropertyDescriptor const&) override;
     virtual ThrowCompletionOr<bool> internal_delete(PropertyKey const&) override;
     virtual ThrowCompletionOr<MarkedVector<Value>> internal_own_property_keys() const override;
+    virtual bool has_exotic_behavior_for(PropertyKey const&) const override;
 
     [[nodiscard]] bool length_is_writable() const { return m_length_writable; };
 
@@ -12,6 +12,8 @@
 namespace JS {
 
 class BigInt final : public Cell {
+    JS_DECLARE_WRITE_BARRIER(BigInt);
+
 public:
     explicit BigInt(Crypto::SignedBigInteger);
     virtual ~BigInt();
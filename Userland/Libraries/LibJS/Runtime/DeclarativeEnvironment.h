@@ -16,6 +16,7 @@ namespace JS {
 
 class DeclarativeEnvironment : public Environment {
     JS_ENVIRONMENT(DeclarativeEnvironment, Environment);
+    JS_DECLARE_WRITE_BARRIER(DeclarativeEnvironment);
 
 public:
     DeclarativeEnvironment();
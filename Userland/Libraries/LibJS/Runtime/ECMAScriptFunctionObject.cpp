@@ -309,6 +309,7 @@ void ECMAScriptFunctionObject::make_method(Object& home_object)
 {
     // 1. Set F.[[HomeObject]] to homeObject.
     m_home_object = &home_object;
+    write_barrier();
 
     // 2. Return NormalCompletion(undefined).
 }
@@ -778,6 +779,14 @@ Completion ECMAScriptFunctionObject::ordinary_call_evaluate_body()
             if (JS::Bytecode::g_dump_bytecode)
                 m_bytecode_executable->dump();
         }
+        // NOTE: Running the bytecode should eventually return a completion.
+        // Until it does, we assume "return" and include the undefined fallback from the call site.
+        if (m_kind == FunctionKind::Normal) {
+            auto result = TRY(bytecode_interpreter->run(*m_bytecode_executable));
+            return { Completion::Type::Return, result.value_or(js_undefined()), {} };
+        }
+
+        // Only generators need to hold on to their registers after returning.
         auto result_and_frame = bytecode_interpreter->run_and_return_frame(*m_bytecode_executable, nullptr);
 
         VERIFY(result_and_frame.frame != nullptr);
@@ -786,11 +795,6 @@ Completion ECMAScriptFunctionObject::ordinary_call_evaluate_body()
 
         auto result = result_and_frame.value.release_value();
 
-        // NOTE: Running the bytecode should eventually return a completion.
-        // Until it does, we assume "return" and include the undefined fallback from the call site.
-        if (m_kind == FunctionKind::Normal)
-            return { Completion::Type::Return, result.value_or(js_undefined()), {} };
-
         auto generator_object = TRY(GeneratorObject::create(global_object(), result, this, vm.running_execution_context().copy(), move(*result_and_frame.frame)));
 
         // NOTE: Async functions are entirely transformed to generator functions, and wrapped in a custom driver that returns a promise
@@ -859,6 +863,7 @@ void ECMAScriptFunctionObject::set_name(const FlyString& name)
 void ECMAScriptFunctionObject::add_field(ClassElement::ClassElementName property_key, ECMAScriptFunctionObject* initializer)
 {
     m_fields.empend(property_key, initializer);
+    write_barrier();
 }
 
 }
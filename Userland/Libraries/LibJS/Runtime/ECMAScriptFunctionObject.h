@@ -19,6 +19,7 @@ void async_block_start(VM&, NonnullRefPtr<Statement> const& parse_node, PromiseC
 // 10.2 ECMAScript Function Objects, https://tc39.es/ecma262/#sec-ecmascript-function-objects
 class ECMAScriptFunctionObject final : public FunctionObject {
     JS_OBJECT(ECMAScriptFunctionObject, FunctionObject);
+    JS_DECLARE_WRITE_BARRIER(ECMAScriptFunctionObject);
 
 public:
     enum class ConstructorKind : u8 {
@@ -63,7 +64,11 @@ public:
     ThisMode this_mode() const { return m_this_mode; }
 
     Object* home_object() const { return m_home_object; }
-    void set_home_object(Object* home_object) { m_home_object = home_object; }
+    void set_home_object(Object* home_object)
+    {
+        m_home_object = home_object;
+        write_barrier();
+    }
 
     String const& source_text() const { return m_source_text; }
     void set_source_text(String source_text) { m_source_text = move(source_text); }
@@ -52,6 +52,15 @@ void GeneratorObject::visit_edges(Cell::Visitor& visitor)
     Base::visit_edges(visitor);
     visitor.visit(m_generating_function);
     visitor.visit(m_previous_value);
+    for (auto value : m_frame)
+        visitor.visit(value);
+
+    // While suspended, nothing else keeps the generator's execution context alive.
+    visitor.visit(m_execution_context.function);
+    visitor.visit(m_execution_context.lexical_environment);
+    visitor.visit(m_execution_context.variable_environment);
+    visitor.visit(m_execution_context.private_environment);
+    visitor.visit(m_execution_context.this_value);
 }
 
 ThrowCompletionOr<Value> GeneratorObject::next_impl(VM& vm, GlobalObject& global_object, Optional<Value> next_argument, Optional<Value> value_to_throw)
@@ -96,23 +105,22 @@ ThrowCompletionOr<Value> GeneratorObject::next_impl(VM& vm, GlobalObject& global
     // Make sure it's an actual block
     VERIFY(!m_generating_function->bytecode_executable()->basic_blocks.find_if([next_block](auto& block) { return block == next_block; }).is_end());
 
-    // Restore the snapshot registers
-    bytecode_interpreter->enter_frame(m_frame);
+    // Pretend that 'yield' threw
+    if (value_to_throw.has_value())
+        return throw_completion(value_to_throw.release_value());
 
     // Temporarily switch to the captured execution context
     TRY(vm.push_execution_context(m_execution_context, global_object));
 
-    // Pretend that 'yield' returned the passed value, or threw
-    if (value_to_throw.has_value()) {
-        bytecode_interpreter->accumulator() = js_undefined();
-        return throw_completion(value_to_throw.release_value());
-    } else {
-        bytecode_interpreter->accumulator() = next_argument.value_or(js_undefined());
-    }
+    // Resume running on the saved registers, which the interpreter modifies in place
+    bytecode_interpreter->enter_frame(m_frame);
+
+    // Pretend that 'yield' returned the passed value
+    bytecode_interpreter->accumulator() = next_argument.value_or(js_undefined());
 
     auto next_result = bytecode_interpreter->run(*m_generating_function->bytecode_executable(), next_block);
 
-    m_frame = move(*bytecode_interpreter->pop_frame());
+    bytecode_interpreter->pop_frame();
 
     vm.pop_execution_context();
 
@@ -4,8 +4,11 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/AllOf.h>
 #include <AK/CharacterTypes.h>
+#include <AK/StringBuilder.h>
 #include <AK/Utf16View.h>
+#include <AK/Utf8View.h>
 #include <LibJS/Runtime/PrimitiveString.h>
 #include <LibJS/Runtime/VM.h>
 
@@ -23,13 +26,105 @@ PrimitiveString::PrimitiveString(Utf16String string)
 {
 }
 
+PrimitiveString::PrimitiveString(PrimitiveString& lhs, PrimitiveString& rhs)
+    : m_is_rope(true)
+    , m_lhs(&lhs)
+    , m_rhs(&rhs)
+{
+}
+
 PrimitiveString::~PrimitiveString()
 {
     vm().string_cache().remove(m_utf8_string);
 }
 
+void PrimitiveString::visit_edges(Cell::Visitor& visitor)
+{
+    Cell::visit_edges(visitor);
+    if (m_is_rope) {
+        visitor.visit(m_lhs);
+        visitor.visit(m_rhs);
+    }
+}
+
+bool PrimitiveString::is_empty() const
+{
+    // Note: Ropes are never created from empty strings.
+    if (m_is_rope)
+        return false;
+    if (m_has_utf16_string)
+        return m_utf16_string.is_empty();
+    return m_utf8_string.is_empty();
+}
+
+void PrimitiveString::resolve_rope_if_needed() const
+{
+    if (!m_is_rope)
+        return;
+
+    // NOTE: Ropes built by appending in a loop can be very deep, so we collect the pieces without recursing.
+    Vector<PrimitiveString const*> pieces;
+    Vector<PrimitiveString const*> stack;
+    stack.append(m_rhs);
+    stack.append(m_lhs);
+    while (!stack.is_empty()) {
+        auto const* current = stack.take_last();
+        if (current->is_rope()) {
+            stack.append(current->m_rhs);
+            stack.append(current->m_lhs);
+            continue;
+        }
+        pieces.append(current);
+    }
+
+    // If every piece is already UTF-16, concatenating them as UTF-16 avoids any conversions.
+    if (all_of(pieces, [](auto const* piece) { return piece->has_utf16_string(); })) {
+        size_t length = 0;
+        for (auto const* piece : pieces)
+            length += piece->utf16_string().length_in_code_units();
+
+        Vector<u16, 1> code_units;
+        code_units.ensure_capacity(length);
+        for (auto const* piece : pieces)
+            code_units.extend(piece->utf16_string().string());
+
+        m_utf16_string = Utf16String(move(code_units));
+        m_has_utf16_string = true;
+    } else {
+        StringBuilder builder;
+        for (auto const* piece : pieces) {
+            auto const& piece_string = piece->string();
+
+            // A surrogate pair may have been split between two pieces, in which case each half is encoded
+            // on its own as 3 bytes. They have to be combined into a single code point again.
+            auto previous = builder.string_view();
+            if (previous.length() >= 3 && piece_string.length() >= 3
+                && (static_cast<u8>(previous[previous.length() - 3]) & 0xf0) == 0xe0
+                && (static_cast<u8>(piece_string[0]) & 0xf0) == 0xe0) {
+                auto high_surrogate = *Utf8View(previous.substring_view(previous.length() - 3)).begin();
+                auto low_surrogate = *Utf8View(piece_string).begin();
+                if (Utf16View::is_high_surrogate(high_surrogate) && Utf16View::is_low_surrogate(low_surrogate)) {
+                    builder.trim(3);
+                    builder.append_code_point(Utf16View::decode_surrogate_pair(high_surrogate, low_surrogate));
+                    builder.append(piece_string.substring_view(3));
+                    continue;
+                }
+            }
+            builder.append(piece_string);
+        }
+
+        m_utf8_string = builder.to_string();
+        m_has_utf8_string = true;
+    }
+
+    m_is_rope = false;
+    m_lhs = nullptr;
+    m_rhs = nullptr;
+}
+
 String const& PrimitiveString::string() const
 {
+    resolve_rope_if_needed();
     if (!m_has_utf8_string) {
         m_utf8_string = m_utf16_string.to_utf8();
         m_has_utf8_string = true;
@@ -39,6 +134,7 @@ String const& PrimitiveString::string() const
 
 Utf16String const& PrimitiveString::utf16_string() const
 {
+    resolve_rope_if_needed();
     if (!m_has_utf16_string) {
         m_utf16_string = Utf16String(m_utf8_string);
         m_has_utf16_string = true;
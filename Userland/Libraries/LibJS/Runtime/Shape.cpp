@@ -203,6 +203,7 @@ void Shape::add_property_to_unique_shape(const StringOrSymbol& property_key, Pro
     VERIFY(m_property_table);
     VERIFY(!m_property_table->contains(property_key));
     m_property_table->set(property_key, { static_cast<u32>(m_property_table->size()), attributes });
+    write_barrier();
 
     VERIFY(m_property_count < NumericLimits<u32>::max());
     ++m_property_count;
@@ -216,6 +217,7 @@ void Shape::reconfigure_property_in_unique_shape(const StringOrSymbol& property_
     VERIFY(it != m_property_table->end());
     it->value.attributes = attributes;
     m_property_table->set(property_key, it->value);
+    write_barrier();
 }
 
 void Shape::remove_property_from_unique_shape(const StringOrSymbol& property_key, size_t offset)
@@ -239,6 +241,7 @@ void Shape::add_property_without_transition(StringOrSymbol const& property_key,
         VERIFY(m_property_count < NumericLimits<u32>::max());
         ++m_property_count;
     }
+    write_barrier();
 }
 
 FLATTEN void Shape::add_property_without_transition(PropertyKey const& property_key, PropertyAttributes attributes)
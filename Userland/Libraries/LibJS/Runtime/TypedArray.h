@@ -57,6 +57,13 @@ public:
     // 25.1.2.13 GetModifySetValueInBuffer ( arrayBuffer, byteIndex, type, value, op [ , isLittleEndian ] ), https://tc39.es/ecma262/#sec-getmodifysetvalueinbuffer
     virtual Value get_modify_set_value_in_buffer(size_t byte_index, Value value, ReadWriteModifyFunction operation, bool is_little_endian = true) = 0;
 
+    // ^Object
+    virtual bool has_exotic_behavior_for(PropertyKey const& property_key) const override
+    {
+        // Note: Canonical numeric strings (like "Infinity") are always treated as indices, see internal_get_own_property().
+        return (property_key.is_string() || property_key.is_number()) && !canonical_numeric_index_string(global_object(), property_key).is_undefined();
+    }
+
 protected:
     explicit TypedArrayBase(Object& prototype)
         : Object(prototype)
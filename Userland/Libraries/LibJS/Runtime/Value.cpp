@@ -208,7 +208,7 @@ ThrowCompletionOr<bool> Value::is_array(GlobalObject& global_object) const
 Array& Value::as_array()
 {
     VERIFY(is_object() && is<Array>(as_object()));
-    return static_cast<Array&>(*m_value.as_object);
+    return static_cast<Array&>(*extract_pointer<Object>());
 }
 
 // 7.2.3 IsCallable ( argument ), https://tc39.es/ecma262/#sec-iscallable
@@ -261,7 +261,7 @@ ThrowCompletionOr<bool> Value::is_regexp(GlobalObject& global_object) const
 // 13.5.3 The typeof Operator, https://tc39.es/ecma262/#sec-typeof-operator
 String Value::typeof() const
 {
-    switch (m_type) {
+    switch (type()) {
     case Value::Type::Undefined:
         return "undefined";
     case Value::Type::Null:
@@ -291,23 +291,23 @@ String Value::typeof() const
 
 String Value::to_string_without_side_effects() const
 {
-    switch (m_type) {
+    switch (type()) {
     case Type::Undefined:
         return "undefined";
     case Type::Null:
         return "null";
     case Type::Boolean:
-        return m_value.as_bool ? "true" : "false";
+        return as_bool() ? "true" : "false";
     case Type::Int32:
-        return String::number(m_value.as_i32);
+        return String::number(as_i32());
     case Type::Double:
-        return double_to_string(m_value.as_double);
+        return double_to_string(as_double());
     case Type::String:
-        return m_value.as_string->string();
+        return extract_pointer<PrimitiveString>()->string();
     case Type::Symbol:
-        return m_value.as_symbol->to_string();
+        return extract_pointer<Symbol>()->to_string();
     case Type::BigInt:
-        return m_value.as_bigint->to_string();
+        return extract_pointer<BigInt>()->to_string();
     case Type::Object:
         return String::formatted("[object {}]", as_object().class_name());
     case Type::Accessor:
@@ -329,23 +329,23 @@ ThrowCompletionOr<PrimitiveString*> Value::to_primitive_string(GlobalObject& glo
 ThrowCompletionOr<String> Value::to_string(GlobalObject& global_object) const
 {
     auto& vm = global_object.vm();
-    switch (m_type) {
+    switch (type()) {
     case Type::Undefined:
         return "undefined"sv;
     case Type::Null:
         return "null"sv;
     case Type::Boolean:
-        return m_value.as_bool ? "true"sv : "false"sv;
+        return as_bool() ? "true"sv : "false"sv;
     case Type::Int32:
-        return String::number(m_value.as_i32);
+        return String::number(as_i32());
     case Type::Double:
-        return double_to_string(m_value.as_double);
+        return double_to_string(as_double());
     case Type::String:
-        return m_value.as_string->string();
+        return extract_pointer<PrimitiveString>()->string();
     case Type::Symbol:
         return vm.throw_completion<TypeError>(global_object, ErrorType::Convert, "symbol", "string");
     case Type::BigInt:
-        return m_value.as_bigint->big_integer().to_base(10);
+        return extract_pointer<BigInt>()->big_integer().to_base(10);
     case Type::Object: {
         auto primitive_value = TRY(to_primitive(global_object, PreferredType::String));
         return primitive_value.to_string(global_object);
@@ -357,8 +357,8 @@ ThrowCompletionOr<String> Value::to_string(GlobalObject& global_object) const
 
 ThrowCompletionOr<Utf16String> Value::to_utf16_string(GlobalObject& global_object) const
 {
-    if (m_type == Type::String)
-        return m_value.as_string->utf16_string();
+    if (type() == Type::String)
+        return extract_pointer<PrimitiveString>()->utf16_string();
 
     auto utf8_string = TRY(to_string(global_object));
     return Utf16String(utf8_string);
@@ -367,27 +367,27 @@ ThrowCompletionOr<Utf16String> Value::to_utf16_string(GlobalObject& global_objec
 // 7.1.2 ToBoolean ( argument ), https://tc39.es/ecma262/#sec-toboolean
 bool Value::to_boolean() const
 {
-    switch (m_type) {
+    switch (type()) {
     case Type::Undefined:
     case Type::Null:
         return false;
     case Type::Boolean:
-        return m_value.as_bool;
+        return as_bool();
     case Type::Int32:
-        return m_value.as_i32 != 0;
+        return as_i32() != 0;
     case Type::Double:
         if (is_nan())
             return false;
-        return m_value.as_double != 0;
+        return as_double() != 0;
     case Type::String:
-        return !m_value.as_string->string().is_empty();
+        return !extract_pointer<PrimitiveString>()->string().is_empty();
     case Type::Symbol:
         return true;
     case Type::BigInt:
-        return m_value.as_bigint->big_integer() != BIGINT_ZERO;
+        return extract_pointer<BigInt>()->big_integer() != BIGINT_ZERO;
     case Type::Object:
         // B.3.7.1 Changes to ToBoolean, https://tc39.es/ecma262/#sec-IsHTMLDDA-internal-slot-to-boolean
-        if (m_value.as_object->is_htmldda())
+        if (extract_pointer<Object>()->is_htmldda())
             return false;
         return true;
     default:
@@ -430,21 +430,21 @@ ThrowCompletionOr<Value> Value::to_primitive(GlobalObject& global_object, Prefer
 // 7.1.18 ToObject ( argument ), https://tc39.es/ecma262/#sec-toobject
 ThrowCompletionOr<Object*> Value::to_object(GlobalObject& global_object) const
 {
-    switch (m_type) {
+    switch (type()) {
     case Type::Undefined:
     case Type::Null:
         return global_object.vm().throw_completion<TypeError>(global_object, ErrorType::ToObjectNullOrUndefined);
     case Type::Boolean:
-        return BooleanObject::create(global_object, m_value.as_bool);
+        return BooleanObject::create(global_object, as_bool());
     case Type::Int32:
     case Type::Double:
         return NumberObject::create(global_object, as_double());
     case Type::String:
-        return StringObject::create(global_object, *m_value.as_string, *global_object.string_prototype());
+        return StringObject::create(global_object, *extract_pointer<PrimitiveString>(), *global_object.string_prototype());
     case Type::Symbol:
-        return SymbolObject::create(global_object, *m_value.as_symbol);
+        return SymbolObject::create(global_object, *extract_pointer<Symbol>());
     case Type::BigInt:
-        return BigIntObject::create(global_object, *m_value.as_bigint);
+        return BigIntObject::create(global_object, *extract_pointer<BigInt>());
     case Type::Object:
         return &const_cast<Object&>(as_object());
     default:
@@ -464,13 +464,13 @@ FLATTEN ThrowCompletionOr<Value> Value::to_numeric(GlobalObject& global_object)
 // 7.1.4 ToNumber ( argument ), https://tc39.es/ecma262/#sec-tonumber
 ThrowCompletionOr<Value> Value::to_number(GlobalObject& global_object) const
 {
-    switch (m_type) {
+    switch (type()) {
     case Type::Undefined:
         return js_nan();
     case Type::Null:
         return Value(0);
     case Type::Boolean:
-        return Value(m_value.as_bool ? 1 : 0);
+        return Value(as_bool() ? 1 : 0);
     case Type::Int32:
     case Type::Double:
         return *this;
@@ -630,7 +630,7 @@ ThrowCompletionOr<double> Value::to_double(GlobalObject& global_object) const
 // 7.1.19 ToPropertyKey ( argument ), https://tc39.es/ecma262/#sec-topropertykey
 ThrowCompletionOr<PropertyKey> Value::to_property_key(GlobalObject& global_object) const
 {
-    if (type() == Type::Int32 && as_i32() >= 0)
+    if (is_int32() && as_i32() >= 0)
         return PropertyKey { as_i32() };
     auto key = TRY(to_primitive(global_object, PreferredType::String));
     if (key.is_symbol())
@@ -640,7 +640,7 @@ ThrowCompletionOr<PropertyKey> Value::to_property_key(GlobalObject& global_objec
 
 ThrowCompletionOr<i32> Value::to_i32_slow_case(GlobalObject& global_object) const
 {
-    VERIFY(type() != Type::Int32);
+    VERIFY(!is_int32());
     double value = TRY(to_number(global_object)).as_double();
     if (!isfinite(value) || value == 0)
         return 0;
@@ -657,8 +657,8 @@ ThrowCompletionOr<i32> Value::to_i32_slow_case(GlobalObject& global_object) cons
 
 ThrowCompletionOr<i32> Value::to_i32(GlobalObject& global_object) const
 {
-    if (m_type == Type::Int32)
-        return m_value.as_i32;
+    if (is_int32())
+        return as_i32();
     return to_i32_slow_case(global_object);
 }
 
@@ -842,7 +842,7 @@ ThrowCompletionOr<FunctionObject*> Value::get_method(GlobalObject& global_object
 // 13.10 Relational Operators, https://tc39.es/ecma262/#sec-relational-operators
 ThrowCompletionOr<Value> greater_than(GlobalObject& global_object, Value lhs, Value rhs)
 {
-    if (lhs.type() == Value::Type::Int32 && rhs.type() == Value::Type::Int32)
+    if (lhs.is_int32() && rhs.is_int32())
         return lhs.as_i32() > rhs.as_i32();
 
     TriState relation = TRY(is_less_than(global_object, false, lhs, rhs));
@@ -854,7 +854,7 @@ ThrowCompletionOr<Value> greater_than(GlobalObject& global_object, Value lhs, Va
 // 13.10 Relational Operators, https://tc39.es/ecma262/#sec-relational-operators
 ThrowCompletionOr<Value> greater_than_equals(GlobalObject& global_object, Value lhs, Value rhs)
 {
-    if (lhs.type() == Value::Type::Int32 && rhs.type() == Value::Type::Int32)
+    if (lhs.is_int32() && rhs.is_int32())
         return lhs.as_i32() >= rhs.as_i32();
 
     TriState relation = TRY(is_less_than(global_object, true, lhs, rhs));
@@ -866,7 +866,7 @@ ThrowCompletionOr<Value> greater_than_equals(GlobalObject& global_object, Value
 // 13.10 Relational Operators, https://tc39.es/ecma262/#sec-relational-operators
 ThrowCompletionOr<Value> less_than(GlobalObject& global_object, Value lhs, Value rhs)
 {
-    if (lhs.type() == Value::Type::Int32 && rhs.type() == Value::Type::Int32)
+    if (lhs.is_int32() && rhs.is_int32())
         return lhs.as_i32() < rhs.as_i32();
 
     TriState relation = TRY(is_less_than(global_object, true, lhs, rhs));
@@ -878,7 +878,7 @@ ThrowCompletionOr<Value> less_than(GlobalObject& global_object, Value lhs, Value
 // 13.10 Relational Operators, https://tc39.es/ecma262/#sec-relational-operators
 ThrowCompletionOr<Value> less_than_equals(GlobalObject& global_object, Value lhs, Value rhs)
 {
-    if (lhs.type() == Value::Type::Int32 && rhs.type() == Value::Type::Int32)
+    if (lhs.is_int32() && rhs.is_int32())
         return lhs.as_i32() <= rhs.as_i32();
 
     TriState relation = TRY(is_less_than(global_object, false, lhs, rhs));
@@ -1044,11 +1044,31 @@ ThrowCompletionOr<Value> unsigned_right_shift(GlobalObject& global_object, Value
     return vm.throw_completion<TypeError>(global_object, ErrorType::BigIntBadOperator, "unsigned right-shift");
 }
 
+// Concatenating strings shorter than this right away is cheaper than creating a rope.
+static constexpr size_t min_rope_length = 64;
+
+static size_t approximate_length(PrimitiveString const& string)
+{
+    if (string.has_utf8_string())
+        return string.string().length();
+    return string.utf16_string().length_in_code_units();
+}
+
 // https://tc39.es/ecma262/#string-concatenation
-static PrimitiveString* concatenate_strings(GlobalObject& global_object, PrimitiveString const& lhs, PrimitiveString const& rhs)
+static PrimitiveString* concatenate_strings(GlobalObject& global_object, PrimitiveString& lhs, PrimitiveString& rhs)
 {
     auto& vm = global_object.vm();
 
+    if (lhs.is_empty())
+        return &rhs;
+    if (rhs.is_empty())
+        return &lhs;
+
+    // NOTE: Repeatedly appending to a string would copy it every time, so we build a rope that is only
+    //       flattened once its contents are actually needed.
+    if (lhs.is_rope() || rhs.is_rope() || approximate_length(lhs) + approximate_length(rhs) >= min_rope_length)
+        return vm.heap().allocate_without_global_object<PrimitiveString>(lhs, rhs);
+
     if (lhs.has_utf16_string() && rhs.has_utf16_string()) {
         auto const& lhs_string = lhs.utf16_string();
         auto const& rhs_string = rhs.utf16_string();
@@ -1100,7 +1120,7 @@ static PrimitiveString* concatenate_strings(GlobalObject& global_object, Primiti
 ThrowCompletionOr<Value> add(GlobalObject& global_object, Value lhs, Value rhs)
 {
     if (both_number(lhs, rhs)) {
-        if (lhs.type() == Value::Type::Int32 && rhs.type() == Value::Type::Int32) {
+        if (lhs.is_int32() && rhs.is_int32()) {
             Checked<i32> result;
             result = MUST(lhs.to_i32(global_object));
             result += MUST(rhs.to_i32(global_object));
@@ -51,75 +51,72 @@ public:
         Number,
     };
 
-    bool is_empty() const { return m_type == Type::Empty; }
-    bool is_undefined() const { return m_type == Type::Undefined; }
-    bool is_null() const { return m_type == Type::Null; }
-    bool is_number() const { return m_type == Type::Int32 || m_type == Type::Double; }
-    bool is_string() const { return m_type == Type::String; }
-    bool is_object() const { return m_type == Type::Object; }
-    bool is_boolean() const { return m_type == Type::Boolean; }
-    bool is_symbol() const { return m_type == Type::Symbol; }
-    bool is_accessor() const { return m_type == Type::Accessor; };
-    bool is_bigint() const { return m_type == Type::BigInt; };
+    bool is_empty() const { return m_value == EMPTY_BITS; }
+    bool is_undefined() const { return m_value == UNDEFINED_BITS; }
+    bool is_null() const { return m_value == NULL_BITS; }
+    bool is_int32() const { return tag() == INT32_TAG; }
+    bool is_number() const { return is_double() || is_int32(); }
+    bool is_string() const { return tag() == STRING_TAG; }
+    bool is_object() const { return tag() == OBJECT_TAG; }
+    bool is_boolean() const { return tag() == BOOLEAN_TAG; }
+    bool is_symbol() const { return tag() == SYMBOL_TAG; }
+    bool is_accessor() const { return tag() == ACCESSOR_TAG; };
+    bool is_bigint() const { return tag() == BIGINT_TAG; };
     bool is_nullish() const { return is_null() || is_undefined(); }
-    bool is_cell() const { return is_string() || is_accessor() || is_object() || is_bigint() || is_symbol(); }
+    bool is_cell() const { return is_boxed_cell(m_value); }
     ThrowCompletionOr<bool> is_array(GlobalObject&) const;
     bool is_function() const;
     bool is_constructor() const;
     ThrowCompletionOr<bool> is_regexp(GlobalObject&) const;
 
-    bool is_nan() const
-    {
-        if (type() == Type::Int32)
-            return false;
-        return is_number() && __builtin_isnan(as_double());
-    }
+    // Note: All NaNs are canonicalized when stored in a Value.
+    bool is_nan() const { return m_value == CANON_NAN_BITS; }
 
     bool is_infinity() const
     {
-        if (type() == Type::Int32)
+        if (is_int32())
             return false;
         return is_number() && __builtin_isinf(as_double());
     }
 
     bool is_positive_infinity() const
     {
-        if (type() == Type::Int32)
+        if (is_int32())
             return false;
         return is_number() && __builtin_isinf_sign(as_double()) > 0;
     }
 
     bool is_negative_infinity() const
     {
-        if (type() == Type::Int32)
+        if (is_int32())
             return false;
         return is_number() && __builtin_isinf_sign(as_double()) < 0;
     }
 
     bool is_positive_zero() const
     {
-        if (type() == Type::Int32)
+        if (is_int32())
             return as_i32() == 0;
         return is_number() && bit_cast<u64>(as_double()) == 0;
     }
 
     bool is_negative_zero() const
     {
-        if (type() == Type::Int32)
+        if (is_int32())
             return false;
         return is_number() && bit_cast<u64>(as_double()) == NEGATIVE_ZERO_BITS;
     }
 
     bool is_integral_number() const
     {
-        if (type() == Type::Int32)
+        if (is_int32())
             return true;
         return is_finite_number() && trunc(as_double()) == as_double();
     }
 
     bool is_finite_number() const
     {
-        if (type() == Type::Int32)
+        if (is_int32())
             return true;
         if (!is_number())
             return false;
@@ -128,160 +125,186 @@ public:
     }
 
     Value()
-        : m_type(Type::Empty)
+        : m_value(EMPTY_BITS)
     {
     }
 
     template<typename T>
     requires(SameAs<RemoveCVReference<T>, bool>) explicit Value(T value)
-        : m_type(Type::Boolean)
+        : m_value(encode(BOOLEAN_TAG, value ? 1 : 0))
     {
-        m_value.as_bool = value;
     }
 
     explicit Value(double value)
     {
         bool is_negative_zero = bit_cast<u64>(value) == NEGATIVE_ZERO_BITS;
-        if (value >= NumericLimits<i32>::min() && value <= NumericLimits<i32>::max() && trunc(value) == value && !is_negative_zero) {
-            m_type = Type::Int32;
-            m_value.as_i32 = static_cast<i32>(value);
-        } else {
-            m_type = Type::Double;
-            m_value.as_double = value;
-        }
+        if (value >= NumericLimits<i32>::min() && value <= NumericLimits<i32>::max() && trunc(value) == value && !is_negative_zero)
+            m_value = encode(INT32_TAG, static_cast<u32>(static_cast<i32>(value)));
+        else if (__builtin_isnan(value))
+            m_value = CANON_NAN_BITS;
+        else
+            m_value = bit_cast<u64>(value);
     }
 
     explicit Value(unsigned long value)
     {
-        if (value > NumericLimits<i32>::max()) {
-            m_value.as_double = static_cast<double>(value);
-            m_type = Type::Double;
-        } else {
-            m_value.as_i32 = static_cast<i32>(value);
-            m_type = Type::Int32;
-        }
+        if (value > NumericLimits<i32>::max())
+            m_value = bit_cast<u64>(static_cast<double>(value));
+        else
+            m_value = encode(INT32_TAG, static_cast<u32>(value));
     }
 
     explicit Value(unsigned value)
     {
-        if (value > NumericLimits<i32>::max()) {
-            m_value.as_double = static_cast<double>(value);
-            m_type = Type::Double;
-        } else {
-            m_value.as_i32 = static_cast<i32>(value);
-            m_type = Type::Int32;
-        }
+        if (value > NumericLimits<i32>::max())
+            m_value = bit_cast<u64>(static_cast<double>(value));
+        else
+            m_value = encode(INT32_TAG, value);
     }
 
     explicit Value(i32 value)
-        : m_type(Type::Int32)
+        : m_value(encode(INT32_TAG, static_cast<u32>(value)))
     {
-        m_value.as_i32 = value;
     }
 
     Value(const Object* object)
-        : m_type(object ? Type::Object : Type::Null)
+        : m_value(object ? encode_cell(OBJECT_TAG, object) : NULL_BITS)
     {
-        m_value.as_object = const_cast<Object*>(object);
     }
 
     Value(const PrimitiveString* string)
-        : m_type(Type::String)
+        : m_value(encode_cell(STRING_TAG, string))
     {
-        m_value.as_string = const_cast<PrimitiveString*>(string);
     }
 
     Value(const Symbol* symbol)
-        : m_type(Type::Symbol)
+        : m_value(encode_cell(SYMBOL_TAG, symbol))
     {
-        m_value.as_symbol = const_cast<Symbol*>(symbol);
     }
 
     Value(const Accessor* accessor)
-        : m_type(Type::Accessor)
+        : m_value(encode_cell(ACCESSOR_TAG, accessor))
     {
-        m_value.as_accessor = const_cast<Accessor*>(accessor);
     }
 
     Value(const BigInt* bigint)
-        : m_type(Type::BigInt)
+        : m_value(encode_cell(BIGINT_TAG, bigint))
     {
-        m_value.as_bigint = const_cast<BigInt*>(bigint);
     }
 
     explicit Value(Type type)
-        : m_type(type)
     {
+        switch (type) {
+        case Type::Empty:
+            m_value = EMPTY_BITS;
+            break;
+        case Type::Undefined:
+            m_value = UNDEFINED_BITS;
+            break;
+        case Type::Null:
+            m_value = NULL_BITS;
+            break;
+        default:
+            VERIFY_NOT_REACHED();
+        }
     }
 
-    Type type() const { return m_type; }
+    Type type() const
+    {
+        if (is_double())
+            return Type::Double;
+        switch (tag()) {
+        case EMPTY_TAG:
+            return Type::Empty;
+        case UNDEFINED_TAG:
+            return Type::Undefined;
+        case NULL_TAG:
+            return Type::Null;
+        case INT32_TAG:
+            return Type::Int32;
+        case BOOLEAN_TAG:
+            return Type::Boolean;
+        case OBJECT_TAG:
+            return Type::Object;
+        case STRING_TAG:
+            return Type::String;
+        case SYMBOL_TAG:
+            return Type::Symbol;
+        case ACCESSOR_TAG:
+            return Type::Accessor;
+        case BIGINT_TAG:
+            return Type::BigInt;
+        default:
+            VERIFY_NOT_REACHED();
+        }
+    }
 
     double as_double() const
     {
         VERIFY(is_number());
-        if (m_type == Type::Int32)
-            return m_value.as_i32;
-        return m_value.as_double;
+        if (is_int32())
+            return decode_i32();
+        return bit_cast<double>(m_value);
     }
 
     bool as_bool() const
     {
-        VERIFY(type() == Type::Boolean);
-        return m_value.as_bool;
+        VERIFY(is_boolean());
+        return payload() != 0;
     }
 
     Object& as_object()
     {
-        VERIFY(type() == Type::Object);
-        return *m_value.as_object;
+        VERIFY(is_object());
+        return *extract_pointer<Object>();
     }
 
     const Object& as_object() const
     {
-        VERIFY(type() == Type::Object);
-        return *m_value.as_object;
+        VERIFY(is_object());
+        return *extract_pointer<Object>();
     }
 
     PrimitiveString& as_string()
     {
         VERIFY(is_string());
-        return *m_value.as_string;
+        return *extract_pointer<PrimitiveString>();
     }
 
     const PrimitiveString& as_string() const
     {
         VERIFY(is_string());
-        return *m_value.as_string;
+        return *extract_pointer<PrimitiveString>();
     }
 
     Symbol& as_symbol()
     {
         VERIFY(is_symbol());
-        return *m_value.as_symbol;
+        return *extract_pointer<Symbol>();
     }
 
     const Symbol& as_symbol() const
     {
         VERIFY(is_symbol());
-        return *m_value.as_symbol;
+        return *extract_pointer<Symbol>();
     }
 
     Cell& as_cell()
     {
         VERIFY(is_cell());
-        return *m_value.as_cell;
+        return *extract_pointer<Cell>();
     }
 
     Accessor& as_accessor()
     {
         VERIFY(is_accessor());
-        return *m_value.as_accessor;
+        return *extract_pointer<Accessor>();
     }
 
     BigInt& as_bigint()
     {
         VERIFY(is_bigint());
-        return *m_value.as_bigint;
+        return *extract_pointer<BigInt>();
     }
 
     Array& as_array();
@@ -291,19 +314,24 @@ public:
     // FIXME: These two conversions are wrong for JS, and seem likely to be footguns
     i32 as_i32() const
     {
-        if (m_type == Type::Int32)
-            return m_value.as_i32;
+        if (is_int32())
+            return decode_i32();
         return static_cast<i32>(as_double());
     }
     u32 as_u32() const
     {
-        if (m_type == Type::Int32 && m_value.as_i32 >= 0)
-            return m_value.as_i32;
+        if (is_int32() && decode_i32() >= 0)
+            return decode_i32();
         VERIFY(as_double() >= 0);
         return (u32)min(as_double(), (double)NumericLimits<u32>::max());
     }
 
-    u64 encoded() const { return m_value.encoded; }
+    u64 encoded() const { return m_value; }
+
+    // Values on the stack are only found by conservative root scanning, which has to see
+    // through the tag to find the cell a Value points to.
+    static constexpr bool is_boxed_cell(u64 encoded) { return (encoded >> TAG_SHIFT) >= OBJECT_TAG; }
+    static constexpr FlatPtr unbox_cell_pointer(u64 encoded) { return static_cast<FlatPtr>(encoded & PAYLOAD_MASK); }
 
     ThrowCompletionOr<String> to_string(GlobalObject&) const;
     ThrowCompletionOr<Utf16String> to_utf16_string(GlobalObject&) const;
@@ -350,27 +378,57 @@ public:
     [[nodiscard]] ALWAYS_INLINE ThrowCompletionOr<Value> invoke(GlobalObject& global_object, PropertyKey const& property_key, Args... args);
 
 private:
-    Type m_type { Type::Empty };
+    // Values are NaN-boxed into 64 bits. Doubles are stored as they are, with every NaN
+    // canonicalized to CANON_NAN_BITS. That leaves the remaining quiet NaN bit patterns to encode
+    // all other types: the top 16 bits hold a tag, and the low 48 bits hold an i32, a boolean or a
+    // cell pointer. Cell tags have the sign bit set, so is_cell() is a single comparison.
+    static constexpr u64 TAG_SHIFT = 48;
+    static constexpr u64 PAYLOAD_MASK = 0x0000'FFFF'FFFF'FFFF;
+    static constexpr u64 CANON_NAN_BITS = 0x7FF8'0000'0000'0000;
+
+    static constexpr u16 UNDEFINED_TAG = 0x7FF9;
+    static constexpr u16 NULL_TAG = 0x7FFA;
+    static constexpr u16 BOOLEAN_TAG = 0x7FFB;
+    static constexpr u16 INT32_TAG = 0x7FFC;
+    static constexpr u16 EMPTY_TAG = 0x7FFD;
+
+    static constexpr u16 OBJECT_TAG = 0xFFF9;
+    static constexpr u16 STRING_TAG = 0xFFFA;
+    static constexpr u16 SYMBOL_TAG = 0xFFFB;
+    static constexpr u16 ACCESSOR_TAG = 0xFFFC;
+    static constexpr u16 BIGINT_TAG = 0xFFFD;
+
+    static constexpr u64 encode(u16 tag, u64 payload) { return (static_cast<u64>(tag) << TAG_SHIFT) | payload; }
+
+    static u64 encode_cell(u16 tag, void const* cell)
+    {
+        auto address = bit_cast<FlatPtr>(cell);
+        VERIFY((static_cast<u64>(address) & ~PAYLOAD_MASK) == 0);
+        return encode(tag, address);
+    }
+
+    static constexpr u64 EMPTY_BITS = static_cast<u64>(EMPTY_TAG) << TAG_SHIFT;
+    static constexpr u64 UNDEFINED_BITS = static_cast<u64>(UNDEFINED_TAG) << TAG_SHIFT;
+    static constexpr u64 NULL_BITS = static_cast<u64>(NULL_TAG) << TAG_SHIFT;
+
+    // Every bit pattern that is not a quiet NaN is a double, as is the canonical NaN itself.
+    bool is_double() const { return (m_value & CANON_NAN_BITS) != CANON_NAN_BITS || m_value == CANON_NAN_BITS; }
+    u16 tag() const { return static_cast<u16>(m_value >> TAG_SHIFT); }
+    u64 payload() const { return m_value & PAYLOAD_MASK; }
+    i32 decode_i32() const { return static_cast<i32>(static_cast<u32>(m_value)); }
+
+    template<typename T>
+    T* extract_pointer() const { return reinterpret_cast<T*>(unbox_cell_pointer(m_value)); }
 
     [[nodiscard]] ThrowCompletionOr<Value> invoke_internal(GlobalObject& global_object, PropertyKey const&, Optional<MarkedVector<Value>> arguments);
 
     ThrowCompletionOr<i32> to_i32_slow_case(GlobalObject&) const;
 
-    union {
-        bool as_bool;
-        i32 as_i32;
-        double as_double;
-        PrimitiveString* as_string;
-        Symbol* as_symbol;
-        Object* as_object;
-        Cell* as_cell;
-        Accessor* as_accessor;
-        BigInt* as_bigint;
-
-        u64 encoded;
-    } m_value { .encoded = 0 };
+    u64 m_value { EMPTY_BITS };
 };
 
+static_assert(sizeof(Value) == sizeof(u64));
+
 inline Value js_undefined()
 {
     return Value(Value::Type::Undefined);
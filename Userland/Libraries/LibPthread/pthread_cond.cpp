@@ -152,7 +152,9 @@ int pthread_cond_broadcast(pthread_cond_t* cond)
     pthread_mutex_t* mutex = AK::atomic_load(&cond->mutex, AK::memory_order_relaxed);
     VERIFY(mutex);
 
-    int rc = futex(&cond->value, FUTEX_REQUEUE, 1, nullptr, &mutex->lock, INT_MAX);
+    // Wake up one waiter to take the mutex, and move everyone else over to wait on the mutex directly.
+    // They would only be fighting over it otherwise, and all but one of them would go right back to sleep.
+    int rc = futex(&cond->value, FUTEX_REQUEUE_PRIVATE, 1, nullptr, &mutex->lock, INT_MAX);
     VERIFY(rc >= 0);
     return 0;
 }
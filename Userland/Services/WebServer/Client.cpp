@@ -16,6 +16,7 @@
 #include <LibCore/DirIterator.h>
 #include <LibCore/File.h>
 #include <LibCore/FileStream.h>
+#include <LibCore/IORing.h>
 #include <LibCore/MappedFile.h>
 #include <LibCore/MimeData.h>
 #include <LibHTTP/HttpRequest.h>
@@ -28,9 +29,21 @@
 
 namespace WebServer {
 
-Client::Client(NonnullOwnPtr<Core::Stream::BufferedTCPSocket> socket, Core::Object* parent)
+static constexpr size_t file_chunk_size = 64 * KiB;
+
+// All clients share one ring, so the requests of everyone we are currently sending files to go to the kernel together.
+static ErrorOr<NonnullRefPtr<Core::IORing>> io_ring()
+{
+    static RefPtr<Core::IORing> s_io_ring;
+    if (!s_io_ring)
+        s_io_ring = TRY(Core::IORing::create());
+    return *s_io_ring;
+}
+
+Client::Client(NonnullOwnPtr<Core::Stream::BufferedTCPSocket> socket, int socket_fd, Core::Object* parent)
     : Core::Object(parent)
     , m_socket(move(socket))
+    , m_socket_fd(socket_fd)
 {
 }
 
@@ -43,6 +56,10 @@ void Client::die()
 void Client::start()
 {
     m_socket->on_ready_to_read = [this] {
+        // We only handle one request per connection, and are still busy sending the response to it.
+        if (m_file)
+            return;
+
         StringBuilder builder;
 
         auto maybe_buffer = ByteBuffer::create_uninitialized(m_socket->buffer_size());
@@ -88,7 +105,9 @@ void Client::start()
             warnln("Failed to handle the request: {}", maybe_did_handle.error());
         }
 
-        die();
+        // A file response is still on its way, and we go away once it has been sent.
+        if (!m_file)
+            die();
     };
 }
 
@@ -162,13 +181,11 @@ ErrorOr<bool> Client::handle_request(ReadonlyBytes raw_request)
         return false;
     }
 
-    Core::InputFileStream stream { file };
-
-    TRY(send_response(stream, request, Core::guess_mime_type_based_on_filename(real_path)));
+    TRY(send_file_response(file, request, Core::guess_mime_type_based_on_filename(real_path)));
     return true;
 }
 
-ErrorOr<void> Client::send_response(InputStream& response, HTTP::HttpRequest const& request, String const& content_type)
+ErrorOr<void> Client::send_response_headers(HTTP::HttpRequest const& request, String const& content_type)
 {
     StringBuilder builder;
     builder.append("HTTP/1.0 200 OK\r\n");
@@ -184,7 +201,89 @@ ErrorOr<void> Client::send_response(InputStream& response, HTTP::HttpRequest con
     auto builder_contents = builder.to_byte_buffer();
     TRY(m_socket->write(builder_contents));
     log_response(200, request);
+    return {};
+}
+
+ErrorOr<void> Client::send_response(InputStream& response, HTTP::HttpRequest const& request, String const& content_type)
+{
+    TRY(send_response_headers(request, content_type));
+    return send_stream_contents(response);
+}
+
+ErrorOr<void> Client::send_file_response(NonnullRefPtr<Core::File> file, HTTP::HttpRequest const& request, String const& content_type)
+{
+    auto io_ring_or_error = io_ring();
+    if (io_ring_or_error.is_error()) {
+        dbgln("Failed to set up the I/O ring, sending the file the slow way: {}", io_ring_or_error.error());
+        Core::InputFileStream stream { file };
+        return send_response(stream, request, content_type);
+    }
+
+    TRY(send_response_headers(request, content_type));
+
+    // Reading the file and writing it to the socket are handed to the kernel together with everyone else's,
+    // and we only get back to this client when they are done, instead of blocking all clients on each of them.
+    m_io_ring = io_ring_or_error.release_value();
+    m_file_buffer = TRY(ByteBuffer::create_uninitialized(file_chunk_size));
+    m_file_offset = 0;
+    m_file = move(file);
+    if (auto result = read_next_file_chunk(); result.is_error()) {
+        m_file = nullptr;
+        return result.release_error();
+    }
+    return {};
+}
 
+ErrorOr<void> Client::read_next_file_chunk()
+{
+    return m_io_ring->read(m_file->fd(), m_file_buffer.bytes(), m_file_offset, [this, protector = NonnullRefPtr { *this }](auto nread_or_error) {
+        if (nread_or_error.is_error()) {
+            warnln("Failed to read the file: {}", nread_or_error.error());
+            finish_file_response();
+            return;
+        }
+        auto nread = nread_or_error.release_value();
+        if (nread == 0) {
+            finish_file_response();
+            return;
+        }
+        m_file_offset += nread;
+        send_file_chunk(m_file_buffer.bytes().trim(nread));
+    });
+}
+
+void Client::send_file_chunk(ReadonlyBytes chunk)
+{
+    auto result = m_io_ring->send(m_socket_fd, chunk, 0, [this, protector = NonnullRefPtr { *this }, chunk](auto nsent_or_error) {
+        if (nsent_or_error.is_error()) {
+            warnln("Failed to send the file: {}", nsent_or_error.error());
+            finish_file_response();
+            return;
+        }
+        auto rest = chunk.slice(nsent_or_error.release_value());
+        if (!rest.is_empty()) {
+            send_file_chunk(rest);
+            return;
+        }
+        if (auto result = read_next_file_chunk(); result.is_error()) {
+            warnln("Failed to read the file: {}", result.error());
+            finish_file_response();
+        }
+    });
+    if (result.is_error()) {
+        warnln("Failed to send the file: {}", result.error());
+        finish_file_response();
+    }
+}
+
+void Client::finish_file_response()
+{
+    m_file = nullptr;
+    die();
+}
+
+ErrorOr<void> Client::send_stream_contents(InputStream& response)
+{
     char buffer[PAGE_SIZE];
     do {
         auto size = response.read({ buffer, sizeof(buffer) });
@@ -6,6 +6,8 @@
 
 #pragma once
 
+#include <AK/ByteBuffer.h>
+#include <LibCore/Forward.h>
 #include <LibCore/Object.h>
 #include <LibCore/Stream.h>
 #include <LibHTTP/Forward.h>
@@ -20,10 +22,16 @@ public:
     void start();
 
 private:
-    Client(NonnullOwnPtr<Core::Stream::BufferedTCPSocket>, Core::Object* parent);
+    Client(NonnullOwnPtr<Core::Stream::BufferedTCPSocket>, int socket_fd, Core::Object* parent);
 
     ErrorOr<bool> handle_request(ReadonlyBytes);
+    ErrorOr<void> send_response_headers(HTTP::HttpRequest const&, String const& content_type);
     ErrorOr<void> send_response(InputStream&, HTTP::HttpRequest const&, String const& content_type);
+    ErrorOr<void> send_file_response(NonnullRefPtr<Core::File>, HTTP::HttpRequest const&, String const& content_type);
+    ErrorOr<void> read_next_file_chunk();
+    void send_file_chunk(ReadonlyBytes);
+    void finish_file_response();
+    ErrorOr<void> send_stream_contents(InputStream&);
     ErrorOr<void> send_redirect(StringView redirect, HTTP::HttpRequest const&);
     ErrorOr<void> send_error_response(unsigned code, HTTP::HttpRequest const&, Vector<String> const& headers = {});
     void die();
@@ -32,6 +40,14 @@ private:
     bool verify_credentials(Vector<HTTP::HttpRequest::Header> const&);
 
     NonnullOwnPtr<Core::Stream::BufferedTCPSocket> m_socket;
+    // The socket's fd, for sending files to it through the I/O ring.
+    int m_socket_fd { -1 };
+
+    // The file we are sending, one chunk at a time, while the event loop goes on serving other clients.
+    RefPtr<Core::IORing> m_io_ring;
+    RefPtr<Core::File> m_file;
+    ByteBuffer m_file_buffer;
+    off_t m_file_offset { 0 };
 };
 
 }
@@ -78,6 +78,7 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
             return;
         }
 
+        auto client_socket_fd = maybe_client_socket.value()->fd();
         auto maybe_buffered_socket = Core::Stream::BufferedTCPSocket::create(maybe_client_socket.release_value());
         if (maybe_buffered_socket.is_error()) {
             warnln("Could not obtain a buffered socket for the client: {}", maybe_buffered_socket.error());
@@ -86,7 +87,7 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
 
         // FIXME: Propagate errors
         MUST(maybe_buffered_socket.value()->set_blocking(true));
-        auto client = WebServer::Client::construct(maybe_buffered_socket.release_value(), server);
+        auto client = WebServer::Client::construct(maybe_buffered_socket.release_value(), client_socket_fd, server);
         client->start();
     };
 
@@ -47,7 +47,23 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
 
     Array<u8, 32768> buffer;
     for (auto& fd : fds) {
-        for (;;) {
+        // Let the kernel copy regular files straight to stdout. Pipes and the like are read and written below.
+        bool use_sendfile = true;
+        size_t total_nsent = 0;
+        while (use_sendfile) {
+            auto nsent_or_error = Core::System::sendfile(STDOUT_FILENO, fd, nullptr, 1 * MiB);
+            if (nsent_or_error.is_error()) {
+                if (total_nsent > 0)
+                    return nsent_or_error.release_error();
+                use_sendfile = false;
+                break;
+            }
+            if (nsent_or_error.value() == 0)
+                break;
+            total_nsent += nsent_or_error.value();
+        }
+
+        while (!use_sendfile) {
             auto buffer_span = buffer.span();
             auto nread = TRY(Core::System::read(fd, buffer_span));
             if (nread == 0)
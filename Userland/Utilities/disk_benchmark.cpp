@@ -4,6 +4,7 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/Atomic.h>
 #include <AK/ByteBuffer.h>
 #include <AK/ScopeGuard.h>
 #include <AK/String.h>
@@ -12,8 +13,10 @@
 #include <LibCore/ElapsedTimer.h>
 #include <fcntl.h>
 #include <getopt.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
@@ -39,11 +42,12 @@ static Result average_result(const Vector<Result>& results)
 
 static void exit_with_usage(int rc)
 {
-    warnln("Usage: disk_benchmark [-h] [-d directory] [-t time_per_benchmark] [-f file_size1,file_size2,...] [-b block_size1,block_size2,...]");
+    warnln("Usage: disk_benchmark [-h] [-d directory] [-t time_per_benchmark] [-f file_size1,file_size2,...] [-b block_size1,block_size2,...] [-q queue_depth1,queue_depth2,...]");
     exit(rc);
 }
 
 static Optional<Result> benchmark(const String& filename, int file_size, int block_size, ByteBuffer& buffer, bool allow_cache);
+static Optional<u64> benchmark_queue_depth(const String& filename, int file_size, int block_size, int queue_depth, int time_per_benchmark, bool allow_cache);
 
 int main(int argc, char** argv)
 {
@@ -51,10 +55,11 @@ int main(int argc, char** argv)
     int time_per_benchmark = 10;
     Vector<size_t> file_sizes;
     Vector<size_t> block_sizes;
+    Vector<int> queue_depths;
     bool allow_cache = false;
 
     int opt;
-    while ((opt = getopt(argc, argv, "chd:t:f:b:")) != -1) {
+    while ((opt = getopt(argc, argv, "chd:t:f:b:q:")) != -1) {
         switch (opt) {
         case 'h':
             exit_with_usage(0);
@@ -76,6 +81,14 @@ int main(int argc, char** argv)
             for (const auto& size : String(optarg).split(','))
                 block_sizes.append(atoi(size.characters()));
             break;
+        case 'q':
+            for (const auto& depth : String(optarg).split(',')) {
+                auto queue_depth = atoi(depth.characters());
+                if (queue_depth < 1)
+                    exit_with_usage(1);
+                queue_depths.append(queue_depth);
+            }
+            break;
         }
     }
 
@@ -95,6 +108,18 @@ int main(int argc, char** argv)
             if (block_size > file_size)
                 continue;
 
+            if (!queue_depths.is_empty()) {
+                // Random reads with one reader thread per outstanding request, to see how well the device scales with queue depth.
+                for (auto queue_depth : queue_depths) {
+                    outln("Running: file_size={} block_size={} queue_depth={}", file_size, block_size, queue_depth);
+                    auto iops = benchmark_queue_depth(filename, file_size, block_size, queue_depth, time_per_benchmark, allow_cache);
+                    if (!iops.has_value())
+                        return 1;
+                    outln("Finished: queue_depth={} iops={} read_bps={}", queue_depth, iops.value(), iops.value() * block_size);
+                }
+                continue;
+            }
+
             auto buffer_result = ByteBuffer::create_uninitialized(block_size);
             if (buffer_result.is_error()) {
                 warnln("Not enough memory to allocate space for block size = {}", block_size);
@@ -177,3 +202,104 @@ Optional<Result> benchmark(const String& filename, int file_size, int block_size
     result.read_bps = (u64)(timer.elapsed() ? (file_size / timer.elapsed()) : file_size) * 1000;
     return result;
 }
+
+struct RandomReader {
+    int fd { -1 };
+    int file_size { 0 };
+    int block_size { 0 };
+    Atomic<bool>* should_stop { nullptr };
+    u64 reads { 0 };
+    bool failed { false };
+};
+
+static void* random_read_thread(void* context)
+{
+    auto& reader = *static_cast<RandomReader*>(context);
+    auto buffer_result = ByteBuffer::create_uninitialized(reader.block_size);
+    if (buffer_result.is_error()) {
+        reader.failed = true;
+        return nullptr;
+    }
+    auto buffer = buffer_result.release_value();
+
+    auto block_count = reader.file_size / reader.block_size;
+    while (!reader.should_stop->load()) {
+        off_t offset = (off_t)arc4random_uniform(block_count) * reader.block_size;
+        if (pread(reader.fd, buffer.data(), reader.block_size, offset) != reader.block_size) {
+            perror("pread");
+            reader.failed = true;
+            return nullptr;
+        }
+        ++reader.reads;
+    }
+    return nullptr;
+}
+
+Optional<u64> benchmark_queue_depth(const String& filename, int file_size, int block_size, int queue_depth, int time_per_benchmark, bool allow_cache)
+{
+    int flags = O_CREAT | O_TRUNC | O_RDWR;
+    if (!allow_cache)
+        flags |= O_DIRECT;
+
+    int fd = open(filename.characters(), flags, 0644);
+    if (fd == -1) {
+        perror("open");
+        exit(1);
+    }
+
+    auto fd_cleanup = ScopeGuard([fd, filename] {
+        if (close(fd) < 0)
+            perror("close");
+        if (unlink(filename.characters()) < 0)
+            perror("unlink");
+    });
+
+    auto buffer_result = ByteBuffer::create_zeroed(block_size);
+    if (buffer_result.is_error()) {
+        warnln("Not enough memory to allocate space for block size = {}", block_size);
+        return {};
+    }
+    for (int total_written = 0; total_written + block_size <= file_size; total_written += block_size) {
+        if (write(fd, buffer_result.value().data(), block_size) != block_size) {
+            perror("write");
+            return {};
+        }
+    }
+
+    Atomic<bool> should_stop { false };
+    Vector<RandomReader> readers;
+    readers.resize(queue_depth);
+    Vector<pthread_t> threads;
+    threads.resize(queue_depth);
+
+    auto timer = Core::ElapsedTimer::start_new();
+    for (int i = 0; i < queue_depth; ++i) {
+        readers[i].fd = fd;
+        readers[i].file_size = file_size;
+        readers[i].block_size = block_size;
+        readers[i].should_stop = &should_stop;
+        if (int rc = pthread_create(&threads[i], nullptr, random_read_thread, &readers[i]); rc != 0) {
+            warnln("pthread_create: {}", strerror(rc));
+            should_stop.store(true);
+            for (int j = 0; j < i; ++j)
+                pthread_join(threads[j], nullptr);
+            return {};
+        }
+    }
+
+    sleep(time_per_benchmark);
+    should_stop.store(true);
+
+    u64 total_reads = 0;
+    bool failed = false;
+    for (int i = 0; i < queue_depth; ++i) {
+        pthread_join(threads[i], nullptr);
+        total_reads += readers[i].reads;
+        failed |= readers[i].failed;
+    }
+    if (failed)
+        return {};
+
+    auto elapsed = timer.elapsed();
+    return elapsed ? total_reads * 1000 / elapsed : total_reads;
+}
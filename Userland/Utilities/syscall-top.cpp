@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/HashMap.h>
+#include <AK/QuickSort.h>
+#include <AK/String.h>
+#include <AK/Vector.h>
+#include <LibCore/ArgsParser.h>
+#include <LibCore/File.h>
+#include <LibCore/ProcessStatisticsReader.h>
+#include <LibCore/System.h>
+#include <LibMain/Main.h>
+#include <unistd.h>
+
+struct SyscallKey {
+    pid_t pid;
+    String name;
+
+    bool operator==(SyscallKey const&) const = default;
+};
+
+namespace AK {
+template<>
+struct Traits<SyscallKey> : public GenericTraits<SyscallKey> {
+    static unsigned hash(SyscallKey const& key) { return pair_int_hash(key.pid, key.name.hash()); }
+};
+}
+
+struct Row {
+    pid_t pid;
+    String process_name;
+    String syscall_name;
+    u64 count;
+    u64 total_ns;
+    u64 max_ns;
+    size_t p99_bucket;
+};
+
+using Snapshot = HashMap<SyscallKey, Core::SyscallStatistics>;
+
+static Snapshot take_snapshot(Vector<Core::ProcessStatistics> const& processes, pid_t only_pid)
+{
+    Snapshot snapshot;
+    for (auto const& process : processes) {
+        if (only_pid != -1 && process.pid != only_pid)
+            continue;
+        auto syscalls = Core::ProcessStatisticsReader::get_syscall_statistics(process.pid);
+        if (!syscalls.has_value())
+            continue;
+        for (auto& syscall : syscalls.value())
+            snapshot.set({ process.pid, syscall.name }, move(syscall));
+    }
+    return snapshot;
+}
+
+static String format_duration(u64 ns)
+{
+    if (ns < 1'000)
+        return String::formatted("{}ns", ns);
+    if (ns < 1'000'000)
+        return String::formatted("{}.{}us", ns / 1'000, (ns / 100) % 10);
+    if (ns < 1'000'000'000)
+        return String::formatted("{}.{}ms", ns / 1'000'000, (ns / 100'000) % 10);
+    return String::formatted("{}.{}s", ns / 1'000'000'000, (ns / 100'000'000) % 10);
+}
+
+static String format_bucket(size_t bucket)
+{
+    if (bucket == 0)
+        return "<1us";
+    return String::formatted("<{}", format_duration((1ull << bucket) * 1'000));
+}
+
+static bool syscall_statistics_enabled()
+{
+    auto file = Core::File::open("/proc/sys/syscall_statistics", Core::OpenMode::ReadOnly);
+    if (file.is_error())
+        return false;
+    auto contents = file.value()->read_all();
+    return !contents.is_empty() && contents[0] == '1';
+}
+
+ErrorOr<int> serenity_main(Main::Arguments arguments)
+{
+    TRY(Core::System::pledge("stdio rpath"));
+    TRY(Core::System::unveil("/proc", "r"));
+    // needed by ProcessStatisticsReader::get_all()
+    TRY(Core::System::unveil("/etc/passwd", "r"));
+    TRY(Core::System::unveil(nullptr, nullptr));
+
+    pid_t pid = -1;
+    int delay = 1;
+    int count = 20;
+    bool once = false;
+
+    Core::ArgsParser args_parser;
+    args_parser.set_general_help("Show the syscalls that processes spend the most time in.");
+    args_parser.add_option(pid, "Only show syscalls of the given process", "pid", 'p', "pid");
+    args_parser.add_option(delay, "Delay between updates, in seconds", "delay", 'd', "seconds");
+    args_parser.add_option(count, "Number of syscalls to show", "count", 'n', "count");
+    args_parser.add_option(once, "Show totals since accounting was enabled, then exit", "once", 'o');
+    args_parser.parse(arguments);
+
+    if (!syscall_statistics_enabled())
+        warnln("syscall-top: Syscall accounting is disabled, enable it with `sysctl -w syscall_statistics=1`");
+
+    Snapshot previous;
+    for (;;) {
+        auto all_processes = Core::ProcessStatisticsReader::get_all();
+        if (!all_processes.has_value())
+            return 1;
+        auto current = take_snapshot(all_processes->processes, pid);
+
+        HashMap<pid_t, String> process_names;
+        for (auto const& process : all_processes->processes)
+            process_names.set(process.pid, process.name);
+
+        Vector<Row> rows;
+        for (auto const& it : current) {
+            auto const& syscall = it.value;
+            Core::SyscallStatistics const* before = nullptr;
+            // NOTE: If the counts went down, the PID now belongs to a different process.
+            if (auto previous_it = previous.find(it.key); previous_it != previous.end() && previous_it->value.count <= syscall.count)
+                before = &previous_it->value;
+
+            Row row { it.key.pid, process_names.get(it.key.pid).value_or("?"), syscall.name, syscall.count, syscall.total_ns, syscall.max_ns, 0 };
+            Vector<u64> histogram = syscall.histogram;
+            if (before) {
+                row.count -= before->count;
+                row.total_ns -= before->total_ns;
+                for (size_t i = 0; i < histogram.size() && i < before->histogram.size(); ++i)
+                    histogram[i] -= before->histogram[i];
+            }
+            if (row.count == 0)
+                continue;
+
+            u64 seen = 0;
+            for (size_t i = 0; i < histogram.size(); ++i) {
+                seen += histogram[i];
+                if (seen * 100 >= row.count * 99) {
+                    row.p99_bucket = i;
+                    break;
+                }
+            }
+            rows.append(move(row));
+        }
+
+        quick_sort(rows, [](auto& a, auto& b) { return a.total_ns > b.total_ns; });
+
+        if (!once)
+            out("\033[3J\033[H\033[2J");
+        outln("\033[1m{:>6}  {:<16}  {:<20}  {:>8}  {:>9}  {:>9}  {:>9}  {:>9}\033[0m", "PID", "NAME", "SYSCALL", "COUNT", "TOTAL", "AVG", "P99", "MAX");
+        for (size_t i = 0; i < rows.size() && i < static_cast<size_t>(count); ++i) {
+            auto const& row = rows[i];
+            outln("{:>6}  {:<16}  {:<20}  {:>8}  {:>9}  {:>9}  {:>9}  {:>9}",
+                row.pid,
+                row.process_name,
+                row.syscall_name,
+                row.count,
+                format_duration(row.total_ns),
+                format_duration(row.total_ns / row.count),
+                format_bucket(row.p99_bucket),
+                format_duration(row.max_ns));
+        }
+
+        if (once)
+            return 0;
+        previous = move(current);
+        sleep(delay);
+    }
+}